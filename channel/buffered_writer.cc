@@ -105,4 +105,14 @@ bool BufferedWriter::is_writable() const
   return channel_.is_open();
 }
 
+bool BufferedWriter::is_congested() const
+{
+  return channel_.is_congested();
+}
+
+bool BufferedWriter::is_full() const
+{
+  return channel_.is_full();
+}
+
 } // namespace channel
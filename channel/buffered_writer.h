@@ -67,6 +67,9 @@ public:
 
   bool is_writable() const override;
 
+  bool is_congested() const override;
+  bool is_full() const override;
+
 private:
   u8 *buf_;
   const u32 buf_size_;
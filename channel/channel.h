@@ -7,8 +7,10 @@
 
 #include <platform/types.h>
 
+#include <functional>
 #include <string_view>
 #include <system_error>
+#include <vector>
 
 namespace channel {
 
@@ -31,6 +33,32 @@ public:
 
   inline std::error_code send(std::string_view data) { return send(reinterpret_cast<u8 const *>(data.data()), data.size()); }
 
+  /**
+   * Sends the data |fill| writes to the buffer it is given, of |max_len|
+   * bytes. |fill| returns the number of bytes it wrote.
+   *
+   * Channels that copy sent data into buffers of their own let |fill| write
+   * directly into them.
+   */
+  virtual std::error_code send_in_place(u32 max_len, std::function<u32(u8 *)> const &fill)
+  {
+    std::vector<u8> buffer(max_len);
+    return send(buffer.data(), fill(buffer.data()));
+  }
+
+  /**
+   * Whether data is being sent faster than the channel can write it out.
+   * Writers can then hold back data that is fine to lose, before the channel
+   * gives up on the connection.
+   */
+  virtual bool is_congested() const { return false; }
+
+  /**
+   * Whether the channel holds as much unsent data as it allows. It keeps
+   * taking sends for a while, but writers should only send what can't be lost.
+   */
+  virtual bool is_full() const { return false; }
+
   /**
    * Flushes any internal buffers.
    */
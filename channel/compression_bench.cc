@@ -0,0 +1,223 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+// Intake compression benchmark: compression ratio and speed of the codecs
+// UpstreamConnection can use, on a recording of real collector output.
+//
+// Not part of the unit test suite; run manually on a recording made with
+// EBPF_NET_RECORD_INTAKE_OUTPUT_PATH:
+//   INTAKE_RECORDING=/tmp/intake.bin compression_bench [--gtest_filter=...]
+//
+// The recording is cut in flushes of COMPRESSION_BENCH_FLUSH_SIZE bytes (16KiB,
+// the collector's write buffer size, by default). Dictionaries are trained on
+// the first half of the recording and every codec is measured on the second
+// half. ZSTD_DICTIONARY can point to a dictionary trained with `zstd --train`
+// to measure it instead of the one trained here.
+
+#include <channel/lz4_channel.h>
+#include <channel/zstd_channel.h>
+#include <util/lz4_decompressor.h>
+#include <util/zstd_decompressor.h>
+
+#include <gtest/gtest.h>
+
+#include <lz4frame.h>
+#include <zdict.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace channel {
+
+namespace {
+
+constexpr size_t default_flush_size = 16 * 1024;
+constexpr size_t dictionary_size = 112 * 1024;
+
+// Keeps what is sent to it.
+class SinkChannel : public Channel {
+public:
+  std::error_code send(const u8 *data, int data_len) override
+  {
+    packets.emplace_back(reinterpret_cast<char const *>(data), data_len);
+    return {};
+  }
+
+  bool is_open() const override { return true; }
+
+  std::vector<std::string> packets;
+};
+
+// Old behavior of Lz4Channel: one frame per flush.
+class Lz4FrameChannel : public Channel {
+public:
+  Lz4FrameChannel(Channel &channel, u32 max_data_length)
+      : channel_(channel), buffer_(LZ4F_compressFrameBound(max_data_length, nullptr))
+  {}
+
+  std::error_code send(const u8 *data, int data_len) override
+  {
+    size_t const size = LZ4F_compressFrame(buffer_.data(), buffer_.size(), data, data_len, nullptr);
+    EXPECT_FALSE(LZ4F_isError(size)) << LZ4F_getErrorName(size);
+    return channel_.send(buffer_.data(), size);
+  }
+
+  bool is_open() const override { return true; }
+
+private:
+  Channel &channel_;
+  std::vector<u8> buffer_;
+};
+
+size_t flush_size()
+{
+  if (char const *env = getenv("COMPRESSION_BENCH_FLUSH_SIZE")) {
+    return strtoull(env, nullptr, 10);
+  }
+  return default_flush_size;
+}
+
+std::string read_file(char const *path)
+{
+  std::ifstream in(path, std::ios::binary);
+  EXPECT_TRUE(in) << "can't open " << path;
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+std::vector<std::string> cut_in_flushes(std::string_view data, size_t size)
+{
+  std::vector<std::string> flushes;
+  for (size_t offset = 0; offset < data.size(); offset += size) {
+    flushes.emplace_back(data.substr(offset, size));
+  }
+  return flushes;
+}
+
+// Trains a zstd dictionary on |samples|.
+std::string train_dictionary(std::vector<std::string> const &samples)
+{
+  std::string joined;
+  std::vector<size_t> sizes;
+  for (auto const &sample : samples) {
+    joined += sample;
+    sizes.push_back(sample.size());
+  }
+
+  std::string dictionary(dictionary_size, '\0');
+  size_t const size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), joined.data(), sizes.data(), sizes.size());
+  EXPECT_FALSE(ZDICT_isError(size)) << ZDICT_getErrorName(size);
+  dictionary.resize(ZDICT_isError(size) ? 0 : size);
+  return dictionary;
+}
+
+double mb_per_second(size_t bytes, std::chrono::steady_clock::duration elapsed)
+{
+  return bytes / std::chrono::duration<double>(elapsed).count() / 1e6;
+}
+
+// Compresses |flushes| through |channel| into |sink|, then decompresses them
+// with |decompressor|, and prints how that went.
+void measure(
+    char const *name,
+    std::vector<std::string> const &flushes,
+    Channel &channel,
+    SinkChannel &sink,
+    Decompressor &decompressor)
+{
+  size_t total = 0;
+  auto const compress_start = std::chrono::steady_clock::now();
+  for (auto const &flush : flushes) {
+    channel.send(flush);
+    total += flush.size();
+  }
+  auto const compress_elapsed = std::chrono::steady_clock::now() - compress_start;
+
+  size_t compressed = 0;
+  size_t decompressed = 0;
+  auto const decompress_start = std::chrono::steady_clock::now();
+  for (auto const &packet : sink.packets) {
+    compressed += packet.size();
+
+    // the output buffer holds one flush, so a packet is decompressed in one go
+    size_t consumed = 0;
+    size_t const res = decompressor.process(reinterpret_cast<u8 const *>(packet.data()), packet.size(), &consumed);
+    ASSERT_EQ(0u, res) << name << ": " << decompressor.error_name(res);
+    ASSERT_EQ(packet.size(), consumed) << name;
+    decompressed += decompressor.output_buf_size();
+    decompressor.discard(decompressor.output_buf_size());
+  }
+  auto const decompress_elapsed = std::chrono::steady_clock::now() - decompress_start;
+
+  EXPECT_EQ(total, decompressed) << name;
+
+  printf(
+      "%-20s ratio=%5.2f  compress=%7.1f MB/s  decompress=%7.1f MB/s\n",
+      name,
+      double(total) / compressed,
+      mb_per_second(total, compress_elapsed),
+      mb_per_second(total, decompress_elapsed));
+}
+
+} // namespace
+
+TEST(CompressionBench, Recording)
+{
+  char const *path = getenv("INTAKE_RECORDING");
+  if (!path || !*path) {
+    GTEST_SKIP() << "INTAKE_RECORDING not set";
+  }
+
+  std::string const recording = read_file(path);
+  size_t const size = flush_size();
+  auto const training = cut_in_flushes(std::string_view(recording).substr(0, recording.size() / 2), size);
+  auto const flushes = cut_in_flushes(std::string_view(recording).substr(recording.size() / 2), size);
+  ASSERT_FALSE(flushes.empty());
+
+  printf("%zu bytes in %zu flushes of %zu bytes\n", recording.size() - recording.size() / 2, flushes.size(), size);
+
+  {
+    SinkChannel sink;
+    Lz4FrameChannel channel(sink, size);
+    Lz4Decompressor decompressor(size);
+    measure("lz4 frame per flush", flushes, channel, sink, decompressor);
+  }
+
+  {
+    SinkChannel sink;
+    Lz4Channel channel(sink, size);
+    channel.set_compression(true);
+    Lz4Decompressor decompressor(size);
+    measure("lz4 stream", flushes, channel, sink, decompressor);
+  }
+
+  {
+    SinkChannel sink;
+    ZstdChannel channel(sink, size);
+    channel.set_compression(true);
+    ZstdDecompressor decompressor(size);
+    measure("zstd stream", flushes, channel, sink, decompressor);
+  }
+
+  char const *dictionary_path = getenv("ZSTD_DICTIONARY");
+  std::string const dictionary =
+      (dictionary_path && *dictionary_path) ? read_file(dictionary_path) : train_dictionary(training);
+  ASSERT_FALSE(dictionary.empty());
+
+  {
+    SinkChannel sink;
+    ZstdChannel channel(sink, size, dictionary);
+    channel.set_compression(true);
+    ZstdDecompressor decompressor(size, ZstdDecompressor::load_dictionary(dictionary));
+    measure("zstd stream + dict", flushes, channel, sink, decompressor);
+  }
+}
+
+} // namespace channel
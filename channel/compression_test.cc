@@ -0,0 +1,151 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <config.h>
+
+#include <channel/lz4_channel.h>
+#include <util/lz4_decompressor.h>
+
+#if ENABLE_ZSTD
+#include <channel/zstd_channel.h>
+#include <util/zstd_decompressor.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace channel {
+namespace {
+
+constexpr u32 max_data_length = 16 * 1024;
+
+// Keeps what is sent to it.
+class SinkChannel : public Channel {
+public:
+  std::error_code send(const u8 *data, int data_len) override
+  {
+    packets.emplace_back(reinterpret_cast<char const *>(data), data_len);
+    return {};
+  }
+
+  bool is_open() const override { return true; }
+
+  std::vector<std::string> packets;
+};
+
+// Something that looks like a batch of render messages: the same fields in
+// each, with values that vary.
+std::string make_batch(int i)
+{
+  std::string batch;
+  for (int j = 0; j < 20; ++j) {
+    u64 const hash = (i * 20 + j + 1) * 0x9e3779b97f4a7c15ull;
+    batch += "socket_stats pid=" + std::to_string(1000 + j) + " comm=nginx sk=" + std::to_string(hash) +
+             " bytes=" + std::to_string(hash >> 40) + ";";
+  }
+  return batch;
+}
+
+// Decompresses |packet| and checks it restores |batch|.
+void expect_decompresses(Decompressor &decompressor, std::string const &packet, std::string const &batch)
+{
+  size_t consumed = 0;
+  ASSERT_EQ(0u, decompressor.process(reinterpret_cast<u8 const *>(packet.data()), packet.size(), &consumed));
+  EXPECT_EQ(packet.size(), consumed);
+
+  ASSERT_EQ(batch.size(), decompressor.output_buf_size());
+  EXPECT_EQ(batch, std::string(reinterpret_cast<char const *>(decompressor.output_buf()), decompressor.output_buf_size()));
+  decompressor.discard(decompressor.output_buf_size());
+}
+
+} // namespace
+
+TEST(CompressionTest, Lz4Stream)
+{
+  SinkChannel sink;
+  Lz4Channel lz4_channel(sink, max_data_length);
+  Channel &channel = lz4_channel;
+
+  channel.send(std::string_view("uncompressed"));
+  ASSERT_EQ(1u, sink.packets.size());
+  EXPECT_EQ("uncompressed", sink.packets[0]);
+
+  lz4_channel.set_compression(true);
+
+  std::vector<std::string> batches;
+  for (int i = 0; i < 50; ++i) {
+    batches.push_back(make_batch(i));
+    channel.send(batches.back());
+  }
+  ASSERT_EQ(1 + batches.size(), sink.packets.size());
+
+  // each packet is decompressed as soon as it's received
+  Lz4Decompressor decompressor(max_data_length);
+  for (size_t i = 0; i < batches.size(); ++i) {
+    expect_decompresses(decompressor, sink.packets[1 + i], batches[i]);
+  }
+
+  // a repeated batch compresses against the earlier packets
+  channel.send(batches.back());
+  expect_decompresses(decompressor, sink.packets.back(), batches.back());
+  EXPECT_LT(sink.packets.back().size() * 4, sink.packets[batches.size()].size());
+
+  // re-enabling compression, as a new connection does, starts a new frame
+  lz4_channel.set_compression(false);
+  lz4_channel.set_compression(true);
+  sink.packets.clear();
+  channel.send(batches[0]);
+
+  Lz4Decompressor new_decompressor(max_data_length);
+  expect_decompresses(new_decompressor, sink.packets[0], batches[0]);
+}
+
+#if ENABLE_ZSTD
+TEST(CompressionTest, ZstdStream)
+{
+  // a dictionary of raw content from typical messages
+  std::string const dictionary = make_batch(1000) + make_batch(2000);
+
+  for (bool const use_dictionary : {false, true}) {
+    SinkChannel sink;
+    ZstdChannel zstd_channel(sink, max_data_length, use_dictionary ? dictionary : std::string());
+    zstd_channel.set_compression(true);
+    Channel &channel = zstd_channel;
+
+    std::vector<std::string> batches;
+    for (int i = 0; i < 50; ++i) {
+      batches.push_back(make_batch(i));
+      channel.send(batches.back());
+    }
+    ASSERT_EQ(batches.size(), sink.packets.size());
+
+    ASSERT_GE(sink.packets[0].size(), ZstdDecompressor::magic_size);
+    EXPECT_TRUE(ZstdDecompressor::is_zstd_stream(reinterpret_cast<u8 const *>(sink.packets[0].data())));
+
+    ZstdDecompressor decompressor(
+        max_data_length, use_dictionary ? ZstdDecompressor::load_dictionary(dictionary) : ZstdDecompressor::Dictionary());
+    for (size_t i = 0; i < batches.size(); ++i) {
+      expect_decompresses(decompressor, sink.packets[i], batches[i]);
+    }
+
+    channel.send(batches.back());
+    expect_decompresses(decompressor, sink.packets.back(), batches.back());
+    EXPECT_LT(sink.packets.back().size() * 4, sink.packets[batches.size() - 1].size());
+  }
+}
+
+TEST(CompressionTest, TellsCodecsApart)
+{
+  SinkChannel sink;
+  Lz4Channel lz4_channel(sink, max_data_length);
+  lz4_channel.set_compression(true);
+  static_cast<Channel &>(lz4_channel).send(make_batch(0));
+
+  ASSERT_GE(sink.packets[0].size(), ZstdDecompressor::magic_size);
+  EXPECT_FALSE(ZstdDecompressor::is_zstd_stream(reinterpret_cast<u8 const *>(sink.packets[0].data())));
+}
+#endif // ENABLE_ZSTD
+
+} // namespace channel
@@ -20,6 +20,9 @@ public:
 
   bool is_open() const override { return first_.is_open() && second_.is_open(); }
 
+  bool is_congested() const override { return first_.is_congested(); }
+  bool is_full() const override { return first_.is_full(); }
+
 private:
   Channel &first_;
   Channel &second_;
@@ -57,4 +57,14 @@ public:
   virtual u32 buf_size() const = 0;
 
   virtual bool is_writable() const = 0;
+
+  // Whether data is written faster than it can be sent, so data that is fine
+  // to lose should be held back.
+  //
+  virtual bool is_congested() const { return false; }
+
+  // Whether the channel can't take more data for now, so only data that can't
+  // be lost should be written.
+  //
+  virtual bool is_full() const { return false; }
 };
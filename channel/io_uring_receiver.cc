@@ -0,0 +1,464 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <channel/io_uring_receiver.h>
+
+#include <util/defer.h>
+#include <util/log.h>
+#include <util/log_formatters.h>
+#include <util/uv_helpers.h>
+
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+namespace channel {
+
+namespace {
+
+constexpr u32 submission_queue_entries = 256;
+constexpr u32 min_completion_queue_entries = 1024;
+constexpr u16 buffer_group = 0;
+
+std::error_code last_error()
+{
+  return {errno, std::generic_category()};
+}
+
+int io_uring_setup(u32 entries, io_uring_params *params)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int fd, u32 to_submit, u32 min_complete, u32 flags)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int io_uring_register(int fd, u32 opcode, void *arg, u32 nr_args)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+template <typename T> T *at_offset(void *base, u32 offset)
+{
+  return reinterpret_cast<T *>(reinterpret_cast<u8 *>(base) + offset);
+}
+
+} // namespace
+
+Expected<std::unique_ptr<IoUringReceiver>, std::error_code>
+IoUringReceiver::create(uv_loop_t &loop, u32 buffer_count, u32 buffer_size)
+{
+  std::unique_ptr<IoUringReceiver> receiver(new IoUringReceiver(loop));
+
+  if (auto const error = receiver->init(buffer_count, buffer_size)) {
+    return {unexpected, error};
+  }
+
+  if (auto const error = receiver->probe()) {
+    return {unexpected, error};
+  }
+
+  CHECK_UV(uv_prepare_init(&loop, &receiver->prepare_));
+  receiver->prepare_.data = receiver.get();
+  CHECK_UV(uv_poll_init(&loop, &receiver->poll_, receiver->event_fd_));
+  receiver->poll_.data = receiver.get();
+  receiver->handles_initialized_ = true;
+  CHECK_UV(uv_poll_start(&receiver->poll_, UV_READABLE, poll_cb));
+  receiver->update_loop_ref();
+
+  return std::move(receiver);
+}
+
+IoUringReceiver::IoUringReceiver(uv_loop_t &loop) : loop_(loop) {}
+
+IoUringReceiver::~IoUringReceiver()
+{
+  if (handles_initialized_) {
+    if (!uv_is_closing(reinterpret_cast<uv_handle_t *>(&prepare_))) {
+      uv_close(reinterpret_cast<uv_handle_t *>(&prepare_), nullptr);
+    }
+    if (!uv_is_closing(reinterpret_cast<uv_handle_t *>(&poll_))) {
+      uv_close(reinterpret_cast<uv_handle_t *>(&poll_), nullptr);
+    }
+  }
+
+  // closing the ring cancels the receives still armed
+  if (ring_fd_ >= 0) {
+    ::close(ring_fd_);
+  }
+  if (event_fd_ >= 0) {
+    ::close(event_fd_);
+  }
+
+  if (rings_) {
+    ::munmap(rings_, rings_size_);
+  }
+  if (sqes_) {
+    ::munmap(sqes_, sqes_size_);
+  }
+  if (buf_ring_) {
+    ::munmap(buf_ring_, buf_ring_size_);
+  }
+  if (buffers_) {
+    ::munmap(buffers_, std::size_t(buffer_count_) * buffer_size_);
+  }
+}
+
+std::error_code IoUringReceiver::init(u32 buffer_count, u32 buffer_size)
+{
+  assert(buffer_count && !(buffer_count & (buffer_count - 1)));
+
+  io_uring_params params = {};
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = std::max(min_completion_queue_entries, 4 * buffer_count);
+
+  ring_fd_ = io_uring_setup(submission_queue_entries, &params);
+  if (ring_fd_ < 0) {
+    return last_error();
+  }
+
+  // queues are mapped separately on kernels before 5.4, way too old anyway
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+    return std::make_error_code(std::errc::not_supported);
+  }
+
+  rings_size_ = std::max(
+      params.sq_off.array + params.sq_entries * sizeof(u32), params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+  void *rings = ::mmap(nullptr, rings_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (rings == MAP_FAILED) {
+    return last_error();
+  }
+  rings_ = rings;
+
+  sq_head_ = at_offset<u32>(rings_, params.sq_off.head);
+  sq_tail_ = at_offset<u32>(rings_, params.sq_off.tail);
+  sq_flags_ = at_offset<u32>(rings_, params.sq_off.flags);
+  sq_array_ = at_offset<u32>(rings_, params.sq_off.array);
+  sq_mask_ = *at_offset<u32>(rings_, params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  sq_local_tail_ = *sq_tail_;
+
+  cq_head_ = at_offset<u32>(rings_, params.cq_off.head);
+  cq_tail_ = at_offset<u32>(rings_, params.cq_off.tail);
+  cq_mask_ = *at_offset<u32>(rings_, params.cq_off.ring_mask);
+  cqes_ = at_offset<io_uring_cqe>(rings_, params.cq_off.cqes);
+
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return last_error();
+  }
+  sqes_ = reinterpret_cast<io_uring_sqe *>(sqes);
+
+  buffer_count_ = buffer_count;
+  buffer_size_ = buffer_size;
+
+  void *buffers = ::mmap(
+      nullptr, std::size_t(buffer_count) * buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buffers == MAP_FAILED) {
+    return last_error();
+  }
+  buffers_ = reinterpret_cast<u8 *>(buffers);
+
+  // the kernel wants the buffer ring page-aligned, which mmap guarantees
+  buf_ring_size_ = buffer_count * sizeof(io_uring_buf);
+  void *buf_ring = ::mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buf_ring == MAP_FAILED) {
+    return last_error();
+  }
+  buf_ring_ = reinterpret_cast<io_uring_buf *>(buf_ring);
+
+  io_uring_buf_reg reg = {};
+  reg.ring_addr = reinterpret_cast<u64>(buf_ring_);
+  reg.ring_entries = buffer_count;
+  reg.bgid = buffer_group;
+  if (io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+    return last_error();
+  }
+
+  for (u32 bid = 0; bid < buffer_count; ++bid) {
+    recycle_buffer(bid);
+  }
+  publish_buffers();
+
+  event_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd_ < 0) {
+    return last_error();
+  }
+  if (io_uring_register(ring_fd_, IORING_REGISTER_EVENTFD, &event_fd_, 1) < 0) {
+    return last_error();
+  }
+
+  return {};
+}
+
+std::error_code IoUringReceiver::probe()
+{
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+    return last_error();
+  }
+  Defer close_fds([&fds] {
+    ::close(fds[0]);
+    ::close(fds[1]);
+  });
+
+  struct ProbeHandler : Handler {
+    void on_receive(u8 const *data, u32 len) override { received += len; }
+    void on_receive_error(int error) override { failure = error; }
+
+    u32 received = 0;
+    int failure = 0;
+  } handler;
+
+  u8 const byte = 0;
+  if (::write(fds[1], &byte, sizeof(byte)) != sizeof(byte)) {
+    return last_error();
+  }
+
+  // kernels without multishot receive reject it right away
+  auto const id = start(fds[0], handler);
+  submit(1);
+  reap();
+  stop(id);
+  submit();
+
+  if (handler.failure) {
+    return {-handler.failure, std::generic_category()};
+  }
+  if (handler.received != sizeof(byte)) {
+    return std::make_error_code(std::errc::not_supported);
+  }
+
+  return {};
+}
+
+u64 IoUringReceiver::start(int fd, Handler &handler)
+{
+  auto const id = next_id_++;
+  receives_.emplace(id, Receive{.fd = fd, .handler = &handler});
+  update_loop_ref();
+  arm(id, fd);
+  return id;
+}
+
+void IoUringReceiver::stop(u64 id)
+{
+  if (!receives_.erase(id)) {
+    return;
+  }
+  update_loop_ref();
+
+  // completions that come in the meantime are ignored
+  if (auto sqe = next_sqe()) {
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = id;
+    sqe->user_data = 0;
+  }
+}
+
+io_uring_sqe *IoUringReceiver::next_sqe()
+{
+  if (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+    submit();
+    if (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+      LOG::error("IoUringReceiver: submission queue full");
+      return nullptr;
+    }
+  }
+
+  u32 const index = sq_local_tail_ & sq_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  ++sq_local_tail_;
+  ++to_submit_;
+
+  if (handles_initialized_ && !uv_is_active(reinterpret_cast<uv_handle_t *>(&prepare_))) {
+    uv_prepare_start(&prepare_, prepare_cb);
+  }
+
+  return sqe;
+}
+
+void IoUringReceiver::arm(u64 id, int fd)
+{
+  auto sqe = next_sqe();
+  if (!sqe) {
+    auto const it = receives_.find(id);
+    auto handler = it->second.handler;
+    receives_.erase(it);
+    update_loop_ref();
+    handler->on_receive_error(UV_ENOBUFS);
+    return;
+  }
+
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = fd;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = buffer_group;
+  sqe->user_data = id;
+}
+
+void IoUringReceiver::submit(u32 wait_for)
+{
+  if (!to_submit_ && !wait_for) {
+    return;
+  }
+
+  __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+
+  int res;
+  do {
+    res = io_uring_enter(ring_fd_, to_submit_, wait_for, wait_for ? IORING_ENTER_GETEVENTS : 0);
+  } while (res < 0 && errno == EINTR);
+
+  if (res < 0) {
+    // what wasn't submitted is retried with the next submission
+    LOG::error("IoUringReceiver: failed to submit {} entries: {}", to_submit_, last_error());
+    return;
+  }
+
+  to_submit_ -= std::min<u32>(res, to_submit_);
+}
+
+void IoUringReceiver::reap()
+{
+  for (;;) {
+    u32 head = *cq_head_;
+    u32 tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      // completions the queue had no room for are flushed on request
+      if (!(__atomic_load_n(sq_flags_, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW)) {
+        break;
+      }
+      io_uring_enter(ring_fd_, 0, 0, IORING_ENTER_GETEVENTS);
+      continue;
+    }
+
+    for (; head != tail; ++head) {
+      handle_completion(cqes_[head & cq_mask_]);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  }
+
+  publish_buffers();
+
+  std::vector<u64> starved;
+  std::swap(starved, starved_);
+  for (auto const id : starved) {
+    if (auto const it = receives_.find(id); it != receives_.end()) {
+      arm(id, it->second.fd);
+    }
+  }
+}
+
+void IoUringReceiver::handle_completion(io_uring_cqe const &cqe)
+{
+  bool const has_buffer = cqe.flags & IORING_CQE_F_BUFFER;
+  u16 const bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+  Defer recycle([&] {
+    if (has_buffer) {
+      recycle_buffer(bid);
+    }
+  });
+
+  auto const id = cqe.user_data;
+  auto const it = receives_.find(id);
+  if (it == receives_.end()) {
+    // cancellation, or a receive already stopped
+    return;
+  }
+
+  auto const receive = it->second;
+  bool const more = cqe.flags & IORING_CQE_F_MORE;
+
+  if (cqe.res > 0) {
+    assert(has_buffer);
+    receive.handler->on_receive(buffers_ + std::size_t(bid) * buffer_size_, cqe.res);
+
+    // the kernel can end a multishot receive, e.g. on a full completion queue
+    if (!more && receives_.count(id)) {
+      arm(id, receive.fd);
+    }
+  } else if (cqe.res == -ENOBUFS) {
+    starved_.push_back(id);
+  } else {
+    if (more) {
+      stop(id);
+    } else {
+      receives_.erase(it);
+      update_loop_ref();
+    }
+    receive.handler->on_receive_error(cqe.res == 0 ? UV_EOF : cqe.res);
+  }
+}
+
+void IoUringReceiver::recycle_buffer(u16 bid)
+{
+  // fields are set one by one: the ring's tail overlays the first entry
+  io_uring_buf &buf = buf_ring_[buf_local_tail_ & (buffer_count_ - 1)];
+  buf.addr = reinterpret_cast<u64>(buffers_ + std::size_t(bid) * buffer_size_);
+  buf.len = buffer_size_;
+  buf.bid = bid;
+  ++buf_local_tail_;
+}
+
+void IoUringReceiver::publish_buffers()
+{
+  // the tail is the first entry's reserved field; io_uring_buf_ring isn't
+  // used since its flexible array member is laid out differently in C++
+  __atomic_store_n(&buf_ring_[0].resv, buf_local_tail_, __ATOMIC_RELEASE);
+}
+
+void IoUringReceiver::update_loop_ref()
+{
+  if (!handles_initialized_) {
+    return;
+  }
+
+  // like libuv streams, the ring only keeps the loop alive while receiving
+  auto const handle = reinterpret_cast<uv_handle_t *>(&poll_);
+  if (receives_.empty()) {
+    uv_unref(handle);
+  } else {
+    uv_ref(handle);
+  }
+}
+
+void IoUringReceiver::prepare_cb(uv_prepare_t *handle)
+{
+  auto receiver = reinterpret_cast<IoUringReceiver *>(handle->data);
+  receiver->submit();
+  uv_prepare_stop(handle);
+}
+
+void IoUringReceiver::poll_cb(uv_poll_t *handle, int status, int events)
+{
+  auto receiver = reinterpret_cast<IoUringReceiver *>(handle->data);
+
+  if (status < 0) {
+    LOG::error("IoUringReceiver: failed to poll the ring's eventfd: {}", uv_error_t{status});
+    return;
+  }
+
+  u64 count;
+  while (::read(receiver->event_fd_, &count, sizeof(count)) > 0) {
+  }
+
+  receiver->reap();
+}
+
+} // namespace channel
@@ -0,0 +1,159 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <platform/types.h>
+#include <util/expected.h>
+
+#include <uv.h>
+
+#include <memory>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf;
+
+namespace channel {
+
+// Receives from sockets through io_uring instead of libuv, for loops that
+// serve many connections.
+//
+// Each socket gets a multishot receive on a ring shared by the loop: the
+// kernel puts each chunk of data it receives in a buffer it picks from a
+// registered ring of provided buffers, and the socket's Handler is given the
+// data straight from that buffer, which goes back to the kernel once the
+// handler returns. Submissions are batched and made once per loop iteration,
+// and completions are reaped when the ring's eventfd, polled on the loop, is
+// signaled.
+//
+// Requires multishot receive with provided buffer rings (Linux 6.0): create()
+// fails on kernels without them, so that callers can fall back to libuv.
+//
+// This class is NOT thread safe: it must be used from its loop's thread.
+class IoUringReceiver {
+public:
+  class Handler {
+  public:
+    virtual ~Handler() {}
+
+    // Data received. |data| is only valid for the duration of the call.
+    virtual void on_receive(u8 const *data, u32 len) = 0;
+
+    // The receive failed with |error|, a libuv error code (UV_EOF once the
+    // peer closed the connection), and was stopped.
+    virtual void on_receive_error(int error) = 0;
+  };
+
+  static constexpr u32 default_buffer_count = 256;
+  static constexpr u32 default_buffer_size = 16 * 1024;
+
+  // Sets up a ring on |loop| with |buffer_count| buffers, a power of 2, of
+  // |buffer_size| bytes each, or returns why io_uring can't be used.
+  static Expected<std::unique_ptr<IoUringReceiver>, std::error_code>
+  create(uv_loop_t &loop, u32 buffer_count = default_buffer_count, u32 buffer_size = default_buffer_size);
+
+  ~IoUringReceiver();
+
+  IoUringReceiver(IoUringReceiver const &) = delete;
+  IoUringReceiver &operator=(IoUringReceiver const &) = delete;
+
+  // Starts receiving from |fd| into |handler|, until stop() is called or the
+  // handler is told about an error. Returns an id for stop().
+  u64 start(int fd, Handler &handler);
+
+  // Stops a receive started with start(). Its handler isn't called anymore,
+  // and can be destroyed right away.
+  void stop(u64 id);
+
+  // Number of receives started and not stopped.
+  std::size_t receive_count() const { return receives_.size(); }
+
+private:
+  struct Receive {
+    int fd;
+    Handler *handler;
+  };
+
+  explicit IoUringReceiver(uv_loop_t &loop);
+
+  std::error_code init(u32 buffer_count, u32 buffer_size);
+
+  // Checks that a multishot receive works, by receiving from a socket pair.
+  std::error_code probe();
+
+  // Returns a cleared submission queue entry, submitting what is queued if
+  // the queue is full.
+  io_uring_sqe *next_sqe();
+
+  void arm(u64 id, int fd);
+
+  // Submits what's queued, waiting for |wait_for| completions.
+  void submit(u32 wait_for = 0);
+
+  // Handles the completions posted so far.
+  void reap();
+
+  void handle_completion(io_uring_cqe const &cqe);
+
+  // Hands buffer |bid| back; it's published to the kernel by reap().
+  void recycle_buffer(u16 bid);
+
+  // Makes the buffers handed back available to the kernel.
+  void publish_buffers();
+
+  // Keeps the loop alive while there are receives, and only then.
+  void update_loop_ref();
+
+  static void prepare_cb(uv_prepare_t *handle);
+  static void poll_cb(uv_poll_t *handle, int status, int events);
+
+  uv_loop_t &loop_;
+  int ring_fd_ = -1;
+  int event_fd_ = -1;
+
+  // submission and completion queues, which share a mapping
+  void *rings_ = nullptr;
+  std::size_t rings_size_ = 0;
+  u32 *sq_head_ = nullptr;
+  u32 *sq_tail_ = nullptr;
+  u32 *sq_flags_ = nullptr;
+  u32 *sq_array_ = nullptr;
+  u32 sq_mask_ = 0;
+  u32 sq_entries_ = 0;
+  io_uring_sqe *sqes_ = nullptr;
+  std::size_t sqes_size_ = 0;
+  // entries queued but not submitted yet
+  u32 sq_local_tail_ = 0;
+  u32 to_submit_ = 0;
+
+  u32 *cq_head_ = nullptr;
+  u32 *cq_tail_ = nullptr;
+  u32 cq_mask_ = 0;
+  io_uring_cqe *cqes_ = nullptr;
+
+  // provided buffers
+  io_uring_buf *buf_ring_ = nullptr;
+  std::size_t buf_ring_size_ = 0;
+  u32 buffer_count_ = 0;
+  u32 buffer_size_ = 0;
+  u8 *buffers_ = nullptr;
+  // buffers handed back, not yet published to the kernel
+  u16 buf_local_tail_ = 0;
+
+  std::unordered_map<u64, Receive> receives_;
+  u64 next_id_ = 1;
+  // receives that ran out of buffers, to re-arm once buffers are handed back
+  std::vector<u64> starved_;
+
+  uv_prepare_t prepare_;
+  uv_poll_t poll_;
+  bool handles_initialized_ = false;
+};
+
+} // namespace channel
@@ -0,0 +1,197 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+// Receive benchmark: messages per second and loop thread CPU time of a loop
+// serving many TCP connections, receiving through libuv and through
+// IoUringReceiver.
+//
+// Not part of the unit test suite; run manually:
+//   io_uring_receiver_bench [--gtest_filter=...]
+//
+// IO_URING_BENCH_CONNECTIONS (1000 by default) connections each get
+// IO_URING_BENCH_MESSAGES (1000 by default) messages of IO_URING_BENCH_SIZE
+// bytes (64 by default), written in batches of 16 messages by a writer
+// thread going round the connections.
+
+#include <channel/io_uring_receiver.h>
+#include <channel/tcp_channel.h>
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace channel {
+
+namespace {
+
+constexpr u32 messages_per_write = 16;
+
+u64 env_or(char const *name, u64 fallback)
+{
+  if (char const *env = getenv(name)) {
+    return strtoull(env, nullptr, 10);
+  }
+  return fallback;
+}
+
+// Counts messages framed by their length, as a u32.
+struct CountingCallbacks : Callbacks {
+  u32 received_data(u8 const *data, int length) override
+  {
+    u32 consumed = 0;
+    while (length - consumed >= sizeof(u32)) {
+      u32 message_length;
+      memcpy(&message_length, data + consumed, sizeof(message_length));
+      if (length - consumed - sizeof(u32) < message_length) {
+        break;
+      }
+      consumed += sizeof(u32) + message_length;
+      ++*messages;
+    }
+    return consumed;
+  }
+
+  void on_error(int error) override { ADD_FAILURE() << "receive failed: " << error; }
+
+  u64 *messages;
+};
+
+double thread_cpu_seconds()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_THREAD, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// Receives on |loop|, through |receiver| unless null, and prints how that went.
+void measure(char const *name, uv_loop_t &loop, IoUringReceiver *receiver)
+{
+  u64 const connection_count = env_or("IO_URING_BENCH_CONNECTIONS", 1000);
+  u64 const message_count = env_or("IO_URING_BENCH_MESSAGES", 1000);
+  u64 const message_size = env_or("IO_URING_BENCH_SIZE", 64);
+
+  int const listener = ::socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_LE(0, listener);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(0, ::bind(listener, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)));
+  ASSERT_EQ(0, ::listen(listener, 128));
+  ASSERT_EQ(0, ::getsockname(listener, reinterpret_cast<struct sockaddr *>(&addr), &len));
+
+  u64 received = 0;
+  CountingCallbacks callbacks;
+  callbacks.messages = &received;
+
+  std::vector<int> clients;
+  std::vector<std::unique_ptr<TCPChannel>> servers;
+  for (u64 i = 0; i < connection_count; ++i) {
+    int const client = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_LE(0, client) << "raise the open files limit for more connections";
+    ASSERT_EQ(0, ::connect(client, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)));
+    int const server_fd = ::accept(listener, nullptr, nullptr);
+    ASSERT_LE(0, server_fd);
+    clients.push_back(client);
+
+    servers.push_back(std::make_unique<TCPChannel>(loop));
+    servers.back()->open_fd(callbacks, server_fd, receiver);
+  }
+  ::close(listener);
+
+  u32 const length = message_size;
+  std::string message(reinterpret_cast<char const *>(&length), sizeof(length));
+  message.resize(sizeof(length) + message_size, 'x');
+  std::string batch;
+  for (u32 i = 0; i < messages_per_write; ++i) {
+    batch += message;
+  }
+
+  // messages are written in whole batches
+  u64 const rounds = (message_count + messages_per_write - 1) / messages_per_write;
+  u64 const expected = connection_count * rounds * messages_per_write;
+  auto const start = std::chrono::steady_clock::now();
+  double const cpu_start = thread_cpu_seconds();
+
+  std::thread writer([&] {
+    for (u64 round = 0; round < rounds; ++round) {
+      for (int client : clients) {
+        for (std::size_t offset = 0; offset < batch.size();) {
+          auto const written = ::write(client, batch.data() + offset, batch.size() - offset);
+          if (written <= 0) {
+            return;
+          }
+          offset += written;
+        }
+      }
+    }
+  });
+
+  while (received < expected) {
+    uv_run(&loop, UV_RUN_ONCE);
+  }
+
+  double const cpu = thread_cpu_seconds() - cpu_start;
+  double const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  writer.join();
+
+  printf(
+      "%-10s %8.0f Kmsg/s  %7.1f MB/s  loop cpu=%5.2fs (%3.0f%% of %5.2fs)\n",
+      name,
+      received / elapsed / 1e3,
+      received * (sizeof(length) + message_size) / elapsed / 1e6,
+      cpu,
+      100 * cpu / elapsed,
+      elapsed);
+
+  for (int client : clients) {
+    ::close(client);
+  }
+  for (auto &server : servers) {
+    server->close_permanently();
+  }
+  uv_run(&loop, UV_RUN_DEFAULT);
+}
+
+} // namespace
+
+TEST(IoUringReceiverBench, Libuv)
+{
+  uv_loop_t loop;
+  ASSERT_EQ(0, uv_loop_init(&loop));
+  measure("libuv", loop, nullptr);
+  EXPECT_EQ(0, uv_loop_close(&loop));
+}
+
+TEST(IoUringReceiverBench, IoUring)
+{
+  uv_loop_t loop;
+  ASSERT_EQ(0, uv_loop_init(&loop));
+
+  auto receiver = IoUringReceiver::create(loop);
+  if (!receiver) {
+    uv_loop_close(&loop);
+    GTEST_SKIP() << "io_uring not available: " << receiver.error().message();
+  }
+
+  measure("io_uring", loop, receiver->get());
+
+  receiver->reset();
+  uv_run(&loop, UV_RUN_DEFAULT);
+  EXPECT_EQ(0, uv_loop_close(&loop));
+}
+
+} // namespace channel
@@ -0,0 +1,205 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <channel/io_uring_receiver.h>
+#include <channel/tcp_channel.h>
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace channel {
+namespace {
+
+// Messages are framed by their length, as a u32.
+std::string frame(std::string const &message)
+{
+  u32 const length = message.size();
+  return std::string(reinterpret_cast<char const *>(&length), sizeof(length)) + message;
+}
+
+struct FramedCallbacks : Callbacks {
+  u32 received_data(u8 const *data, int length) override
+  {
+    u32 consumed = 0;
+    while (length - consumed >= sizeof(u32)) {
+      u32 message_length;
+      memcpy(&message_length, data + consumed, sizeof(message_length));
+      if (length - consumed - sizeof(u32) < message_length) {
+        break;
+      }
+      messages.emplace_back(reinterpret_cast<char const *>(data + consumed + sizeof(u32)), message_length);
+      consumed += sizeof(u32) + message_length;
+    }
+    return consumed;
+  }
+
+  void on_error(int error) override { last_error = error; }
+
+  void on_closed() override { closed = true; }
+
+  std::vector<std::string> messages;
+  int last_error = 0;
+  bool closed = false;
+};
+
+// A server channel receiving through io_uring from a client socket.
+class IoUringReceiverTest : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    ASSERT_EQ(0, uv_loop_init(&loop_));
+
+    auto receiver = IoUringReceiver::create(loop_);
+    if (!receiver) {
+      uv_loop_close(&loop_);
+      GTEST_SKIP() << "io_uring not available: " << receiver.error().message();
+    }
+    receiver_ = std::move(*receiver);
+
+    int const listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_LE(0, listener);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(0, ::bind(listener, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)));
+    ASSERT_EQ(0, ::listen(listener, 1));
+    ASSERT_EQ(0, ::getsockname(listener, reinterpret_cast<struct sockaddr *>(&addr), &len));
+
+    client_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(0, ::connect(client_, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)));
+    int const server_fd = ::accept(listener, nullptr, nullptr);
+    ASSERT_LE(0, server_fd);
+    ::close(listener);
+
+    server_ = std::make_unique<TCPChannel>(loop_);
+    server_->open_fd(callbacks_, server_fd, receiver_.get());
+    EXPECT_EQ(1u, receiver_->receive_count());
+  }
+
+  void TearDown() override
+  {
+    if (!receiver_) {
+      return;
+    }
+
+    if (client_ >= 0) {
+      ::close(client_);
+    }
+
+    server_->close_permanently();
+    uv_run(&loop_, UV_RUN_DEFAULT);
+    EXPECT_TRUE(callbacks_.closed);
+    EXPECT_EQ(0u, receiver_->receive_count());
+
+    server_.reset();
+    receiver_.reset();
+    uv_run(&loop_, UV_RUN_DEFAULT);
+    EXPECT_EQ(0, uv_loop_close(&loop_));
+  }
+
+  void send(std::string const &data)
+  {
+    for (std::size_t offset = 0; offset < data.size();) {
+      auto const written = ::write(client_, data.data() + offset, data.size() - offset);
+      ASSERT_LT(0, written);
+      offset += written;
+    }
+  }
+
+  void wait_for_messages(std::size_t count)
+  {
+    while (callbacks_.messages.size() < count) {
+      ASSERT_EQ(0, callbacks_.last_error);
+      uv_run(&loop_, UV_RUN_ONCE);
+    }
+  }
+
+  uv_loop_t loop_;
+  std::unique_ptr<IoUringReceiver> receiver_;
+  FramedCallbacks callbacks_;
+  std::unique_ptr<TCPChannel> server_;
+  int client_ = -1;
+};
+
+} // namespace
+
+TEST_F(IoUringReceiverTest, ReceivesInOrder)
+{
+  std::vector<std::string> sent;
+  for (int i = 0; i < 1000; ++i) {
+    sent.push_back(std::to_string(i) + std::string(i * 7 % 3000, 'x'));
+    send(frame(sent.back()));
+  }
+
+  wait_for_messages(sent.size());
+  EXPECT_EQ(sent, callbacks_.messages);
+}
+
+TEST_F(IoUringReceiverTest, KeepsPartialMessages)
+{
+  // larger than a receive buffer
+  std::string const large(3 * IoUringReceiver::default_buffer_size, 'l');
+  send(frame(large));
+  wait_for_messages(1);
+  EXPECT_EQ(large, callbacks_.messages[0]);
+
+  std::string const framed = frame("split in two writes");
+  send(framed.substr(0, 7));
+  for (int i = 0; i < 10; ++i) {
+    uv_run(&loop_, UV_RUN_NOWAIT);
+  }
+  EXPECT_EQ(1u, callbacks_.messages.size());
+
+  send(framed.substr(7));
+  wait_for_messages(2);
+  EXPECT_EQ("split in two writes", callbacks_.messages[1]);
+}
+
+TEST_F(IoUringReceiverTest, KeepsDataWhilePaused)
+{
+  server_->pause_reading();
+  send(frame("held"));
+  for (int i = 0; i < 10; ++i) {
+    uv_run(&loop_, UV_RUN_NOWAIT);
+  }
+  EXPECT_TRUE(callbacks_.messages.empty());
+
+  server_->resume_reading();
+  wait_for_messages(1);
+  EXPECT_EQ("held", callbacks_.messages[0]);
+}
+
+TEST_F(IoUringReceiverTest, ReportsEof)
+{
+  ::close(client_);
+  client_ = -1;
+
+  while (!callbacks_.last_error) {
+    uv_run(&loop_, UV_RUN_ONCE);
+  }
+  EXPECT_EQ(UV_EOF, callbacks_.last_error);
+  EXPECT_EQ(0u, receiver_->receive_count());
+}
+
+TEST_F(IoUringReceiverTest, StopsOnClose)
+{
+  server_->close_permanently();
+  EXPECT_EQ(0u, receiver_->receive_count());
+
+  // data arriving once closed is dropped
+  send(frame("too late"));
+  uv_run(&loop_, UV_RUN_DEFAULT);
+  EXPECT_TRUE(callbacks_.messages.empty());
+}
+
+} // namespace channel
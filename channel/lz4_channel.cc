@@ -6,8 +6,16 @@
 
 namespace channel {
 
+// Linked blocks, flushed on every update.
+const LZ4F_preferences_t Lz4Channel::preferences_ = {
+    .frameInfo = {.blockSizeID = LZ4F_max64KB, .blockMode = LZ4F_blockLinked},
+    .autoFlush = 1,
+};
+
 Lz4Channel::Lz4Channel(Channel &channel, u32 max_data_length)
-    : compression_enabled_(false), channel_(channel), buffer_(LZ4F_compressBound(max_data_length, NULL) + LZ4F_HEADER_SIZE_MAX)
+    : compression_enabled_(false),
+      channel_(channel),
+      max_packet_length_(LZ4F_compressBound(max_data_length, &preferences_) + LZ4F_HEADER_SIZE_MAX)
 {
   if (LZ4F_cctx *lz4_context = nullptr; LZ4F_isError(LZ4F_createCompressionContext(&lz4_context, LZ4F_VERSION))) {
     throw std::runtime_error("Lz4Channel: Failed to create LZ4 context.");
@@ -19,6 +27,7 @@ Lz4Channel::Lz4Channel(Channel &channel, u32 max_data_length)
 void Lz4Channel::set_compression(bool enabled)
 {
   compression_enabled_ = enabled;
+  frame_started_ = false;
 }
 
 #define _CHECK_LZ4_ERROR(code)                                                                                                 \
@@ -32,22 +41,26 @@ std::error_code Lz4Channel::send(const u8 *data, int data_len)
     return channel_.send(data, data_len);
   }
 
-  // Reference: https://github.com/lz4/lz4/blob/dev/lib/lz4frame.h#L248
-  size_t tail = 0;
-  size_t res = LZ4F_compressBegin(lz4_ctx_.get(), (void *)buffer_.data(), buffer_.size(), NULL);
-  _CHECK_LZ4_ERROR(res);
-  tail += res;
+  return channel_.send_in_place(max_packet_length_, [&](u8 *buffer) {
+    // Reference: https://github.com/lz4/lz4/blob/dev/lib/lz4frame.h#L248
+    size_t tail = 0;
+    size_t res = 0;
 
-  res =
-      LZ4F_compressUpdate(lz4_ctx_.get(), (void *)(buffer_.data() + tail), buffer_.size() - tail, (void *)data, data_len, NULL);
-  _CHECK_LZ4_ERROR(res);
-  tail += res;
+    if (!frame_started_) {
+      // the frame is never ended: packets keep being appended to it until
+      // compression is reset, when a new connection starts
+      res = LZ4F_compressBegin(lz4_ctx_.get(), (void *)buffer, max_packet_length_, &preferences_);
+      _CHECK_LZ4_ERROR(res);
+      tail += res;
+      frame_started_ = true;
+    }
 
-  res = LZ4F_compressEnd(lz4_ctx_.get(), (void *)(buffer_.data() + tail), buffer_.size() - tail, NULL);
-  _CHECK_LZ4_ERROR(res);
-  tail += res;
+    res = LZ4F_compressUpdate(lz4_ctx_.get(), (void *)(buffer + tail), max_packet_length_ - tail, (void *)data, data_len, NULL);
+    _CHECK_LZ4_ERROR(res);
+    tail += res;
 
-  return channel_.send(buffer_.data(), tail);
+    return u32(tail);
+  });
 }
 
 void Lz4Channel::close()
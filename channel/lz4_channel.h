@@ -11,8 +11,6 @@
 
 #include <lz4frame.h>
 
-#include <vector>
-
 namespace channel {
 
 // Lz4Channel serves as an adapter between upstream data source and downstream
@@ -23,6 +21,12 @@ namespace channel {
 //
 // When the compression is enabled, the Lz4Channel will compress the incoming
 // data packets before relay then.
+//
+// Compressed packets are blocks of a single LZ4 frame, which starts when
+// compression is enabled. Blocks are linked, so each packet is compressed
+// using the previous ones as history, and flushed, so the receiving end can
+// decompress each packet as it arrives. Packets are compressed directly into
+// the downstream channel's send buffers.
 class Lz4Channel : public Channel {
 public:
   // |channel|: the downstream channel which will actually send out the data.
@@ -33,6 +37,8 @@ public:
 
   std::error_code send(const u8 *data, int data_len) override;
 
+  // Enables or disables compression. Either way, the next compressed packet
+  // starts a new frame.
   void set_compression(bool enabled);
 
   void close() override;
@@ -40,11 +46,19 @@ public:
 
   bool is_open() const override { return channel_.is_open(); }
 
+  bool is_congested() const override { return channel_.is_congested(); }
+  bool is_full() const override { return channel_.is_full(); }
+
 private:
+  static const LZ4F_preferences_t preferences_;
+
   bool compression_enabled_;
+  // Whether the current frame's header has been sent.
+  bool frame_started_ = false;
 
   Channel &channel_;
-  std::vector<u8> buffer_;
+  // Largest packet a send() can produce.
+  u32 const max_packet_length_;
 
   pod_unique_ptr<LZ4F_cctx, LZ4F_errorCode_t, LZ4F_freeCompressionContext> lz4_ctx_;
 };
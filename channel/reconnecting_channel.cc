@@ -5,6 +5,7 @@
 #include <channel/reconnecting_channel.h>
 
 #include <util/log.h>
+#include <util/uv_helpers.h>
 
 #include <stdexcept>
 
@@ -20,6 +21,12 @@ void connection_timer_cb(uv_timer_t *timer)
 }
 } // namespace
 
+void drain_timer_cb(uv_timer_t *timer)
+{
+  ReconnectingChannel *channel = (ReconnectingChannel *)(timer->data);
+  channel->drain_spool();
+}
+
 void start_timer_cb(uv_timer_t *timer)
 {
   ReconnectingChannel *channel = (ReconnectingChannel *)(timer->data);
@@ -30,7 +37,13 @@ ReconnectingChannel::ReconnectingChannel(config::IntakeConfig intake_config, uv_
     : loop_(loop),
       intake_config_(std::move(intake_config)),
       network_channel_(intake_config_.make_channel(loop)),
-      upstream_connection_(buffer_size, intake_config_.allow_compression(), *network_channel_),
+      upstream_connection_(
+          buffer_size,
+          intake_config_.allow_compression(),
+          *network_channel_,
+          nullptr,
+          intake_config_.compression(),
+          intake_config_.zstd_dictionary()),
       state_(State::INACTIVE)
 {
   int res = uv_timer_init(&loop_, &start_timer_);
@@ -44,13 +57,31 @@ ReconnectingChannel::ReconnectingChannel(config::IntakeConfig intake_config, uv_
     LOG::error("ReconnectingChannel: Cannot init connection_timer");
   }
   connection_timer_.data = this;
+
+  res = uv_timer_init(&loop_, &drain_timer_);
+  if (res != 0) {
+    LOG::error("ReconnectingChannel: Cannot init drain_timer");
+  }
+  drain_timer_.data = this;
+
+  if (auto const &directory = intake_config_.spool_directory(); !directory.empty()) {
+    spool_ = std::make_unique<Spool>(directory, intake_config_.spool_size());
+    spool_writer_ = std::make_unique<BufferedWriter>(spool_inlet_, buffer_size);
+    LOG::info(
+        "ReconnectingChannel: spooling up to {} bytes to `{}` while congested, drained at {} bytes/s",
+        intake_config_.spool_size(),
+        directory,
+        intake_config_.spool_drain_rate());
+  }
 }
 
 ReconnectingChannel::~ReconnectingChannel()
 {
   close();
-  uv_close((uv_handle_t *)&connection_timer_, NULL);
-  uv_close((uv_handle_t *)&start_timer_, NULL);
+  // the loop may have closed them already, e.g. with close_uv_loop_cleanly()
+  close_uv_handle_cleanly((uv_handle_t *)&drain_timer_, NULL);
+  close_uv_handle_cleanly((uv_handle_t *)&connection_timer_, NULL);
+  close_uv_handle_cleanly((uv_handle_t *)&start_timer_, NULL);
 }
 
 void ReconnectingChannel::register_pipeline_observer(Callbacks *observer)
@@ -98,6 +129,15 @@ void ReconnectingChannel::on_connect()
   LOG::info("ReconnectingChannel: Remote connection established.");
 
   num_bytes_sent_ = 0;
+  handshake_done_ = false;
+  if (spool_) {
+    // the observers' resync supersedes it
+    spool_writer_->reset();
+    if (!spool_->empty()) {
+      LOG::info("ReconnectingChannel: dropping {} bytes spooled for the previous connection", spool_->size());
+      spool_->clear();
+    }
+  }
   set_compression(false);
 
   stop_all_timers();
@@ -107,10 +147,20 @@ void ReconnectingChannel::on_connect()
   for (auto *observer : pipeline_observers_) {
     observer->on_connect();
   }
+
+  // observers send the connection's handshake as they're told about it
+  if (spool_) {
+    spool_writer_->flush();
+    handshake_done_ = true;
+  }
 }
 
 void ReconnectingChannel::set_compression(bool enabled)
 {
+  if (spool_writer_) {
+    spool_writer_->flush();
+  }
+
   upstream_connection_.set_compression(enabled);
 }
 
@@ -122,7 +172,7 @@ std::error_code ReconnectingChannel::send(const u8 *data, int data_len)
     return std::make_error_code(std::errc::not_connected);
   }
 
-  auto &buffered_writer = upstream_connection_.buffered_writer();
+  auto &buffered_writer = this->buffered_writer();
 
   num_bytes_sent_ += data_len;
   LOG::trace_in(
@@ -143,21 +193,100 @@ std::error_code ReconnectingChannel::send(const u8 *data, int data_len)
 
 BufferedWriter &ReconnectingChannel::buffered_writer()
 {
-  return upstream_connection_.buffered_writer();
+  return spool_writer_ ? *spool_writer_ : upstream_connection_.buffered_writer();
 }
 
 void ReconnectingChannel::close()
 {
   state_ = State::INACTIVE;
+  handshake_done_ = false;
   stop_all_timers();
   upstream_connection_.close();
 }
 
 std::error_code ReconnectingChannel::flush()
 {
+  if (spool_writer_) {
+    if (auto error = spool_writer_->flush()) {
+      return error;
+    }
+  }
+
+  return upstream_connection_.flush();
+}
+
+std::error_code ReconnectingChannel::send_batch(const u8 *data, int data_len)
+{
+  // nothing is spooled while disconnected, as the next connection's resync
+  // supersedes it
+  if (state_ != State::CONNECTED) {
+    return std::make_error_code(std::errc::not_connected);
+  }
+
+  // during the handshake, batches go straight to the new connection; after
+  // it, they wait for older ones to be sent first
+  if (!handshake_done_ || (spool_->empty() && !is_congested())) {
+    return send_upstream(data, data_len);
+  }
+
+  if (auto error = spool_->append(std::string_view(reinterpret_cast<char const *>(data), data_len))) {
+    LOG::error("ReconnectingChannel: cannot spool {} bytes: {}", data_len, error);
+    return error;
+  }
+
+  // drain once the connection catches up
+  start_drain_timer();
+
+  return {};
+}
+
+std::error_code ReconnectingChannel::send_upstream(const u8 *data, int data_len)
+{
+  if (auto error = upstream_connection_.send(data, data_len)) {
+    return error;
+  }
+
   return upstream_connection_.flush();
 }
 
+void ReconnectingChannel::start_drain_timer()
+{
+  if (uv_is_active((uv_handle_t *)&drain_timer_)) {
+    return;
+  }
+
+  int res = uv_timer_start(&drain_timer_, drain_timer_cb, 0, drain_interval_ms_);
+  if (res != 0) {
+    LOG::error("ReconnectingChannel: Cannot start drain_timer {}", uv_err_name(res));
+  }
+}
+
+void ReconnectingChannel::drain_spool()
+{
+  u64 const budget = intake_config_.spool_drain_rate() * drain_interval_ms_ / 1000;
+
+  // at least one batch is sent each time, however low the rate
+  for (u64 sent = 0; sent < budget || sent == 0;) {
+    if (spool_->empty() || state_ != State::CONNECTED || is_congested()) {
+      break;
+    }
+
+    auto const batch = spool_->front();
+    if (auto error = send_upstream(reinterpret_cast<u8 const *>(batch.data()), batch.size())) {
+      LOG::warn("ReconnectingChannel: cannot send spooled data: {}", error);
+      return;
+    }
+
+    sent += batch.size();
+    spool_->pop_front();
+  }
+
+  if (spool_->empty()) {
+    LOG::info("ReconnectingChannel: spool drained, {} bytes dropped while spooling so far", spool_->dropped());
+    uv_timer_stop(&drain_timer_);
+  }
+}
+
 u64 ReconnectingChannel::get_start_wait_time() const
 {
   // TODO: better back-off mechanism here.
@@ -213,6 +342,7 @@ void ReconnectingChannel::start_connect()
 void ReconnectingChannel::to_closing_state()
 {
   state_ = State::CLOSING;
+  handshake_done_ = false;
   stop_all_timers();
   try {
     upstream_connection_.close();
@@ -251,6 +381,7 @@ void ReconnectingChannel::stop_all_timers()
 {
   uv_timer_stop(&connection_timer_);
   uv_timer_stop(&start_timer_);
+  uv_timer_stop(&drain_timer_);
 }
 
 } // namespace channel
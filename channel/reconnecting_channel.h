@@ -9,9 +9,11 @@
 
 #include <channel/callbacks.h>
 #include <channel/channel.h>
+#include <channel/spool.h>
 #include <channel/upstream_connection.h>
 #include <config/intake_config.h>
 
+#include <memory>
 #include <set>
 
 namespace channel {
@@ -20,6 +22,15 @@ namespace channel {
 //
 // Retries connection when network error occurs.
 //
+// When the intake config has a spool directory, what is written to
+// buffered_writer() while the connection is congested is spooled to disk
+// instead of piling up in memory, and drained at the configured rate ahead of
+// newer data once the connection catches up. The spool doesn't outlast the
+// connection: observers resync their whole state from on_connect() after a
+// reconnect, so whatever was spooled for the previous connection is stale and
+// dropped then. For the same reason, nothing is spooled while disconnected:
+// writes fail with not_connected, as they do without a spool.
+//
 // Note that this class is NOT thread safe.
 class ReconnectingChannel : public Channel, public Callbacks {
 public:
@@ -65,8 +76,33 @@ public:
 
   bool is_open() const override { return upstream_connection_.is_open(); }
 
+  bool is_congested() const override { return upstream_connection_.is_congested(); }
+  bool is_full() const override { return upstream_connection_.is_full(); }
+
 private:
   friend void start_timer_cb(uv_timer_t *timer);
+  friend void drain_timer_cb(uv_timer_t *timer);
+
+  // What buffered_writer() writes to when spooling. Always open, so that
+  // batches flushed while disconnected reach send_batch(), which refuses them.
+  class SpoolInlet : public Channel {
+  public:
+    explicit SpoolInlet(ReconnectingChannel &channel) : channel_(channel) {}
+
+    std::error_code send(const u8 *data, int data_len) override { return channel_.send_batch(data, data_len); }
+
+    bool is_open() const override { return true; }
+
+    bool is_congested() const override { return channel_.is_congested(); }
+    bool is_full() const override { return channel_.is_full(); }
+
+  private:
+    ReconnectingChannel &channel_;
+  };
+
+  // How often the spool is drained, and the amount of data sent each time
+  // is the drain rate over this frequency.
+  static constexpr u64 drain_interval_ms_ = 100;
 
   // How long we should wait for the connection to be established, before
   // it times out and reconnects again.
@@ -86,6 +122,19 @@ private:
   // Stops all active timers
   void stop_all_timers();
 
+  // Sends a batch flushed to the spool inlet, or spools it if it can't be
+  // sent right away or older batches are still spooled.
+  std::error_code send_batch(const u8 *data, int data_len);
+
+  // Sends a batch upstream right away.
+  std::error_code send_upstream(const u8 *data, int data_len);
+
+  // Starts the drain_timer_, unless it's already running.
+  void start_drain_timer();
+
+  // Sends up to one drain interval's worth of spooled batches.
+  void drain_spool();
+
   // Returns how much time the system should wait, in microsecond,
   // before it tries to start a new connection.
   u64 get_start_wait_time() const;
@@ -116,6 +165,19 @@ private:
 
   // Number of bytes this channel has sent, or is about to send.
   u64 num_bytes_sent_ = 0;
+
+  // Only set when spooling.
+  std::unique_ptr<Spool> spool_;
+  SpoolInlet spool_inlet_{*this};
+  std::unique_ptr<BufferedWriter> spool_writer_;
+
+  // Whether the connection's handshake is done, so that batches can be sent
+  // upstream rather than spooled.
+  bool handshake_done_ = false;
+
+  // The timer to drain the spool once the handshake is done.
+  // (CONNECTED, while the spool isn't empty)
+  uv_timer_t drain_timer_;
 };
 
 } // namespace channel
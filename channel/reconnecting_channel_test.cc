@@ -0,0 +1,193 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <channel/reconnecting_channel.h>
+#include <channel/tcp_channel.h>
+#include <util/uv_helpers.h>
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace channel {
+namespace {
+
+constexpr std::size_t buffer_size = 4096;
+
+std::size_t count_files(std::string const &directory)
+{
+  std::size_t count = 0;
+  for ([[maybe_unused]] auto const &entry : std::filesystem::directory_iterator(directory)) {
+    ++count;
+  }
+  return count;
+}
+
+// The reducer's end of a connection.
+struct ReceivingCallbacks : Callbacks {
+  u32 received_data(u8 const *data, int length) override
+  {
+    received.append(reinterpret_cast<char const *>(data), length);
+    return length;
+  }
+
+  void on_error(int error) override {}
+
+  std::string received;
+};
+
+// Sends the handshake from on_connect(), as collectors do.
+struct HandshakeObserver : Callbacks {
+  explicit HandshakeObserver(ReconnectingChannel &channel) : channel(channel) {}
+
+  u32 received_data(u8 const *data, int length) override { return length; }
+  void on_error(int error) override {}
+  void on_connect() override { send(channel, "hello;"); }
+
+  static void send(ReconnectingChannel &channel, std::string_view data)
+  {
+    ASSERT_FALSE(channel.send(reinterpret_cast<u8 const *>(data.data()), data.size()));
+  }
+
+  ReconnectingChannel &channel;
+};
+
+// A collector's ReconnectingChannel, spooling, connected over loopback to a
+// stand-in for the reducer.
+class ReconnectingChannelTest : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    std::string path = (std::filesystem::temp_directory_path() / "reconnecting_channel_test.XXXXXX").string();
+    ASSERT_NE(nullptr, mkdtemp(path.data()));
+    spool_directory_ = path;
+
+    ASSERT_EQ(0, uv_loop_init(&loop_));
+
+    ASSERT_EQ(0, uv_tcp_init(&loop_, &listener_));
+    listener_.data = this;
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(0, uv_tcp_bind(&listener_, reinterpret_cast<struct sockaddr const *>(&addr), 0));
+    ASSERT_EQ(0, uv_listen(reinterpret_cast<uv_stream_t *>(&listener_), 1, on_new_connection));
+
+    int len = sizeof(addr);
+    ASSERT_EQ(0, uv_tcp_getsockname(&listener_, reinterpret_cast<struct sockaddr *>(&addr), &len));
+    port_ = std::to_string(ntohs(addr.sin_port));
+  }
+
+  void TearDown() override
+  {
+    close_uv_loop_cleanly(&loop_);
+    std::filesystem::remove_all(spool_directory_);
+  }
+
+  void start(u64 send_buffer_limit = 0)
+  {
+    config::IntakeConfig config("127.0.0.1", port_);
+    config.spool_directory(spool_directory_);
+    config.spool_size(4 * Spool::default_segment_size);
+    config.send_buffer_limit(send_buffer_limit);
+
+    channel_ = std::make_unique<ReconnectingChannel>(std::move(config), loop_, buffer_size);
+    observer_ = std::make_unique<HandshakeObserver>(*channel_);
+    channel_->register_pipeline_observer(observer_.get());
+    channel_->start_connect();
+  }
+
+  void send(std::string_view data)
+  {
+    HandshakeObserver::send(*channel_, data);
+    ASSERT_FALSE(channel_->flush());
+  }
+
+  // Runs the loop until the current connection received |expected|.
+  void wait_for(std::size_t connection, std::string const &expected)
+  {
+    while (servers_.size() <= connection || server_callbacks_[connection]->received.size() < expected.size()) {
+      uv_run(&loop_, UV_RUN_ONCE);
+    }
+    EXPECT_EQ(expected, server_callbacks_[connection]->received);
+  }
+
+  static void on_new_connection(uv_stream_t *stream, int status)
+  {
+    ASSERT_EQ(0, status);
+    auto test = reinterpret_cast<ReconnectingChannelTest *>(stream->data);
+    test->server_callbacks_.push_back(std::make_unique<ReceivingCallbacks>());
+    test->servers_.push_back(std::make_unique<TCPChannel>(test->loop_));
+    test->servers_.back()->accept(*test->server_callbacks_.back(), &test->listener_);
+  }
+
+  std::string spool_directory_;
+  std::string port_;
+
+  uv_loop_t loop_;
+  uv_tcp_t listener_;
+
+  std::vector<std::unique_ptr<ReceivingCallbacks>> server_callbacks_;
+  std::vector<std::unique_ptr<TCPChannel>> servers_;
+  std::unique_ptr<ReconnectingChannel> channel_;
+  std::unique_ptr<HandshakeObserver> observer_;
+};
+
+} // namespace
+
+TEST_F(ReconnectingChannelTest, SpoolsWhileCongested)
+{
+  start(64);
+  wait_for(0, "hello;");
+
+  // the first batch goes out, and stays in flight until the loop runs
+  std::string const first(100, 'a');
+  send(first);
+  ASSERT_TRUE(channel_->is_congested());
+
+  // so the second one is spooled, and sent once the first one is written
+  std::string const second(100, 'b');
+  send(second);
+  EXPECT_EQ(1u, count_files(spool_directory_));
+
+  wait_for(0, "hello;" + first + second);
+  EXPECT_EQ(1u, servers_.size());
+}
+
+TEST_F(ReconnectingChannelTest, DropsSpoolOnReconnect)
+{
+  start(64);
+  wait_for(0, "hello;");
+
+  // spooled behind the first batch, still in flight when the connection drops
+  send(std::string(100, 'a'));
+  send(std::string(100, 'b'));
+  EXPECT_EQ(1u, count_files(spool_directory_));
+
+  servers_[0]->close_permanently();
+  while (channel_->state() == ReconnectingChannel::State::CONNECTED) {
+    uv_run(&loop_, UV_RUN_ONCE);
+  }
+
+  // nothing is spooled while disconnected
+  std::string_view const stale = "stale;";
+  EXPECT_EQ(
+      std::make_error_code(std::errc::not_connected), channel_->send(reinterpret_cast<u8 const *>(stale.data()), stale.size()));
+
+  // the new connection starts over from its handshake, as the resync that
+  // follows it supersedes what was spooled
+  wait_for(1, "hello;");
+  EXPECT_EQ(0u, count_files(spool_directory_));
+
+  send("fresh;");
+  wait_for(1, "hello;fresh;");
+}
+
+} // namespace channel
@@ -0,0 +1,173 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <channel/spool.h>
+
+#include <util/log.h>
+#include <util/log_formatters.h>
+
+#include <fmt/format.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace channel {
+
+namespace {
+
+constexpr std::string_view segment_prefix = "spool-";
+constexpr std::string_view segment_suffix = ".seg";
+
+} // namespace
+
+Spool::Spool(std::string directory, u64 max_size, u32 segment_size)
+    : directory_(std::move(directory)),
+      segment_size_(segment_size),
+      max_segments_(std::max<u64>(1, max_size / segment_size))
+{
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  if (error) {
+    throw std::runtime_error(fmt::format("Spool: can't create directory `{}`: {}", directory_, error.message()));
+  }
+
+  // segments left by a previous run belong to connections that are gone
+  for (auto const &entry : std::filesystem::directory_iterator(directory_, error)) {
+    auto const name = entry.path().filename().string();
+    if (name.size() > segment_prefix.size() + segment_suffix.size() && name.find(segment_prefix) == 0 &&
+        name.compare(name.size() - segment_suffix.size(), segment_suffix.size(), segment_suffix) == 0) {
+      std::filesystem::remove(entry.path(), error);
+    }
+  }
+  if (error) {
+    throw std::runtime_error(fmt::format("Spool: can't clean up directory `{}`: {}", directory_, error.message()));
+  }
+}
+
+Spool::~Spool()
+{
+  clear();
+}
+
+std::error_code Spool::append(std::string_view batch)
+{
+  u64 const record_size = header_size + batch.size();
+  if (record_size > segment_size_) {
+    return std::make_error_code(std::errc::message_size);
+  }
+
+  if (segments_.empty() || (segments_.back().write_offset + record_size > segment_size_)) {
+    if (auto const error = add_segment()) {
+      return error;
+    }
+  }
+
+  auto &segment = segments_.back();
+  u32 const length = batch.size();
+  memcpy(segment.data + segment.write_offset, &length, header_size);
+  memcpy(segment.data + segment.write_offset + header_size, batch.data(), batch.size());
+  segment.write_offset += record_size;
+  size_ += batch.size();
+
+  return {};
+}
+
+std::string_view Spool::front() const
+{
+  assert(!empty());
+
+  auto const &segment = segments_.front();
+  assert(segment.read_offset < segment.write_offset);
+
+  u32 length;
+  memcpy(&length, segment.data + segment.read_offset, header_size);
+  return {reinterpret_cast<char const *>(segment.data + segment.read_offset + header_size), length};
+}
+
+void Spool::pop_front()
+{
+  auto const batch = front();
+
+  auto &segment = segments_.front();
+  segment.read_offset += header_size + batch.size();
+  size_ -= batch.size();
+
+  if (segment.read_offset == segment.write_offset) {
+    if (segments_.size() > 1) {
+      remove_front_segment();
+    } else {
+      // the last segment is kept, and written from the start again
+      segment.read_offset = segment.write_offset = 0;
+    }
+  }
+}
+
+void Spool::clear()
+{
+  while (!segments_.empty()) {
+    remove_front_segment();
+  }
+  size_ = 0;
+}
+
+std::error_code Spool::add_segment()
+{
+  while (segments_.size() >= max_segments_) {
+    auto const &oldest = segments_.front();
+    u64 dropped = 0;
+    for (u32 offset = oldest.read_offset; offset < oldest.write_offset;) {
+      u32 length;
+      memcpy(&length, oldest.data + offset, header_size);
+      dropped += length;
+      offset += header_size + length;
+    }
+
+    LOG::warn("Spool: full, dropping {} bytes of the oldest data", dropped);
+    size_ -= dropped;
+    dropped_ += dropped;
+    remove_front_segment();
+  }
+
+  Segment segment;
+  segment.path = fmt::format("{}/{}{:08}{}", directory_, segment_prefix, next_segment_++, segment_suffix);
+
+  if (auto const error = segment.fd.create(segment.path.c_str(), FileDescriptor::Access::read_write)) {
+    LOG::error("Spool: can't create segment `{}`: {}", segment.path, error);
+    return error;
+  }
+
+  if (::ftruncate(segment.fd.fd(), segment_size_) != 0) {
+    std::error_code const error{errno, std::generic_category()};
+    LOG::error("Spool: can't size segment `{}`: {}", segment.path, error);
+    ::unlink(segment.path.c_str());
+    return error;
+  }
+
+  void *data = ::mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, segment.fd.fd(), 0);
+  if (data == MAP_FAILED) {
+    std::error_code const error{errno, std::generic_category()};
+    LOG::error("Spool: can't map segment `{}`: {}", segment.path, error);
+    ::unlink(segment.path.c_str());
+    return error;
+  }
+  segment.data = reinterpret_cast<u8 *>(data);
+
+  segments_.push_back(std::move(segment));
+  return {};
+}
+
+void Spool::remove_front_segment()
+{
+  auto &segment = segments_.front();
+  ::munmap(segment.data, segment_size_);
+  ::unlink(segment.path.c_str());
+  segments_.pop_front();
+}
+
+} // namespace channel
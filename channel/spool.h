@@ -0,0 +1,95 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <platform/types.h>
+#include <util/file_ops.h>
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace channel {
+
+// A bounded, first-in first-out store of batches on disk.
+//
+// Batches are appended to memory-mapped segment files of |segment_size|
+// bytes, created in |directory| as needed. When a new segment would take the
+// spool over |max_size| bytes, the oldest segment is dropped with the batches
+// it still holds.
+//
+// Segments only last as long as the spool: existing ones are removed when it
+// is created, and all of them when it is destroyed.
+//
+// This class is NOT thread safe.
+class Spool {
+public:
+  static constexpr u32 default_segment_size = 4 * 1024 * 1024;
+
+  // Throws std::runtime_error if |directory| can't be used.
+  Spool(std::string directory, u64 max_size, u32 segment_size = default_segment_size);
+  ~Spool();
+
+  Spool(Spool const &) = delete;
+  Spool &operator=(Spool const &) = delete;
+
+  // Appends |batch| to the spool.
+  //
+  // Returns std::errc::message_size if the batch can't fit in a segment, or
+  // the error that kept a segment from being created.
+  std::error_code append(std::string_view batch);
+
+  bool empty() const { return size_ == 0; }
+
+  // The oldest batch. Must not be called on an empty spool.
+  std::string_view front() const;
+
+  // Removes the oldest batch. Must not be called on an empty spool.
+  void pop_front();
+
+  // Removes all batches.
+  void clear();
+
+  // Number of bytes of batches in the spool.
+  u64 size() const { return size_; }
+
+  // Number of bytes of batches dropped to keep the spool under its maximum
+  // size.
+  u64 dropped() const { return dropped_; }
+
+  // Number of segment files the spool is made of.
+  std::size_t segment_count() const { return segments_.size(); }
+
+private:
+  struct Segment {
+    std::string path;
+    FileDescriptor fd;
+    u8 *data = nullptr;
+    // where the next batch is written
+    u32 write_offset = 0;
+    // where the oldest batch starts
+    u32 read_offset = 0;
+  };
+
+  // Size of the header that precedes each batch: its length.
+  static constexpr u32 header_size = sizeof(u32);
+
+  std::error_code add_segment();
+  void remove_front_segment();
+
+  std::string const directory_;
+  u32 const segment_size_;
+  std::size_t const max_segments_;
+
+  std::deque<Segment> segments_;
+  u64 next_segment_ = 0;
+
+  u64 size_ = 0;
+  u64 dropped_ = 0;
+};
+
+} // namespace channel
@@ -0,0 +1,177 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <channel/file_channel.h>
+#include <channel/spool.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace channel {
+namespace {
+
+constexpr u32 segment_size = 4096;
+
+std::size_t count_files(std::string const &directory)
+{
+  std::size_t count = 0;
+  for ([[maybe_unused]] auto const &entry : std::filesystem::directory_iterator(directory)) {
+    ++count;
+  }
+  return count;
+}
+
+class SpoolTest : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    std::string path = (std::filesystem::temp_directory_path() / "spool_test.XXXXXX").string();
+    ASSERT_NE(nullptr, mkdtemp(path.data()));
+    directory_ = path;
+  }
+
+  void TearDown() override { std::filesystem::remove_all(directory_); }
+
+  std::string directory_;
+};
+
+} // namespace
+
+TEST_F(SpoolTest, KeepsBatchesInOrder)
+{
+  Spool spool(directory_, 16 * segment_size, segment_size);
+  EXPECT_TRUE(spool.empty());
+
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_FALSE(spool.append("batch " + std::to_string(i)));
+  }
+  EXPECT_GT(spool.segment_count(), 0u);
+
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_FALSE(spool.empty());
+    EXPECT_EQ("batch " + std::to_string(i), spool.front());
+    spool.pop_front();
+  }
+  EXPECT_TRUE(spool.empty());
+  EXPECT_EQ(0u, spool.size());
+  EXPECT_EQ(0u, spool.dropped());
+
+  // the last segment is reused once drained
+  EXPECT_EQ(1u, spool.segment_count());
+  ASSERT_FALSE(spool.append("again"));
+  EXPECT_EQ("again", spool.front());
+}
+
+TEST_F(SpoolTest, RotatesSegments)
+{
+  Spool spool(directory_, 16 * segment_size, segment_size);
+
+  std::string const batch(segment_size / 4, 'x');
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_FALSE(spool.append(batch));
+  }
+  // batches come with a header, so only three fit in a segment
+  EXPECT_EQ(3u, spool.segment_count());
+  EXPECT_EQ(3u, count_files(directory_));
+  EXPECT_EQ(8 * batch.size(), spool.size());
+
+  // segments are removed as they're drained
+  for (int i = 0; i < 3; ++i) {
+    spool.pop_front();
+  }
+  EXPECT_EQ(2u, spool.segment_count());
+  EXPECT_EQ(2u, count_files(directory_));
+}
+
+TEST_F(SpoolTest, DropsOldestDataWhenFull)
+{
+  Spool spool(directory_, 2 * segment_size, segment_size);
+
+  std::string const batch(segment_size / 4, 'x');
+  for (int i = 0; i < 9; ++i) {
+    ASSERT_FALSE(spool.append(batch + std::to_string(i)));
+  }
+
+  // the first segment, with batches 0 to 2, made room for the third one
+  EXPECT_EQ(2u, spool.segment_count());
+  EXPECT_EQ(3 * (batch.size() + 1), spool.dropped());
+  EXPECT_EQ(6 * (batch.size() + 1), spool.size());
+  EXPECT_EQ(batch + "3", spool.front());
+}
+
+TEST_F(SpoolTest, ClearsBatches)
+{
+  Spool spool(directory_, 16 * segment_size, segment_size);
+
+  std::string const batch(segment_size / 4, 'x');
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_FALSE(spool.append(batch));
+  }
+  spool.clear();
+  EXPECT_TRUE(spool.empty());
+  EXPECT_EQ(0u, spool.size());
+  EXPECT_EQ(0u, count_files(directory_));
+
+  ASSERT_FALSE(spool.append("after"));
+  EXPECT_EQ("after", spool.front());
+}
+
+TEST_F(SpoolTest, RejectsOversizedBatches)
+{
+  Spool spool(directory_, 2 * segment_size, segment_size);
+  EXPECT_EQ(std::errc::message_size, spool.append(std::string(segment_size, 'x')));
+  EXPECT_TRUE(spool.empty());
+}
+
+TEST_F(SpoolTest, CleansUpSegmentFiles)
+{
+  std::ofstream(directory_ + "/spool-00000007.seg") << "left by a previous run";
+  std::ofstream(directory_ + "/unrelated") << "kept";
+
+  {
+    Spool spool(directory_, 4 * segment_size, segment_size);
+    EXPECT_EQ(1u, count_files(directory_));
+
+    ASSERT_FALSE(spool.append("batch"));
+    EXPECT_EQ(2u, count_files(directory_));
+  }
+
+  EXPECT_EQ(1u, count_files(directory_));
+  EXPECT_TRUE(std::filesystem::exists(directory_ + "/unrelated"));
+}
+
+TEST_F(SpoolTest, DrainsToChannel)
+{
+  Spool spool(directory_, 16 * segment_size, segment_size);
+
+  std::string expected;
+  for (int i = 0; i < 500; ++i) {
+    std::string const batch = "message " + std::to_string(i) + ";";
+    ASSERT_FALSE(spool.append(batch));
+    expected += batch;
+  }
+
+  std::string const path = directory_ + "/drained";
+  FileDescriptor fd;
+  ASSERT_FALSE(fd.create(path.c_str(), FileDescriptor::Access::write_only));
+  FileChannel channel(std::move(fd));
+
+  while (!spool.empty()) {
+    auto const batch = spool.front();
+    ASSERT_FALSE(channel.send(reinterpret_cast<u8 const *>(batch.data()), batch.size()));
+    spool.pop_front();
+  }
+  channel.close();
+
+  std::ifstream in(path, std::ios::binary);
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  EXPECT_EQ(expected, contents.str());
+}
+
+} // namespace channel
@@ -18,6 +18,7 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <stdexcept>
 
 #define INVALID_FD -1
@@ -65,32 +66,90 @@ void TCPChannel::conn_read_cb(uv_stream_t *stream, ssize_t nread, const uv_buf_t
     return;
   }
 
-  /* "merge" the read data into the buffer */
-  conn->rx_len_ += nread;
   conn->allocated_ = false;
+  conn->process_rx_buffer(nread);
+}
+
+bool TCPChannel::process_rx_buffer(u32 len)
+{
+  /* "merge" the read data into the buffer */
+  rx_len_ += len;
 
   /* read all complete messages from buffer */
-  try {
-    u32 res = conn->callbacks_->received_data((u8 *)conn->rx_buffer_, conn->rx_len_);
+  auto const res = deliver((u8 *)rx_buffer_, rx_len_);
+  if (!res) {
+    return false;
+  }
 
-    if (res > 0) {
-      ASSUME(res <= conn->rx_len_);
-      conn->rx_len_ -= res;
-      memmove(conn->rx_buffer_, (u8 *)conn->rx_buffer_ + res, conn->rx_len_);
-    }
+  if (*res > 0) {
+    rx_len_ -= *res;
+    memmove(rx_buffer_, (u8 *)rx_buffer_ + *res, rx_len_);
+  }
+
+  /* check that we don't exceed the buffer size */
+  if (rx_len_ == TCPChannel::rx_buffer_size) {
+    connected_ = false;
+    callbacks_->on_error(-EOVERFLOW);
+    return false;
+  }
+
+  return true;
+}
+
+std::optional<u32> TCPChannel::deliver(u8 const *data, u32 len)
+{
+  try {
+    u32 res = callbacks_->received_data(data, len);
+    ASSUME(res <= len);
+    return res;
   } catch (const std::exception &e) {
     LOG::error("TCPChannel: error handling received data: '{}'", e.what());
-    conn->connected_ = false;
-    conn->callbacks_->on_error(-EPROTO);
-    return;
+    connected_ = false;
+    callbacks_->on_error(-EPROTO);
+    return std::nullopt;
   }
+}
 
-  /* check that we don't exceed the buffer size */
-  if (conn->rx_len_ == TCPChannel::rx_buffer_size) {
-    conn->connected_ = false;
-    conn->callbacks_->on_error(-EOVERFLOW);
+void TCPChannel::on_receive(u8 const *data, u32 len)
+{
+  if (!connected_) {
     return;
   }
+
+  /* parse straight from the receiver's buffer when no partial message is pending */
+  if (!rx_len_ && !reading_paused_) {
+    auto const res = deliver(data, len);
+    if (!res) {
+      return;
+    }
+    data += *res;
+    len -= *res;
+  }
+
+  /* keep the rest, along with what was pending */
+  while (len > 0 && connected_) {
+    u32 const chunk = std::min(len, TCPChannel::rx_buffer_size - rx_len_);
+    memcpy((u8 *)rx_buffer_ + rx_len_, data, chunk);
+    data += chunk;
+    len -= chunk;
+
+    if (reading_paused_) {
+      rx_len_ += chunk;
+      if (rx_len_ == TCPChannel::rx_buffer_size) {
+        connected_ = false;
+        callbacks_->on_error(-EOVERFLOW);
+      }
+    } else if (!process_rx_buffer(chunk)) {
+      return;
+    }
+  }
+}
+
+void TCPChannel::on_receive_error(int error)
+{
+  receive_id_ = 0;
+  connected_ = false;
+  callbacks_->on_error(error);
 }
 
 void TCPChannel::conn_close_cb(uv_handle_t *handle)
@@ -135,27 +194,34 @@ void TCPChannel::conn_connect_cb(uv_connect_t *req, int status)
 void TCPChannel::conn_write_cb(uv_write_t *req, int status)
 {
   LOG::trace_in(channel::Component::tcp, "TCPChannel::{}()", __func__);
-  auto tcp = (TCPChannel *)req->handle->data;
+  auto handle = req->handle;
+  auto tcp = (TCPChannel *)handle->data;
+
+  /* assumes req is the first field in send_buffer_t */
+  auto send_buffer = (struct send_buffer_t *)req;
+  tcp->in_flight_bytes_ -= send_buffer->len;
+  tcp->release_send_buffer(send_buffer);
+  if (!tcp->is_full()) {
+    tcp->full_since_ms_.reset();
+  }
 
   if (status < 0) {
     /* no need to notify if close() was called, otherwise -- notify */
-    if (!uv_is_closing((uv_handle_t *)req->handle)) {
+    if (!uv_is_closing((uv_handle_t *)handle)) {
       LOG::trace_in(channel::Component::tcp, "TCPChannel::{}: connection not closing, calling close on handle()", __func__);
       tcp->connected_ = false;
       tcp->callbacks_->on_error(status);
     }
   }
-
-  /* assumes req is the first field in send_buffer_t */
-  free(req);
 }
 
-TCPChannel::TCPChannel(uv_loop_t &loop)
+TCPChannel::TCPChannel(uv_loop_t &loop, TCPSendLimits send_limits) : send_limits_(send_limits)
 {
   reinit(&loop);
 }
 
-TCPChannel::TCPChannel(uv_loop_t &loop, std::string addr, std::string port) : addr_(std::move(addr)), port_(std::move(port))
+TCPChannel::TCPChannel(uv_loop_t &loop, std::string addr, std::string port, TCPSendLimits send_limits)
+    : addr_(std::move(addr)), port_(std::move(port)), send_limits_(send_limits)
 {
   reinit(&loop);
 }
@@ -164,6 +230,10 @@ TCPChannel::~TCPChannel()
 {
   LOG::trace_in(channel::Component::tcp, "TCPChannel::{}: connection not closing, calling close on handle()", __func__);
   DEBUG_ASSUME(uv_is_closing((uv_handle_t *)&conn_));
+
+  for (auto send_buffer : send_buffer_pool_) {
+    free(send_buffer);
+  }
 }
 
 void TCPChannel::connect(Callbacks &callbacks)
@@ -218,10 +288,11 @@ void TCPChannel::accept(Callbacks &callbacks, uv_tcp_t *listener)
   }
 }
 
-void TCPChannel::open_fd(Callbacks &callbacks, const uv_os_sock_t fd)
+void TCPChannel::open_fd(Callbacks &callbacks, const uv_os_sock_t fd, IoUringReceiver *receiver)
 {
   LOG::trace_in(channel::Component::tcp, "TCPChannel::{}()", __func__);
   callbacks_ = &callbacks;
+  receiver_ = receiver;
 
   if (auto const error = ::uv_tcp_open(&conn_, fd)) {
     LOG::error("TCPChannel::{}: failed to open existing file descriptor as a TCP handle: {}", __func__, uv_error_t{error});
@@ -248,36 +319,80 @@ void TCPChannel::close_permanently()
 std::error_code TCPChannel::send(const u8 *data, int data_len)
 {
   LOG::trace_in(channel::Component::tcp, "TCPChannel::{}(len:{})", __func__, data_len);
-  auto send_buffer = allocate_send_buffer(data_len);
+  return send_in_place(data_len, [&](u8 *buffer) {
+    memcpy(buffer, data, data_len);
+    return data_len;
+  });
+}
+
+std::error_code TCPChannel::send_in_place(u32 max_len, std::function<u32(u8 *)> const &fill)
+{
+  auto send_buffer = allocate_send_buffer(max_len);
   if (!send_buffer) {
-    // TODO: gracefully handle out-of-memory errors
-    std::abort();
+    callbacks_->on_error(UV_ENOMEM);
     return std::make_error_code(std::errc::not_enough_memory);
   }
 
-  memcpy(send_buffer->data, data, data_len);
-  send_buffer->len = data_len;
+  try {
+    send_buffer->len = fill(reinterpret_cast<u8 *>(send_buffer->data));
+  } catch (...) {
+    release_send_buffer(send_buffer);
+    throw;
+  }
+  ASSUME(send_buffer->len <= max_len);
 
   return send(send_buffer);
 }
 
 struct TCPChannel::send_buffer_t *TCPChannel::allocate_send_buffer(u32 size)
 {
-  u32 mem_size = ((sizeof(struct send_buffer_t) + 7) & ~7) + size;
-  struct send_buffer_t *ret = (struct send_buffer_t *)malloc(mem_size);
+  if (size <= send_limits_.pooled_buffer_size && !send_buffer_pool_.empty()) {
+    auto ret = send_buffer_pool_.back();
+    send_buffer_pool_.pop_back();
+    return ret;
+  }
+
+  /* buffers that fit in the pool's size get its capacity, so they can be reused */
+  u32 capacity = std::max(size, send_limits_.pooled_buffer_size);
+  u32 mem_size = ((sizeof(struct send_buffer_t) + 7) & ~7) + capacity;
+  // clear memory to ensure we don't exfiltrate uninitialized data; reused
+  // buffers only ever held data sent on this channel
+  struct send_buffer_t *ret = (struct send_buffer_t *)calloc(1, mem_size);
   if (ret == nullptr) {
     LOG::critical("Failed to allocate send buffer of size {} mem_size {}", size, mem_size);
     return nullptr;
   }
 
-  // clear memory to ensure we don't exfiltrate uninitialized data
-  memset(ret, 0, mem_size);
+  ret->capacity = capacity;
 
   return ret;
 }
 
+void TCPChannel::release_send_buffer(struct send_buffer_t *send_buffer)
+{
+  if ((send_buffer->capacity == send_limits_.pooled_buffer_size) &&
+      (send_buffer_pool_.size() < send_limits_.max_pooled_buffers)) {
+    send_buffer_pool_.push_back(send_buffer);
+  } else {
+    free(send_buffer);
+  }
+}
+
 std::error_code TCPChannel::send(struct send_buffer_t *send_buffer)
 {
+  if (full_since_ms_ && (uv_now(conn_.loop) - *full_since_ms_ > send_limits_.max_full_time_ms)) {
+    LOG::error(
+        "TCPChannel::{}: {} bytes waiting to be written, over the limit of {} for more than {}ms",
+        __func__,
+        in_flight_bytes_,
+        send_limits_.max_in_flight_bytes,
+        send_limits_.max_full_time_ms);
+
+    release_send_buffer(send_buffer);
+    callbacks_->on_error(UV_ENOBUFS);
+    return {UV_ENOBUFS, libuv_category()};
+  }
+
   uv_buf_t uv_buf = {.base = (char *)send_buffer->data, .len = send_buffer->len};
 
   if (auto const error = ::uv_write(&send_buffer->req, reinterpret_cast<uv_stream_t *>(&conn_), &uv_buf, 1, conn_write_cb)) {
@@ -288,19 +403,37 @@ std::error_code TCPChannel::send(struct send_buffer_t *send_buffer)
         CONNECTED_DISCONNECTED[connected_],
         uv_error_t{error});
 
+    release_send_buffer(send_buffer);
     callbacks_->on_error(error);
     return {error, libuv_category()};
   }
 
+  in_flight_bytes_ += send_buffer->len;
+  if (is_full() && !full_since_ms_) {
+    full_since_ms_ = uv_now(conn_.loop);
+  }
+
   return {};
 }
 
+bool TCPChannel::is_congested() const
+{
+  return send_limits_.max_in_flight_bytes && (in_flight_bytes_ > send_limits_.max_in_flight_bytes / 2);
+}
+
+bool TCPChannel::is_full() const
+{
+  return send_limits_.max_in_flight_bytes && (in_flight_bytes_ >= send_limits_.max_in_flight_bytes);
+}
+
 void TCPChannel::reinit(uv_loop_t *loop)
 {
   LOG::trace_in(channel::Component::tcp, "TCPChannel::{}()", __func__);
   /* reinit RX buffers */
   rx_len_ = 0;
   allocated_ = false;
+  receive_id_ = 0;
+  reading_paused_ = false;
 
   /* re-init handle */
   CHECK_UV(uv_tcp_init(loop, &conn_));
@@ -316,6 +449,13 @@ void TCPChannel::start_processing()
     // this error is not critical, we may continue
   }
 
+  if (receiver_) {
+    uv_os_fd_t fd;
+    CHECK_UV(uv_fileno(reinterpret_cast<uv_handle_t const *>(&conn_), &fd));
+    receive_id_ = receiver_->start(fd, *this);
+    return;
+  }
+
   if (auto const error = ::uv_read_start(reinterpret_cast<uv_stream_t *>(&conn_), &conn_read_alloc_cb, conn_read_cb)) {
     LOG::error("TCPChannel::{}: failed to start read loop on channel: {}", __func__, uv_error_t{error});
 
@@ -323,6 +463,37 @@ void TCPChannel::start_processing()
   }
 }
 
+void TCPChannel::pause_reading()
+{
+  LOG::trace_in(channel::Component::tcp, "TCPChannel::{}()", __func__);
+
+  if (receive_id_) {
+    reading_paused_ = true;
+    return;
+  }
+
+  uv_read_stop(reinterpret_cast<uv_stream_t *>(&conn_));
+}
+
+void TCPChannel::resume_reading()
+{
+  LOG::trace_in(channel::Component::tcp, "TCPChannel::{}()", __func__);
+
+  if (receive_id_) {
+    reading_paused_ = false;
+    if (rx_len_) {
+      process_rx_buffer(0);
+    }
+    return;
+  }
+
+  if (auto const error = ::uv_read_start(reinterpret_cast<uv_stream_t *>(&conn_), &conn_read_alloc_cb, conn_read_cb)) {
+    LOG::error("TCPChannel::{}: failed to resume read loop on channel: {}", __func__, uv_error_t{error});
+
+    callbacks_->on_error(error);
+  }
+}
+
 in_addr_t const *channel::TCPChannel::connected_address() const
 {
   std::array<in_addr_t const *, 2> choice = {nullptr, &connected_address_};
@@ -334,6 +505,10 @@ void channel::TCPChannel::close_internal(const uv_close_cb close_cb)
   LOG::trace_in(channel::Component::tcp, "TCPChannel::{}()", __func__);
   connected_address_available_ = false;
   connected_ = false;
+  if (receive_id_) {
+    receiver_->stop(receive_id_);
+    receive_id_ = 0;
+  }
   if (!uv_is_closing((uv_handle_t *)&conn_)) {
     LOG::trace_in(channel::Component::tcp, "TCPChannel::{}: connection not closing, calling close on handle()", __func__);
     uv_close((uv_handle_t *)&conn_, close_cb);
@@ -6,11 +6,16 @@
 #pragma once
 
 #include <channel/callbacks.h>
+#include <channel/io_uring_receiver.h>
 #include <channel/network_channel.h>
 #include <platform/platform.h>
 
 #include <uv.h>
 
+#include <memory>
+#include <optional>
+#include <vector>
+
 namespace channel {
 
 struct buffer_t {
@@ -19,34 +24,63 @@ struct buffer_t {
   u32 len;
 };
 
+/**
+ * Bounds on the memory a TCPChannel uses for data waiting to be written.
+ */
+struct TCPSendLimits {
+  /* capacity of the pooled send buffers; larger ones are freed after use */
+  u32 pooled_buffer_size = 32 * 1024;
+  /* maximum number of unused send buffers kept for reuse */
+  u32 max_pooled_buffers = 32;
+  /* maximum number of bytes waiting to be written, 0 for no limit */
+  u64 max_in_flight_bytes = 0;
+  /* how long the channel may stay at max_in_flight_bytes before failing */
+  u64 max_full_time_ms = 30'000;
+};
+
 /**
  * A TCP channel
  *
+ * Data is sent from send buffers, which are kept for reuse once written to the
+ * socket, up to TCPSendLimits::max_pooled_buffers of them. With
+ * TCPSendLimits::max_in_flight_bytes set, the channel is congested once half as
+ * many bytes wait to be written, and full once that many do. Sends are still
+ * taken while full, since dropping one would corrupt the stream, so senders
+ * are expected to hold back; the connection fails with UV_ENOBUFS on a send
+ * once the channel stayed full for TCPSendLimits::max_full_time_ms.
+ *
+ * Channels opened with open_fd() can receive through an IoUringReceiver rather
+ * than libuv. Received data is then handed to the callbacks straight from the
+ * receiver's buffers, and only what is left of a partial message is copied.
+ *
  * Errors for on_error callback:
  *   -EPROTO: handler threw exception
  *   -EOVERFLOW: overflow occupies entire buffer SERVER_CONN_BUFFER_SIZE and not
  *     handled by handler
+ *   UV_ENOBUFS: the channel stayed full for too long, see TCPSendLimits
+ *   UV_ENOMEM: a send buffer couldn't be allocated
  *   libuv errors.
  */
-class TCPChannel : public NetworkChannel {
+class TCPChannel : public NetworkChannel, private IoUringReceiver::Handler {
 public:
   static constexpr u32 rx_buffer_size = (64 * 1024);
 
   struct send_buffer_t {
     uv_write_t req; /* must be first */
     u32 len;
+    u32 capacity;
     u64 data[0];
   };
 
   /**
    * c'tor -- leaves socket ready for accept()
    */
-  TCPChannel(uv_loop_t &loop);
+  TCPChannel(uv_loop_t &loop, TCPSendLimits send_limits = {});
 
   /**
    * c'tor -- leaves socket ready for connect()
    */
-  TCPChannel(uv_loop_t &loop, std::string addr, std::string port);
+  TCPChannel(uv_loop_t &loop, std::string addr, std::string port, TCPSendLimits send_limits = {});
 
   /**
    * d'tor
@@ -71,8 +105,10 @@ public:
 
   /**
    * Opens a TCP connection from the file descriptor.
+   *
+   * @param receiver: if set, receives through it rather than libuv
    */
-  void open_fd(Callbacks &callbacks, uv_os_sock_t fd);
+  void open_fd(Callbacks &callbacks, uv_os_sock_t fd, IoUringReceiver *receiver = nullptr);
 
   /**
    * closes the channel. Callbacks::on_close will be called
@@ -89,9 +125,17 @@ public:
    */
   std::error_code send(const u8 *data, int data_len) override;
 
+  /**
+   * @see Channel::send_in_place
+   */
+  std::error_code send_in_place(u32 max_len, std::function<u32(u8 *)> const &fill) override;
+
   /**
    * Allocates a send buffer capable of holding @size bytes.
    *
+   * The buffer may be a reused one, so its contents are undefined: callers
+   * must set `len` to the number of bytes they wrote.
+   *
    * It is the responsibility of the caller to call send() with the buffer.
    */
   struct send_buffer_t *allocate_send_buffer(u32 size);
@@ -102,6 +146,41 @@ public:
    */
   std::error_code send(struct send_buffer_t *send_buffer);
 
+  /**
+   * Whether more than half of TCPSendLimits::max_in_flight_bytes wait to be
+   * written.
+   */
+  bool is_congested() const override;
+
+  /**
+   * Whether TCPSendLimits::max_in_flight_bytes wait to be written.
+   */
+  bool is_full() const override;
+
+  /**
+   * Number of bytes sent but not yet written to the socket, or given up on.
+   */
+  u64 in_flight_bytes() const { return in_flight_bytes_; }
+
+  /**
+   * Stops reading from the connection until resume_reading() is called, e.g.
+   * while received data can't be handled yet. Data already received is kept.
+   *
+   * When receiving through an IoUringReceiver, data keeps being received, and
+   * kept, until the receive buffer is full.
+   */
+  void pause_reading();
+
+  /**
+   * Resumes reading from the connection, after pause_reading().
+   */
+  void resume_reading();
+
+  /**
+   * Number of bytes sent but not yet written to the socket.
+   */
+  size_t write_queue_size() const { return conn_.write_queue_size; }
+
   /**
    * Returns the address (in binary format) that this channel is connected to,
    * if available. `nullptr` otherwise.
@@ -120,6 +199,11 @@ private:
 
   void close_internal(const uv_close_cb close_cb);
 
+  /**
+   * Returns a send buffer to the pool, or frees it
+   */
+  void release_send_buffer(struct send_buffer_t *send_buffer);
+
   /**
    * Inits the tcp handle (conn_) and buffers
    */
@@ -130,6 +214,22 @@ private:
    */
   void start_processing();
 
+  /**
+   * Hands the receive buffer to the callbacks after @len bytes were added to
+   * it. Returns false if the connection failed.
+   */
+  bool process_rx_buffer(u32 len);
+
+  /**
+   * Hands received data to the callbacks, returning how much they consumed,
+   * or nothing if the connection failed.
+   */
+  std::optional<u32> deliver(u8 const *data, u32 len);
+
+  /* IoUringReceiver::Handler */
+  void on_receive(u8 const *data, u32 len) override;
+  void on_receive_error(int error) override;
+
   Callbacks *callbacks_ = nullptr;
   std::string addr_;
   std::string port_;
@@ -145,9 +245,21 @@ private:
 
   bool allocated_ = false;
 
+  /* set when receiving through io_uring */
+  IoUringReceiver *receiver_ = nullptr;
+  u64 receive_id_ = 0;
+  bool reading_paused_ = false;
+
   bool connected_address_available_ = false;
   bool connected_ = false;
   in_addr_t connected_address_ = 0;
+
+  TCPSendLimits const send_limits_;
+  /* unused send buffers of capacity send_limits_.pooled_buffer_size */
+  std::vector<struct send_buffer_t *> send_buffer_pool_;
+  u64 in_flight_bytes_ = 0;
+  /* loop time at which the channel got full, if it is */
+  std::optional<u64> full_since_ms_;
 };
 
 } /* namespace channel */
@@ -0,0 +1,223 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <channel/tcp_channel.h>
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <memory>
+#include <string>
+
+namespace channel {
+namespace {
+
+constexpr u32 pooled_buffer_size = 4 * 1024;
+constexpr u64 max_in_flight_bytes = 1024 * 1024;
+constexpr u64 max_full_time_ms = 100;
+
+struct RecordingCallbacks : Callbacks {
+  u32 received_data(u8 const *data, int length) override
+  {
+    received += length;
+    return length;
+  }
+
+  void on_error(int error) override { last_error = error; }
+
+  void on_connect() override { connected = true; }
+
+  u64 received = 0;
+  int last_error = 0;
+  bool connected = false;
+};
+
+// A client connected over loopback to a server in the same loop.
+class TCPChannelTest : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    ASSERT_EQ(0, uv_loop_init(&loop_));
+
+    ASSERT_EQ(0, uv_tcp_init(&loop_, &listener_));
+    listener_.data = this;
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(0, uv_tcp_bind(&listener_, reinterpret_cast<struct sockaddr const *>(&addr), 0));
+    ASSERT_EQ(0, uv_listen(reinterpret_cast<uv_stream_t *>(&listener_), 1, on_new_connection));
+
+    int len = sizeof(addr);
+    ASSERT_EQ(0, uv_tcp_getsockname(&listener_, reinterpret_cast<struct sockaddr *>(&addr), &len));
+
+    client_ = std::make_unique<TCPChannel>(
+        loop_,
+        "127.0.0.1",
+        std::to_string(ntohs(addr.sin_port)),
+        TCPSendLimits{
+            .pooled_buffer_size = pooled_buffer_size,
+            .max_pooled_buffers = 4,
+            .max_in_flight_bytes = max_in_flight_bytes,
+            .max_full_time_ms = max_full_time_ms,
+        });
+    client_->connect(client_callbacks_);
+
+    while (!client_callbacks_.connected || !server_) {
+      ASSERT_EQ(0, client_callbacks_.last_error);
+      uv_run(&loop_, UV_RUN_ONCE);
+    }
+  }
+
+  void TearDown() override
+  {
+    client_->close_permanently();
+    if (server_) {
+      server_->close_permanently();
+    }
+    uv_close(reinterpret_cast<uv_handle_t *>(&listener_), nullptr);
+    uv_run(&loop_, UV_RUN_DEFAULT);
+
+    client_.reset();
+    server_.reset();
+    EXPECT_EQ(0, uv_loop_close(&loop_));
+  }
+
+  // Runs the loop until what was sent so far is written to the socket.
+  void wait_for_writes()
+  {
+    while (client_->in_flight_bytes()) {
+      uv_run(&loop_, UV_RUN_ONCE);
+    }
+  }
+
+  static void on_new_connection(uv_stream_t *stream, int status)
+  {
+    ASSERT_EQ(0, status);
+    auto test = reinterpret_cast<TCPChannelTest *>(stream->data);
+    test->server_ = std::make_unique<TCPChannel>(test->loop_);
+    test->server_->accept(test->server_callbacks_, &test->listener_);
+  }
+
+  uv_loop_t loop_;
+  uv_tcp_t listener_;
+
+  RecordingCallbacks client_callbacks_;
+  RecordingCallbacks server_callbacks_;
+  std::unique_ptr<TCPChannel> client_;
+  std::unique_ptr<TCPChannel> server_;
+};
+
+} // namespace
+
+TEST_F(TCPChannelTest, ReusesSendBuffers)
+{
+  auto const small = client_->allocate_send_buffer(100);
+  ASSERT_NE(nullptr, small);
+  EXPECT_EQ(pooled_buffer_size, small->capacity);
+  small->len = 100;
+  ASSERT_FALSE(client_->send(small));
+  EXPECT_EQ(100u, client_->in_flight_bytes());
+  wait_for_writes();
+
+  // once written, the buffer is reused
+  auto const reused = client_->allocate_send_buffer(pooled_buffer_size);
+  EXPECT_EQ(small, reused);
+  reused->len = pooled_buffer_size;
+  ASSERT_FALSE(client_->send(reused));
+
+  // larger buffers aren't pooled
+  auto const large = client_->allocate_send_buffer(pooled_buffer_size + 1);
+  ASSERT_NE(nullptr, large);
+  EXPECT_NE(reused, large);
+  EXPECT_EQ(pooled_buffer_size + 1, large->capacity);
+  large->len = pooled_buffer_size + 1;
+  ASSERT_FALSE(client_->send(large));
+  wait_for_writes();
+
+  while (server_callbacks_.received < 100 + 2 * pooled_buffer_size + 1) {
+    uv_run(&loop_, UV_RUN_ONCE);
+  }
+  EXPECT_EQ(0, client_callbacks_.last_error);
+}
+
+TEST_F(TCPChannelTest, SendsInPlace)
+{
+  std::string const data = "written in place";
+  ASSERT_FALSE(client_->send_in_place(pooled_buffer_size, [&](u8 *buffer) {
+    memcpy(buffer, data.data(), data.size());
+    return u32(data.size());
+  }));
+  EXPECT_EQ(data.size(), client_->in_flight_bytes());
+
+  while (server_callbacks_.received < data.size()) {
+    uv_run(&loop_, UV_RUN_ONCE);
+  }
+}
+
+TEST_F(TCPChannelTest, LimitsBytesInFlight)
+{
+  // the server stops reading, so the socket's buffers fill up
+  server_->pause_reading();
+
+  std::string const chunk(pooled_buffer_size, 'x');
+  bool congested = false;
+  for (u64 sent = 0; !client_->is_full(); sent += chunk.size()) {
+    ASSERT_LT(sent, 1024 * max_in_flight_bytes) << "the limit was never reached";
+    EXPECT_LT(client_->in_flight_bytes(), max_in_flight_bytes);
+
+    congested |= client_->is_congested();
+    if (!client_->is_congested()) {
+      EXPECT_LE(client_->in_flight_bytes(), max_in_flight_bytes / 2);
+    }
+
+    ASSERT_FALSE(client_->send(reinterpret_cast<u8 const *>(chunk.data()), chunk.size()));
+    uv_run(&loop_, UV_RUN_NOWAIT);
+  }
+  EXPECT_TRUE(congested);
+
+  // sends are still taken while full, until it lasts too long
+  auto const full_at = uv_now(&loop_);
+  while (!client_callbacks_.last_error) {
+    EXPECT_TRUE(client_->is_full());
+    client_->send(reinterpret_cast<u8 const *>(chunk.data()), chunk.size());
+    uv_sleep(10);
+    uv_update_time(&loop_);
+    uv_run(&loop_, UV_RUN_NOWAIT);
+  }
+
+  EXPECT_EQ(UV_ENOBUFS, client_callbacks_.last_error);
+  EXPECT_LE(max_full_time_ms, uv_now(&loop_) - full_at);
+}
+
+TEST_F(TCPChannelTest, KeepsSendingOnceDrained)
+{
+  server_->pause_reading();
+
+  std::string const chunk(pooled_buffer_size, 'x');
+  u64 sent = 0;
+  for (; !client_->is_full(); sent += chunk.size()) {
+    ASSERT_LT(sent, 1024 * max_in_flight_bytes) << "the limit was never reached";
+    ASSERT_FALSE(client_->send(reinterpret_cast<u8 const *>(chunk.data()), chunk.size()));
+    uv_run(&loop_, UV_RUN_NOWAIT);
+  }
+
+  // the server catches up before the channel stayed full for too long
+  server_->resume_reading();
+  wait_for_writes();
+  EXPECT_FALSE(client_->is_full());
+
+  uv_sleep(2 * max_full_time_ms);
+  uv_update_time(&loop_);
+  ASSERT_FALSE(client_->send(reinterpret_cast<u8 const *>(chunk.data()), chunk.size()));
+  sent += chunk.size();
+
+  while (server_callbacks_.received < sent) {
+    uv_run(&loop_, UV_RUN_ONCE);
+  }
+  EXPECT_EQ(0, client_callbacks_.last_error);
+}
+
+} // namespace channel
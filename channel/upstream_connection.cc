@@ -9,13 +9,39 @@
 namespace channel {
 
 UpstreamConnection::UpstreamConnection(
-    std::size_t buffer_size, bool allow_compression, NetworkChannel &primary_channel, Channel *secondary_channel)
+    std::size_t buffer_size,
+    bool allow_compression,
+    NetworkChannel &primary_channel,
+    Channel *secondary_channel,
+    IntakeCompression compression,
+    std::string_view zstd_dictionary)
     : primary_channel_(primary_channel),
       lz4_channel_(primary_channel_, buffer_size),
+#if ENABLE_ZSTD
+      zstd_channel_(
+          compression == IntakeCompression::zstd ? std::make_unique<ZstdChannel>(primary_channel_, buffer_size, zstd_dictionary)
+                                                 : nullptr),
+#endif
       allow_compression_(allow_compression),
-      double_write_channel_(lz4_channel_, secondary_channel ? *secondary_channel : lz4_channel_),
-      buffered_writer_(secondary_channel ? static_cast<Channel &>(double_write_channel_) : lz4_channel_, buffer_size)
-{}
+      double_write_channel_(compression_channel(), secondary_channel ? *secondary_channel : compression_channel()),
+      buffered_writer_(secondary_channel ? static_cast<Channel &>(double_write_channel_) : compression_channel(), buffer_size)
+{
+#if !ENABLE_ZSTD
+  if (compression == IntakeCompression::zstd) {
+    LOG::warn("UpstreamConnection: zstd compression is not supported by this build, compressing with LZ4 instead");
+  }
+#endif
+}
+
+Channel &UpstreamConnection::compression_channel()
+{
+#if ENABLE_ZSTD
+  if (zstd_channel_) {
+    return *zstd_channel_;
+  }
+#endif
+  return lz4_channel_;
+}
 
 void UpstreamConnection::connect(Callbacks &callbacks)
 {
@@ -49,12 +75,25 @@ void UpstreamConnection::set_compression(bool enabled)
 {
   buffered_writer_.flush();
 
+#if ENABLE_ZSTD
+  bool const zstd = zstd_channel_ != nullptr;
+#else
+  bool const zstd = false;
+#endif
+
   LOG::trace_in(
       Component::upstream,
-      "UpstreamConnection: {} ({}allowed) LZ4 compression",
+      "UpstreamConnection: {} ({}allowed) {} compression",
       enabled ? "enabling" : "disabling",
-      allow_compression_ ? "" : "not ");
+      allow_compression_ ? "" : "not ",
+      zstd ? "zstd" : "LZ4");
 
+#if ENABLE_ZSTD
+  if (zstd) {
+    zstd_channel_->set_compression(enabled && allow_compression_);
+    return;
+  }
+#endif
   lz4_channel_.set_compression(enabled && allow_compression_);
 }
 
@@ -5,19 +5,36 @@
 
 #pragma once
 
+#include <config.h>
+
 #include <channel/buffered_writer.h>
 #include <channel/callbacks.h>
 #include <channel/double_write_channel.h>
 #include <channel/lz4_channel.h>
 #include <channel/network_channel.h>
+#if ENABLE_ZSTD
+#include <channel/zstd_channel.h>
+#endif
+#include <common/intake_compression.h>
 #include <platform/platform.h>
 
+#include <memory>
+#include <string_view>
+
 namespace channel {
 
 class UpstreamConnection : public NetworkChannel {
 public:
+  // |compression| picks the codec used when compression is allowed and
+  // enabled; |zstd_dictionary| holds the contents of the dictionary to use
+  // with zstd, if any. Builds without zstd use LZ4 instead.
   UpstreamConnection(
-      std::size_t buffer_size, bool allow_compression, NetworkChannel &primary_channel, Channel *secondary_channel = nullptr);
+      std::size_t buffer_size,
+      bool allow_compression,
+      NetworkChannel &primary_channel,
+      Channel *secondary_channel = nullptr,
+      IntakeCompression compression = IntakeCompression::lz4,
+      std::string_view zstd_dictionary = {});
 
   /**
    * Connects to an endpoint and starts negotiating
@@ -50,9 +67,19 @@ public:
 
   bool is_open() const override { return primary_channel_.is_open(); }
 
+  bool is_congested() const override { return primary_channel_.is_congested(); }
+  bool is_full() const override { return primary_channel_.is_full(); }
+
 private:
+  // Returns the channel that compresses with the chosen codec.
+  Channel &compression_channel();
+
   NetworkChannel &primary_channel_;
   Lz4Channel lz4_channel_;
+#if ENABLE_ZSTD
+  // Only set when compressing with zstd.
+  std::unique_ptr<ZstdChannel> zstd_channel_;
+#endif
   bool allow_compression_;
   DoubleWriteChannel double_write_channel_;
   BufferedWriter buffered_writer_;
@@ -0,0 +1,82 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include "channel/zstd_channel.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace channel {
+
+#define _CHECK_ZSTD_ERROR(code)                                                                                                \
+  if (ZSTD_isError(code)) {                                                                                                    \
+    throw std::runtime_error(std::string("ZstdChannel: compression failed: ") + std::string(ZSTD_getErrorName(code)));         \
+  }
+
+ZstdChannel::ZstdChannel(Channel &channel, u32 max_data_length, std::string_view dictionary)
+    : compression_enabled_(false),
+      channel_(channel),
+      max_packet_length_(std::max(ZSTD_compressBound(max_data_length), ZSTD_CStreamOutSize())),
+      zstd_ctx_(ZSTD_createCCtx())
+{
+  if (!zstd_ctx_) {
+    throw std::runtime_error("ZstdChannel: Failed to create zstd context.");
+  }
+
+  _CHECK_ZSTD_ERROR(ZSTD_CCtx_setParameter(zstd_ctx_.get(), ZSTD_c_compressionLevel, compression_level));
+
+  if (!dictionary.empty()) {
+    dictionary_.reset(ZSTD_createCDict(dictionary.data(), dictionary.size(), compression_level));
+    if (!dictionary_) {
+      throw std::runtime_error("ZstdChannel: Failed to load zstd dictionary.");
+    }
+    _CHECK_ZSTD_ERROR(ZSTD_CCtx_refCDict(zstd_ctx_.get(), dictionary_.get()));
+  }
+}
+
+void ZstdChannel::set_compression(bool enabled)
+{
+  compression_enabled_ = enabled;
+
+  // keeps the parameters and dictionary
+  ZSTD_CCtx_reset(zstd_ctx_.get(), ZSTD_reset_session_only);
+}
+
+std::error_code ZstdChannel::send(const u8 *data, int data_len)
+{
+  if (!compression_enabled_) {
+    return channel_.send(data, data_len);
+  }
+
+  ZSTD_inBuffer input = {.src = data, .size = size_t(data_len), .pos = 0};
+
+  // a packet normally fits in one buffer, but flush until zstd is done
+  for (size_t remaining = 1; remaining;) {
+    auto const error = channel_.send_in_place(max_packet_length_, [&](u8 *buffer) {
+      ZSTD_outBuffer output = {.dst = buffer, .size = max_packet_length_, .pos = 0};
+
+      remaining = ZSTD_compressStream2(zstd_ctx_.get(), &output, &input, ZSTD_e_flush);
+      _CHECK_ZSTD_ERROR(remaining);
+
+      return u32(output.pos);
+    });
+    if (error) {
+      return error;
+    }
+  }
+
+  return {};
+}
+
+void ZstdChannel::close()
+{
+  channel_.close();
+}
+
+std::error_code ZstdChannel::flush()
+{
+  return channel_.flush();
+}
+
+} // namespace channel
@@ -0,0 +1,65 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <channel/channel.h>
+#include <platform/types.h>
+#include <util/raii.h>
+
+#include <zstd.h>
+
+#include <string_view>
+
+namespace channel {
+
+// ZstdChannel is the zstd counterpart of Lz4Channel: when compression is
+// enabled, it compresses incoming data packets before relaying them to the
+// downstream channel.
+//
+// Compressed packets are flushed parts of a single zstd frame, which starts
+// when compression is enabled, so each packet is compressed using the
+// previous ones as history. A dictionary trained on typical traffic gives
+// the first packets of a connection that history too.
+class ZstdChannel : public Channel {
+public:
+  // Favors speed, as collectors compress on hosts running other workloads.
+  static constexpr int compression_level = 1;
+
+  // |channel|: the downstream channel which will actually send out the data.
+  // |max_data_length|: max number of bytes of any incoming data packet sent
+  //                    via send() function.
+  // |dictionary|: contents of a dictionary made by `zstd --train`, or empty
+  //               to compress without one. The receiving end needs the same
+  //               dictionary, identified by its ID in the frame header.
+  ZstdChannel(Channel &channel, u32 max_data_length, std::string_view dictionary = {});
+
+  std::error_code send(const u8 *data, int data_len) override;
+
+  // Enables or disables compression. Either way, the next compressed packet
+  // starts a new frame.
+  void set_compression(bool enabled);
+
+  void close() override;
+  std::error_code flush() override;
+
+  bool is_open() const override { return channel_.is_open(); }
+
+  bool is_congested() const override { return channel_.is_congested(); }
+  bool is_full() const override { return channel_.is_full(); }
+
+private:
+  bool compression_enabled_;
+
+  Channel &channel_;
+  // Largest packet a send() produces; packets are compressed directly into
+  // the downstream channel's send buffers.
+  u32 const max_packet_length_;
+
+  pod_unique_ptr<ZSTD_CCtx, size_t, ZSTD_freeCCtx> zstd_ctx_;
+  pod_unique_ptr<ZSTD_CDict, size_t, ZSTD_freeCDict> dictionary_;
+};
+
+} // namespace channel
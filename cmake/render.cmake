@@ -71,6 +71,8 @@ function(render_compile INPUT_DIR)
         "${OUTPUT_DIR}/${PACKAGE}/${APP}/protocol.cc"
         "${OUTPUT_DIR}/${PACKAGE}/${APP}/transform_builder.h"
         "${OUTPUT_DIR}/${PACKAGE}/${APP}/transform_builder.cc"
+        "${OUTPUT_DIR}/${PACKAGE}/${APP}/snapshot.h"
+        "${OUTPUT_DIR}/${PACKAGE}/${APP}/snapshot.cc"
         "${OUTPUT_DIR}/${PACKAGE}/${APP}/parsed_message.h"
         "${OUTPUT_DIR}/${PACKAGE}/${APP}/wire_message.h"
         "${OUTPUT_DIR}/${PACKAGE}/${APP}/meta.h"
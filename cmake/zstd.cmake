@@ -0,0 +1,26 @@
+# Copyright The OpenTelemetry Authors
+# SPDX-License-Identifier: Apache-2.0
+
+include_guard()
+
+# Without zstd, collectors configured for zstd compression use LZ4 instead.
+option(ENABLE_ZSTD "Enable zstd compression of collector telemetry" ON)
+
+if(ENABLE_ZSTD)
+  find_path(ZSTD_INCLUDE_DIR zstd.h)
+  find_library(ZSTD_LIBRARY NAMES "libzstd.a")
+  find_package_handle_standard_args(ZSTD DEFAULT_MSG ZSTD_LIBRARY ZSTD_INCLUDE_DIR)
+  if(NOT ZSTD_FOUND)
+    message(WARNING "Could not find zstd, building without zstd compression")
+    set(ENABLE_ZSTD OFF)
+  endif()
+endif()
+
+message(STATUS "ENABLE_ZSTD is ${ENABLE_ZSTD}")
+if(ENABLE_ZSTD)
+  message(STATUS "zstd INCLUDE_DIR: ${ZSTD_INCLUDE_DIR}")
+  message(STATUS "zstd LIBRARY: ${ZSTD_LIBRARY}")
+  add_library(zstd INTERFACE)
+  target_include_directories(zstd INTERFACE "${ZSTD_INCLUDE_DIR}")
+  target_link_libraries(zstd INTERFACE "${ZSTD_LIBRARY}")
+endif()
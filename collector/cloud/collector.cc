@@ -30,7 +30,8 @@ CloudCollector::CloudCollector(
     std::chrono::milliseconds heartbeat_interval,
     std::size_t buffer_size,
     config::IntakeConfig intake_config,
-    std::chrono::milliseconds poll_interval)
+    std::chrono::milliseconds poll_interval,
+    std::string ec2_endpoint)
     : loop_(loop),
       connection_(
           hostname,
@@ -42,7 +43,7 @@ CloudCollector::CloudCollector(
           *this,
           std::bind(&CloudCollector::on_connected, this)),
       log_(connection_.writer()),
-      enumerator_(log_, connection_.index(), connection_.writer()),
+      enumerator_(log_, connection_.index(), connection_.writer(), std::move(ec2_endpoint)),
       scheduler_(loop_, std::bind(&CloudCollector::callback, this)),
       poll_interval_(poll_interval)
 {}
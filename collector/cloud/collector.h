@@ -26,7 +26,8 @@ struct CloudCollector : channel::Callbacks {
       std::chrono::milliseconds heartbeat_interval,
       std::size_t buffer_size,
       config::IntakeConfig intake_config,
-      std::chrono::milliseconds poll_interval);
+      std::chrono::milliseconds poll_interval,
+      std::string ec2_endpoint = {});
 
   ~CloudCollector();
 
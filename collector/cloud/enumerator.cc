@@ -17,7 +17,12 @@
 #include <util/resource_usage_reporter.h>
 #include <util/stop_watch.h>
 
-#include <array>
+#include <absl/container/flat_hash_set.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
 #include <type_traits>
 #include <utility>
 
@@ -25,107 +30,86 @@
 
 namespace collector::cloud {
 
-NetworkInterfacesEnumerator::NetworkInterfacesEnumerator(
-    logging::Logger &log, ebpf_net::cloud_collector::Index &index, ebpf_net::ingest::Writer &writer)
-    : index_(index), writer_(writer), log_(log)
-{}
+namespace {
 
-NetworkInterfacesEnumerator::~NetworkInterfacesEnumerator()
-{
-  free_handles();
-}
+// Largest page DescribeNetworkInterfaces is asked for.
+constexpr int describe_page_size = 1000;
 
-void NetworkInterfacesEnumerator::set_handles(std::vector<ebpf_net::cloud_collector::handles::aws_network_interface> handles)
+Aws::Client::ClientConfiguration make_client_config(std::string const &ec2_endpoint, Aws::String const &region = {})
 {
-  free_handles();
-  handles_ = std::move(handles);
+  Aws::Client::ClientConfiguration client_config;
+  if (!region.empty()) {
+    client_config.region = region;
+  }
+  if (!ec2_endpoint.empty()) {
+    client_config.endpointOverride = ec2_endpoint;
+  }
+  return client_config;
 }
 
-void NetworkInterfacesEnumerator::free_handles()
+// Lists the network interfaces of |result.region|, one page at a time.
+void describe_network_interfaces(std::string const &ec2_endpoint, NetworkInterfacesEnumerator::RegionInterfaces &result)
 {
-  for (auto &handle : handles_) {
-    handle.put(index_);
-  }
+  Aws::EC2::EC2Client client(make_client_config(ec2_endpoint, result.region));
 
-  handles_.clear();
-}
+  Aws::EC2::Model::DescribeNetworkInterfacesRequest request;
+  request.SetMaxResults(describe_page_size);
 
-void translate_interfaces_to_spans(
-    ebpf_net::cloud_collector::Index &index,
-    Aws::Vector<Aws::EC2::Model::NetworkInterface> const &interfaces,
-    std::vector<ebpf_net::cloud_collector::handles::aws_network_interface> &handles)
-{
-  for (auto const &interface : interfaces) {
-    auto const &attachment = interface.GetAttachment();
-    auto const &association = interface.GetAssociation();
-    auto const &ip_owner_id = association.GetIpOwnerId();
-    auto const &vpc_id = interface.GetVpcId();
-    auto const &az = interface.GetAvailabilityZone();
-
-    auto const &interface_id = interface.GetNetworkInterfaceId();
-    auto const raw_interface_type = static_cast<std::uint16_t>(interface.GetInterfaceType());
-    auto const &instance_id = attachment.GetInstanceId();
-    auto const &instance_owner_id = attachment.GetInstanceOwnerId();
-    auto const &public_dns_name = association.GetPublicDnsName();
-    auto const &private_dns_name = interface.GetPrivateDnsName();
-    auto const &description = interface.GetDescription();
-
-    auto const add_entry = [&](IPv6Address const &ipv6) {
-      auto handle = index.aws_network_interface.by_key({.ip = ipv6.as_int()});
-
-      LOG::trace(
-          "network_interface_info:"
-          " ip={}"
-          " ip_owner_id={}"
-          " vpc_id={}"
-          " az={}"
-          " interface_id={} interface_type={} instance_id={} instance_owner_id={}"
-          " public_dns_name={} private_dns_name={} description={}",
-          ipv6,
-          ip_owner_id,
-          vpc_id,
-          az,
-          interface_id,
-          raw_interface_type,
-          instance_id,
-          instance_owner_id,
-          public_dns_name,
-          private_dns_name,
-          description);
-
-      handle.network_interface_info(
-          jb_blob{ip_owner_id},
-          jb_blob{vpc_id},
-          jb_blob{az},
-          jb_blob{interface_id},
-          raw_interface_type,
-          jb_blob{instance_id},
-          jb_blob{instance_owner_id},
-          jb_blob{public_dns_name},
-          jb_blob{private_dns_name},
-          jb_blob{description});
-
-      handles.emplace_back(handle.to_handle());
-    };
-
-    if (auto const public_ip = IPv4Address::parse(association.GetPublicIp().c_str())) {
-      add_entry(public_ip->to_ipv6());
+  for (;;) {
+    auto const response = client.DescribeNetworkInterfaces(request);
+    if (!response.IsSuccess()) {
+      result.error = response.GetError();
+      return;
     }
 
-    for (auto const &ipv4 : interface.GetPrivateIpAddresses()) {
-      auto const private_ip = IPv4Address::parse(ipv4.GetPrivateIpAddress().c_str());
+    auto const &page = response.GetResult();
+    auto const &interfaces = page.GetNetworkInterfaces();
+    result.interfaces.insert(result.interfaces.end(), interfaces.begin(), interfaces.end());
 
-      if (private_ip) {
-        add_entry(private_ip->to_ipv6());
-      }
+    if (page.GetNextToken().empty()) {
+      return;
     }
+    request.SetNextToken(page.GetNextToken());
+  }
+}
 
-    for (auto const &address : interface.GetIpv6Addresses()) {
-      if (auto const ipv6 = IPv6Address::parse(address.GetIpv6Address().c_str())) {
-        add_entry(*ipv6);
-      }
-    }
+} // namespace
+
+NetworkInterfacesEnumerator::Ec2Requests NetworkInterfacesEnumerator::aws_ec2_requests(std::string ec2_endpoint)
+{
+  auto const client = std::make_shared<Aws::EC2::EC2Client>(make_client_config(ec2_endpoint));
+
+  return {
+      .describe_regions = [client]() { return client->DescribeRegions({}); },
+      .describe_network_interfaces =
+          [ec2_endpoint = std::move(ec2_endpoint)](RegionInterfaces &result) {
+            describe_network_interfaces(ec2_endpoint, result);
+          },
+  };
+}
+
+NetworkInterfacesEnumerator::NetworkInterfacesEnumerator(
+    logging::Logger &log, ebpf_net::cloud_collector::Index &index, ebpf_net::ingest::Writer &writer, std::string ec2_endpoint)
+    : NetworkInterfacesEnumerator(log, index, writer, aws_ec2_requests(std::move(ec2_endpoint)))
+{}
+
+NetworkInterfacesEnumerator::NetworkInterfacesEnumerator(
+    logging::Logger &log, ebpf_net::cloud_collector::Index &index, ebpf_net::ingest::Writer &writer, Ec2Requests ec2)
+    : ec2_(std::move(ec2)), index_(index), writer_(writer), log_(log)
+{}
+
+NetworkInterfacesEnumerator::~NetworkInterfacesEnumerator()
+{
+  free_handles();
+}
+
+void NetworkInterfacesEnumerator::free_handles()
+{
+  for (auto &[ip, known] : addresses_) {
+    known.handle.put(index_);
   }
+
+  addresses_.clear();
 }
 
 void NetworkInterfacesEnumerator::handle_ec2_error(
@@ -159,44 +143,172 @@ scheduling::JobFollowUp NetworkInterfacesEnumerator::enumerate()
 {
   ResourceUsageReporter::report(writer_);
 
-  auto const regions_response = ec2_.DescribeRegions({});
+  auto const regions_response = ec2_.describe_regions();
   if (!regions_response.IsSuccess()) {
     handle_ec2_error(CollectorStatus::aws_describe_regions_error, regions_response.GetError());
     return scheduling::JobFollowUp::backoff;
   }
 
-  std::vector<ebpf_net::cloud_collector::handles::aws_network_interface> handles;
-  auto result = scheduling::JobFollowUp::ok;
+  auto const &regions = regions_response.GetResult().GetRegions();
+  std::vector<RegionInterfaces> region_interfaces(regions.size());
+  for (std::size_t i = 0; i < regions.size(); ++i) {
+    region_interfaces[i].region = regions[i].GetRegionName();
+  }
 
   LOG::trace("starting AWS network interfaces enumeration");
   StopWatch<> watch;
-  for (auto const &region : regions_response.GetResult().GetRegions()) {
-    LOG::trace("enumerating network interfaces in region '{}'", region.GetRegionName());
 
-    Aws::Client::ClientConfiguration client_config;
-    client_config.region = region.GetRegionName();
+  // regions are enumerated a few at a time, since most of the time goes into
+  // waiting for EC2
+  std::atomic<std::size_t> next_region = 0;
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < std::min(max_concurrent_regions, regions.size()); ++i) {
+    threads.emplace_back([&] {
+      for (std::size_t region; (region = next_region++) < region_interfaces.size();) {
+        ec2_.describe_network_interfaces(region_interfaces[region]);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  LOG::trace("finished AWS network interfaces enumeration after {}", watch.elapsed<std::chrono::milliseconds>());
 
-    Aws::EC2::EC2Client client(client_config);
+  auto result = scheduling::JobFollowUp::ok;
 
-    auto const interfaces_response = client.DescribeNetworkInterfaces({});
+  // addresses found, with the region they were found in; an address found in
+  // more than one interface is attributed to the last one
+  absl::flat_hash_map<IPv6Address, std::pair<std::string const *, AddressInfo>> found;
+  // regions that couldn't be enumerated, whose addresses are kept as they were
+  absl::flat_hash_set<std::string> failed_regions;
 
-    if (!interfaces_response.IsSuccess()) {
-      handle_ec2_error(CollectorStatus::aws_describe_network_interfaces_error, interfaces_response.GetError());
+  for (auto const &region : region_interfaces) {
+    if (region.error) {
+      handle_ec2_error(CollectorStatus::aws_describe_network_interfaces_error, *region.error);
+      failed_regions.insert(region.region);
       result = scheduling::JobFollowUp::backoff;
       continue;
     }
 
-    auto const &interfaces = interfaces_response.GetResult().GetNetworkInterfaces();
+    LOG::trace("found {} network interfaces in region '{}'", region.interfaces.size(), region.region);
+
+    for (auto const &interface : region.interfaces) {
+      auto const &attachment = interface.GetAttachment();
+      auto const &association = interface.GetAssociation();
+
+      AddressInfo info{
+          .ip_owner_id = association.GetIpOwnerId(),
+          .vpc_id = interface.GetVpcId(),
+          .az = interface.GetAvailabilityZone(),
+          .interface_id = interface.GetNetworkInterfaceId(),
+          .interface_type = static_cast<std::uint16_t>(interface.GetInterfaceType()),
+          .instance_id = attachment.GetInstanceId(),
+          .instance_owner_id = attachment.GetInstanceOwnerId(),
+          .public_dns_name = association.GetPublicDnsName(),
+          .private_dns_name = interface.GetPrivateDnsName(),
+          .description = interface.GetDescription(),
+      };
+
+      auto const add_entry = [&](IPv6Address const &ipv6) {
+        found.insert_or_assign(ipv6, std::make_pair(&region.region, info));
+      };
+
+      if (auto const public_ip = IPv4Address::parse(association.GetPublicIp().c_str())) {
+        add_entry(public_ip->to_ipv6());
+      }
 
-    LOG::trace("found {} network interfaces in region '{}'", interfaces.size(), region.GetRegionName());
+      for (auto const &ipv4 : interface.GetPrivateIpAddresses()) {
+        if (auto const private_ip = IPv4Address::parse(ipv4.GetPrivateIpAddress().c_str())) {
+          add_entry(private_ip->to_ipv6());
+        }
+      }
 
-    translate_interfaces_to_spans(index_, interfaces, handles);
+      for (auto const &address : interface.GetIpv6Addresses()) {
+        if (auto const ipv6 = IPv6Address::parse(address.GetIpv6Address().c_str())) {
+          add_entry(*ipv6);
+        }
+      }
+    }
+  }
+
+  // only addresses that are new or changed are sent to the reducer
+  absl::flat_hash_map<IPv6Address, KnownAddress> addresses;
+  addresses.reserve(found.size());
+  std::size_t added = 0;
+  std::size_t changed = 0;
+
+  for (auto &[ipv6, entry] : found) {
+    auto &[region, info] = entry;
+
+    auto known = addresses_.extract(ipv6);
+    if (known && known.mapped().info == info) {
+      known.mapped().region = *region;
+      addresses.insert(std::move(known));
+      continue;
+    }
+
+    auto handle = index_.aws_network_interface.by_key({.ip = ipv6.as_int()});
+
+    LOG::trace(
+        "network_interface_info:"
+        " ip={}"
+        " ip_owner_id={}"
+        " vpc_id={}"
+        " az={}"
+        " interface_id={} interface_type={} instance_id={} instance_owner_id={}"
+        " public_dns_name={} private_dns_name={} description={}",
+        ipv6,
+        info.ip_owner_id,
+        info.vpc_id,
+        info.az,
+        info.interface_id,
+        info.interface_type,
+        info.instance_id,
+        info.instance_owner_id,
+        info.public_dns_name,
+        info.private_dns_name,
+        info.description);
+
+    handle.network_interface_info(
+        jb_blob{info.ip_owner_id},
+        jb_blob{info.vpc_id},
+        jb_blob{info.az},
+        jb_blob{info.interface_id},
+        info.interface_type,
+        jb_blob{info.instance_id},
+        jb_blob{info.instance_owner_id},
+        jb_blob{info.public_dns_name},
+        jb_blob{info.private_dns_name},
+        jb_blob{info.description});
+
+    if (known) {
+      // same span, the reference taken above keeps it alive
+      known.mapped().handle.put(index_);
+      ++changed;
+    } else {
+      ++added;
+    }
+
+    addresses.emplace(ipv6, KnownAddress{.handle = handle.to_handle(), .region = *region, .info = std::move(info)});
+  }
+
+  // what's left wasn't found: releasing its span deletes it from the reducer,
+  // unless its region couldn't be enumerated
+  std::size_t removed = 0;
+  for (auto &[ipv6, known] : addresses_) {
+    if (failed_regions.contains(known.region)) {
+      addresses.emplace(ipv6, std::move(known));
+      continue;
+    }
+    known.handle.put(index_);
+    ++removed;
   }
-  LOG::trace("finished AWS network interfaces enumeration after {}", watch.elapsed<std::chrono::milliseconds>());
 
-  set_handles(std::move(handles));
+  addresses_ = std::move(addresses);
 
-  LOG::trace("network interface live span count: {}", handles_.size());
+  LOG::trace(
+      "network interface addresses: {} live, {} added, {} changed, {} removed", addresses_.size(), added, changed, removed);
 
   if (result == scheduling::JobFollowUp::ok) {
     LOG::trace("reporting cloud collector as healthy");
@@ -8,18 +8,55 @@
 #include <common/collector_status.h>
 #include <generated/ebpf_net/cloud_collector/handles.h>
 #include <scheduling/job.h>
+#include <util/ip_address.h>
 #include <util/logger.h>
 
 #include <aws/ec2/EC2Client.h>
 
+#include <absl/container/flat_hash_map.h>
+
 #include <functional>
+#include <optional>
+#include <string>
 #include <vector>
 
 namespace collector::cloud {
 
+// Enumerates the network interfaces of all regions, and keeps the reducer
+// informed of their addresses.
+//
+// Only addresses that are new or whose interface changed since the last
+// enumeration are sent; addresses that are gone are released, so that the
+// reducer deletes them.
 struct NetworkInterfacesEnumerator {
+  // The network interfaces of a region, or why they couldn't be listed.
+  struct RegionInterfaces {
+    std::string region;
+    Aws::Vector<Aws::EC2::Model::NetworkInterface> interfaces;
+    std::optional<Aws::Client::AWSError<Aws::EC2::EC2Errors>> error;
+  };
+
+  // The EC2 requests enumerations are made of.
+  struct Ec2Requests {
+    // Lists the regions to enumerate.
+    std::function<Aws::EC2::Model::DescribeRegionsOutcome()> describe_regions;
+
+    // Lists the network interfaces of |result.region|. Called from the
+    // enumeration threads.
+    std::function<void(RegionInterfaces &result)> describe_network_interfaces;
+  };
+
+  // Requests sent to EC2 through the AWS SDK. |ec2_endpoint|, if not empty,
+  // is queried instead of AWS's endpoints, e.g. to test against a local mock.
+  static Ec2Requests aws_ec2_requests(std::string ec2_endpoint = {});
 
-  NetworkInterfacesEnumerator(logging::Logger &log, ebpf_net::cloud_collector::Index &index, ebpf_net::ingest::Writer &writer);
+  NetworkInterfacesEnumerator(
+      logging::Logger &log,
+      ebpf_net::cloud_collector::Index &index,
+      ebpf_net::ingest::Writer &writer,
+      std::string ec2_endpoint = {});
+  NetworkInterfacesEnumerator(
+      logging::Logger &log, ebpf_net::cloud_collector::Index &index, ebpf_net::ingest::Writer &writer, Ec2Requests ec2);
   ~NetworkInterfacesEnumerator();
 
   scheduling::JobFollowUp enumerate();
@@ -27,15 +64,40 @@ struct NetworkInterfacesEnumerator {
   void free_handles();
 
 private:
-  void set_handles(std::vector<ebpf_net::cloud_collector::handles::aws_network_interface> handles);
+  // What the reducer is sent about an address.
+  struct AddressInfo {
+    std::string ip_owner_id;
+    std::string vpc_id;
+    std::string az;
+    std::string interface_id;
+    std::uint16_t interface_type = 0;
+    std::string instance_id;
+    std::string instance_owner_id;
+    std::string public_dns_name;
+    std::string private_dns_name;
+    std::string description;
+
+    bool operator==(AddressInfo const &) const = default;
+  };
+
+  struct KnownAddress {
+    ebpf_net::cloud_collector::handles::aws_network_interface handle;
+    std::string region;
+    AddressInfo info;
+  };
+
+  // How many regions are enumerated at once.
+  static constexpr std::size_t max_concurrent_regions = 4;
 
   void handle_ec2_error(CollectorStatus status, Aws::Client::AWSError<Aws::EC2::EC2Errors> const &error);
 
-  Aws::EC2::EC2Client ec2_;
+  Ec2Requests const ec2_;
   ebpf_net::cloud_collector::Index &index_;
   ebpf_net::ingest::Writer &writer_;
   logging::Logger &log_;
-  std::vector<ebpf_net::cloud_collector::handles::aws_network_interface> handles_;
+
+  // Addresses the reducer was sent, as of the last enumeration.
+  absl::flat_hash_map<IPv6Address, KnownAddress> addresses_;
 };
 
 } // namespace collector::cloud
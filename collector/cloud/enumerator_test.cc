@@ -0,0 +1,154 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <collector/cloud/enumerator.h>
+
+#include <channel/buffered_writer.h>
+#include <channel/test_channel.h>
+#include <generated/ebpf_net/cloud_collector/index.h>
+#include <generated/ebpf_net/ingest/writer.h>
+#include <platform/userspace-time.h>
+#include <util/logger.h>
+
+#include <gtest/gtest.h>
+
+#include <initializer_list>
+#include <map>
+#include <set>
+#include <string>
+
+namespace collector::cloud {
+namespace {
+
+using Aws::EC2::Model::NetworkInterface;
+using Aws::EC2::Model::NetworkInterfacePrivateIpAddress;
+
+constexpr std::size_t buffer_size = 16 * 1024;
+
+NetworkInterface network_interface(std::string const &id, std::initializer_list<char const *> private_ips)
+{
+  NetworkInterface interface;
+  interface.SetNetworkInterfaceId(id);
+  interface.SetVpcId("vpc-1");
+  interface.SetAvailabilityZone("us-east-1a");
+  for (auto const ip : private_ips) {
+    interface.AddPrivateIpAddresses(NetworkInterfacePrivateIpAddress().WithPrivateIpAddress(ip));
+  }
+  return interface;
+}
+
+// The cloud collector's enumerator, describing the network interfaces of
+// |regions_| rather than querying EC2.
+class NetworkInterfacesEnumeratorTest : public ::testing::Test {
+protected:
+  NetworkInterfacesEnumerator::Ec2Requests ec2_requests()
+  {
+    return {
+        .describe_regions =
+            [this]() {
+              Aws::EC2::Model::DescribeRegionsResponse response;
+              for (auto const &[region, interfaces] : regions_) {
+                response.AddRegions(Aws::EC2::Model::Region().WithRegionName(region));
+              }
+              return Aws::EC2::Model::DescribeRegionsOutcome(std::move(response));
+            },
+        .describe_network_interfaces =
+            [this](NetworkInterfacesEnumerator::RegionInterfaces &result) {
+              if (failed_regions_.count(result.region)) {
+                result.error = Aws::Client::AWSError<Aws::EC2::EC2Errors>(Aws::EC2::EC2Errors::INTERNAL_FAILURE, true);
+                return;
+              }
+              result.interfaces = regions_.at(result.region);
+            },
+    };
+  }
+
+  // Enumerates, and returns how many of each message were sent.
+  std::map<std::string, u64> enumerate(scheduling::JobFollowUp expected = scheduling::JobFollowUp::ok)
+  {
+    auto const before = channel_.get_message_counts();
+    EXPECT_EQ(expected, enumerator_.enumerate());
+    EXPECT_FALSE(buffered_writer_.flush());
+    EXPECT_EQ(0u, channel_.get_num_failed_sends());
+
+    std::map<std::string, u64> sent;
+    for (auto const &[name, count] : channel_.get_message_counts()) {
+      auto const iter = before.find(name);
+      if (auto const delta = count - (iter == before.end() ? 0 : iter->second)) {
+        sent[name] = delta;
+      }
+    }
+    return sent;
+  }
+
+  std::map<std::string, Aws::Vector<NetworkInterface>> regions_;
+  std::set<std::string> failed_regions_;
+
+  channel::TestChannel channel_{std::nullopt, IntakeEncoder::binary};
+  channel::BufferedWriter buffered_writer_{channel_, buffer_size};
+  ebpf_net::ingest::Writer writer_{buffered_writer_, monotonic, 0, nullptr};
+  logging::Logger log_{writer_};
+  ebpf_net::cloud_collector::Index index_{{writer_}};
+  NetworkInterfacesEnumerator enumerator_{log_, index_, writer_, ec2_requests()};
+};
+
+} // namespace
+
+TEST_F(NetworkInterfacesEnumeratorTest, SendsAddressDeltas)
+{
+  regions_["us-east-1"] = {
+      network_interface("eni-1", {"10.0.0.1", "10.0.0.2"}),
+      network_interface("eni-2", {"10.0.0.3"}),
+  };
+
+  auto sent = enumerate();
+  EXPECT_EQ(3u, sent["aws_network_interface_start"]);
+  EXPECT_EQ(3u, sent["network_interface_info"]);
+  EXPECT_EQ(0u, sent["aws_network_interface_end"]);
+
+  // eni-1 changes and loses an address, eni-2 is unchanged, and eni-3 is new
+  regions_["us-east-1"] = {
+      network_interface("eni-1", {"10.0.0.1"}).WithDescription("changed"),
+      network_interface("eni-2", {"10.0.0.3"}),
+      network_interface("eni-3", {"10.0.0.4"}),
+  };
+
+  sent = enumerate();
+  // 10.0.0.4 is added
+  EXPECT_EQ(1u, sent["aws_network_interface_start"]);
+  // 10.0.0.1 is sent again, along with 10.0.0.4
+  EXPECT_EQ(2u, sent["network_interface_info"]);
+  // 10.0.0.2 is removed
+  EXPECT_EQ(1u, sent["aws_network_interface_end"]);
+
+  // nothing changed
+  sent = enumerate();
+  EXPECT_EQ(0u, sent["aws_network_interface_start"]);
+  EXPECT_EQ(0u, sent["network_interface_info"]);
+  EXPECT_EQ(0u, sent["aws_network_interface_end"]);
+}
+
+TEST_F(NetworkInterfacesEnumeratorTest, KeepsAddressesOfFailedRegions)
+{
+  regions_["us-east-1"] = {network_interface("eni-1", {"10.0.0.1"})};
+  regions_["us-west-2"] = {network_interface("eni-2", {"10.0.1.1"})};
+
+  auto sent = enumerate();
+  EXPECT_EQ(2u, sent["aws_network_interface_start"]);
+
+  // both are gone, but only eni-2 is removed as us-east-1 can't be enumerated
+  regions_["us-east-1"].clear();
+  regions_["us-west-2"].clear();
+  failed_regions_.insert("us-east-1");
+
+  sent = enumerate(scheduling::JobFollowUp::backoff);
+  EXPECT_EQ(1u, sent["aws_network_interface_end"]);
+
+  // eni-1 is removed once us-east-1 is enumerated again
+  failed_regions_.clear();
+
+  sent = enumerate();
+  EXPECT_EQ(1u, sent["aws_network_interface_end"]);
+}
+
+} // namespace collector::cloud
@@ -61,6 +61,13 @@ int main(int argc, char *argv[])
   args::ValueFlag<u64> aws_metadata_timeout_ms(
       *parser, "milliseconds", "Milliseconds to wait for AWS instance metadata", {"aws-timeout"}, 1 * 1000);
 
+  args::ValueFlag<std::string> ec2_endpoint(
+      *parser,
+      "url",
+      "Endpoint to query EC2 at instead of AWS's, e.g. a local mock for testing.",
+      {"ec2-endpoint"},
+      "");
+
   parser.new_handler<LogWhitelistHandler<channel::Component>>("channel");
   parser.new_handler<LogWhitelistHandler<CloudPlatform>>("cloud-platform");
   parser.new_handler<LogWhitelistHandler<Utility>>("utility");
@@ -108,7 +115,8 @@ int main(int argc, char *argv[])
       HEARTBEAT_INTERVAL,
       WRITE_BUFFER_SIZE,
       std::move(intake_config),
-      std::chrono::milliseconds(ec2_poll_interval_ms.Get())};
+      std::chrono::milliseconds(ec2_poll_interval_ms.Get()),
+      ec2_endpoint.Get()};
 
   signal_manager.handle_signals({SIGINT, SIGTERM} // TODO: close gracefully
   );
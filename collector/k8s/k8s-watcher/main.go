@@ -390,6 +390,12 @@ func run() error {
 		}
 	}
 
+	// Lets the relay tell which objects were deleted since the last stream.
+	err = send_info(&collector.Info{Event: collector.Info_SYNCED}, stream)
+	if err != nil {
+		return err
+	}
+
 	logmsg(Trace, "Start watch.")
 
 	cancel_ch := make(chan error)
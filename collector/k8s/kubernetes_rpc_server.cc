@@ -19,23 +19,54 @@
 #include "resync_channel.h"
 #include "util/boot_time.h"
 #include "util/log.h"
+#include "util/lookup3.h"
 #include "util/lookup3_hasher.h"
 #include <util/protobuf_log.h>
 
 namespace collector {
 using ::grpc::ServerContext;
 using ::grpc::ServerReaderWriter;
+using ::grpc::ServerReaderWriterInterface;
 using ::grpc::Status;
 using ::grpc::WriteOptions;
 
 namespace {
+// Hashes the fields of a message, to tell whether it changed.
+class ContentHash {
+public:
+  ContentHash &add(std::string_view data)
+  {
+    u64 const size = data.size();
+    lookup3_hashlittle2(&size, sizeof(size), &pc_, &pb_);
+    lookup3_hashlittle2(data.data(), data.size(), &pc_, &pb_);
+    return *this;
+  }
+
+  ContentHash &add(u64 value)
+  {
+    lookup3_hashlittle2(&value, sizeof(value), &pc_, &pb_);
+    return *this;
+  }
+
+  u64 value() const { return (static_cast<u64>(pb_) << 32) | pc_; }
+
+private:
+  u32 pc_ = 0;
+  u32 pb_ = 0;
+};
+
 // K8sHandler maintain keeps track of the state of Pod & ReplicaSet.
 // It consumes the Pod & ReplicaSet events sent back by k8s-watcher, and
 // decides whether & what messages to be sent back to the reducer.
 class K8sHandler {
 public:
-  // Does not take ownership of |writer|
-  explicit K8sHandler(ebpf_net::ingest::Writer *writer) : writer_(writer) {}
+  // Does not take ownership of |writer| or |reported_pods|.
+  //
+  // |reported_pods| holds what the reducer was sent about pods, possibly
+  // through previous streams: pods are only sent again if they changed since.
+  K8sHandler(ebpf_net::ingest::Writer *writer, std::unordered_map<std::string, ReportedPod> &reported_pods)
+      : writer_(writer), reported_pods_(reported_pods)
+  {}
 
   ~K8sHandler() {}
 
@@ -51,6 +82,10 @@ public:
   void pod_new_or_modified(const PodInfo &pod_info);
   void pod_deleted(const PodInfo &pod_info);
 
+  // All objects existing when the stream started have been seen: deletes
+  // the pods the reducer was sent that are gone.
+  void synced();
+
 private:
   // Max number of Pods allowed to wait for the ReplicaSet infos.
   static constexpr u64 max_waiting_pods_ = 10000;
@@ -61,6 +96,8 @@ private:
   u64 get_id(const std::string &uid);
   void send_pod_new(const PodInfo &pod_info, const OwnerInfo &owner);
   void send_pod_new_no_owner(const PodInfo &pod_info);
+  void send_pod_new(
+      const PodInfo &pod_info, std::string_view owner_name, KubernetesOwnerKind owner_kind, std::string_view owner_uid);
   void send_pod_containers(const PodInfo &pod_info);
 
   struct OwnerStore {
@@ -97,6 +134,7 @@ private:
   PodStore pods_;
 
   ebpf_net::ingest::Writer *writer_;
+  std::unordered_map<std::string, ReportedPod> &reported_pods_;
 };
 
 bool K8sHandler::need_restart() const
@@ -106,40 +144,49 @@ bool K8sHandler::need_restart() const
 
 void K8sHandler::send_pod_new(const PodInfo &pod_info, const OwnerInfo &owner)
 {
-  LOG::trace("Server: enqueue POD New: {}", pod_info.uid());
-
-  jb_blob uid{pod_info.uid().data(), (u16)pod_info.uid().size()};
-
-  writer_->pod_new_with_name(
-      uid,
-      (u32)(inet_addr(pod_info.ip().c_str())),
-      jb_blob{owner.name().data(), (u16)owner.name().size()},
-      jb_blob{pod_info.name().c_str(), (u16)pod_info.name().size()},
-      (uint8_t)KubernetesOwnerKindFromString(owner.kind()),
-      jb_blob{owner.uid().data(), (u16)owner.uid().size()},
-      (pod_info.is_host_network() ? 1 : 0),
-      jb_blob{pod_info.ns().data(), (u16)pod_info.ns().size()},
-      jb_blob{pod_info.version().data(), (u16)pod_info.version().size()});
-
-  send_pod_containers(pod_info);
+  send_pod_new(pod_info, owner.name(), KubernetesOwnerKindFromString(owner.kind()), owner.uid());
 }
 
 void K8sHandler::send_pod_new_no_owner(const PodInfo &pod_info)
 {
-  LOG::trace("Server: enqueue POD New (No Owner): {}", pod_info.uid());
+  send_pod_new(pod_info, pod_info.name(), KubernetesOwnerKind::NoOwner, "");
+}
 
+void K8sHandler::send_pod_new(
+    const PodInfo &pod_info, std::string_view owner_name, KubernetesOwnerKind owner_kind, std::string_view owner_uid)
+{
   jb_blob uid{pod_info.uid().data(), (u16)pod_info.uid().size()};
+  u32 const ip = inet_addr(pod_info.ip().c_str());
+
+  u64 const hash = ContentHash()
+                       .add(ip)
+                       .add(owner_name)
+                       .add(pod_info.name())
+                       .add(static_cast<u64>(owner_kind))
+                       .add(owner_uid)
+                       .add(pod_info.is_host_network())
+                       .add(pod_info.ns())
+                       .add(pod_info.version())
+                       .value();
+
+  auto &reported = reported_pods_[pod_info.uid()];
+  if (reported.pod_hash == hash) {
+    LOG::trace("Server: POD unchanged since reported: {}", pod_info.uid());
+  } else {
+    LOG::trace("Server: enqueue POD New: {}", pod_info.uid());
 
-  writer_->pod_new_with_name(
-      uid,
-      (u32)(inet_addr(pod_info.ip().c_str())),
-      jb_blob{pod_info.name().c_str(), (u16)pod_info.name().size()},
-      jb_blob{pod_info.name().c_str(), (u16)pod_info.name().size()},
-      (uint8_t)(KubernetesOwnerKind::NoOwner),
-      jb_blob{"", (u16)0},
-      (pod_info.is_host_network() ? 1 : 0),
-      jb_blob{pod_info.ns().data(), (u16)pod_info.ns().size()},
-      jb_blob{pod_info.version().data(), (u16)pod_info.version().size()});
+    writer_->pod_new_with_name(
+        uid,
+        ip,
+        jb_blob{owner_name.data(), (u16)owner_name.size()},
+        jb_blob{pod_info.name().c_str(), (u16)pod_info.name().size()},
+        (uint8_t)owner_kind,
+        jb_blob{owner_uid.data(), (u16)owner_uid.size()},
+        (pod_info.is_host_network() ? 1 : 0),
+        jb_blob{pod_info.ns().data(), (u16)pod_info.ns().size()},
+        jb_blob{pod_info.version().data(), (u16)pod_info.version().size()});
+    reported.pod_hash = hash;
+  }
 
   send_pod_containers(pod_info);
 }
@@ -148,6 +195,17 @@ void K8sHandler::send_pod_containers(const PodInfo &pod_info)
 {
   jb_blob uid{pod_info.uid().data(), (u16)pod_info.uid().size()};
 
+  ContentHash hash;
+  for (int i = 0; i < pod_info.container_infos_size(); ++i) {
+    hash.add(pod_info.container_infos(i).id()).add(pod_info.container_infos(i).name()).add(pod_info.container_infos(i).image());
+  }
+
+  auto &reported = reported_pods_[pod_info.uid()];
+  if (reported.containers_hash == hash.value()) {
+    return;
+  }
+  reported.containers_hash = hash.value();
+
   for (int i = 0; i < pod_info.container_infos_size(); ++i) {
     std::string const &cid = pod_info.container_infos(i).id();
     std::string const &name = pod_info.container_infos(i).name();
@@ -382,8 +440,7 @@ void K8sHandler::pod_deleted(const PodInfo &pod_info)
   }
 
   u64 id = get_id(pod_info.uid());
-  auto live_iter = pods_.live.find(id);
-  if (live_iter != pods_.live.end()) {
+  if (reported_pods_.erase(pod_info.uid())) {
     LOG::trace("Server: enqueue POD Delete: {}\n", pod_info.uid());
 
     writer_->pod_delete(jb_blob{pod_info.uid().data(), (u16)pod_info.uid().size()});
@@ -394,6 +451,26 @@ void K8sHandler::pod_deleted(const PodInfo &pod_info)
   pods_.waiting.erase(id);
   uid_to_id_.erase(pod_info.uid());
 }
+
+void K8sHandler::synced()
+{
+  std::size_t deleted = 0;
+  for (auto iter = reported_pods_.begin(); iter != reported_pods_.end();) {
+    auto const &uid = iter->first;
+    auto const id_iter = uid_to_id_.find(uid);
+    if (id_iter != uid_to_id_.end() && pods_.infos.count(id_iter->second)) {
+      ++iter;
+      continue;
+    }
+
+    LOG::trace("Server: enqueue POD Delete (gone while resyncing): {}\n", uid);
+    writer_->pod_delete(jb_blob{uid.data(), (u16)uid.size()});
+    iter = reported_pods_.erase(iter);
+    ++deleted;
+  }
+
+  LOG::info("Synced with k8s-watcher: {} pods known, {} deleted meanwhile.", pods_.infos.size(), deleted);
+}
 } // namespace
 
 KubernetesRpcServer::KubernetesRpcServer(ResyncChannelFactory *channel_factory, std::size_t collect_buffer_size)
@@ -403,6 +480,12 @@ KubernetesRpcServer::KubernetesRpcServer(ResyncChannelFactory *channel_factory,
 KubernetesRpcServer::~KubernetesRpcServer() {}
 
 Status KubernetesRpcServer::Collect(ServerContext *context, ServerReaderWriter<Response, Info> *reader_writer)
+{
+  return collect(reader_writer, [context]() { context->TryCancel(); });
+}
+
+Status KubernetesRpcServer::collect(
+    ServerReaderWriterInterface<Response, Info> *reader_writer, std::function<void(void)> const &cancel)
 {
   std::function<void(void)> reset_callback = [&]() {
     Response response;
@@ -412,19 +495,49 @@ Status KubernetesRpcServer::Collect(ServerContext *context, ServerReaderWriter<R
 
     reader_writer->Write(response, options);
     LOG::info("Relay: canceling watcher.");
-    context->TryCancel();
+    cancel();
   };
 
+  // A watcher only has one stream at a time, so the current stream, if any,
+  // is a stale one: rather than waiting for it to break, cancel it.
+  u64 stream;
+  {
+    std::lock_guard<std::mutex> lock(streams_mutex_);
+    stream = ++latest_stream_;
+    if (cancel_active_stream_) {
+      LOG::info("Relay: canceling the stream superseded by a new one.");
+      cancel_active_stream_();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(collect_mutex_);
+  {
+    std::lock_guard<std::mutex> streams_lock(streams_mutex_);
+    if (stream != latest_stream_) {
+      // superseded by yet another stream while waiting for the previous one
+      return Status::CANCELLED;
+    }
+    cancel_active_stream_ = cancel;
+  }
+
   std::unique_ptr<ResyncChannel> resync_channel = channel_factory_->new_channel(reset_callback);
+  if (resync_channel->resync() != reported_resync_) {
+    // a new resync: the reducer dropped the pods it was sent
+    LOG::info("Relay: full resync {}.", resync_channel->resync());
+    reported_resync_ = resync_channel->resync();
+    reported_pods_.clear();
+  }
 
   channel::BufferedWriter buffered_writer(*resync_channel, collect_buffer_size_);
 
   ebpf_net::ingest::Writer writer(buffered_writer, monotonic, get_boot_time());
 
-  K8sHandler handler(&writer);
+  K8sHandler handler(&writer, reported_pods_);
   Info info;
   while (reader_writer->Read(&info)) {
-    if (info.type() == Info::K8S_REPLICASET) {
+    if (info.event() == Info_Event_SYNCED) {
+      handler.synced();
+    } else if (info.type() == Info::K8S_REPLICASET) {
       const ReplicaSetInfo &rs_info = info.rs_info();
       switch (info.event()) {
       case Info_Event_ADDED:
@@ -439,7 +552,7 @@ Status KubernetesRpcServer::Collect(ServerContext *context, ServerReaderWriter<R
         // do nothing now.
         break;
       }
-    } if (info.type() == Info::K8S_JOB) {
+    } else if (info.type() == Info::K8S_JOB) {
       const JobInfo &job_info = info.job_info();
       switch (info.event()) {
       case Info_Event_ADDED:
@@ -484,6 +597,11 @@ Status KubernetesRpcServer::Collect(ServerContext *context, ServerReaderWriter<R
   // Discard anything left.
   buffered_writer.reset();
 
+  {
+    std::lock_guard<std::mutex> streams_lock(streams_mutex_);
+    cancel_active_stream_ = nullptr;
+  }
+
   // Always returns CANCELLED, since the stream should not be broken unless
   // something bad happens.
   return Status::CANCELLED;
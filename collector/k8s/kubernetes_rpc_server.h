@@ -4,6 +4,8 @@
  */
 
 #pragma once
+#include <functional>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -13,10 +15,21 @@
 
 namespace collector {
 
+// What the reducer was sent about a pod, as hashes of the messages' contents.
+struct ReportedPod {
+  // pod_new_with_name
+  u64 pod_hash = 0;
+  // pod_container, for all of the pod's containers
+  u64 containers_hash = 0;
+};
+
 // KubernetesRpcServer implements Collector::Service gRpc server.
 //
 // It recieves the client-side streaming gRpc from Kubernetes Reader, and
 // extracts related information and forwards to the reducer.
+//
+// What the reducer was sent is kept across streams, so that when the watcher
+// restarts its stream, only what changed in the meantime is sent again.
 class KubernetesRpcServer : public Collector::Service {
 public:
   // Does not take ownership of |chanel_factory|
@@ -25,8 +38,28 @@ public:
 
   ::grpc::Status Collect(::grpc::ServerContext *context, ::grpc::ServerReaderWriter<Response, Info> *reader_writer) override;
 
+  // Handles a stream from k8s-watcher, as Collect() does. |cancel| cancels
+  // the stream, failing its pending and future reads.
+  ::grpc::Status
+  collect(::grpc::ServerReaderWriterInterface<Response, Info> *reader_writer, std::function<void(void)> const &cancel);
+
 private:
   ResyncChannelFactory *channel_factory_; // not owned
   std::size_t collect_buffer_size_;
+
+  // Streams are handled one at a time, since they share |reported_pods_|: a
+  // new stream supersedes the current one, which is cancelled to give way.
+  std::mutex collect_mutex_;
+
+  // Guards |latest_stream_| and |cancel_active_stream_|.
+  std::mutex streams_mutex_;
+  // Sequence number of the latest stream to start.
+  u64 latest_stream_ = 0;
+  // Cancels the stream holding |collect_mutex_|, if any.
+  std::function<void(void)> cancel_active_stream_;
+
+  // Pods the reducer was sent at resync |reported_resync_|, by uid.
+  u64 reported_resync_ = 0;
+  std::unordered_map<std::string, ReportedPod> reported_pods_;
 };
 } // namespace collector
@@ -0,0 +1,185 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include "kubernetes_rpc_server.h"
+#include "resync_queue.h"
+
+#include <channel/test_channel.h>
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace collector {
+namespace {
+
+constexpr std::size_t collect_buffer_size = 16 * 1024;
+
+Info pod_added(std::string const &uid)
+{
+  Info info;
+  info.set_type(Info::K8S_POD);
+  info.set_event(Info_Event_ADDED);
+  info.mutable_pod_info()->set_uid(uid);
+  info.mutable_pod_info()->set_ip("10.0.0.1");
+  info.mutable_pod_info()->set_name("pod-" + uid);
+  return info;
+}
+
+Info synced()
+{
+  Info info;
+  info.set_event(Info_Event_SYNCED);
+  return info;
+}
+
+// A stream from k8s-watcher, whose reads block until it is given more infos,
+// closed or cancelled.
+class FakeStream : public ::grpc::ServerReaderWriterInterface<Response, Info> {
+public:
+  explicit FakeStream(std::initializer_list<Info> infos) : infos_(infos) {}
+
+  void SendInitialMetadata() override {}
+  bool NextMessageSize(uint32_t *size) override { return false; }
+  bool Write(const Response &response, ::grpc::WriteOptions options) override { return true; }
+
+  bool Read(Info *info) override
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.notify_all();
+    available_.wait(lock, [this] { return !infos_.empty() || closed_ || cancelled_; });
+    if (cancelled_ || infos_.empty()) {
+      return false;
+    }
+    *info = std::move(infos_.front());
+    infos_.pop_front();
+    return true;
+  }
+
+  // Ends the stream once its infos are read.
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    available_.notify_all();
+  }
+
+  void cancel()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    available_.notify_all();
+  }
+
+  bool cancelled() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cancelled_;
+  }
+
+  // Waits until the stream's infos are read, and it waits for more.
+  void wait_until_drained()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [this] { return infos_.empty(); });
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::condition_variable available_;
+  std::condition_variable drained_;
+  std::deque<Info> infos_;
+  bool closed_ = false;
+  bool cancelled_ = false;
+};
+
+class KubernetesRpcServerTest : public ::testing::Test {
+protected:
+  ::grpc::Status collect(FakeStream &stream)
+  {
+    return server_.collect(&stream, [&stream]() { stream.cancel(); });
+  }
+
+  // Sends what was queued for the reducer to |channel_|, as ResyncProcessor
+  // does.
+  void process_queue()
+  {
+    auto *queue = queue_.consumer_get_queue();
+    queue->start_read_batch();
+    while (queue->peek() > 0) {
+      char *element = nullptr;
+      int const length = queue->read(element);
+      ASSERT_GT(length, static_cast<int>(sizeof(u64)));
+
+      u64 resync;
+      memcpy(&resync, element, sizeof(resync));
+      EXPECT_EQ(1u, resync);
+
+      channel_.send(reinterpret_cast<u8 const *>(element + sizeof(u64)), length - sizeof(u64));
+    }
+    queue->finish_read_batch();
+    EXPECT_EQ(0u, channel_.get_num_failed_sends());
+  }
+
+  ResyncQueue queue_;
+  KubernetesRpcServer server_{&queue_, collect_buffer_size};
+  channel::TestChannel channel_;
+};
+
+} // namespace
+
+TEST_F(KubernetesRpcServerTest, DeletesPodsGoneWhileRestarting)
+{
+  FakeStream first{pod_added("a"), pod_added("b"), synced()};
+  first.close();
+  EXPECT_EQ(::grpc::StatusCode::CANCELLED, collect(first).error_code());
+
+  // the watcher restarts its stream, which carries on with the same resync,
+  // after pod b was deleted
+  FakeStream second{pod_added("a"), synced()};
+  second.close();
+  EXPECT_EQ(::grpc::StatusCode::CANCELLED, collect(second).error_code());
+
+  ASSERT_NO_FATAL_FAILURE(process_queue());
+
+  // pod a is unchanged, so it isn't sent again, and pod b is deleted once the
+  // watcher is synced
+  auto &message_counts = channel_.get_message_counts();
+  EXPECT_EQ(2u, message_counts["pod_new_with_name"]);
+  ASSERT_EQ(1u, message_counts["pod_delete"]);
+
+  auto const &messages = channel_.get_json_messages();
+  ASSERT_FALSE(messages.empty());
+  EXPECT_EQ("pod_delete", messages.back()["name"]);
+  EXPECT_EQ("b", messages.back()["data"]["uid"]);
+}
+
+TEST_F(KubernetesRpcServerTest, SupersedesPreviousStream)
+{
+  // the previous stream never breaks, as when the watcher's connection is
+  // lost without the relay noticing
+  FakeStream first{pod_added("a")};
+  std::thread thread([&]() { EXPECT_EQ(::grpc::StatusCode::CANCELLED, collect(first).error_code()); });
+  first.wait_until_drained();
+
+  FakeStream second{pod_added("a"), pod_added("c"), synced()};
+  second.close();
+  EXPECT_EQ(::grpc::StatusCode::CANCELLED, collect(second).error_code());
+  thread.join();
+
+  EXPECT_TRUE(first.cancelled());
+  EXPECT_FALSE(second.cancelled());
+
+  ASSERT_NO_FATAL_FAILURE(process_queue());
+
+  auto &message_counts = channel_.get_message_counts();
+  EXPECT_EQ(2u, message_counts["pod_new_with_name"]);
+  EXPECT_EQ(0u, message_counts["pod_delete"]);
+}
+
+} // namespace collector
@@ -26,6 +26,8 @@ public:
 
   bool is_open() const override { return true; }
 
+  u64 resync() const { return resync_; }
+
 private:
   // At which Resync generation that this channel is created.
   const u64 resync_;
@@ -40,6 +40,7 @@ void ResyncQueue::consumer_reset()
   {
     std::vector<ResyncChannel *> chs;
     std::lock_guard<std::recursive_mutex> lock(mutex_);
+    full_resync_needed_ = true;
     for (auto *ch : channels_) {
       chs.push_back(ch);
     }
@@ -53,7 +54,13 @@ void ResyncQueue::consumer_reset()
 std::unique_ptr<ResyncChannel> ResyncQueue::new_channel(std::function<void(void)> &reset_callback)
 {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
-  last_resync_ += 1;
+
+  // Channels replacing one that was merely restarted carry on with the same
+  // resync: the reducer still has what was sent through the previous ones.
+  if (full_resync_needed_) {
+    last_resync_ += 1;
+    full_resync_needed_ = false;
+  }
 
   auto *ch = new ResyncChannel(last_resync_, this, reset_callback);
   channels_.insert(ch);
@@ -75,6 +82,7 @@ std::error_code ResyncQueue::producer_send(const u8 *data, int data_len, const u
   if (offset < 0) {
     LOG::warn("element queue is full\n");
     write_queue_.finish_write_batch();
+    full_resync_needed_ = true;
     return std::make_error_code(std::errc::no_buffer_space);
   }
 
@@ -41,6 +41,9 @@ private:
   mutable std::recursive_mutex mutex_;
 
   u64 last_resync_;
+  // Whether the reducer may have lost some of what was sent at |last_resync_|,
+  // in which case the next channel starts a new resync.
+  bool full_resync_needed_ = true;
   std::unordered_set<ResyncChannel *> channels_;
 }; // class ResyncQUeue
 } // namespace collector
@@ -140,6 +140,8 @@ BPF_HASH(
 BPF_HASH(tcp_open_sockets, struct sock *, struct tcp_open_socket_t, TABLE_SIZE__TCP_OPEN_SOCKETS); /* information on live sks */
 BPF_HASH(udp_open_sockets, struct sock *, struct udp_open_socket_t, TABLE_SIZE__UDP_OPEN_SOCKETS);
 BPF_HASH(udp_get_port_hash, u64, struct sock *, TABLE_SIZE__UDP_GET_PORT_HASH);
+/* masks of the busy udp sockets that userspace samples, see udp_sampled_in */
+BPF_HASH(udp_sampling, struct sock *, u32, TABLE_SIZE__UDP_SAMPLING);
 
 BEGIN_DECLARE_SAVED_ARGS(cgroup_exit)
 pid_t tgid;
@@ -158,6 +160,20 @@ END_DECLARE_SAVED_ARGS(cgroup_exit)
 #endif
 #pragma passthrough off
 
+/* mask of the events of |sk| to drop, 0 for sockets not being sampled */
+static inline u32 udp_sampling_mask(struct sock *sk)
+{
+  u32 *mask = udp_sampling.lookup(&sk);
+  return mask == NULL ? 0 : *mask;
+}
+
+/* whether an event of |sk| with |hash| should be sent; sockets not being
+ * sampled keep all their events */
+static inline int udp_sampled_in(struct sock *sk, u32 hash)
+{
+  return (hash & udp_sampling_mask(sk)) == 0;
+}
+
 /* forward declarations */
 
 static void
@@ -1310,6 +1326,8 @@ static void remove_udp_open_socket(struct pt_regs *ctx, struct sock *sk)
     return;
   }
 
+  udp_sampling.delete(&sk);
+
   u64 now = get_timestamp();
   udp_send_stats_if_nonempty(ctx, now, sk, &sk_info.stats[0], 0);
   udp_send_stats_if_nonempty(ctx, now, sk, &sk_info.stats[1], 1);
@@ -1599,6 +1617,14 @@ static void udp_update_stats(
 
   u64 now = get_timestamp();
 
+  /* while the socket is sampled, a change of remote address alone (e.g. of a
+   * DNS server answering many clients) is only sent for some packets; the
+   * others are counted against the previous address so totals stay exact */
+  if (rchanged && !lchanged && !dchanged && stats->last_output != 0 && (now - stats->last_output) < FILTER_NS &&
+      !udp_sampled_in(sk, bpf_get_prandom_u32())) {
+    changed = 0;
+  }
+
   if (changed || ((now - stats->last_output) >= FILTER_NS)) {
 
     /* set the address */
@@ -2130,6 +2156,17 @@ perf_check_and_submit_dns(struct pt_regs *ctx, struct sock *sk, struct sk_buff *
     valid_len -= diff;
   }
 
+  /* keep only some of the messages of sockets being sampled, by message id;
+   * the mask goes along so userspace knows what each message stands for */
+  u16 dns_id = 0;
+  if (valid_len < sizeof(dns_id) || bpf_probe_read(&dns_id, sizeof(dns_id), from) != 0) {
+    return;
+  }
+  u32 const sampling_mask = udp_sampling_mask(sk);
+  if ((UDP_SAMPLING_DNS_HASH(dns_id) & sampling_mask) != 0) {
+    return;
+  }
+
   /* only enable this if we need to detect
   if (valid_len < len) {
     // we are facing a paged or fragmented skb. only copy headlen bytes
@@ -2171,7 +2208,7 @@ perf_check_and_submit_dns(struct pt_regs *ctx, struct sock *sk, struct sk_buff *
 
   struct bpf_agent_internal__dns_packet *const msg = (struct bpf_agent_internal__dns_packet *)&buf[0];
   struct jb_blob blob = {to, valid_len};
-  bpf_fill_agent_internal__dns_packet(msg, get_timestamp(), (u64)sk, blob, len, is_rx);
+  bpf_fill_agent_internal__dns_packet(msg, get_timestamp(), (u64)sk, blob, len, is_rx, sampling_mask);
 
   events.perf_submit(
       ctx, &msg->unpadded_size, ((DNS_MAX_PACKET_LEN + sizeof(struct jb_agent_internal__dns_packet) + 8 + 7) / 8) * 8 + 4);
@@ -24,6 +24,7 @@
 #define TABLE_SIZE__DEAD_GROUP_TASKS 512 // Should be no more than the number of cores, in theory
 #define TABLE_SIZE__STACK_TRACES 16384   // Number of stack traces to keep in the table
 #define TABLE_SIZE__NIC_INFO_TABLE 128   // Info per network interface
+#define TABLE_SIZE__UDP_SAMPLING 4096    // Busy UDP sockets being sampled under overload
 
 #define WATERMARK_STACK_TRACES                                                                                                 \
   (TABLE_SIZE__STACK_TRACES - 256) // When to clear the table (unfortunately non-atomic, but that's a lot of stack traces...)
@@ -49,6 +50,10 @@
 #define TCP_LIFETIME_HACK_CODE 1
 #define UDP_LIFETIME_HACK_CODE 2
 
+// Hash of a DNS message's id, which decides whether it is kept when its socket
+// is sampled, so that a query and its response are kept or dropped together
+#define UDP_SAMPLING_DNS_HASH(id) ((((u32)(id)) * 2654435761u) >> 16)
+
 ///////// bpf_tcp_processor.c config
 
 #define TCP_CONNECTION_HASH_SIZE TABLE_SIZE__TCP_OPEN_SOCKETS // Same for now to ensure we can always handle all http requests
@@ -55,6 +55,7 @@ BufferedPoller::BufferedPoller(
       bpf_dump_file_(bpf_dump_file),
       log_(log),
       buffered_writer_(writer),
+      send_lanes_(writer, SendLanes::Budgets{}),
       probe_handler_(probe_handler),
       bpf_module_(bpf_module),
       writer_(buffered_writer_, monotonic, time_adjustment, encoder),
@@ -67,6 +68,7 @@ BufferedPoller::BufferedPoller(
       tcp_socket_stats_(tslot_),
       udp_socket_table_ever_full_(false),
       udp_socket_stats_{{{tslot_}, {tslot_}}},
+      udp_sampler_(UdpSampler::Settings{}, [this](u64 sk, u32 mask) { udp_sampling_changed(sk, mask); }),
       all_probes_loaded_(false),
       kernel_collector_restarter_(kernel_collector_restarter)
 {
@@ -78,16 +80,21 @@ BufferedPoller::BufferedPoller(
     using namespace ebpf_net::agent_internal;
 
     memset(handlers_, 0, sizeof(handlers_));
-    add_handler<dns_packet_message_metadata, &BufferedPoller::handle_dns_message, DNS_MAX_PACKET_LEN + 16>();
+    add_handler<
+        dns_packet_message_metadata,
+        &BufferedPoller::handle_dns_message,
+        DNS_MAX_PACKET_LEN + 16,
+        u64,
+        SendLane::events>();
     add_handler<new_sock_created_message_metadata, &BufferedPoller::handle_new_socket>();
     add_handler<set_state_ipv4_message_metadata, &BufferedPoller::handle_set_state_ipv4>();
     add_handler<set_state_ipv6_message_metadata, &BufferedPoller::handle_set_state_ipv6>();
     add_handler<close_sock_info_message_metadata, &BufferedPoller::handle_close_socket>();
     add_handler<rtt_estimator_message_metadata, &BufferedPoller::handle_rtt_estimator>();
     add_handler<reset_tcp_counters_message_metadata, &BufferedPoller::handle_reset_tcp_counters>();
-    add_handler<tcp_syn_timeout_message_metadata, &BufferedPoller::handle_tcp_syn_timeout>();
-    add_handler<tcp_reset_message_metadata, &BufferedPoller::handle_tcp_reset>();
-    add_handler<http_response_message_metadata, &BufferedPoller::handle_http_response>();
+    add_handler<tcp_syn_timeout_message_metadata, &BufferedPoller::handle_tcp_syn_timeout, 0, u64, SendLane::stats>();
+    add_handler<tcp_reset_message_metadata, &BufferedPoller::handle_tcp_reset, 0, u64, SendLane::stats>();
+    add_handler<http_response_message_metadata, &BufferedPoller::handle_http_response, 0, u64, SendLane::events>();
     add_handler<udp_new_socket_message_metadata, &BufferedPoller::handle_udp_new_socket>();
     add_handler<udp_destroy_socket_message_metadata, &BufferedPoller::handle_udp_destroy_socket>();
     add_handler<udp_stats_message_metadata, &BufferedPoller::handle_udp_stats>();
@@ -102,13 +109,21 @@ BufferedPoller::BufferedPoller(
     add_handler<nf_nat_cleanup_conntrack_message_metadata, &BufferedPoller::handle_nf_nat_cleanup_conntrack>();
     add_handler<nf_conntrack_alter_reply_message_metadata, &BufferedPoller::handle_nf_conntrack_alter_reply>();
     add_handler<existing_conntrack_tuple_message_metadata, &BufferedPoller::handle_existing_conntrack_tuple>();
-    add_handler<bpf_log_message_metadata, &BufferedPoller::handle_bpf_log>();
+    add_handler<bpf_log_message_metadata, &BufferedPoller::handle_bpf_log, 0, u64, SendLane::events>();
     add_handler<stack_trace_message_metadata, &BufferedPoller::handle_stack_trace>();
     add_handler<tcp_data_message_metadata, &BufferedPoller::handle_tcp_data>();
   }
 
+  // Get the udp sampling hash table
+  ebpf::TableStorage::iterator it;
+  ebpf::Path path({bpf_module.id(), "udp_sampling"});
+  if (!bpf_module.table_storage().Find(path, it)) {
+    throw std::runtime_error("missing udp_sampling hash table");
+  }
+  udp_sampling_desc_ = it->second.dup();
+
   // Create a tcp data handler for the tcp_data message
-  tcp_data_handler_ = std::make_unique<TCPDataHandler>(loop_, bpf_module, writer_, container, log_);
+  tcp_data_handler_ = std::make_unique<TCPDataHandler>(loop_, bpf_module, writer_, send_lanes_, container, log_);
 
   // Set perf container callback for events
   container.set_callback(loop, this, [](void *ctx) { ((BufferedPoller *)ctx)->handle_event(); });
@@ -132,6 +147,10 @@ void BufferedPoller::poll(void)
 void BufferedPoller::process_samples(bool is_event)
 {
   u64 t = monotonic() + time_adjustment_;
+
+  udp_sampler_.observe_ring_fill(container_.max_fill_percent());
+  poll_timestamp_ = t;
+
   PerfReader reader(container_, t);
 
   // in the case of event-driven poll, print debugging information to assist
@@ -200,12 +219,26 @@ void BufferedPoller::process_samples(bool is_event)
     send_stats_from_queue(t);
     udp_send_stats_from_queue(t);
     send_report_if_recent_loss();
+    send_shed_report();
   }
 
   // clear out buffer if there's still anything left
   if (auto error = buffered_writer_.flush(); error && buffered_writer_.is_writable()) {
     throw std::runtime_error(fmt::format("flush failed at end: {}", error));
   }
+
+  if (!buffered_writer_.is_congested()) {
+    for (auto lane : enum_traits<SendLane>::values) {
+      auto &logged = logged_shed_counts_[enum_index_of(lane)];
+      if (u64 const shed = send_lanes_.shed_count(lane); shed != logged) {
+        log_.warn(
+            "Shed {} messages of the {} lane while the connection to the reducer was congested.",
+            shed - logged,
+            to_string(lane));
+        logged = shed;
+      }
+    }
+  }
 }
 
 void BufferedPoller::send_report_if_recent_loss()
@@ -218,6 +251,15 @@ void BufferedPoller::send_report_if_recent_loss()
   notified_lost_count_ = lost_count_;
 }
 
+void BufferedPoller::send_shed_report()
+{
+  for (auto lane : enum_traits<SendLane>::values) {
+    if (u64 const count = send_lanes_.take_unreported(lane)) {
+      writer_.shed_messages(integer_value(lane), count);
+    }
+  }
+}
+
 u64 BufferedPoller::serv_lost_count()
 {
   return lost_count_;
@@ -227,7 +269,8 @@ template <
     typename MessageMetadata,
     BufferedPoller::message_handler_fn<MessageMetadata> Handler,
     std::size_t MaxPadding,
-    typename Alignment>
+    typename Alignment,
+    SendLane Lane>
 void BufferedPoller::message_handler_entrypoint(PerfReader &reader, u16 length)
 {
   struct {
@@ -261,6 +304,10 @@ void BufferedPoller::message_handler_entrypoint(PerfReader &reader, u16 length)
 
   reader.pop_and_copy_to(reinterpret_cast<char *>(&in));
 
+  if (poll_timestamp_ > in.timestamp) {
+    udp_sampler_.observe_lag(poll_timestamp_ - in.timestamp);
+  }
+
   // at this point it's ok to skip the handler since the message has been
   // consumed
 
@@ -269,6 +316,12 @@ void BufferedPoller::message_handler_entrypoint(PerfReader &reader, u16 length)
     return;
   }
 
+  if constexpr (Lane != SendLane::state) {
+    if (!send_lanes_.admit(Lane, in.timestamp)) {
+      return;
+    }
+  }
+
   (this->*Handler)(
       {
           .timestamp = in.timestamp,
@@ -283,7 +336,8 @@ template <
     typename MessageMetadata,
     BufferedPoller::message_handler_fn<MessageMetadata> Handler,
     std::size_t MaxPadding,
-    typename Alignment>
+    typename Alignment,
+    SendLane Lane>
 void BufferedPoller::add_handler()
 {
   u32 idx = agent_internal_hash(MessageMetadata::rpc_id);
@@ -292,7 +346,7 @@ void BufferedPoller::add_handler()
     throw std::runtime_error("tried to add_handler to an occupied slot");
   }
 
-  handlers_[idx] = &BufferedPoller::message_handler_entrypoint<MessageMetadata, Handler, MaxPadding, Alignment>;
+  handlers_[idx] = &BufferedPoller::message_handler_entrypoint<MessageMetadata, Handler, MaxPadding, Alignment, Lane>;
 }
 
 void BufferedPoller::handle_dns_message(message_metadata const &metadata, jb_agent_internal__dns_packet &msg)
@@ -330,6 +384,14 @@ void BufferedPoller::handle_dns_message(message_metadata const &metadata, jb_age
   }
   u32 sk_id = pos.index;
 
+  // bpf already sampled the message, with msg.sampling_mask: what it kept is
+  // weighed by that mask, not by the socket's mask now
+  u16 dns_id = 0;
+  if (pkt_len >= sizeof(dns_id)) {
+    memcpy(&dns_id, dns_packet.data(), sizeof(dns_id));
+  }
+  udp_sampler_.count(sk);
+
   /* make variables to parse the DNS packet */
   char hostname_out[DNS_NAME_MAX_LENGTH];
   int hostname_len = 0;
@@ -369,7 +431,11 @@ void BufferedPoller::handle_dns_message(message_metadata const &metadata, jb_age
         .qid = qid_out, .type = type_out, .name = std::string(hostname_out, hostname_len), .is_rx = (bool)msg.is_rx};
 
     // Add request to table, for later processing when response shows up
-    DnsRequests::dns_request_value value{.timestamp_ns = metadata.timestamp, .sk = sk};
+    DnsRequests::dns_request_value value{
+        .timestamp_ns = metadata.timestamp,
+        .sk = sk,
+        .id_hash = UDP_SAMPLING_DNS_HASH(dns_id),
+        .sampling_mask = msg.sampling_mask};
     dns_requests_.add(key, value);
     return;
   }
@@ -500,7 +566,8 @@ void BufferedPoller::handle_dns_message(message_metadata const &metadata, jb_age
             /* ipv6_addrs */
             jb_blob{(char *)ipv6_addrs, (u16)(sizeof(struct in6_addr) * num_ipv6_addrs)},
             latency_ns,
-            msg.is_rx ? SC_CLIENT : SC_SERVER);
+            msg.is_rx ? SC_CLIENT : SC_SERVER,
+            UdpSampler::dns_response_weight(req->second.sampling_mask, msg.sampling_mask));
       }
       // else {
       //  // someday add other dns responses, or dns resolution errors
@@ -530,6 +597,12 @@ void BufferedPoller::timeout_dns_request(u64 timestamp_ns, const DnsRequests::Re
     u32 sk_id = pos.index;
     u64 duration_ns = (timestamp_ns - t_req);
 
+    u32 const weight = udp_sampler_.dns_timeout_weight(sk, req->second.id_hash, req->second.sampling_mask);
+    if (!weight) {
+      dns_requests_.remove(req);
+      return;
+    }
+
     /* truncate hostname */
     const char *hostname_out = req->first.name.c_str();
     size_t hostname_len = req->first.name.size();
@@ -545,7 +618,8 @@ void BufferedPoller::timeout_dns_request(u64 timestamp_ns, const DnsRequests::Re
         sk_id,
         hostname_len,
         /* domain_name */ jb_blob{sent_hostname, sent_hostname_len},
-        duration_ns);
+        duration_ns,
+        weight);
   }
 
   // drop this request from dns_requests_
@@ -556,6 +630,7 @@ void BufferedPoller::slow_poll()
 {
   u64 const t = monotonic() + time_adjustment_;
   process_dns_timeouts(t);
+  udp_sampler_.update();
 }
 
 void BufferedPoller::process_dns_timeouts(u64 t)
@@ -659,11 +734,12 @@ void BufferedPoller::handle_close_socket(message_metadata const &metadata, jb_ag
 
   LOG::debug_in(AgentLogKind::TCP, "handle_close_socket: sk={:x}", msg.sk);
 
-  // send out a statistics message if needed
+  // send out a statistics message if needed; it's the socket's last, so it
+  // isn't shed
   for (u32 epoch = 0; epoch < n_epochs; epoch++) {
     auto &stats = tcp_socket_stats_.lookup_relative(pos.index, epoch, false).second;
     if (stats.valid == true) {
-      send_socket_stats(metadata.timestamp, msg.sk, stats);
+      send_socket_stats(metadata.timestamp, pos.index, stats, false);
     }
   }
 
@@ -815,8 +891,16 @@ void BufferedPoller::handle_http_response(message_metadata const &metadata, jb_a
   writer_.http_response_tstamp(metadata.timestamp, msg.sk, msg.pid, msg.code, msg.latency_ns, msg.client_server);
 }
 
-void BufferedPoller::send_socket_stats(u64 t, u64 sk, tcp_statistics &stats)
+void BufferedPoller::send_socket_stats(u64 t, u32 index, tcp_statistics &stats, bool sheddable)
 {
+  if (sheddable && !send_lanes_.admit(SendLane::stats, t)) {
+    tcp_socket_stats_.lookup_relative(index, 1, true).second.add(stats);
+    stats.valid = false;
+    return;
+  }
+
+  u64 const sk = tcp_index_to_sk_[index];
+
   if ((stats.diff_bytes_acked > 0) || (stats.diff_retrans > 0)) {
     writer_.socket_stats_tstamp(t, sk, stats.diff_bytes_acked, stats.diff_delivered, stats.diff_retrans, stats.max_srtt, 0);
   }
@@ -846,7 +930,7 @@ void BufferedPoller::send_stats_from_queue(u64 t)
 
     if (stats.valid) {
       /* write the message */
-      send_socket_stats(t, tcp_index_to_sk_[index], stats);
+      send_socket_stats(t, index, stats, true);
 
       /* send_socket_stats sets stats.valid = false */
     }
@@ -896,10 +980,31 @@ void BufferedPoller::handle_udp_new_socket(message_metadata const &metadata, jb_
   //			<< " laddr " << addr_s << std::endl;
 }
 
+void BufferedPoller::udp_sampling_changed(u64 sk, u32 mask)
+{
+  int const fd = (int)udp_sampling_desc_.fd;
+
+  int err;
+  if (mask) {
+    err = bpf_update_elem(fd, &sk, &mask, BPF_ANY);
+  } else {
+    err = bpf_delete_elem(fd, &sk);
+  }
+  if (err < 0) {
+    // bpf keeps its previous mask, which the messages it keeps carry
+    LOG::debug_in(AgentLogKind::UDP, "udp_sampling_changed: failed to set mask={:x} of sk={:x}, err={}", mask, sk, err);
+  } else {
+    LOG::debug_in(AgentLogKind::UDP, "udp_sampling_changed: sk={:x} sampled 1 in {}", sk, mask + 1);
+  }
+}
+
 void BufferedPoller::handle_udp_destroy_socket(message_metadata const &metadata, jb_agent_internal__udp_destroy_socket &msg)
 {
   LOG::debug_in(AgentLogKind::UDP, "handle_udp_destroy_socket: sk={:x}", msg.sk);
 
+  // bpf drops the socket's sampling mask along with it
+  udp_sampler_.forget(msg.sk);
+
   auto pos = udp_socket_table_.find(msg.sk);
   if (pos.index == udp_socket_table_.invalid) {
     if (!udp_socket_table_ever_full_ && all_probes_loaded_) {
@@ -915,13 +1020,13 @@ void BufferedPoller::handle_udp_destroy_socket(message_metadata const &metadata,
     timeout_dns_request(metadata.timestamp, req);
   }
 
-  /* send out statistics message if available */
+  /* send out statistics message if available; it's the socket's last, so it isn't shed */
   if (pos.entry->reported) {
     for (int is_rx = 0; is_rx < 2; is_rx++) {
       for (u32 epoch = 0; epoch < n_epochs; epoch++) {
         auto &stats = udp_socket_stats_[is_rx].lookup_relative(pos.index, epoch, false).second;
         if (stats.valid == true)
-          udp_send_stats(metadata.timestamp, pos.index, is_rx, *pos.entry, stats);
+          udp_send_stats(metadata.timestamp, pos.index, is_rx, *pos.entry, stats, false);
       }
     }
     /* notify of the destruction */
@@ -947,6 +1052,8 @@ void BufferedPoller::handle_udp_stats(message_metadata const &metadata, jb_agent
   }
   auto &entry = *pos.entry;
 
+  udp_sampler_.count(msg.sk);
+
   /* find the statistics, and ask it to enqueue */
   u8 is_rx = msg.is_rx;
   auto &stats = udp_socket_stats_[is_rx].lookup(pos.index, metadata.timestamp, true).second;
@@ -954,10 +1061,11 @@ void BufferedPoller::handle_udp_stats(message_metadata const &metadata, jb_agent
   /* if stats are valid and address changed, output the previous stat and update
    * address */
   if (msg.changed_af != 0) {
-    /* there might be statistics for a different address */
+    /* there might be statistics for a different address, which can't be
+     * carried over to the next one */
     if (stats.valid) {
       /* send the stats. will clear the stats */
-      udp_send_stats(metadata.timestamp, pos.index, is_rx, entry, stats);
+      udp_send_stats(metadata.timestamp, pos.index, is_rx, entry, stats, false);
     }
 
     // Lookup whether this is a NAT-ed connection if this is ipv4
@@ -993,7 +1101,7 @@ void BufferedPoller::handle_udp_stats(message_metadata const &metadata, jb_agent
     // fast track stats for address changes. we can't delay pushing address
     // changes to the server, because the next messages (dns
     // responses/timeouts/etc for example) may require the address to be set
-    udp_send_stats(metadata.timestamp, pos.index, is_rx, entry, stats);
+    udp_send_stats(metadata.timestamp, pos.index, is_rx, entry, stats, false);
   }
 
   if (!stats.valid) {
@@ -1112,11 +1220,18 @@ void BufferedPoller::udp_send_new_socket(u64 ts, udp_socket_entry *entry, u64 in
   }
 }
 
-void BufferedPoller::udp_send_stats(u64 t, u32 sk_id, u8 is_rx, udp_socket_entry &entry, udp_statistics &stats)
+void BufferedPoller::udp_send_stats(u64 t, u32 sk_id, u8 is_rx, udp_socket_entry &entry, udp_statistics &stats, bool sheddable)
 {
   trace_print_udp_socket_entry("udp_send_stats", &entry);
 
   auto &addr = entry.addrs[is_rx];
+
+  // address changes are state the next stats rely on, so they aren't shed
+  if (sheddable && entry.reported && !addr.changed_af && !send_lanes_.admit(SendLane::stats, t)) {
+    udp_socket_stats_[is_rx].lookup_relative(sk_id, 1, true).second.add(stats);
+    stats.valid = false;
+    return;
+  }
   if (entry.reported == false) {
     LOG::trace("BufferedPoller::udp_send_stats - entry.reported == false");
     udp_send_new_socket(t, &entry, sk_id);
@@ -1189,7 +1304,7 @@ void BufferedPoller::udp_send_stats_from_queue(u64 t)
 
       if (stats.valid) {
         /* write the message */
-        udp_send_stats(t, index, is_rx, udp_socket_table_[index], stats);
+        udp_send_stats(t, index, is_rx, udp_socket_table_[index], stats, true);
 
         /* udp_send_stats sets stats.valid = false */
       }
@@ -21,8 +21,10 @@
 #include <collector/kernel/perf_poller.h>
 #include <collector/kernel/probe_handler.h>
 #include <collector/kernel/process_handler.h>
+#include <collector/kernel/send_lanes.h>
 #include <collector/kernel/socket_table.h>
 #include <collector/kernel/tcp_data_handler.h>
+#include <collector/kernel/udp_sampler.h>
 #include <generated/ebpf_net/agent_internal/hash.h>
 #include <generated/ebpf_net/ingest/encoder.h>
 #include <generated/ebpf_net/ingest/writer.h>
@@ -102,6 +104,12 @@ public:
    */
   void send_report_if_recent_loss();
 
+  /**
+   * Tells the backend how many messages of each lane were shed since the last
+   *   report, if any were
+   */
+  void send_shed_report();
+
   /**
    * accessor for lost_count_
    */
@@ -146,13 +154,26 @@ private:
   using message_handler_fn =
       void (BufferedPoller::*)(message_metadata const &metadata, typename MessageMetadata::wire_message &);
 
-  template <typename MessageMetadata, message_handler_fn<MessageMetadata>, std::size_t MaxPadding, typename Alignment>
+  template <
+      typename MessageMetadata,
+      message_handler_fn<MessageMetadata>,
+      std::size_t MaxPadding,
+      typename Alignment,
+      SendLane Lane>
   void message_handler_entrypoint(PerfReader &reader, u16 length);
 
   /**
    * Adds a handler to the hash. Throws on collision.
-   */
-  template <typename MessageMetadata, message_handler_fn<MessageMetadata>, std::size_t MaxPadding = 0, typename Alignment = u64>
+   *
+   * Messages of handlers in a lossy lane are shed past the lane's budget
+   * while the connection to the reducer is congested.
+   */
+  template <
+      typename MessageMetadata,
+      message_handler_fn<MessageMetadata>,
+      std::size_t MaxPadding = 0,
+      typename Alignment = u64,
+      SendLane Lane = SendLane::state>
   void add_handler();
 
   /**
@@ -206,11 +227,13 @@ private:
   void handle_http_response(message_metadata const &metadata, jb_agent_internal__http_response &msg);
 
   /**
-   * Sends a message with statistics for the entry
+   * Sends a message with statistics for the socket at |index|
    *
-   * Also marks the entry as invalid.
+   * Also marks the entry as invalid. If |sheddable| and the stats lane sheds
+   * the message, the statistics are added to the socket's next timeslot, to
+   * be sent with its next update.
    */
-  void send_socket_stats(u64 t, u64 sk, tcp_statistics &stats);
+  void send_socket_stats(u64 t, u32 index, tcp_statistics &stats, bool sheddable);
 
   /**
    * Processes the current queue in socket_stats_, sending out messages and
@@ -265,10 +288,12 @@ private:
   /**
    * Sends a message with statistics for the entry
    *
-   * Also marks the entry as invalid.
+   * Also marks the entry as invalid. If |sheddable| and the stats lane sheds
+   * the message, the statistics are added to the socket's next timeslot, to
+   * be sent with its next update.
    * @assumes entry is valid
    */
-  void udp_send_stats(u64 t, u32 sk_id, u8 is_rx, udp_socket_entry &entry, udp_statistics &stats);
+  void udp_send_stats(u64 t, u32 sk_id, u8 is_rx, udp_socket_entry &entry, udp_statistics &stats, bool sheddable);
 
   /**
    * Processes the current queue in socket_stats_, sending out messages and
@@ -277,6 +302,11 @@ private:
    */
   void udp_send_stats_from_queue(u64 t);
 
+  /**
+   * Applies a new sampling mask of a udp socket in bpf
+   */
+  void udp_sampling_changed(u64 sk, u32 mask);
+
   /*** CONTAINERS ***/
   /**
    * Handler for a new cgroup dir
@@ -314,6 +344,7 @@ private:
   FileDescriptor &bpf_dump_file_;
   logging::Logger &log_;
   IBufferedWriter &buffered_writer_;
+  SendLanes send_lanes_;
   ProbeHandler &probe_handler_;
   ebpf::BPFModule &bpf_module_;
   ::ebpf_net::ingest::Writer writer_;
@@ -326,6 +357,9 @@ private:
   /* the last lost count that a message was sent for */
   u64 notified_lost_count_ = 0;
 
+  /* messages shed in each lane since the connection got congested, for the log */
+  enum_traits<SendLane>::array_map<u64> logged_shed_counts_ = {};
+
   handler_fn handlers_[AGENT_INTERNAL_HASH_SIZE];
 
   /* u64 Hasher */
@@ -354,6 +388,12 @@ private:
   bool udp_socket_table_ever_full_;
   std::array<UdpSocketStatistics, 2> udp_socket_stats_; /* 0: TX, 1: RX */
 
+  /* sampling of busy udp sockets while the collector can't keep up */
+  ebpf::TableDesc udp_sampling_desc_;
+  UdpSampler udp_sampler_;
+  /* when the messages being handled were read from the perf rings */
+  u64 poll_timestamp_ = 0;
+
   /* DNS */
   DnsRequests dns_requests_;
 
@@ -21,8 +21,10 @@ public:
   };
 
   struct dns_request_value {
-    u64 timestamp_ns; // when the query was made according to bpf
-    u64 sk;           // socket that sent the dns request
+    u64 timestamp_ns;  // when the query was made according to bpf
+    u64 sk;            // socket that sent the dns request
+    u32 id_hash;       // hash of the message id that bpf samples by
+    u32 sampling_mask; // mask bpf kept the request with, see UdpSampler
   };
 
 protected:
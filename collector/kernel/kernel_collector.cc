@@ -108,7 +108,9 @@ KernelCollector::KernelCollector(
           WRITE_BUFFER_SIZE,
           intake_config_.allow_compression(),
           *primary_channel_,
-          secondary_channel_ ? &secondary_channel_ : nullptr),
+          secondary_channel_ ? &secondary_channel_ : nullptr,
+          intake_config_.compression(),
+          intake_config_.zstd_dictionary()),
       writer_(upstream_connection_.buffered_writer(), monotonic, boot_time_adjustment, encoder_.get()),
       last_probe_monotonic_time_ns_(monotonic() - inter_probe_time_ns_),
       is_connected_(false),
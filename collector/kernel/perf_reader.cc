@@ -65,6 +65,19 @@ std::string PerfContainer::inspect(void)
   return out;
 }
 
+u32 PerfContainer::max_fill_percent() const
+{
+  u32 max_percent = 0;
+  for (auto const &reader : readers_) {
+    u32 total_bytes = 0;
+    u32 const bytes = reader.bytes_remaining(&total_bytes);
+    if (total_bytes) {
+      max_percent = std::max(max_percent, static_cast<u32>(u64(bytes) * 100 / total_bytes));
+    }
+  }
+  return max_percent;
+}
+
 PerfReader::PerfReader(PerfContainer &container, u64 max_timestamp)
     : container_(container), max_timestamp_(max_timestamp), active_(true)
 {
@@ -68,6 +68,9 @@ public:
    */
   std::string inspect(void);
 
+  // returns how full the fullest control channel ring is, in percent
+  u32 max_fill_percent() const;
+
   // returns the number of perf rings in this container
   std::size_t size() const { return readers_.size(); }
 
@@ -131,8 +131,10 @@ void ProtocolHandler_HTTP::handle_server_data(u64 tstamp, u64 offset, STREAM_TYP
           latency,
           client_server_type_to_string(client_server));
 
-      data_handler()->writer().http_response_tstamp(
-          response_timestamp_, control_key().sk, pid(), http_code_, latency, (u8)client_server);
+      if (data_handler()->send_lanes().admit(SendLane::events, response_timestamp_)) {
+        data_handler()->writer().http_response_tstamp(
+            response_timestamp_, control_key().sk, pid(), http_code_, latency, (u8)client_server);
+      }
 
       transition(SERVER_STATE::STOP);
     } break;
@@ -0,0 +1,62 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <collector/kernel/send_lanes.h>
+
+#include <algorithm>
+
+namespace {
+
+/* a message costs this many tokens; a lane gets |budget| tokens per ns */
+constexpr u64 MESSAGE_TOKENS = 1'000'000'000;
+
+/* lanes are refilled with at most a second's worth of budget */
+constexpr u64 MAX_REFILL_NS = 1'000'000'000;
+
+} // namespace
+
+SendLanes::SendLanes(IBufferedWriter &writer, Budgets budgets) : writer_(writer)
+{
+  lanes_[enum_index_of(SendLane::stats)].budget = budgets.stats;
+  lanes_[enum_index_of(SendLane::events)].budget = budgets.events;
+}
+
+bool SendLanes::admit(SendLane lane, u64 timestamp)
+{
+  if (lane == SendLane::state) {
+    return true;
+  }
+
+  auto &state = lanes_[enum_index_of(lane)];
+  u64 const capacity = state.budget * MESSAGE_TOKENS;
+
+  if (!writer_.is_congested()) {
+    /* the next congestion starts with a full budget */
+    state.tokens = capacity;
+    state.refilled_at = timestamp;
+    return true;
+  }
+
+  /* timestamps from different CPUs can go slightly back in time */
+  if (timestamp > state.refilled_at) {
+    u64 const elapsed = std::min(timestamp - state.refilled_at, MAX_REFILL_NS);
+    state.tokens = std::min(capacity, state.tokens + elapsed * state.budget);
+    state.refilled_at = timestamp;
+  }
+
+  if (state.tokens >= MESSAGE_TOKENS && !writer_.is_full()) {
+    state.tokens -= MESSAGE_TOKENS;
+    return true;
+  }
+
+  ++state.shed;
+  return false;
+}
+
+u64 SendLanes::take_unreported(SendLane lane)
+{
+  auto &state = lanes_[enum_index_of(lane)];
+  u64 const unreported = state.shed - state.reported;
+  state.reported = state.shed;
+  return unreported;
+}
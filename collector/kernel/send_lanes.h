@@ -0,0 +1,60 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <channel/ibuffered_writer.h>
+#include <common/send_lane.h>
+#include <platform/platform.h>
+
+/**
+ * Decides, by lane, which messages to send to the reducer while the
+ * connection to it is congested.
+ *
+ * While the connection keeps up, every message is sent. While it's congested,
+ * each lossy lane may send up to its budget of messages per second, with
+ * bursts of up to a second's worth, and the messages over it are shed and
+ * counted. Once the connection is full, lossy lanes send nothing until it
+ * drains. The state lane has no budget, so that the reducer's state stays
+ * consistent however much is shed.
+ */
+class SendLanes {
+public:
+  /* messages per second each lossy lane may send while congested */
+  struct Budgets {
+    u64 stats = 10'000;
+    u64 events = 1'000;
+  };
+
+  SendLanes(IBufferedWriter &writer, Budgets budgets);
+
+  /**
+   * Whether a message of |lane| can be sent at |timestamp|, in nanoseconds
+   * from a monotonic clock. Counts the message as shed if not.
+   */
+  bool admit(SendLane lane, u64 timestamp);
+
+  /* number of messages of |lane| shed so far */
+  u64 shed_count(SendLane lane) const { return lanes_[enum_index_of(lane)].shed; }
+
+  /**
+   * Number of messages of |lane| shed since the last call, for reporting.
+   */
+  u64 take_unreported(SendLane lane);
+
+private:
+  struct Lane {
+    /* messages per second while congested */
+    u64 budget = 0;
+    /* in billionths of a message, so that refills don't round down */
+    u64 tokens = 0;
+    u64 refilled_at = 0;
+    u64 shed = 0;
+    u64 reported = 0;
+  };
+
+  IBufferedWriter &writer_;
+  enum_traits<SendLane>::array_map<Lane> lanes_;
+};
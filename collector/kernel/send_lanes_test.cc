@@ -0,0 +1,120 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <collector/kernel/send_lanes.h>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr u64 SECOND_NS = 1'000'000'000;
+
+class FakeWriter : public IBufferedWriter {
+public:
+  Expected<u8 *, std::error_code> start_write(u32 length) override
+  {
+    return {unexpected, std::make_error_code(std::errc::not_supported)};
+  }
+  void finish_write() override {}
+  std::error_code flush() override { return {}; }
+  u32 buf_size() const override { return 0; }
+  bool is_writable() const override { return true; }
+  bool is_congested() const override { return congested || full; }
+  bool is_full() const override { return full; }
+
+  bool congested = false;
+  bool full = false;
+};
+
+u64 admitted(SendLanes &lanes, SendLane lane, u64 count, u64 timestamp)
+{
+  u64 result = 0;
+  for (u64 i = 0; i < count; ++i) {
+    result += lanes.admit(lane, timestamp);
+  }
+  return result;
+}
+
+} // namespace
+
+TEST(SendLanesTest, SendsEverythingUnlessCongested)
+{
+  FakeWriter writer;
+  SendLanes lanes(writer, {.stats = 0, .events = 0});
+
+  for (auto lane : enum_traits<SendLane>::values) {
+    EXPECT_EQ(1000u, admitted(lanes, lane, 1000, SECOND_NS));
+    EXPECT_EQ(0u, lanes.shed_count(lane));
+  }
+}
+
+TEST(SendLanesTest, NeverShedsState)
+{
+  FakeWriter writer;
+  writer.congested = true;
+  SendLanes lanes(writer, {.stats = 0, .events = 0});
+
+  EXPECT_EQ(1000u, admitted(lanes, SendLane::state, 1000, SECOND_NS));
+  EXPECT_EQ(0u, admitted(lanes, SendLane::events, 1000, SECOND_NS));
+  EXPECT_EQ(0u, lanes.shed_count(SendLane::state));
+  EXPECT_EQ(1000u, lanes.shed_count(SendLane::events));
+}
+
+TEST(SendLanesTest, KeepsLossyLanesWithinBudget)
+{
+  FakeWriter writer;
+  SendLanes lanes(writer, {.stats = 100, .events = 10});
+
+  // congestion starts with a second's worth of budget
+  admitted(lanes, SendLane::stats, 1, 0);
+  admitted(lanes, SendLane::events, 1, 0);
+  writer.congested = true;
+  EXPECT_EQ(100u, admitted(lanes, SendLane::stats, 1000, SECOND_NS / 10));
+  EXPECT_EQ(10u, admitted(lanes, SendLane::events, 1000, SECOND_NS / 10));
+  EXPECT_EQ(900u, lanes.shed_count(SendLane::stats));
+  EXPECT_EQ(990u, lanes.shed_count(SendLane::events));
+
+  // then refills at the budget's rate
+  EXPECT_EQ(50u, admitted(lanes, SendLane::stats, 1000, SECOND_NS * 6 / 10));
+  EXPECT_EQ(5u, admitted(lanes, SendLane::events, 1000, SECOND_NS * 6 / 10));
+
+  // up to a second's worth
+  EXPECT_EQ(100u, admitted(lanes, SendLane::stats, 1000, SECOND_NS * 60));
+
+  // time going back doesn't refill
+  EXPECT_EQ(0u, admitted(lanes, SendLane::stats, 1000, SECOND_NS * 59));
+}
+
+TEST(SendLanesTest, ShedsLossyLanesWhileFull)
+{
+  FakeWriter writer;
+  SendLanes lanes(writer, {.stats = 100, .events = 10});
+
+  admitted(lanes, SendLane::stats, 1, 0);
+  writer.full = true;
+  EXPECT_EQ(0u, admitted(lanes, SendLane::stats, 1000, SECOND_NS));
+  EXPECT_EQ(0u, admitted(lanes, SendLane::events, 1000, SECOND_NS));
+  EXPECT_EQ(1000u, admitted(lanes, SendLane::state, 1000, SECOND_NS));
+
+  // the budget is left for once the connection drains below full
+  writer.full = false;
+  writer.congested = true;
+  EXPECT_EQ(100u, admitted(lanes, SendLane::stats, 1000, SECOND_NS));
+}
+
+TEST(SendLanesTest, ReportsSheddingOnce)
+{
+  FakeWriter writer;
+  writer.congested = true;
+  SendLanes lanes(writer, {.stats = 0, .events = 0});
+
+  admitted(lanes, SendLane::events, 7, SECOND_NS);
+  admitted(lanes, SendLane::stats, 3, SECOND_NS);
+  EXPECT_EQ(7u, lanes.take_unreported(SendLane::events));
+  EXPECT_EQ(0u, lanes.take_unreported(SendLane::events));
+  EXPECT_EQ(3u, lanes.take_unreported(SendLane::stats));
+
+  admitted(lanes, SendLane::events, 2, SECOND_NS);
+  EXPECT_EQ(2u, lanes.take_unreported(SendLane::events));
+  EXPECT_EQ(9u, lanes.shed_count(SendLane::events));
+}
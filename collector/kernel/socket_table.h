@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <platform/platform.h>
 #include <string.h>
@@ -29,6 +30,26 @@ struct tcp_statistics {
    * code to invalidate this entry so it will be ignored
    */
   bool valid = false;
+
+  /* adds the changes in |other|, if valid, to this statistic */
+  void add(tcp_statistics const &other)
+  {
+    if (!other.valid) {
+      return;
+    }
+    if (!valid) {
+      *this = other;
+      return;
+    }
+    diff_bytes_acked += other.diff_bytes_acked;
+    diff_delivered += other.diff_delivered;
+    diff_retrans += other.diff_retrans;
+    max_srtt = std::max(max_srtt, other.max_srtt);
+    diff_rcv_holes += other.diff_rcv_holes;
+    diff_bytes_received += other.diff_bytes_received;
+    diff_rcv_delivered += other.diff_rcv_delivered;
+    max_rcv_rtt = std::max(max_rcv_rtt, other.max_rcv_rtt);
+  }
 };
 
 struct tcp_socket_entry {
@@ -46,6 +67,21 @@ struct udp_statistics {
   u32 packets = 0;
   u64 bytes = 0;
   u32 drops = 0;
+
+  /* adds the changes in |other|, if valid, to this statistic */
+  void add(udp_statistics const &other)
+  {
+    if (!other.valid) {
+      return;
+    }
+    if (!valid) {
+      *this = other;
+      return;
+    }
+    packets += other.packets;
+    bytes += other.bytes;
+    drops += other.drops;
+  }
 };
 
 struct udp_remote_endpoint {
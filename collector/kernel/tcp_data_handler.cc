@@ -28,9 +28,10 @@ TCPDataHandler::TCPDataHandler(
     uv_loop_t &loop,
     ebpf::BPFModule &bpf_module,
     ::ebpf_net::ingest::Writer &writer,
+    SendLanes &send_lanes,
     PerfContainer &container,
     logging::Logger &log)
-    : loop_(loop), bpf_module_(bpf_module), writer_(writer), container_(container), log_(log)
+    : loop_(loop), bpf_module_(bpf_module), writer_(writer), send_lanes_(send_lanes), container_(container), log_(log)
 {
   // Get tcp control hash table
   ebpf::TableStorage::iterator it;
@@ -21,6 +21,7 @@
 #include "collector/agent_log.h"
 #include "collector/kernel/bpf_src/tcp-processor/tcp_processor.h"
 #include "collector/kernel/perf_reader.h"
+#include "collector/kernel/send_lanes.h"
 #include "protocols/protocol_handler_base.h"
 
 class TCPDataHandler {
@@ -32,6 +33,7 @@ public:
       uv_loop_t &loop,
       ebpf::BPFModule &bpf_module,
       ::ebpf_net::ingest::Writer &writer,
+      SendLanes &send_lanes,
       PerfContainer &container,
       logging::Logger &log);
 
@@ -55,6 +57,7 @@ public:
 
   // Output
   inline ::ebpf_net::ingest::Writer &writer() { return writer_; }
+  inline SendLanes &send_lanes() { return send_lanes_; }
 
   // tcp kernel->userland throttling control backchannel
   void enable_stream(const tcp_control_key_t &key, STREAM_TYPE stream_type, bool enable);
@@ -75,6 +78,7 @@ protected:
   uv_loop_t &loop_;
   ebpf::BPFModule &bpf_module_;
   ::ebpf_net::ingest::Writer &writer_;
+  SendLanes &send_lanes_;
   PerfContainer &container_;
   u64 lost_record_total_count_ = 0;
   std::map<tcp_control_key_t, std::shared_ptr<ProtocolHandlerBase>, tcp_control_key_t_comparator> protocol_handlers_;
@@ -0,0 +1,78 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <collector/kernel/udp_sampler.h>
+
+UdpSampler::UdpSampler(Settings settings, on_change_fn on_change) : settings_(settings), on_change_(std::move(on_change)) {}
+
+void UdpSampler::update()
+{
+  bool const pressure =
+      max_ring_fill_percent_ >= settings_.high_ring_fill_percent || max_lag_ns_ >= settings_.high_lag_ns;
+  bool const relief =
+      max_ring_fill_percent_ < settings_.high_ring_fill_percent / 2 && max_lag_ns_ < settings_.high_lag_ns / 2;
+
+  max_ring_fill_percent_ = 0;
+  max_lag_ns_ = 0;
+
+  for (auto i = sockets_.begin(); i != sockets_.end();) {
+    auto &[sk, socket] = *i;
+
+    if (pressure && socket.events >= settings_.min_socket_events && socket.shift < settings_.max_shift) {
+      set_shift(sk, socket, socket.shift + 1);
+    } else if (relief && socket.shift > 0) {
+      set_shift(sk, socket, socket.shift - 1);
+    }
+
+    socket.events = 0;
+
+    if (socket.shift == 0) {
+      sockets_.erase(i++);
+    } else {
+      ++i;
+    }
+  }
+}
+
+u32 UdpSampler::mask(u64 sk) const
+{
+  if (!sampled_count_) {
+    return 0;
+  }
+
+  auto const i = sockets_.find(sk);
+  return i == sockets_.end() ? 0 : (1u << i->second.shift) - 1;
+}
+
+u32 UdpSampler::dns_timeout_weight(u64 sk, u32 hash, u32 query_mask) const
+{
+  // a response dropped by bpf was dropped with at most the current mask,
+  // unless sampling eased off since, which slightly over-counts timeouts
+  u32 const effective = std::max(query_mask, mask(sk));
+  return (hash & effective) ? 0 : effective + 1;
+}
+
+void UdpSampler::forget(u64 sk)
+{
+  auto const i = sockets_.find(sk);
+  if (i == sockets_.end()) {
+    return;
+  }
+
+  if (i->second.shift) {
+    --sampled_count_;
+  }
+  sockets_.erase(i);
+}
+
+void UdpSampler::set_shift(u64 sk, Socket &socket, u32 shift)
+{
+  if (!socket.shift) {
+    ++sampled_count_;
+  } else if (!shift) {
+    --sampled_count_;
+  }
+
+  socket.shift = shift;
+  on_change_(sk, (1u << shift) - 1);
+}
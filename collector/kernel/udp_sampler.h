@@ -0,0 +1,95 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <platform/platform.h>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <algorithm>
+#include <functional>
+
+/**
+ * Decides which UDP sockets to sample DNS packets and remote address changes
+ * of, so that a few very busy sockets (e.g. of a DNS server) can't overwhelm
+ * the collector.
+ *
+ * Sampling is driven by how full the perf rings get and how late messages are
+ * handled: under pressure, the busiest sockets are sampled at half their
+ * previous rate, down to 1 in 2^Settings::max_shift events; once the pressure
+ * is gone, rates are doubled back until sampling stops.
+ *
+ * A sampled socket has a mask: only events whose hash has none of the mask's
+ * bits set are kept, so that each kept event stands for mask + 1 events.
+ *
+ * bpf applies masks as it sees events, which userspace handles later, maybe
+ * after the mask changed: DNS messages carry the mask they were kept with, and
+ * are weighed by it rather than by the socket's current mask.
+ */
+class UdpSampler {
+public:
+  struct Settings {
+    /* ring fill, in percent, and lag past which there is pressure; there is
+     * none anymore below half of both */
+    u32 high_ring_fill_percent = 50;
+    u64 high_lag_ns = 100'000'000;
+    /* sockets with fewer kept events than this between updates aren't
+     * sampled any further */
+    u64 min_socket_events = 1000;
+    /* lowest sampling rate is 1 in 2^max_shift */
+    u32 max_shift = 10;
+  };
+
+  /* called with a socket's new mask when it changes, 0 once it's not sampled */
+  using on_change_fn = std::function<void(u64 sk, u32 mask)>;
+
+  UdpSampler(Settings settings, on_change_fn on_change);
+
+  /* an event of socket |sk| was kept */
+  void count(u64 sk) { ++sockets_[sk].events; }
+
+  /* how full the fullest perf ring was, before a poll */
+  void observe_ring_fill(u32 percent) { max_ring_fill_percent_ = std::max(max_ring_fill_percent_, percent); }
+
+  /* how long a message waited in the perf ring before being handled */
+  void observe_lag(u64 lag_ns) { max_lag_ns_ = std::max(max_lag_ns_, lag_ns); }
+
+  /* adjusts sampling rates, given what was observed since the last update */
+  void update();
+
+  u32 mask(u64 sk) const;
+
+  /* number of query and response pairs that a response stands for, given the
+   * masks the query and response were kept with: masks are low bits, so both
+   * are kept exactly when their id's hash passes the larger mask */
+  static u32 dns_response_weight(u32 query_mask, u32 response_mask) { return std::max(query_mask, response_mask) + 1; }
+
+  /* number of timeouts that a query of |sk| kept with |query_mask| and with
+   * |hash|, still without a response, stands for; 0 when its response might
+   * have been dropped since, by a larger mask, so the query can't be counted */
+  u32 dns_timeout_weight(u64 sk, u32 hash, u32 query_mask) const;
+
+  /* the socket is gone */
+  void forget(u64 sk);
+
+  /* number of sockets being sampled */
+  std::size_t sampled_count() const { return sampled_count_; }
+
+private:
+  struct Socket {
+    u64 events = 0;
+    u32 shift = 0;
+  };
+
+  void set_shift(u64 sk, Socket &socket, u32 shift);
+
+  Settings const settings_;
+  on_change_fn on_change_;
+  absl::flat_hash_map<u64, Socket> sockets_;
+  std::size_t sampled_count_ = 0;
+  u32 max_ring_fill_percent_ = 0;
+  u64 max_lag_ns_ = 0;
+};
@@ -0,0 +1,282 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <collector/kernel/udp_sampler.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr u64 DNS_SERVER_SK = 0xd115;
+
+// Replays DNS traffic through a sampler, one update interval at a time, with
+// ring fill growing with the number of messages kept.
+//
+// As in the collector, bpf keeps or drops each message by the mask it has when
+// it sees the message, and userspace handles it after the next update, maybe
+// under another mask. Responses come an interval after their query, and
+// queries without one time out two intervals after they were made.
+class Replay {
+public:
+  // fill reaches 50% at |capacity| messages kept per interval
+  explicit Replay(u64 capacity)
+      : capacity_(capacity), sampler_({}, [this](u64 sk, u32 mask) { masks_[sk] = mask; })
+  {}
+
+  // each socket makes |queries| queries during the interval, of which one in
+  // |unanswered_every| gets no response
+  void interval(std::map<u64, u64> const &queries, u64 unanswered_every = 10)
+  {
+    // bpf sees this interval's queries and the previous interval's responses
+    std::vector<Message> ring;
+    for (auto const &query : answered_) {
+      capture(ring, query, true);
+    }
+    answered_.clear();
+
+    for (auto const &[sk, count] : queries) {
+      for (u64 i = 0; i < count; ++i) {
+        Query const query{.sk = sk, .id = next_id_++, .hash = u32(random_()), .interval = now_};
+        bool const answered = query.id % unanswered_every;
+        if (answered) {
+          answered_.push_back(query);
+        }
+        auto &totals = totals_[sk][now_];
+        ++(answered ? totals.actual_responses : totals.actual_timeouts);
+        capture(ring, query, false);
+      }
+    }
+
+    // the update happens before userspace gets to the ring
+    kept_ = ring.size();
+    sampler_.observe_ring_fill(std::min<u64>(100, kept_ * 50 / capacity_));
+    sampler_.update();
+
+    for (auto const &msg : ring) {
+      handle(msg);
+    }
+    if (now_ >= 2) {
+      time_out(now_ - 2);
+    }
+
+    ++now_;
+  }
+
+  struct Totals {
+    u64 actual_responses = 0;
+    u64 estimated_responses = 0;
+    u64 actual_timeouts = 0;
+    u64 estimated_timeouts = 0;
+  };
+
+  // what happened to a socket's queries, and what the collector reported,
+  // leaving out the last queries which don't all have an outcome yet
+  Totals totals(u64 sk)
+  {
+    Totals sum;
+    for (auto const &[interval, totals] : totals_[sk]) {
+      if (interval + 2 < now_) {
+        sum.actual_responses += totals.actual_responses;
+        sum.estimated_responses += totals.estimated_responses;
+        sum.actual_timeouts += totals.actual_timeouts;
+        sum.estimated_timeouts += totals.estimated_timeouts;
+      }
+    }
+    return sum;
+  }
+
+  u64 const capacity_;
+  UdpSampler sampler_;
+  std::mt19937 random_{1234};
+  std::map<u64, u32> masks_;
+  u64 kept_ = 0;
+
+private:
+  struct Query {
+    u64 sk;
+    u64 id;
+    u32 hash;
+    u64 interval;
+  };
+
+  struct Message {
+    Query query;
+    bool is_response;
+    u32 mask;
+  };
+
+  // bpf's side: its mask is the one last set through the sampler
+  void capture(std::vector<Message> &ring, Query const &query, bool is_response)
+  {
+    auto const found = masks_.find(query.sk);
+    u32 const mask = found == masks_.end() ? 0 : found->second;
+    if ((query.hash & mask) == 0) {
+      ring.push_back({.query = query, .is_response = is_response, .mask = mask});
+    }
+  }
+
+  // userspace's side
+  void handle(Message const &msg)
+  {
+    sampler_.count(msg.query.sk);
+
+    if (!msg.is_response) {
+      pending_[msg.query.id] = msg;
+      return;
+    }
+
+    auto const request = pending_.find(msg.query.id);
+    if (request == pending_.end()) {
+      return;
+    }
+    totals_[msg.query.sk][msg.query.interval].estimated_responses +=
+        UdpSampler::dns_response_weight(request->second.mask, msg.mask);
+    pending_.erase(request);
+  }
+
+  void time_out(u64 interval)
+  {
+    for (auto i = pending_.begin(); i != pending_.end();) {
+      auto const &[query, is_response, mask] = i->second;
+      if (query.interval > interval) {
+        ++i;
+        continue;
+      }
+      totals_[query.sk][query.interval].estimated_timeouts += sampler_.dns_timeout_weight(query.sk, query.hash, mask);
+      pending_.erase(i++);
+    }
+  }
+
+  std::vector<Query> answered_;
+  std::map<u64, Message> pending_;
+  std::map<u64, std::map<u64, Totals>> totals_;
+  u64 next_id_ = 0;
+  u64 now_ = 0;
+};
+
+} // namespace
+
+TEST(UdpSamplerTest, DoesNotSampleWithoutPressure)
+{
+  Replay replay(1'000'000);
+  for (int i = 0; i < 10; ++i) {
+    replay.interval({{DNS_SERVER_SK, 100'000}, {1, 10}});
+  }
+
+  EXPECT_EQ(0u, replay.sampler_.sampled_count());
+  EXPECT_TRUE(replay.masks_.empty());
+
+  for (u64 sk : {DNS_SERVER_SK, u64(1)}) {
+    auto const totals = replay.totals(sk);
+    EXPECT_LT(0u, totals.actual_timeouts);
+    EXPECT_EQ(totals.actual_responses, totals.estimated_responses);
+    EXPECT_EQ(totals.actual_timeouts, totals.estimated_timeouts);
+  }
+}
+
+TEST(UdpSamplerTest, BoundsBusySocketsWithAccurateTotals)
+{
+  Replay replay(20'000);
+
+  std::map<u64, u64> queries{{DNS_SERVER_SK, 100'000}};
+  for (u64 sk = 1; sk <= 50; ++sk) {
+    queries[sk] = 100;
+  }
+
+  // masks change while messages kept with the previous ones are handled, and
+  // while queries wait for their response
+  for (int i = 0; i < 30; ++i) {
+    replay.interval(queries);
+  }
+
+  // the busy socket is sampled until it stops overflowing the rings
+  EXPECT_EQ(1u, replay.sampler_.sampled_count());
+  EXPECT_LT(0u, replay.sampler_.mask(DNS_SERVER_SK));
+  EXPECT_LE(replay.kept_, replay.capacity_);
+
+  // quiet sockets are left alone
+  for (u64 sk = 1; sk <= 50; ++sk) {
+    EXPECT_EQ(0u, replay.sampler_.mask(sk));
+    auto const totals = replay.totals(sk);
+    EXPECT_EQ(totals.actual_responses, totals.estimated_responses);
+    EXPECT_EQ(totals.actual_timeouts, totals.estimated_timeouts);
+  }
+
+  // scaled counts add up to what happened
+  auto const totals = replay.totals(DNS_SERVER_SK);
+  double const responses = totals.actual_responses;
+  EXPECT_NEAR(responses, totals.estimated_responses, responses * 0.01);
+  double const timeouts = totals.actual_timeouts;
+  EXPECT_NEAR(timeouts, totals.estimated_timeouts, timeouts * 0.05);
+}
+
+TEST(UdpSamplerTest, StopsSamplingOncePressureIsGone)
+{
+  Replay replay(20'000);
+  for (int i = 0; i < 10; ++i) {
+    replay.interval({{DNS_SERVER_SK, 100'000}});
+  }
+  ASSERT_EQ(1u, replay.sampler_.sampled_count());
+
+  for (int i = 0; i < 20; ++i) {
+    replay.interval({{DNS_SERVER_SK, 1'000}});
+  }
+  EXPECT_EQ(0u, replay.sampler_.sampled_count());
+  EXPECT_EQ(0u, replay.sampler_.mask(DNS_SERVER_SK));
+  EXPECT_EQ(0u, replay.masks_[DNS_SERVER_SK]);
+}
+
+TEST(UdpSamplerTest, WeighsMessagesByTheirOwnMask)
+{
+  std::map<u64, u32> masks;
+  UdpSampler sampler({.min_socket_events = 1}, [&](u64 sk, u32 mask) { masks[sk] = mask; });
+
+  // a query kept 1 in 2, whose response was kept 1 in 4
+  EXPECT_EQ(4u, UdpSampler::dns_response_weight(1, 3));
+  EXPECT_EQ(4u, UdpSampler::dns_response_weight(3, 1));
+  EXPECT_EQ(1u, UdpSampler::dns_response_weight(0, 0));
+
+  // without sampling, timeouts count as they are
+  EXPECT_EQ(1u, sampler.dns_timeout_weight(DNS_SERVER_SK, 0b11, 0));
+
+  sampler.count(DNS_SERVER_SK);
+  sampler.observe_lag(1'000'000'000);
+  sampler.update();
+  sampler.count(DNS_SERVER_SK);
+  sampler.observe_lag(1'000'000'000);
+  sampler.update();
+  ASSERT_EQ(3u, masks[DNS_SERVER_SK]);
+
+  // a query kept unsampled, or 1 in 2, stands for as many timeouts as the
+  // socket's mask now, unless its response might have been dropped by it
+  EXPECT_EQ(4u, sampler.dns_timeout_weight(DNS_SERVER_SK, 0b100, 0));
+  EXPECT_EQ(4u, sampler.dns_timeout_weight(DNS_SERVER_SK, 0b100, 1));
+  EXPECT_EQ(0u, sampler.dns_timeout_weight(DNS_SERVER_SK, 0b10, 1));
+
+  // a query kept with a larger mask than now stands for more
+  EXPECT_EQ(8u, sampler.dns_timeout_weight(DNS_SERVER_SK, 0b1000, 7));
+}
+
+TEST(UdpSamplerTest, SamplesOnLag)
+{
+  std::map<u64, u32> masks;
+  UdpSampler sampler({.min_socket_events = 1}, [&](u64 sk, u32 mask) { masks[sk] = mask; });
+
+  sampler.count(DNS_SERVER_SK);
+  sampler.observe_lag(1'000'000'000);
+  sampler.update();
+  EXPECT_EQ(1u, masks[DNS_SERVER_SK]);
+
+  sampler.count(DNS_SERVER_SK);
+  sampler.observe_lag(1'000'000'000);
+  sampler.update();
+  EXPECT_EQ(3u, masks[DNS_SERVER_SK]);
+
+  sampler.forget(DNS_SERVER_SK);
+  EXPECT_EQ(0u, sampler.sampled_count());
+  EXPECT_EQ(0u, sampler.mask(DNS_SERVER_SK));
+}
@@ -0,0 +1,18 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <util/enum.h>
+
+// Codec collectors compress their intake stream with, once the connection
+// is established. The reducer tells them apart by the stream's magic number.
+#define ENUM_NAME IntakeCompression
+#define ENUM_TYPE std::uint8_t
+#define ENUM_ELEMENTS(X)                                                                                                       \
+  X(lz4, 0, "")                                                                                                                \
+  X(zstd, 1, "")
+#define ENUM_DEFAULT lz4
+#include <util/enum_operators.inl>
@@ -0,0 +1,25 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <util/enum.h>
+
+// Lanes that collectors send messages to the reducer in, from the one that
+// is never shed to the one that is shed first while the connection is
+// congested.
+//
+// state: lifecycle of sockets, processes, cgroups and NAT mappings, which the
+//   reducer's state depends on.
+// stats: socket statistics and counters, of which the reducer misses a delta
+//   when shed.
+// events: DNS, HTTP and debugging events.
+#define ENUM_NAME SendLane
+#define ENUM_TYPE std::uint8_t
+#define ENUM_ELEMENTS(X)                                                                                                       \
+  X(state, 0, "")                                                                                                              \
+  X(stats, 1, "")                                                                                                              \
+  X(events, 2, "")
+#include <util/enum_operators.inl>
@@ -10,6 +10,7 @@
 #include <util/utility.h>
 
 #include <cstdlib>
+#include <stdexcept>
 
 namespace config {
 
@@ -46,7 +47,23 @@ std::unique_ptr<channel::NetworkChannel> IntakeConfig::make_channel(uv_loop_t &l
     throw std::invalid_argument("missing intake port value");
   }
 
-  return std::make_unique<channel::TCPChannel>(loop, host_, port_);
+  return std::make_unique<channel::TCPChannel>(
+      loop, host_, port_, channel::TCPSendLimits{.max_in_flight_bytes = send_buffer_limit_});
+}
+
+std::string IntakeConfig::zstd_dictionary() const
+{
+  if (zstd_dictionary_path_.empty()) {
+    return {};
+  }
+
+  auto dictionary = read_file_as_string(zstd_dictionary_path_.c_str());
+  if (!dictionary) {
+    throw std::runtime_error(
+        fmt::format("failed to read zstd dictionary from `{}`: {}", zstd_dictionary_path_, dictionary.error().message()));
+  }
+
+  return std::move(*dictionary);
 }
 
 void IntakeConfig::read_from_env(IntakeConfig &config)
@@ -66,6 +83,23 @@ void IntakeConfig::read_from_env(IntakeConfig &config)
   if (std::string_view value = try_get_env_var(INTAKE_INTAKE_ENCODER_VAR); !value.empty()) {
     config.encoder_ = try_enum_from_string(value, IntakeEncoder::binary);
   }
+
+  if (std::string_view value = try_get_env_var(INTAKE_COMPRESSION_VAR); !value.empty()) {
+    config.compression_ = try_enum_from_string(value, IntakeCompression::lz4);
+  }
+
+  if (std::string_view value = try_get_env_var(INTAKE_ZSTD_DICTIONARY_VAR); !value.empty()) {
+    config.zstd_dictionary_path_ = value;
+  }
+
+  config.send_buffer_limit_ = try_get_env_value(INTAKE_SEND_BUFFER_LIMIT_VAR, config.send_buffer_limit_);
+
+  if (std::string_view value = try_get_env_var(INTAKE_SPOOL_DIR_VAR); !value.empty()) {
+    config.spool_directory_ = value;
+  }
+
+  config.spool_size_ = try_get_env_value(INTAKE_SPOOL_SIZE_VAR, config.spool_size_);
+  config.spool_drain_rate_ = try_get_env_value(INTAKE_SPOOL_DRAIN_RATE_VAR, config.spool_drain_rate_);
 }
 
 IntakeConfig::ArgsHandler::ArgsHandler(cli::ArgsParser &parser)
@@ -76,7 +110,25 @@ IntakeConfig::ArgsHandler::ArgsHandler(cli::ArgsParser &parser)
       encoder_(parser.add_arg<IntakeEncoder>(
           "intake-encoder",
           "Chooses the intake encoder to use"
-          " - this relates to the sink used to dump collected telemetry to"))
+          " - this relates to the sink used to dump collected telemetry to")),
+      compression_(parser.add_arg<IntakeCompression>(
+          "intake-compression", "Chooses the codec to compress telemetry sent to the reducer with")),
+      zstd_dictionary_path_(parser.add_arg<std::string>(
+          "intake-zstd-dictionary",
+          "Path to a dictionary made with `zstd --train` to compress telemetry with, when using zstd compression;"
+          " the reducer must be given the same dictionary")),
+      send_buffer_limit_(parser.add_arg<u64>(
+          "intake-send-buffer-limit",
+          "Maximum number of bytes waiting to be sent to the reducer, 0 for no limit; data that is fine to lose is"
+          " held back past half of it and not sent at all past it, and the connection is reset if it stays full")),
+      spool_directory_(parser.add_arg<std::string>(
+          "intake-spool-dir",
+          "Directory in which to spool telemetry while the connection to the reducer is congested, to send it once"
+          " the connection catches up")),
+      spool_size_(
+          parser.add_arg<u64>("intake-spool-size", "Maximum size of the spool, in bytes; the oldest data is dropped past it")),
+      spool_drain_rate_(parser.add_arg<u64>(
+          "intake-spool-drain-rate", "Rate at which spooled telemetry is sent once caught up, in bytes per second"))
 {}
 
 void IntakeConfig::ArgsHandler::read_config(IntakeConfig &config)
@@ -94,6 +146,30 @@ void IntakeConfig::ArgsHandler::read_config(IntakeConfig &config)
   if (encoder_) {
     config.encoder(*encoder_);
   }
+
+  if (compression_) {
+    config.compression(*compression_);
+  }
+
+  if (zstd_dictionary_path_) {
+    config.zstd_dictionary_path(*zstd_dictionary_path_);
+  }
+
+  if (send_buffer_limit_) {
+    config.send_buffer_limit(*send_buffer_limit_);
+  }
+
+  if (spool_directory_) {
+    config.spool_directory(*spool_directory_);
+  }
+
+  if (spool_size_) {
+    config.spool_size(*spool_size_);
+  }
+
+  if (spool_drain_rate_) {
+    config.spool_drain_rate(*spool_drain_rate_);
+  }
 }
 
 } // namespace config
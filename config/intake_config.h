@@ -6,6 +6,7 @@
 #pragma once
 
 #include <channel/network_channel.h>
+#include <common/intake_compression.h>
 #include <common/intake_encoder.h>
 #include <util/args_parser.h>
 #include <util/file_ops.h>
@@ -27,10 +28,24 @@ class IntakeConfig {
   static constexpr auto INTAKE_PORT_VAR = "EBPF_NET_INTAKE_PORT";
   static constexpr auto INTAKE_INTAKE_ENCODER_VAR = "EBPF_NET_INTAKE_ENCODER";
   static constexpr auto INTAKE_RECORD_OUTPUT_PATH_VAR = "EBPF_NET_RECORD_INTAKE_OUTPUT_PATH";
+  static constexpr auto INTAKE_COMPRESSION_VAR = "EBPF_NET_INTAKE_COMPRESSION";
+  static constexpr auto INTAKE_ZSTD_DICTIONARY_VAR = "EBPF_NET_INTAKE_ZSTD_DICTIONARY";
+  static constexpr auto INTAKE_SEND_BUFFER_LIMIT_VAR = "EBPF_NET_INTAKE_SEND_BUFFER_LIMIT";
+  static constexpr auto INTAKE_SPOOL_DIR_VAR = "EBPF_NET_INTAKE_SPOOL_DIR";
+  static constexpr auto INTAKE_SPOOL_SIZE_VAR = "EBPF_NET_INTAKE_SPOOL_SIZE";
+  static constexpr auto INTAKE_SPOOL_DRAIN_RATE_VAR = "EBPF_NET_INTAKE_SPOOL_DRAIN_RATE";
 
 public:
   static const IntakeConfig DEFAULT_CONFIG;
 
+  // Default maximum number of bytes waiting to be sent to the reducer.
+  static constexpr u64 DEFAULT_SEND_BUFFER_LIMIT = 64 * 1024 * 1024;
+  // Default maximum size of the spool, in bytes.
+  static constexpr u64 DEFAULT_SPOOL_SIZE = 256 * 1024 * 1024;
+  // Default rate at which spooled data is sent once the connection catches
+  // up, in bytes per second.
+  static constexpr u64 DEFAULT_SPOOL_DRAIN_RATE = 4 * 1024 * 1024;
+
   IntakeConfig() {}
 
   /**
@@ -70,6 +85,43 @@ public:
 
   virtual bool allow_compression() const { return encoder_ == IntakeEncoder::binary; }
 
+  void compression(IntakeCompression compression) { compression_ = compression; }
+  IntakeCompression compression() const { return compression_; }
+
+  void zstd_dictionary_path(std::string const &path) { zstd_dictionary_path_ = path; }
+  std::string const &zstd_dictionary_path() const { return zstd_dictionary_path_; }
+
+  /**
+   * Returns the contents of the zstd dictionary file, or an empty string if
+   * none is set.
+   *
+   * Throws std::runtime_error if the file can't be read.
+   */
+  std::string zstd_dictionary() const;
+
+  /**
+   * Maximum number of bytes waiting to be sent to the reducer, 0 for no limit.
+   *
+   * Past half of it, the connection is congested and collectors hold back
+   * data that is fine to lose; at it, they only send data that can't be
+   * lost, and the connection is reset if it stays full for too long.
+   */
+  void send_buffer_limit(u64 limit) { send_buffer_limit_ = limit; }
+  u64 send_buffer_limit() const { return send_buffer_limit_; }
+
+  /**
+   * Directory in which to spool data while the connection to the reducer is
+   * congested, or empty not to spool. See ReconnectingChannel.
+   */
+  void spool_directory(std::string const &directory) { spool_directory_ = directory; }
+  std::string const &spool_directory() const { return spool_directory_; }
+
+  void spool_size(u64 size) { spool_size_ = size; }
+  u64 spool_size() const { return spool_size_; }
+
+  void spool_drain_rate(u64 rate) { spool_drain_rate_ = rate; }
+  u64 spool_drain_rate() const { return spool_drain_rate_; }
+
   virtual std::unique_ptr<channel::NetworkChannel> make_channel(uv_loop_t &loop) const;
 
   std::unique_ptr<::ebpf_net::ingest::Encoder> make_encoder() const
@@ -104,6 +156,12 @@ private:
   std::string port_;
   std::string record_path_;
   IntakeEncoder encoder_ = IntakeEncoder::binary;
+  IntakeCompression compression_ = IntakeCompression::lz4;
+  std::string zstd_dictionary_path_;
+  u64 send_buffer_limit_ = DEFAULT_SEND_BUFFER_LIMIT;
+  std::string spool_directory_;
+  u64 spool_size_ = DEFAULT_SPOOL_SIZE;
+  u64 spool_drain_rate_ = DEFAULT_SPOOL_DRAIN_RATE;
 };
 
 struct IntakeConfig::ArgsHandler : cli::ArgsParser::Handler {
@@ -115,6 +173,12 @@ private:
   cli::ArgsParser::ArgProxy<std::string> host_;
   cli::ArgsParser::ArgProxy<std::string> port_;
   cli::ArgsParser::ArgProxy<IntakeEncoder> encoder_;
+  cli::ArgsParser::ArgProxy<IntakeCompression> compression_;
+  cli::ArgsParser::ArgProxy<std::string> zstd_dictionary_path_;
+  cli::ArgsParser::ArgProxy<u64> send_buffer_limit_;
+  cli::ArgsParser::ArgProxy<std::string> spool_directory_;
+  cli::ArgsParser::ArgProxy<u64> spool_size_;
+  cli::ArgsParser::ArgProxy<u64> spool_drain_rate_;
 };
 
 } // namespace config
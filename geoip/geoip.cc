@@ -3,7 +3,10 @@
 
 #include "geoip.h"
 
+#include <algorithm>
 #include <cstring>
+#include <iterator>
+#include <vector>
 
 namespace geoip {
 
@@ -130,4 +133,98 @@ address_entry database::lookup(char const *ip)
   return address_entry(entry);
 }
 
+bool database::foreach_network(network_callback const &fn)
+{
+  auto *const db = &*db_;
+  auto const node_count = db->metadata.node_count;
+  bool const ipv6_db = db->metadata.ip_version == 6;
+
+  // IPv6 databases hold IPv4 networks under ::/96. Find that subtree to tell it apart from its
+  // aliases, which point to the same node.
+  std::uint32_t ipv4_start_node = 0;
+  if (ipv6_db) {
+    ipv4_start_node = node_count;
+    std::uint32_t node_number = 0;
+    for (unsigned depth = 0; depth < 96 && node_number < node_count; ++depth) {
+      MMDB_search_node_s node;
+      if (::MMDB_read_node(db, node_number, &node) != MMDB_SUCCESS) {
+        return false;
+      }
+      node_number = node.left_record;
+    }
+    if (node_number < node_count) {
+      ipv4_start_node = node_number;
+    }
+  }
+
+  struct pending {
+    std::uint32_t node_number;
+    in6_addr network;
+    unsigned prefix_length;
+  };
+
+  // IPv4 databases are walked as if they were the IPv4 subtree of an IPv6 one.
+  pending root{.node_number = 0, .network = {}, .prefix_length = ipv6_db ? 0u : 96u};
+  if (!ipv6_db) {
+    root.network.s6_addr[10] = root.network.s6_addr[11] = 0xff;
+  }
+
+  std::vector<pending> stack{root};
+  while (!stack.empty()) {
+    auto const current = stack.back();
+    stack.pop_back();
+
+    MMDB_search_node_s node;
+    if (::MMDB_read_node(db, current.node_number, &node) != MMDB_SUCCESS) {
+      return false;
+    }
+
+    for (unsigned bit : {1u, 0u}) {
+      auto const record = bit ? node.right_record : node.left_record;
+      auto const record_type = bit ? node.right_record_type : node.left_record_type;
+
+      pending child{.node_number = static_cast<std::uint32_t>(record), .network = current.network, .prefix_length = current.prefix_length + 1};
+      if (bit) {
+        auto const index = current.prefix_length;
+        child.network.s6_addr[index / 8] |= 0x80 >> (index % 8);
+      }
+
+      switch (record_type) {
+      case MMDB_RECORD_TYPE_SEARCH_NODE:
+        if (ipv6_db && record == ipv4_start_node) {
+          bool const is_ipv4_subtree =
+              (child.prefix_length == 96) && std::all_of(std::begin(child.network.s6_addr),
+                                                         std::end(child.network.s6_addr),
+                                                         [](std::uint8_t byte) { return byte == 0; });
+          if (!is_ipv4_subtree) {
+            break;
+          }
+          child.network.s6_addr[10] = child.network.s6_addr[11] = 0xff;
+        }
+        stack.push_back(child);
+        break;
+
+      case MMDB_RECORD_TYPE_DATA: {
+        MMDB_lookup_result_s result{};
+        result.found_entry = true;
+        result.entry = bit ? node.right_record_entry : node.left_record_entry;
+        result.netmask = child.prefix_length;
+
+        address_entry entry(result);
+        fn(child.network, child.prefix_length, entry);
+        break;
+      }
+
+      case MMDB_RECORD_TYPE_EMPTY:
+        break;
+
+      default:
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 } // namespace geoip
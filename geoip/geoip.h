@@ -7,6 +7,7 @@
 
 #include <maxminddb.h>
 
+#include <functional>
 #include <initializer_list>
 #include <new>
 #include <optional>
@@ -407,6 +408,22 @@ struct database {
    */
   address_entry lookup(char const *ip);
 
+  /**
+   * Callback for `foreach_network`: receives the network address, its prefix length and the
+   * network's entry.
+   */
+  using network_callback = std::function<void(in6_addr const &network, unsigned prefix_length, address_entry &entry)>;
+
+  /**
+   * Calls `fn` for each network that has an entry in the database, by walking the search tree.
+   *
+   * IPv4 networks are reported as IPv4-mapped IPv6 networks (::ffff:a.b.c.d/96+n), once: the
+   * aliases of the IPv4 subtree that IPv6 databases hold (e.g. 2002::/16) are skipped.
+   *
+   * Returns `false` if the search tree is corrupt, in which case the walk stops early.
+   */
+  bool foreach_network(network_callback const &fn);
+
   /**
    * Tells whether the database was successfully loaded or not.
    */
@@ -4,12 +4,45 @@
 #include <jitbuf/transform_builder.h>
 
 #include <jitbuf/descriptor_reader.h>
+#include <jitbuf/transform_cache.h>
+#include <cstring>
 #include <sstream>
 #include <vector>
 
 namespace jitbuf {
 
-TransformBuilder::TransformBuilder(llvm::LLVMContext &context) : xformer_(context) {}
+namespace {
+
+/**
+ * Returns whether @from and @to describe the exact same fixed-size layout
+ */
+bool is_identity_layout(const Descriptor &from, const Descriptor &to)
+{
+  if ((from.n_var_fields > 0) || (to.n_var_fields > 0))
+    return false;
+
+  if ((from.size != to.size) || (from.fields.size() != to.fields.size()))
+    return false;
+
+  for (std::size_t i = 0; i < from.fields.size(); i++) {
+    auto &from_field = from.fields[i];
+    auto &to_field = to.fields[i];
+    if ((from_field.field_id != to_field.field_id) || (from_field.ftype != to_field.ftype) ||
+        (from_field.n_elems != to_field.n_elems) || (from_field.pos != to_field.pos))
+      return false;
+  }
+
+  return true;
+}
+
+} /* namespace */
+
+TransformBuilder::TransformBuilder(llvm::LLVMContext &context) : context_(context), xformer_(context) {}
+
+void TransformBuilder::share_transforms(TransformCache &cache)
+{
+  shared_cache_ = &cache;
+}
 
 void TransformBuilder::add_descriptor(std::shared_ptr<Descriptor> descriptor)
 {
@@ -48,6 +81,22 @@ std::shared_ptr<TransformRecord> TransformBuilder::get_xform(const std::string &
     cache_.erase(iter);
   }
 
+  /* then try the shared cache, if any: the rpc_id follows the flags in the header */
+  std::shared_ptr<Descriptor> shared_to;
+  if ((shared_cache_ != nullptr) && (from.size() >= 2 * sizeof(u16))) {
+    u16 rpc_id;
+    memcpy(&rpc_id, from.data() + sizeof(u16), sizeof(rpc_id));
+    if (auto to_iter = descriptors_.find(rpc_id); to_iter != descriptors_.end())
+      shared_to = to_iter->second;
+  }
+
+  if (shared_to) {
+    if (auto sptr = shared_cache_->find(context_, from, shared_to)) {
+      cache_.insert({from, sptr});
+      return sptr;
+    }
+  }
+
   /* De-serialize the descriptor */
   Descriptor jb_desc(DescriptorReader::read((u8 *)from.data(), from.size()));
 
@@ -61,7 +110,9 @@ std::shared_ptr<TransformRecord> TransformBuilder::get_xform(const std::string &
   /* make a MessageHandler */
   std::shared_ptr<TransformRecord> buf(get_xform_to(jb_desc, *to_ptr));
 
-  /* put in the cache */
+  /* put in the caches */
+  if (shared_to && (shared_to == to_ptr))
+    buf = shared_cache_->insert(context_, from, shared_to, buf);
   cache_.insert({from, buf});
 
   return buf;
@@ -192,6 +243,7 @@ std::shared_ptr<TransformRecord> TransformBuilder::get_xform_to(const Descriptor
   buf->xform = xformer_.get_xform(src_pos.data(), dst_pos.data(), sizes.data(), sizes.size(), len_pos, src_size, blobs);
   buf->size = src_size;
   buf->min_buffer_size = min_size;
+  buf->identity = is_identity_layout(from, to);
 
   return buf;
 }
@@ -19,15 +19,20 @@ class LLVMContext;
 
 namespace jitbuf {
 
+class TransformCache;
+
 /**
  * Handling incoming buffers including their mapping into known structs
  * @param min_buffer_size: the minimum required buffer size to be able to decode
+ * @param identity: whether the incoming layout matches the local layout, so
+ *   messages can be handled in place without applying the transform
  */
 struct TransformRecord {
   uint32_t msg_rpc_id;
   Transform xform;
   uint32_t size;
   uint32_t min_buffer_size;
+  bool identity;
 };
 
 /**
@@ -43,11 +48,24 @@ struct TransformRecord {
  *
  *  The included Transformer (xformer_) handles the LLVM-related parts of
  *    creating the functions.
+ *
+ *  Transforms are looked up in the builder's own cache first, then in the
+ *    TransformCache shared with share_transforms(), if any, and only compiled
+ *    when neither has them.
  */
 class TransformBuilder {
 public:
   TransformBuilder(llvm::LLVMContext &context);
 
+  /**
+   * Shares this builder's transforms with other builders through @cache.
+   *
+   * @important: only for builders whose LLVMContext outlives every connection,
+   *   e.g. one builder shared by all connections: other builders with the same
+   *   context run the code it compiles.
+   */
+  void share_transforms(TransformCache &cache);
+
   /**
    * Adds a message descriptor.
    */
@@ -72,7 +90,9 @@ public:
   std::shared_ptr<TransformRecord> get_xform_to(const Descriptor &from, const Descriptor &to);
 
 private:
+  llvm::LLVMContext &context_;
   Transformer xformer_;
+  TransformCache *shared_cache_ = nullptr;
 
   std::unordered_map<uint32_t, std::shared_ptr<Descriptor>> descriptors_;
   std::unordered_map<std::string, std::weak_ptr<TransformRecord>> cache_;
@@ -0,0 +1,118 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <jitbuf/transform_cache.h>
+
+namespace jitbuf {
+
+namespace {
+
+/* FNV-1a */
+constexpr u64 fnv_offset_basis = 0xcbf29ce484222325ull;
+constexpr u64 fnv_prime = 0x100000001b3ull;
+
+inline u64 fnv_mix(u64 hash, u64 value)
+{
+  for (int i = 0; i < 8; i++) {
+    hash ^= (value >> (i * 8)) & 0xff;
+    hash *= fnv_prime;
+  }
+  return hash;
+}
+
+} /* namespace */
+
+TransformCache &TransformCache::global()
+{
+  static TransformCache instance;
+  return instance;
+}
+
+TransformCache::Key::Key(const llvm::LLVMContext &context, const std::string &from, std::shared_ptr<const Descriptor> to)
+    : context(&context), from(from), to(std::move(to)), to_fingerprint(fingerprint(*this->to))
+{}
+
+std::shared_ptr<TransformRecord>
+TransformCache::find(const llvm::LLVMContext &context, const std::string &from, std::shared_ptr<const Descriptor> to)
+{
+  Key key(context, from, std::move(to));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto iter = cache_.find(key);
+  if (iter == cache_.end())
+    return nullptr;
+
+  auto sptr = iter->second.lock();
+  if (!sptr) {
+    /* transform has been freed */
+    cache_.erase(iter);
+  }
+
+  return sptr;
+}
+
+std::shared_ptr<TransformRecord> TransformCache::insert(
+    const llvm::LLVMContext &context,
+    const std::string &from,
+    std::shared_ptr<const Descriptor> to,
+    std::shared_ptr<TransformRecord> record)
+{
+  Key key(context, from, std::move(to));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto res = cache_.try_emplace(std::move(key), record);
+  if (!res.second) {
+    /* another builder got here first -- prefer its transform if still alive */
+    if (auto existing = res.first->second.lock())
+      return existing;
+
+    res.first->second = record;
+  }
+
+  return record;
+}
+
+std::size_t TransformCache::size()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cache_.size();
+}
+
+u64 TransformCache::fingerprint(const Descriptor &descriptor)
+{
+  u64 hash = fnv_offset_basis;
+
+  hash = fnv_mix(hash, descriptor.rpc_id);
+  hash = fnv_mix(hash, descriptor.size);
+  hash = fnv_mix(hash, descriptor.n_var_fields);
+
+  for (auto &field : descriptor.fields) {
+    hash = fnv_mix(hash, field.field_id);
+    hash = fnv_mix(hash, static_cast<u64>(field.ftype));
+    hash = fnv_mix(hash, field.n_elems);
+    hash = fnv_mix(hash, field.pos);
+  }
+
+  return hash;
+}
+
+bool TransformCache::same_layout(const Descriptor &a, const Descriptor &b)
+{
+  if ((a.rpc_id != b.rpc_id) || (a.dynamic_size != b.dynamic_size) || (a.size != b.size) ||
+      (a.n_var_fields != b.n_var_fields) || (a.fields.size() != b.fields.size()))
+    return false;
+
+  for (std::size_t i = 0; i < a.fields.size(); i++) {
+    auto &a_field = a.fields[i];
+    auto &b_field = b.fields[i];
+    if ((a_field.field_id != b_field.field_id) || (a_field.ftype != b_field.ftype) || (a_field.n_elems != b_field.n_elems) ||
+        (a_field.pos != b_field.pos))
+      return false;
+  }
+
+  return true;
+}
+
+} /* namespace jitbuf */
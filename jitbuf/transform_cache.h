@@ -0,0 +1,104 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <jitbuf/descriptor.h>
+#include <jitbuf/transform_builder.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace jitbuf {
+
+/**
+ * A thread-safe cache of transforms, shared by the TransformBuilders that opt
+ *   in with TransformBuilder::share_transforms().
+ *
+ * Transforms are keyed by the LLVMContext they were compiled in, the
+ *   serialized remote descriptor and the local descriptor, so builders for the
+ *   same app on different threads reuse each other's transforms instead of
+ *   re-parsing descriptors and re-compiling for every connection. Builders
+ *   with different contexts never share transforms.
+ *
+ * The cache only holds weak pointers: a transform lives as long as some
+ *   connection uses it.
+ *
+ * @important: a cached transform's code is owned by the LLVMContext it was
+ *   compiled in, so only builders whose context outlives every connection
+ *   may opt in.
+ */
+class TransformCache {
+public:
+  /**
+   * Returns the process-wide instance.
+   */
+  static TransformCache &global();
+
+  /**
+   * Returns the cached transform from @from to @to compiled in @context, or
+   *   nullptr if none is alive.
+   */
+  std::shared_ptr<TransformRecord>
+  find(const llvm::LLVMContext &context, const std::string &from, std::shared_ptr<const Descriptor> to);
+
+  /**
+   * Caches @record, unless a live transform was inserted concurrently for the
+   *   same key.
+   *
+   * @returns the cached transform, which callers should use instead of @record.
+   */
+  std::shared_ptr<TransformRecord> insert(
+      const llvm::LLVMContext &context,
+      const std::string &from,
+      std::shared_ptr<const Descriptor> to,
+      std::shared_ptr<TransformRecord> record);
+
+  /**
+   * Returns the number of keys in the cache, including expired ones.
+   */
+  std::size_t size();
+
+  /**
+   * Returns a fingerprint of the descriptor's layout, used to hash keys.
+   */
+  static u64 fingerprint(const Descriptor &descriptor);
+
+  /**
+   * Returns whether @a and @b describe the same layout.
+   */
+  static bool same_layout(const Descriptor &a, const Descriptor &b);
+
+private:
+  struct Key {
+    Key(const llvm::LLVMContext &context, const std::string &from, std::shared_ptr<const Descriptor> to);
+
+    const llvm::LLVMContext *context;
+    std::string from;
+    /* fingerprints only speed up comparisons, the full descriptors decide */
+    std::shared_ptr<const Descriptor> to;
+    u64 to_fingerprint;
+
+    bool operator==(const Key &other) const
+    {
+      return (context == other.context) && (to_fingerprint == other.to_fingerprint) && (from == other.from) &&
+             same_layout(*to, *other.to);
+    }
+  };
+
+  struct KeyHasher {
+    std::size_t operator()(const Key &key) const
+    {
+      return std::hash<std::string>{}(key.from) ^ key.to_fingerprint ^ std::hash<const void *>{}(key.context);
+    }
+  };
+
+  std::mutex mutex_;
+  std::unordered_map<Key, std::weak_ptr<TransformRecord>, KeyHasher> cache_;
+};
+
+} /* namespace jitbuf */
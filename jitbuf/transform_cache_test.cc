@@ -0,0 +1,133 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <jitbuf/descriptor_reader.h>
+#include <jitbuf/transform_builder.h>
+#include <jitbuf/transform_cache.h>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include <gtest/gtest.h>
+
+#include <initializer_list>
+#include <memory>
+#include <string>
+
+namespace jitbuf {
+namespace {
+
+constexpr u16 RPC_ID = 301;
+
+// Field encodings: type in bits 12-14, id in the low bits.
+constexpr u16 INT32_FIELD_1 = (2 << 12) | 1;
+constexpr u16 INT64_FIELD_2 = (3 << 12) | 2;
+
+// Serializes a descriptor without arrays, as sent by collectors.
+std::string serialize(u16 rpc_id, std::initializer_list<u16> fields)
+{
+  std::basic_string<u16> words{0 /* flags */, rpc_id, static_cast<u16>(fields.size()), 0 /* n_arrays */};
+  words.append(fields);
+  return std::string(reinterpret_cast<const char *>(words.data()), words.size() * sizeof(u16));
+}
+
+std::shared_ptr<const Descriptor> local_descriptor(std::initializer_list<u16> fields)
+{
+  std::string const serialized = serialize(RPC_ID, fields);
+  auto descriptor = std::make_shared<Descriptor>(DescriptorReader::read((u8 *)serialized.data(), serialized.size()));
+  DescriptorReader::compute_positions(*descriptor, false);
+  return descriptor;
+}
+
+class TransformCacheTest : public ::testing::Test {
+protected:
+  static void SetUpTestSuite()
+  {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+  }
+
+  // A connection's builder, sharing transforms through the test's cache.
+  std::unique_ptr<TransformBuilder> make_builder()
+  {
+    auto builder = std::make_unique<TransformBuilder>(context_);
+    builder->add_descriptor(serialize(RPC_ID, {INT32_FIELD_1, INT64_FIELD_2}));
+    builder->share_transforms(cache_);
+    return builder;
+  }
+
+  llvm::LLVMContext context_;
+  TransformCache cache_;
+};
+
+} // namespace
+
+TEST_F(TransformCacheTest, MatchesIdenticalDescriptors)
+{
+  std::string const from = serialize(RPC_ID, {INT32_FIELD_1, INT64_FIELD_2});
+  auto const record = std::make_shared<TransformRecord>();
+  EXPECT_EQ(record, cache_.insert(context_, from, local_descriptor({INT32_FIELD_1, INT64_FIELD_2}), record));
+
+  // another connection's copy of the same local descriptor finds it
+  EXPECT_EQ(record, cache_.find(context_, from, local_descriptor({INT32_FIELD_1, INT64_FIELD_2})));
+
+  // but not with another local layout, remote descriptor, or LLVMContext
+  EXPECT_EQ(nullptr, cache_.find(context_, from, local_descriptor({INT64_FIELD_2, INT32_FIELD_1})));
+  auto const to = local_descriptor({INT32_FIELD_1, INT64_FIELD_2});
+  EXPECT_EQ(nullptr, cache_.find(context_, serialize(RPC_ID, {INT32_FIELD_1}), to));
+  llvm::LLVMContext other_context;
+  EXPECT_EQ(nullptr, cache_.find(other_context, from, to));
+}
+
+TEST_F(TransformCacheTest, KeepsFirstLiveInsert)
+{
+  std::string const from = serialize(RPC_ID, {INT32_FIELD_1, INT64_FIELD_2});
+  auto const to = local_descriptor({INT32_FIELD_1, INT64_FIELD_2});
+
+  auto const first = std::make_shared<TransformRecord>();
+  auto const second = std::make_shared<TransformRecord>();
+  EXPECT_EQ(first, cache_.insert(context_, from, to, first));
+  EXPECT_EQ(first, cache_.insert(context_, from, to, second));
+  EXPECT_EQ(1u, cache_.size());
+}
+
+TEST_F(TransformCacheTest, SharesTransformsBetweenConnections)
+{
+  auto first = make_builder();
+  auto second = make_builder();
+
+  std::string const from = serialize(RPC_ID, {INT64_FIELD_2, INT32_FIELD_1});
+  auto const compiled = first->get_xform(from);
+  ASSERT_NE(nullptr, compiled);
+  EXPECT_FALSE(compiled->xform.empty());
+
+  // the second connection gets the first one's transform instead of compiling
+  EXPECT_EQ(compiled, second->get_xform(from));
+  EXPECT_EQ(1u, cache_.size());
+}
+
+TEST_F(TransformCacheTest, ExpiresOnceNoConnectionUsesIt)
+{
+  std::string const from = serialize(RPC_ID, {INT64_FIELD_2, INT32_FIELD_1});
+  auto const to = local_descriptor({INT32_FIELD_1, INT64_FIELD_2});
+
+  // connections hold on to the transforms their handlers use
+  auto first_record = make_builder()->get_xform(from);
+  auto second_record = make_builder()->get_xform(from);
+  ASSERT_EQ(first_record, second_record);
+
+  first_record.reset();
+  EXPECT_EQ(second_record, cache_.find(context_, from, to));
+  second_record.reset();
+
+  // the last connection using it is gone, and the expired key is dropped
+  EXPECT_EQ(nullptr, cache_.find(context_, from, to));
+  EXPECT_EQ(0u, cache_.size());
+
+  // the next connection compiles it again
+  auto third = make_builder();
+  EXPECT_NE(nullptr, third->get_xform(from));
+  EXPECT_EQ(1u, cache_.size());
+}
+
+} // namespace jitbuf
@@ -0,0 +1,60 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <reducer/admission_controller.h>
+
+#include <algorithm>
+
+namespace reducer {
+
+namespace {
+
+// An admission costs this many tokens; `per_second` tokens are added per ns.
+constexpr u64 admission_tokens = 1'000'000'000;
+
+} // namespace
+
+AdmissionController::AdmissionController(u32 per_second) : per_second_(per_second), tokens_(per_second * admission_tokens) {}
+
+std::size_t AdmissionController::admit(std::size_t pending, std::chrono::nanoseconds now)
+{
+  if (!per_second_) {
+    return pending;
+  }
+
+  refill(now);
+
+  std::size_t const admitted = std::min<u64>(pending, tokens_ / admission_tokens);
+  tokens_ -= admitted * admission_tokens;
+  return admitted;
+}
+
+std::chrono::nanoseconds AdmissionController::next_admission_delay(std::chrono::nanoseconds now) const
+{
+  if (!per_second_ || tokens_ >= admission_tokens) {
+    return std::chrono::nanoseconds::zero();
+  }
+
+  u64 const elapsed = now > refilled_at_ ? (now - refilled_at_).count() : 0;
+  u64 const tokens = tokens_ + elapsed * per_second_;
+  if (tokens >= admission_tokens) {
+    return std::chrono::nanoseconds::zero();
+  }
+
+  // round up, so that the tokens are there once the delay is over
+  return std::chrono::nanoseconds((admission_tokens - tokens + per_second_ - 1) / per_second_);
+}
+
+void AdmissionController::refill(std::chrono::nanoseconds now)
+{
+  if (now <= refilled_at_) {
+    return;
+  }
+
+  u64 const capacity = per_second_ * admission_tokens;
+  u64 const elapsed = std::min<u64>((now - refilled_at_).count(), 1'000'000'000);
+  tokens_ = std::min(capacity, tokens_ + elapsed * per_second_);
+  refilled_at_ = now;
+}
+
+} // namespace reducer
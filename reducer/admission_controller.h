@@ -0,0 +1,45 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <platform/types.h>
+
+#include <chrono>
+#include <cstddef>
+
+namespace reducer {
+
+// Paces how fast a worker starts handling new connections, so that a
+// reconnect storm (e.g. every collector reconnecting after a reducer
+// restart) is spread over time instead of having all handshakes and initial
+// state dumps compete at once.
+//
+// Admissions are allowed at a steady rate, with bursts of up to a second's
+// worth. A rate of 0 admits everything right away.
+// This class is not thread-safe.
+class AdmissionController {
+public:
+  explicit AdmissionController(u32 per_second);
+
+  // Returns how many of `pending` connections can be admitted at `now`, and
+  // counts them as admitted.
+  std::size_t admit(std::size_t pending, std::chrono::nanoseconds now);
+
+  // Returns how long after `now` the next connection can be admitted.
+  std::chrono::nanoseconds next_admission_delay(std::chrono::nanoseconds now) const;
+
+  u32 per_second() const { return per_second_; }
+
+private:
+  void refill(std::chrono::nanoseconds now);
+
+  u32 const per_second_;
+  // In billionths of an admission, so that refills don't round down.
+  u64 tokens_;
+  std::chrono::nanoseconds refilled_at_{0};
+};
+
+} // namespace reducer
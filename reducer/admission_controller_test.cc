@@ -0,0 +1,55 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <reducer/admission_controller.h>
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+namespace reducer {
+
+TEST(AdmissionControllerTest, AdmitsEverythingWithoutRate)
+{
+  AdmissionController admission(0);
+
+  EXPECT_EQ(5000u, admission.admit(5000, 1s));
+  EXPECT_EQ(5000u, admission.admit(5000, 1s));
+  EXPECT_EQ(0ns, admission.next_admission_delay(1s));
+}
+
+TEST(AdmissionControllerTest, AdmitsABurstThenPaces)
+{
+  AdmissionController admission(100);
+
+  // a second's worth right away
+  EXPECT_EQ(100u, admission.admit(5000, 10s));
+  EXPECT_EQ(0u, admission.admit(4900, 10s));
+  EXPECT_EQ(10ms, admission.next_admission_delay(10s));
+  EXPECT_EQ(4ms, admission.next_admission_delay(10s + 6ms));
+
+  // then the rate
+  EXPECT_EQ(0u, admission.admit(4900, 10s + 9ms));
+  EXPECT_EQ(1u, admission.admit(4900, 10s + 10ms));
+  EXPECT_EQ(50u, admission.admit(4899, 10s + 510ms));
+}
+
+TEST(AdmissionControllerTest, IdleTimeDoesNotAddUpPastABurst)
+{
+  AdmissionController admission(100);
+
+  EXPECT_EQ(100u, admission.admit(100, 10s));
+  EXPECT_EQ(100u, admission.admit(5000, 1h));
+  EXPECT_EQ(0u, admission.admit(4900, 1h));
+}
+
+TEST(AdmissionControllerTest, IgnoresTimeGoingBack)
+{
+  AdmissionController admission(10);
+
+  EXPECT_EQ(10u, admission.admit(20, 10s));
+  EXPECT_EQ(0u, admission.admit(10, 5s));
+  EXPECT_EQ(5u, admission.admit(10, 10s + 500ms));
+}
+
+} // namespace reducer
@@ -22,10 +22,61 @@
 #include <util/log_formatters.h>
 #include <util/time.h>
 
+#include <optional>
 #include <stdexcept>
 
 namespace reducer::aggregation {
 
+namespace {
+
+// Returns the timestamp, aligned to the slot boundary, of the timeslot of
+// |store| that is ready for output at |t|, or nullopt if none is.
+template <typename Store> std::optional<u64> ready_timeslot_timestamp(Store &store, u64 t)
+{
+  s16 relative_timeslot = store.relative_timeslot(t);
+
+  if (relative_timeslot <= 0) {
+    // Not ready.
+    return std::nullopt;
+  }
+
+  double slot_duration = store.slot_duration();
+  // timestamp, in nanoseconds, within the metric slot
+  u64 metric_timestamp = t - (u64)(relative_timeslot * slot_duration);
+  // fraction of the slot remaining after the timestamp
+  double frac = 1.0 - fmod(metric_timestamp / slot_duration, 1);
+  // align to slot boundary
+  metric_timestamp += (u64)(frac * slot_duration);
+
+  return metric_timestamp;
+}
+
+} // namespace
+
+// Writes the node_node, az_node and az_az metrics of one protocol; SUFFIX is
+// empty for the base stores, or `_<count>` for the stores of a rollup.
+#define WRITE_NODE_METRICS(A_B, B_A, SUFFIX, AZ_AZ_WRITER)                                                                     \
+  index_.node_node.A_B##SUFFIX##_foreach(t, encoder);                                                                          \
+  encoder.set_reverse(1);                                                                                                      \
+  index_.node_node.B_A##SUFFIX##_foreach(t, encoder);                                                                          \
+  encoder.set_reverse(0);                                                                                                      \
+                                                                                                                               \
+  index_.az_node.A_B##SUFFIX##_foreach(t, encoder);                                                                            \
+  encoder.set_reverse(1);                                                                                                      \
+  index_.az_node.B_A##SUFFIX##_foreach(t, encoder);                                                                            \
+  encoder.set_reverse(0);                                                                                                      \
+                                                                                                                               \
+  index_.az_az.A_B##SUFFIX##_foreach(t, AZ_AZ_WRITER);
+
+#define WRITE_ALL_NODE_METRICS(SUFFIX)                                                                                         \
+  WRITE_NODE_METRICS(tcp_a_to_b, tcp_b_to_a, SUFFIX, encoder)                                                                  \
+  WRITE_NODE_METRICS(udp_a_to_b, udp_b_to_a, SUFFIX, encoder)                                                                  \
+  WRITE_NODE_METRICS(http_a_to_b, http_b_to_a, SUFFIX, encoder)                                                                \
+  WRITE_NODE_METRICS(dns_a_to_b, dns_b_to_a, SUFFIX, encoder)                                                                  \
+  WRITE_NODE_METRICS(tcp_latency_a_to_b, tcp_latency_b_to_a, SUFFIX, encoder)                                                  \
+  WRITE_NODE_METRICS(http_latency_a_to_b, http_latency_b_to_a, SUFFIX, encoder)                                                \
+  WRITE_NODE_METRICS(dns_latency_a_to_b, dns_latency_b_to_a, SUFFIX, encoder)
+
 bool AggCore::node_ip_field_disabled_ = false;
 
 void AggCore::set_node_ip_field_disabled(bool disabled)
@@ -36,6 +87,9 @@ void AggCore::set_node_ip_field_disabled(bool disabled)
 bool AggCore::id_id_enabled_ = false;
 bool AggCore::az_id_enabled_ = false;
 bool AggCore::flow_logs_enabled_ = false;
+u32 AggCore::max_id_id_series_ = 0;
+u32 AggCore::max_az_id_series_ = 0;
+enum_traits<Rollup>::array_map<bool> AggCore::rollups_enabled_ = {};
 
 void AggCore::set_id_id_enabled(bool enabled)
 {
@@ -52,6 +106,28 @@ void AggCore::set_flow_logs_enabled(bool enabled)
   flow_logs_enabled_ = enabled;
 }
 
+void AggCore::set_max_id_id_series(u32 max_series)
+{
+  max_id_id_series_ = max_series;
+}
+
+void AggCore::set_max_az_id_series(u32 max_series)
+{
+  max_az_id_series_ = max_series;
+}
+
+void AggCore::set_rollup_enabled(Rollup rollup, bool enabled)
+{
+  rollups_enabled_[enum_index_of(rollup)] = enabled;
+}
+
+bool AggCore::latency_histograms_enabled(bool otlp_output, DisabledMetrics const &disabled_metrics)
+{
+  return otlp_output && (!disabled_metrics.is_metric_disabled(TcpMetrics::rtt) ||
+                         !disabled_metrics.is_metric_disabled(DnsMetrics::client_duration) ||
+                         !disabled_metrics.is_metric_disabled(HttpMetrics::client_duration));
+}
+
 AggCore::AggCore(
     RpcQueueMatrix &matching_to_aggregation_queues,
     RpcQueueMatrix &aggregation_to_logging_queues,
@@ -59,6 +135,7 @@ AggCore::AggCore(
     std::vector<Publisher::WriterPtr> metric_writers,
     std::unique_ptr<Publisher> &otlp_metrics_publisher,
     Publisher::WriterPtr otlp_metric_writer,
+    std::vector<Publisher::WriterPtr> rollup_metric_writers,
     bool enable_percentile_latencies,
     TsdbFormat metrics_tsdb_format,
     DisabledMetrics disabled_metrics,
@@ -70,14 +147,17 @@ AggCore::AggCore(
           initial_timestamp,
           aggregation_to_logging_queues.make_writers<ebpf_net::logging::Writer>(
               shard_num, std::bind(&Core::current_timestamp, this))),
+      matching_string_dictionaries(matching_to_aggregation_queues.num_senders()),
       metrics_publisher_(metrics_publisher),
       metric_writers_(std::move(metric_writers)),
       otlp_metrics_publisher_(otlp_metrics_publisher),
       otlp_metric_writer_(std::move(otlp_metric_writer)),
+      rollup_metric_writers_(std::move(rollup_metric_writers)),
       metrics_tsdb_format_(metrics_tsdb_format),
       matching_to_aggregation_stats_(shard_num, "matching", "aggregation"),
       aggregation_to_logging_stats_(shard_num, "aggregation", "logging", aggregation_to_logging_queues),
       disabled_metrics_(disabled_metrics),
+      cardinality_guards_(max_id_id_series_, max_az_id_series_),
       core_stats_(index_.core_stats.alloc()),
       agg_core_stats_(index_.agg_core_stats.alloc())
 {
@@ -85,6 +165,54 @@ AggCore::AggCore(
 
   if (enable_percentile_latencies)
     p_latencies_ = std::make_unique<PercentileLatencies>();
+
+  latency_sketches_enabled_ = latency_histograms_enabled(otlp_metric_writer_ != nullptr, disabled_metrics_);
+
+  // rollup stores are only updated for the aggregations that are written
+  for (auto rollup : enum_traits<Rollup>::values) {
+    if (rollup_enabled(rollup)) {
+      rollup_cardinality_guards_[enum_index_of(rollup)] =
+          std::make_unique<CardinalityGuards>(max_id_id_series_, max_az_id_series_);
+    }
+  }
+
+  // a span's location is reused once it is freed: make sure the next span
+  // there doesn't inherit the weight of the freed one's series
+  index_.node_node.on_free = [this](u32 loc) {
+    cardinality_guards_.forget_node_node(loc);
+    for (auto &guards : rollup_cardinality_guards_) {
+      if (guards) {
+        guards->forget_node_node(loc);
+      }
+    }
+  };
+  index_.az_node.on_free = [this](u32 loc) {
+    cardinality_guards_.forget_az_node(loc);
+    for (auto &guards : rollup_cardinality_guards_) {
+      if (guards) {
+        guards->forget_az_node(loc);
+      }
+    }
+  };
+
+#define ENABLE_ROLLUP_STORES(ROLLUP, COUNT)                                                                                    \
+  index_.node_node.rollup_##COUNT##_enabled = rollup_enabled(ROLLUP) && id_id_enabled_;                                       \
+  index_.az_node.rollup_##COUNT##_enabled = rollup_enabled(ROLLUP) && az_id_enabled_;                                         \
+  index_.az_az.rollup_##COUNT##_enabled = rollup_enabled(ROLLUP);
+
+  ENABLE_ROLLUP_STORES(Rollup::five_minutes, 10);
+  ENABLE_ROLLUP_STORES(Rollup::one_hour, 120);
+#undef ENABLE_ROLLUP_STORES
+}
+
+void AggCore::on_start()
+{
+  restore_index_snapshot();
+}
+
+void AggCore::on_stop()
+{
+  write_index_snapshot();
 }
 
 void AggCore::on_timeslot_complete()
@@ -94,16 +222,35 @@ void AggCore::on_timeslot_complete()
   index_.send_pulse();
 }
 
+void AggCore::resync_rpc_client(size_t client_index)
+{
+  CoreBase::resync_rpc_client(client_index);
+
+  // only forwarded queues start over, and with those there's a client for
+  // each matching shard, in order
+  matching_string_dictionaries.reset(client_index);
+}
+
 void AggCore::write_metrics()
 {
   u64 t = current_timestamp();
 
   write_standard_metrics(t);
 
+  for (auto rollup : enum_traits<Rollup>::values) {
+    if (rollup_enabled(rollup)) {
+      write_rollup_metrics(rollup, t);
+    }
+  }
+
   for (auto &metric_writer : metric_writers_) {
     metric_writer->flush();
   }
 
+  for (auto &metric_writer : rollup_metric_writers_) {
+    metric_writer->flush();
+  }
+
   if (otlp_metric_writer_) {
     otlp_metric_writer_->flush();
   }
@@ -111,31 +258,22 @@ void AggCore::write_metrics()
 
 void AggCore::write_standard_metrics(u64 t)
 {
-  s16 relative_timeslot = index_.agg_root.tcp_a_to_b.relative_timeslot(t);
-
-  if (relative_timeslot <= 0) {
-    // Not ready.
+  auto metric_timestamp = ready_timeslot_timestamp(index_.agg_root.tcp_a_to_b, t);
+  if (!metric_timestamp) {
     return;
   }
 
   SCOPED_TIMING(AggCoreWriteStandardMetrics);
 
-  double slot_duration = index_.agg_root.tcp_a_to_b.slot_duration();
-  // timestamp, in nanoseconds, within the metric slot
-  u64 metric_timestamp = t - (u64)(relative_timeslot * slot_duration);
-  // fraction of the slot remaining after the timestamp
-  double frac = 1.0 - fmod(metric_timestamp / slot_duration, 1);
-  // align to slot boundary
-  metric_timestamp += (u64)(frac * slot_duration);
-
   TsdbEncoder encoder(
       metric_writers_,
       metrics_tsdb_format_,
       otlp_metric_writer_,
-      std::chrono::nanoseconds(metric_timestamp),
+      std::chrono::nanoseconds(*metric_timestamp),
       id_id_enabled_,
       az_id_enabled_,
       flow_logs_enabled_,
+      cardinality_guards_,
       disabled_metrics_);
 
   auto az_az_writer = [&encoder, this](auto &&...args) {
@@ -151,22 +289,15 @@ void AggCore::write_standard_metrics(u64 t)
   index_.agg_root.B_A##_foreach(t, encoder);                                                                                   \
   encoder.set_reverse(0);                                                                                                      \
                                                                                                                                \
-  index_.node_node.A_B##_foreach(t, encoder);                                                                                  \
-  encoder.set_reverse(1);                                                                                                      \
-  index_.node_node.B_A##_foreach(t, encoder);                                                                                  \
-  encoder.set_reverse(0);                                                                                                      \
-                                                                                                                               \
-  index_.az_node.A_B##_foreach(t, encoder);                                                                                    \
-  encoder.set_reverse(1);                                                                                                      \
-  index_.az_node.B_A##_foreach(t, encoder);                                                                                    \
-  encoder.set_reverse(0);                                                                                                      \
-                                                                                                                               \
-  index_.az_az.A_B##_foreach(t, az_az_writer);
+  WRITE_NODE_METRICS(A_B, B_A, , az_az_writer)
 
   WRITE_METRICS(tcp_a_to_b, tcp_b_to_a);
   WRITE_METRICS(udp_a_to_b, udp_b_to_a);
   WRITE_METRICS(http_a_to_b, http_b_to_a);
   WRITE_METRICS(dns_a_to_b, dns_b_to_a);
+  WRITE_METRICS(tcp_latency_a_to_b, tcp_latency_b_to_a);
+  WRITE_METRICS(http_latency_a_to_b, http_latency_b_to_a);
+  WRITE_METRICS(dns_latency_a_to_b, dns_latency_b_to_a);
 #undef WRITE_METRICS
 
   // write pXX latencies
@@ -175,8 +306,60 @@ void AggCore::write_standard_metrics(u64 t)
   }
 
   encoder.flush();
+
+  cardinality_guards_.end_timeslot();
 }
 
+void AggCore::write_rollup_metrics(Rollup rollup, u64 t)
+{
+  // The rollup stores are filled as the base stores are written, so
+  // writing them doesn't walk the base stores again.
+  std::optional<u64> metric_timestamp;
+  switch (rollup) {
+  case Rollup::five_minutes:
+    metric_timestamp = ready_timeslot_timestamp(index_.az_az.tcp_a_to_b_10, t);
+    break;
+  case Rollup::one_hour:
+    metric_timestamp = ready_timeslot_timestamp(index_.az_az.tcp_a_to_b_120, t);
+    break;
+  }
+  if (!metric_timestamp) {
+    return;
+  }
+
+  SCOPED_TIMING(AggCoreWriteRollupMetrics);
+
+  auto &cardinality_guards = *rollup_cardinality_guards_[enum_index_of(rollup)];
+
+  TsdbEncoder encoder(
+      rollup_metric_writers_,
+      metrics_tsdb_format_,
+      otlp_metric_writer_,
+      std::chrono::nanoseconds(*metric_timestamp),
+      id_id_enabled_,
+      az_id_enabled_,
+      /* flow_logs_enabled */ false,
+      cardinality_guards,
+      disabled_metrics_,
+      rollup);
+
+  switch (rollup) {
+  case Rollup::five_minutes:
+    WRITE_ALL_NODE_METRICS(_10);
+    break;
+  case Rollup::one_hour:
+    WRITE_ALL_NODE_METRICS(_120);
+    break;
+  }
+
+  encoder.flush();
+
+  cardinality_guards.end_timeslot();
+}
+
+#undef WRITE_ALL_NODE_METRICS
+#undef WRITE_NODE_METRICS
+
 void AggCore::write_internal_stats()
 {
   SCOPED_TIMING(AggCoreWriteInternalStats);
@@ -201,6 +384,11 @@ void AggCore::write_internal_stats()
   agg_core_stats_.agg_prometheus_bytes_stats(
       jb_blob(module), shard, prometheus_bytes_written, prometheus_bytes_discarded, time_ns);
 
+  cardinality_guards_.foreach_enabled([&](NodeAggregation aggregation, CardinalityGuard const &guard) {
+    agg_core_stats_.agg_cardinality_stats(
+        jb_blob(module), shard, jb_blob(to_string(aggregation)), guard.series(), guard.folded(), guard.evicted(), time_ns);
+  });
+
   matching_to_aggregation_stats_.write_internal_metrics_to_logging_core(core_stats_, time_ns);
   aggregation_to_logging_stats_.write_internal_metrics_to_logging_core(core_stats_, time_ns);
 
@@ -7,17 +7,21 @@
 
 #include <reducer/core_base.h>
 
+#include <reducer/aggregation/cardinality_guard.h>
 #include <reducer/aggregation/percentile_latencies.h>
+#include <reducer/aggregation/rollup.h>
 #include <reducer/aggregation/stat_counters.h>
 
 #include <reducer/disabled_metrics.h>
 #include <reducer/publisher.h>
 #include <reducer/rpc_stats.h>
+#include <reducer/string_dictionaries.h>
 #include <reducer/tsdb_format.h>
 
 #include <generated/ebpf_net/aggregation/connection.h>
 #include <generated/ebpf_net/aggregation/index.h>
 #include <generated/ebpf_net/aggregation/protocol.h>
+#include <generated/ebpf_net/aggregation/snapshot.h>
 #include <generated/ebpf_net/aggregation/span_base.h>
 #include <generated/ebpf_net/aggregation/transform_builder.h>
 
@@ -57,6 +61,20 @@ public:
   // Enables generating flow logs from node-node (id-id) metrics.
   static void set_flow_logs_enabled(bool enabled);
 
+  // Limits how many id-id series each shard outputs per timeslot, folding the
+  // rest into an "other" series. 0 means no limit.
+  static void set_max_id_id_series(u32 max_series);
+
+  // Limits how many az-id and id-az series each shard outputs per timeslot,
+  // folding the rest into an "other" series. 0 means no limit.
+  static void set_max_az_id_series(u32 max_series);
+
+  // Enables writing metrics rolled up to |rollup|, on its own cadence, in
+  // addition to the base timeslots.
+  static void set_rollup_enabled(Rollup rollup, bool enabled);
+  // Returns whether writing metrics rolled up to |rollup| is enabled.
+  static bool rollup_enabled(Rollup rollup) { return rollups_enabled_[enum_index_of(rollup)]; }
+
   // How many top aggregation role/role pairs to show the count for in the
   // pipeline_aggregation_roles internal stat.
   static void count_top_aggregation_roles(size_t k);
@@ -64,6 +82,16 @@ public:
   // Internal statistics counters.
   StatCounters stat_counters;
 
+  // Dictionaries of strings sent by the matching cores, by matching shard.
+  StringDictionaryReaders matching_string_dictionaries;
+
+  // Whether latency sketches are aggregated, because an output uses them.
+  bool latency_sketches_enabled() const { return latency_sketches_enabled_; }
+
+  // Whether latency histograms are written, given whether there's an OTLP
+  // output and which metrics are disabled.
+  static bool latency_histograms_enabled(bool otlp_output, DisabledMetrics const &disabled_metrics);
+
   AggCore(
       RpcQueueMatrix &matching_to_aggregation_queues,
       RpcQueueMatrix &aggregation_to_logging_queues,
@@ -71,6 +99,7 @@ public:
       std::vector<Publisher::WriterPtr> metric_writers,
       std::unique_ptr<Publisher> &otlp_metrics_publisher,
       Publisher::WriterPtr otlp_metric_writer,
+      std::vector<Publisher::WriterPtr> rollup_metric_writers,
       bool enable_percentile_latencies,
       TsdbFormat metrics_tsdb_format,
       reducer::DisabledMetrics disabled_metrics,
@@ -80,6 +109,8 @@ public:
 private:
   // Stores TDigests to compute p90, p95, p99 latencies
   std::unique_ptr<PercentileLatencies> p_latencies_;
+  // Whether latency sketches are aggregated.
+  bool latency_sketches_enabled_{false};
 
   // Publisher for Prometheus (scrape) style external metrics.
   std::unique_ptr<Publisher> &metrics_publisher_;
@@ -91,6 +122,10 @@ private:
   // For writing external metrics to opentelemetry collector via OTLP gRPC.
   Publisher::WriterPtr otlp_metric_writer_;
 
+  // For writing rolled up metrics to their own Prometheus (scrape) style
+  // publisher. Rolled up metrics are also written to otlp_metric_writer_.
+  std::vector<Publisher::WriterPtr> rollup_metric_writers_;
+
   // Format of TSDB metrics.
   TsdbFormat metrics_tsdb_format_;
 
@@ -102,6 +137,11 @@ private:
   // allow the user to control which metrics are disabled
   DisabledMetrics disabled_metrics_;
 
+  // Limits the number of id-id, az-id and id-az series written.
+  CardinalityGuards cardinality_guards_;
+  // Same as above, for each enabled rollup.
+  enum_traits<Rollup>::array_map<std::unique_ptr<CardinalityGuards>> rollup_cardinality_guards_;
+
   // accessor handle for core_worker_internal_metrics span
   ::ebpf_net::aggregation::auto_handles::core_stats core_stats_;
 
@@ -119,14 +159,34 @@ private:
   // Flag indicating whether flow logs should be outputted.
   static bool flow_logs_enabled_;
 
+  // Maximum number of id-id series written per timeslot, 0 if unlimited.
+  static u32 max_id_id_series_;
+
+  // Maximum number of az-id (and id-az) series written per timeslot, 0 if unlimited.
+  static u32 max_az_id_series_;
+
+  // Flags indicating which rollups should be outputted.
+  static enum_traits<Rollup>::array_map<bool> rollups_enabled_;
+
   void on_timeslot_complete() override;
 
+  // Drops the strings and agg_roots of matching shard |client_index|, which
+  // started over.
+  void resync_rpc_client(size_t client_index) override;
+
+  // Restores the index snapshot when the core starts, and writes it when the core stops.
+  void on_start() override;
+  void on_stop() override;
+
   // Outputs external metrics.
   void write_metrics();
 
   // Outputs standard-resolution metrics.
   void write_standard_metrics(u64 t);
 
+  // Outputs metrics rolled up to |rollup|, if a rollup slot is complete.
+  void write_rollup_metrics(Rollup rollup, u64 t);
+
   // Outputs internal stats.
   void write_internal_stats() override;
 };
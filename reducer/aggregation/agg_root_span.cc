@@ -29,6 +29,28 @@ template <typename T> T as_short_string(jb_blob const &value, std::size_t &trunc
   return T::truncate(value);
 }
 
+// Returns the dictionary of strings sent by matching shard |dict|.
+StringDictionaryDecoder &matching_string_dictionary(u16 dict)
+{
+  auto *dictionary = local_core<AggCore>().matching_string_dictionaries.get(dict);
+  ASSUME(dictionary).else_log("unknown string dictionary {}", dict);
+  return *dictionary;
+}
+
+// Decodes the latency sketch |encoded| sent by matching into |sketch|.
+// Returns false if there is nothing to add.
+bool decode_sketch(jb_blob const &encoded, ::util::LatencySketch &sketch)
+{
+  if (!local_core<AggCore>().latency_sketches_enabled()) {
+    return false;
+  }
+
+  bool const decoded = sketch.decode(encoded);
+  DEBUG_ASSUME(decoded).else_log("malformed latency sketch of {} bytes", encoded.len);
+
+  return decoded && !sketch.empty();
+}
+
 } // namespace
 
 AggRootSpan::AggRootSpan() {}
@@ -110,6 +132,36 @@ void AggRootSpan::update_node(
   }
 }
 
+void AggRootSpan::define_string(
+    ::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__define_string *msg)
+{
+  ASSUME(matching_string_dictionary(msg->dict).define(msg->id, std::string_view(msg->value.buf, msg->value.len)))
+      .else_log("string id {} out of range in dictionary {}", msg->id, msg->dict);
+}
+
+void AggRootSpan::update_node_ids(
+    ::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__update_node_ids *msg)
+{
+  auto &strings = matching_string_dictionary(msg->dict);
+
+  jsrv_aggregation__update_node node{};
+  node.side = msg->side;
+  node.id = jb_blob(strings.lookup(msg->id));
+  node.az = jb_blob(strings.lookup(msg->az));
+  node.role = jb_blob(strings.lookup(msg->role));
+  node.version = jb_blob(strings.lookup(msg->version));
+  node.env = jb_blob(strings.lookup(msg->env));
+  node.ns = jb_blob(strings.lookup(msg->ns));
+  node.node_type = msg->node_type;
+  node.address = jb_blob(strings.lookup(msg->address));
+  node.process = jb_blob(strings.lookup(msg->process));
+  node.container = jb_blob(strings.lookup(msg->container));
+  node.pod_name = jb_blob(strings.lookup(msg->pod_name));
+  node.role_uid = jb_blob(strings.lookup(msg->role_uid));
+
+  update_node(span_ref, timestamp, &node);
+}
+
 void AggRootSpan::update_tcp_metrics(
     ::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__update_tcp_metrics *msg)
 {
@@ -170,4 +222,55 @@ void AggRootSpan::update_dns_metrics(
   }
 }
 
+void AggRootSpan::update_tcp_latency(
+    ::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__update_tcp_latency *msg)
+{
+  ::ebpf_net::metrics::tcp_latency_metrics_point latency;
+  if (!decode_sketch(msg->rtt, latency.rtt)) {
+    return;
+  }
+
+  auto direction = static_cast<UpdateDirection>(msg->direction);
+
+  if (direction == UpdateDirection::A_TO_B) {
+    span_ref.tcp_latency_a_to_b_update(timestamp, latency);
+  } else if (direction == UpdateDirection::B_TO_A) {
+    span_ref.tcp_latency_b_to_a_update(timestamp, latency);
+  }
+}
+
+void AggRootSpan::update_http_latency(
+    ::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__update_http_latency *msg)
+{
+  ::ebpf_net::metrics::http_latency_metrics_point latency;
+  if (!decode_sketch(msg->client_duration, latency.client_duration)) {
+    return;
+  }
+
+  auto direction = static_cast<UpdateDirection>(msg->direction);
+
+  if (direction == UpdateDirection::A_TO_B) {
+    span_ref.http_latency_a_to_b_update(timestamp, latency);
+  } else if (direction == UpdateDirection::B_TO_A) {
+    span_ref.http_latency_b_to_a_update(timestamp, latency);
+  }
+}
+
+void AggRootSpan::update_dns_latency(
+    ::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__update_dns_latency *msg)
+{
+  ::ebpf_net::metrics::dns_latency_metrics_point latency;
+  if (!decode_sketch(msg->client_duration, latency.client_duration)) {
+    return;
+  }
+
+  auto direction = static_cast<UpdateDirection>(msg->direction);
+
+  if (direction == UpdateDirection::A_TO_B) {
+    span_ref.dns_latency_a_to_b_update(timestamp, latency);
+  } else if (direction == UpdateDirection::B_TO_A) {
+    span_ref.dns_latency_b_to_a_update(timestamp, latency);
+  }
+}
+
 } // namespace reducer::aggregation
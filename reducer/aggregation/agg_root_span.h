@@ -16,6 +16,12 @@ public:
 
   void update_node(::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__update_node *msg);
 
+  void
+  define_string(::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__define_string *msg);
+
+  void update_node_ids(
+      ::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__update_node_ids *msg);
+
   void update_tcp_metrics(
       ::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__update_tcp_metrics *msg);
 
@@ -27,6 +33,15 @@ public:
 
   void update_dns_metrics(
       ::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__update_dns_metrics *msg);
+
+  void update_tcp_latency(
+      ::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__update_tcp_latency *msg);
+
+  void update_http_latency(
+      ::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__update_http_latency *msg);
+
+  void update_dns_latency(
+      ::ebpf_net::aggregation::weak_refs::agg_root span_ref, u64 timestamp, jsrv_aggregation__update_dns_latency *msg);
 };
 
 } // namespace reducer::aggregation
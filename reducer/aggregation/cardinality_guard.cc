@@ -0,0 +1,105 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include "cardinality_guard.h"
+
+namespace reducer::aggregation {
+
+CardinalityGuard::CardinalityGuard(u32 max_series) : max_series_(max_series), spare_(max_series)
+{
+  if (max_series_ > 0) {
+    summary_ = std::make_unique<HeavyHitters>(max_series_ * summary_factor);
+  }
+}
+
+bool CardinalityGuard::admit(u64 key, u64 weight)
+{
+  if (!summary_) {
+    return true;
+  }
+
+  if (weight > 0) {
+    summary_->add(key, weight);
+  }
+
+  if (admitted_.contains(key)) {
+    return true;
+  }
+
+  if (top_.contains(key)) {
+    admitted_.insert(key);
+    return true;
+  }
+
+  if (spare_ > 0) {
+    --spare_;
+    admitted_.insert(key);
+    return true;
+  }
+
+  ++folded_;
+  return false;
+}
+
+void CardinalityGuard::end_timeslot()
+{
+  if (!summary_) {
+    return;
+  }
+
+  last_series_ = admitted_.size();
+  admitted_.clear();
+
+  top_.clear();
+  for (u64 key : summary_->top(max_series_, min_top_weight)) {
+    top_.insert(key);
+  }
+
+  spare_ = max_series_ - top_.size();
+
+  summary_->decay(decay);
+}
+
+void CardinalityGuard::forget(u32 loc)
+{
+  if (!summary_) {
+    return;
+  }
+
+  for (int reverse : {0, 1}) {
+    u64 const key = series_key(loc, reverse);
+
+    summary_->remove(key);
+
+    // a series reserved this timeslot gives its budget back. One already
+    // output keeps it, so a new span at |loc| is output too without
+    // exceeding the limit.
+    if (top_.erase(key) && !admitted_.contains(key)) {
+      ++spare_;
+    }
+  }
+}
+
+CardinalityGuards::CardinalityGuards(u32 max_id_id_series, u32 max_az_id_series)
+    : guards_{CardinalityGuard(max_id_id_series), CardinalityGuard(max_az_id_series), CardinalityGuard(max_az_id_series)}
+{}
+
+void CardinalityGuards::end_timeslot()
+{
+  for (auto &guard : guards_) {
+    guard.end_timeslot();
+  }
+}
+
+void CardinalityGuards::forget_node_node(u32 loc)
+{
+  guards_[enum_index_of(NodeAggregation::id_id)].forget(loc);
+}
+
+void CardinalityGuards::forget_az_node(u32 loc)
+{
+  guards_[enum_index_of(NodeAggregation::az_id)].forget(loc);
+  guards_[enum_index_of(NodeAggregation::id_az)].forget(loc);
+}
+
+} // namespace reducer::aggregation
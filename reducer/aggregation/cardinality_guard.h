@@ -0,0 +1,127 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <platform/types.h>
+#include <util/enum.h>
+#include <util/heavy_hitters.h>
+
+#include <absl/container/flat_hash_set.h>
+
+#include <memory>
+
+// Aggregations with a series per node (or node pair), whose output size grows
+// with the size of the cluster.
+#define ENUM_NAMESPACE reducer::aggregation
+#define ENUM_NAME NodeAggregation
+#define ENUM_TYPE u8
+#define ENUM_ELEMENTS(X)                                                                                                       \
+  X(id_id, 0, "")                                                                                                              \
+  X(az_id, 1, "")                                                                                                              \
+  X(id_az, 2, "")
+#define ENUM_DEFAULT id_id
+#include <util/enum_operators.inl>
+
+namespace reducer::aggregation {
+
+// Limits the number of series that one node aggregation outputs each
+// timeslot.
+//
+// Series are weighted by their number of active sockets, and their recent
+// weights are tracked in a HeavyHitters summary. The series that were the
+// heaviest as of the end of the previous timeslot are output on their own.
+// Budget left over by those goes to other series on a first come basis,
+// which is how new series get in. All remaining series are folded into a
+// single "other" series, so output stays within `max_series + 1` series per
+// metric, whatever the size of the cluster.
+//
+class CardinalityGuard {
+public:
+  // Number of series tracked in the heavy-hitter summary, per output series.
+  static constexpr u32 summary_factor = 4;
+  // Fraction of its weight a series keeps from one timeslot to the next.
+  static constexpr double decay = 0.5;
+  // Minimum weight for a series to keep its place among the heaviest ones,
+  // so series that went idle give their budget back.
+  static constexpr double min_top_weight = 1.0;
+
+  // A |max_series| of 0 disables the guard.
+  explicit CardinalityGuard(u32 max_series);
+
+  bool enabled() const { return summary_ != nullptr; }
+
+  // Identifies a series by its span location and direction.
+  static u64 series_key(u32 loc, int reverse) { return (u64(reverse) << 32) | loc; }
+
+  // Adds |weight| to the series |key| and returns whether the series is output
+  // on its own in the current timeslot. Otherwise it is to be folded into the
+  // "other" series.
+  //
+  // The decision holds for the rest of the timeslot, so a series' metrics of
+  // all protocols are either output or folded together.
+  bool admit(u64 key, u64 weight);
+
+  // Completes the current timeslot, choosing which series are output in the
+  // next one.
+  void end_timeslot();
+
+  // Forgets the weight of the series of the span at |loc|, in both
+  // directions, as the span is freed, so that the next span at that location
+  // starts from scratch.
+  void forget(u32 loc);
+
+  // Number of series output on their own in the last completed timeslot.
+  u64 series() const { return last_series_; }
+  // Total number of metrics entries folded into the "other" series.
+  u64 folded() const { return folded_; }
+  // Total number of series evicted from the heavy-hitter summary.
+  u64 evicted() const { return summary_ ? summary_->evictions() : 0; }
+
+private:
+  u32 max_series_;
+  std::unique_ptr<HeavyHitters> summary_;
+
+  // Heaviest series as of the end of the previous timeslot.
+  absl::flat_hash_set<u64> top_;
+  // Series output on their own in the current timeslot.
+  absl::flat_hash_set<u64> admitted_;
+  // Budget left for series not in top_.
+  u32 spare_ = 0;
+
+  u64 last_series_ = 0;
+  u64 folded_ = 0;
+};
+
+// The cardinality guards of all node aggregations of a core.
+//
+class CardinalityGuards {
+public:
+  CardinalityGuards(u32 max_id_id_series, u32 max_az_id_series);
+
+  CardinalityGuard &operator[](NodeAggregation aggregation) { return guards_[enum_index_of(aggregation)]; }
+
+  void end_timeslot();
+
+  // Forgets the series of the node_node span at |loc|.
+  void forget_node_node(u32 loc);
+  // Forgets the series of the az_node span at |loc|.
+  void forget_az_node(u32 loc);
+
+  // Calls `fn(NodeAggregation, CardinalityGuard const &)` for each enabled guard.
+  template <typename Fn> void foreach_enabled(Fn &&fn) const
+  {
+    for (auto aggregation : enum_traits<NodeAggregation>::values) {
+      if (auto const &guard = guards_[enum_index_of(aggregation)]; guard.enabled()) {
+        fn(aggregation, guard);
+      }
+    }
+  }
+
+private:
+  enum_traits<NodeAggregation>::array_map<CardinalityGuard> guards_;
+};
+
+} // namespace reducer::aggregation
@@ -0,0 +1,148 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <reducer/aggregation/cardinality_guard.h>
+
+#include <gtest/gtest.h>
+
+using namespace reducer::aggregation;
+
+namespace {
+
+u64 key(u32 loc)
+{
+  return CardinalityGuard::series_key(loc, 0);
+}
+
+} // namespace
+
+TEST(CardinalityGuardTest, DisabledAdmitsEverything)
+{
+  CardinalityGuard guard(0);
+  EXPECT_FALSE(guard.enabled());
+
+  for (u32 loc = 0; loc < 100; ++loc) {
+    EXPECT_TRUE(guard.admit(key(loc), 1));
+  }
+  guard.end_timeslot();
+
+  EXPECT_EQ(0u, guard.folded());
+}
+
+TEST(CardinalityGuardTest, FoldsSeriesBeyondBudget)
+{
+  CardinalityGuard guard(2);
+  EXPECT_TRUE(guard.enabled());
+
+  EXPECT_TRUE(guard.admit(key(1), 1));
+  EXPECT_TRUE(guard.admit(key(2), 1));
+  EXPECT_FALSE(guard.admit(key(3), 1));
+  EXPECT_EQ(1u, guard.folded());
+
+  // the decision holds for the rest of the timeslot, e.g. for other protocols
+  EXPECT_TRUE(guard.admit(key(1), 1));
+  EXPECT_FALSE(guard.admit(key(3), 1));
+  EXPECT_EQ(2u, guard.folded());
+
+  guard.end_timeslot();
+  EXPECT_EQ(2u, guard.series());
+}
+
+TEST(CardinalityGuardTest, HeaviestSeriesAreOutputNextTimeslot)
+{
+  CardinalityGuard guard(2);
+
+  // series 3 comes in last, after the budget is spent, but is the heaviest
+  EXPECT_TRUE(guard.admit(key(1), 1));
+  EXPECT_TRUE(guard.admit(key(2), 2));
+  EXPECT_FALSE(guard.admit(key(3), 100));
+  guard.end_timeslot();
+
+  // so it gets a place of its own, and the lightest series is folded even
+  // though it comes in first
+  EXPECT_FALSE(guard.admit(key(1), 1));
+  EXPECT_TRUE(guard.admit(key(3), 100));
+  EXPECT_TRUE(guard.admit(key(2), 2));
+}
+
+TEST(CardinalityGuardTest, IdleSeriesGiveTheirPlaceBack)
+{
+  CardinalityGuard guard(1);
+
+  EXPECT_TRUE(guard.admit(key(1), 4));
+  guard.end_timeslot();
+
+  // series 1 keeps its place while its decayed weight is 4, 2, then 1
+  for (int timeslot = 0; timeslot < 3; ++timeslot) {
+    EXPECT_FALSE(guard.admit(key(2), 0));
+    guard.end_timeslot();
+  }
+
+  // its weight fell below the minimum, so its budget is free for others
+  EXPECT_TRUE(guard.admit(key(2), 0));
+  guard.end_timeslot();
+  EXPECT_EQ(1u, guard.series());
+}
+
+TEST(CardinalityGuardTest, ForgetReleasesReservedPlace)
+{
+  CardinalityGuard guard(1);
+
+  EXPECT_TRUE(guard.admit(key(1), 10));
+  guard.end_timeslot();
+
+  // the span of series 1 is freed before it is output again
+  guard.forget(1);
+  EXPECT_TRUE(guard.admit(key(2), 1));
+  guard.end_timeslot();
+
+  // and its weight doesn't carry over to the next span at its location
+  EXPECT_TRUE(guard.admit(key(2), 1));
+  EXPECT_FALSE(guard.admit(key(1), 1));
+}
+
+TEST(CardinalityGuardTest, ForgetKeepsPlaceAlreadyOutput)
+{
+  CardinalityGuard guard(1);
+
+  EXPECT_TRUE(guard.admit(key(1), 10));
+  guard.end_timeslot();
+
+  // series 1 was output this timeslot, so its place stays used
+  EXPECT_TRUE(guard.admit(key(1), 10));
+  guard.forget(1);
+  EXPECT_FALSE(guard.admit(key(2), 1));
+
+  // the next span at the location is still output on its own
+  EXPECT_TRUE(guard.admit(key(1), 1));
+}
+
+TEST(CardinalityGuardTest, EvictsLightSeriesFromSummary)
+{
+  CardinalityGuard guard(1);
+
+  // the summary tracks summary_factor series per output series
+  for (u32 loc = 0; loc < CardinalityGuard::summary_factor; ++loc) {
+    guard.admit(key(loc), 1);
+  }
+  EXPECT_EQ(0u, guard.evicted());
+
+  guard.admit(key(CardinalityGuard::summary_factor), 1);
+  EXPECT_EQ(1u, guard.evicted());
+}
+
+TEST(CardinalityGuardTest, GuardsForgetTheirAggregationsSpans)
+{
+  CardinalityGuards guards(1, 1);
+
+  for (auto aggregation : {NodeAggregation::id_id, NodeAggregation::az_id, NodeAggregation::id_az}) {
+    EXPECT_TRUE(guards[aggregation].admit(key(1), 10));
+  }
+  guards.end_timeslot();
+
+  // az_node spans are forgotten in the az_id and id_az guards only
+  guards.forget_az_node(1);
+  EXPECT_FALSE(guards[NodeAggregation::id_id].admit(key(2), 1));
+  EXPECT_TRUE(guards[NodeAggregation::az_id].admit(key(2), 1));
+  EXPECT_TRUE(guards[NodeAggregation::id_az].admit(key(2), 1));
+}
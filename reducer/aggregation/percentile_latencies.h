@@ -33,6 +33,11 @@ public:
   void
   operator()(u64 t, ::ebpf_net::aggregation::weak_refs::az_az &az_az, ::ebpf_net::metrics::http_metrics &metrics, u64 interval);
 
+  // The latency sketches are exported as histograms instead.
+  template <typename LatencyMetrics>
+  void operator()(u64 t, ::ebpf_net::aggregation::weak_refs::az_az &az_az, LatencyMetrics &metrics, u64 interval)
+  {}
+
 private:
   LatencyAccumulator tcp_;
   LatencyAccumulator dns_;
@@ -0,0 +1,36 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <platform/types.h>
+#include <util/enum.h>
+
+// Resolutions that metrics can be output at, in addition to the base
+// 30-second timeslots. Each one is maintained incrementally in the `rollup`
+// stores of the node_node, az_node and az_az aggregations (see render
+// definition file); the value is the rollup count, in base timeslots.
+#define ENUM_NAMESPACE reducer::aggregation
+#define ENUM_NAME Rollup
+#define ENUM_TYPE u16
+#define ENUM_ELEMENTS(X)                                                                                                       \
+  X(five_minutes, 10, "5m")                                                                                                    \
+  X(one_hour, 120, "1h")
+#define ENUM_DEFAULT five_minutes
+#include <util/enum_operators.inl>
+
+namespace reducer::aggregation {
+
+// Duration of the base timeslots of the aggregations, in seconds (`interval`
+// in the render definition file).
+constexpr u32 kBaseTimeslotSeconds = 30;
+
+// Duration of a rollup slot, in seconds.
+constexpr u32 rollup_seconds(Rollup rollup)
+{
+  return static_cast<u32>(rollup) * kBaseTimeslotSeconds;
+}
+
+} // namespace reducer::aggregation
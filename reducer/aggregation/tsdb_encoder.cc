@@ -6,6 +6,8 @@
 #include "labels.h"
 #include "tsdb_encoder.h"
 
+#include <reducer/copy_metrics.h>
+
 #include <generated/ebpf_net/aggregation/index.h>
 
 #include <util/log.h>
@@ -15,6 +17,89 @@
 
 namespace reducer::aggregation {
 
+namespace {
+
+// Whether metrics of a node_node span show activity, which is followed by a
+// zero report. Latency distributions have nothing to report as zero.
+template <typename Metrics> bool needs_zero_report(Metrics const &metrics)
+{
+  return metrics.active_sockets > 0;
+}
+
+bool needs_zero_report(::ebpf_net::metrics::tcp_latency_metrics const &metrics)
+{
+  return false;
+}
+
+bool needs_zero_report(::ebpf_net::metrics::http_latency_metrics const &metrics)
+{
+  return false;
+}
+
+bool needs_zero_report(::ebpf_net::metrics::dns_latency_metrics const &metrics)
+{
+  return false;
+}
+
+// Weight of a series, for cardinality guards: its number of active sockets.
+// Latency distributions follow the decision made for their flows' metrics.
+template <typename Metrics> u64 series_weight(Metrics const &metrics)
+{
+  return metrics.active_sockets;
+}
+
+u64 series_weight(::ebpf_net::metrics::tcp_latency_metrics const &metrics)
+{
+  return 0;
+}
+
+u64 series_weight(::ebpf_net::metrics::http_latency_metrics const &metrics)
+{
+  return 0;
+}
+
+u64 series_weight(::ebpf_net::metrics::dns_latency_metrics const &metrics)
+{
+  return 0;
+}
+
+void fold_metrics(::ebpf_net::metrics::tcp_metrics &dst, ::ebpf_net::metrics::tcp_metrics const &src)
+{
+  add_tcp_metrics(dst, src);
+}
+
+void fold_metrics(::ebpf_net::metrics::udp_metrics &dst, ::ebpf_net::metrics::udp_metrics const &src)
+{
+  add_udp_metrics(dst, src);
+}
+
+void fold_metrics(::ebpf_net::metrics::http_metrics &dst, ::ebpf_net::metrics::http_metrics const &src)
+{
+  add_http_metrics(dst, src);
+}
+
+void fold_metrics(::ebpf_net::metrics::dns_metrics &dst, ::ebpf_net::metrics::dns_metrics const &src)
+{
+  add_dns_metrics(dst, src);
+}
+
+void fold_metrics(::ebpf_net::metrics::tcp_latency_metrics &dst, ::ebpf_net::metrics::tcp_latency_metrics const &src)
+{
+  dst.rtt.merge(src.rtt);
+}
+
+void fold_metrics(::ebpf_net::metrics::http_latency_metrics &dst, ::ebpf_net::metrics::http_latency_metrics const &src)
+{
+  dst.client_duration.merge(src.client_duration);
+}
+
+void fold_metrics(::ebpf_net::metrics::dns_latency_metrics &dst, ::ebpf_net::metrics::dns_latency_metrics const &src)
+{
+  dst.client_duration.merge(src.client_duration);
+}
+
+} // namespace
+
 TsdbEncoder::TsdbEncoder(
     std::vector<Publisher::WriterPtr> &metric_writers,
     TsdbFormat tsdb_format,
@@ -23,8 +108,9 @@ TsdbEncoder::TsdbEncoder(
     bool id_id_enabled,
     bool az_id_enabled,
     bool flow_logs_enabled,
+    CardinalityGuards &cardinality_guards,
     const DisabledMetrics &disabled_metrics,
-    std::optional<int> rollup_count)
+    std::optional<Rollup> rollup)
     : metric_writers_(metric_writers),
       tsdb_format_(tsdb_format),
       otlp_metric_writer_(otlp_metric_writer),
@@ -32,8 +118,15 @@ TsdbEncoder::TsdbEncoder(
       id_id_enabled_(id_id_enabled),
       az_id_enabled_(az_id_enabled),
       flow_logs_enabled_(flow_logs_enabled),
+      rollup_(rollup),
+      cardinality_guards_(cardinality_guards),
       disabled_metrics_(disabled_metrics)
 {
+  TsdbFormatter::rollup_t rollup_seconds;
+  if (rollup) {
+    rollup_seconds = aggregation::rollup_seconds(*rollup);
+  }
+
   if (!metric_writers.empty()) {
     switch (tsdb_format_) {
     case TsdbFormat::prometheus:
@@ -44,13 +137,13 @@ TsdbEncoder::TsdbEncoder(
       throw std::invalid_argument("invalid format, otlp_grpc, for prometheus formatter");
       break;
     }
-    prometheus_formatter_->set_rollup(rollup_count);
+    prometheus_formatter_->set_rollup(rollup_seconds);
     prometheus_formatter_->set_timestamp(timestamp);
   }
 
   if (otlp_metric_writer) {
     otlp_grpc_formatter_ = TsdbFormatter::make(TsdbFormat::otlp_grpc, otlp_metric_writer);
-    otlp_grpc_formatter_->set_rollup(rollup_count);
+    otlp_grpc_formatter_->set_rollup(rollup_seconds);
     otlp_grpc_formatter_->set_timestamp(timestamp);
   }
 }
@@ -92,8 +185,60 @@ void TsdbEncoder::encode_and_write_p_latencies(const std::string &proto, const P
   }
 }
 
+template <typename Metrics> bool TsdbEncoder::admit_or_fold(NodeAggregation aggregation, u32 loc, Metrics const &metrics)
+{
+  if (cardinality_guards_[aggregation].admit(CardinalityGuard::series_key(loc, reverse_), series_weight(metrics))) {
+    return true;
+  }
+
+  auto &folded = std::get<FoldedMetrics<Metrics>>(folded_)[enum_index_of(aggregation)];
+  if (folded) {
+    fold_metrics(*folded, metrics);
+  } else {
+    folded = metrics;
+  }
+
+  return false;
+}
+
+void TsdbEncoder::write_folded_metrics()
+{
+  // each metric type and aggregation always gets the same number, so each
+  // "other" series keeps going to the same writer
+  size_t series_num = 0;
+  std::apply([&](auto &...folded) { (write_folded_metrics(folded, series_num), ...); }, folded_);
+}
+
+template <typename Metrics> void TsdbEncoder::write_folded_metrics(FoldedMetrics<Metrics> &folded, size_t &series_num)
+{
+  NodeLabels other;
+  other.id = kOtherSeries;
+  FlowLabels const labels{other, other};
+
+  for (auto aggregation : enum_traits<NodeAggregation>::values) {
+    size_t const writer_num = series_num++;
+
+    auto &metrics = folded[enum_index_of(aggregation)];
+    if (!metrics) {
+      continue;
+    }
+
+    if (!metric_writers_.empty()) {
+      encode_and_write(metric_writers_[writer_num % metric_writers_.size()], to_string(aggregation), labels, *metrics);
+    }
+
+    if (otlp_metric_writer_) {
+      encode_and_write_otlp_grpc(otlp_metric_writer_, to_string(aggregation), labels, *metrics);
+    }
+
+    metrics.reset();
+  }
+}
+
 void TsdbEncoder::flush()
 {
+  write_folded_metrics();
+
   if (prometheus_formatter_) {
     prometheus_formatter_->flush();
   }
@@ -141,4 +286,31 @@ void TsdbEncoder::flush()
 #undef A_B_UPDATE
 #undef B_A_UPDATE
 
+// TCP latency
+#define METRICS tcp_latency_metrics
+#define A_B_UPDATE tcp_latency_a_to_b_update
+#define B_A_UPDATE tcp_latency_b_to_a_update
+#include "tsdb_encoder.inl"
+#undef METRICS
+#undef A_B_UPDATE
+#undef B_A_UPDATE
+
+// HTTP latency
+#define METRICS http_latency_metrics
+#define A_B_UPDATE http_latency_a_to_b_update
+#define B_A_UPDATE http_latency_b_to_a_update
+#include "tsdb_encoder.inl"
+#undef METRICS
+#undef A_B_UPDATE
+#undef B_A_UPDATE
+
+// DNS latency
+#define METRICS dns_latency_metrics
+#define A_B_UPDATE dns_latency_a_to_b_update
+#define B_A_UPDATE dns_latency_b_to_a_update
+#include "tsdb_encoder.inl"
+#undef METRICS
+#undef A_B_UPDATE
+#undef B_A_UPDATE
+
 } // namespace reducer::aggregation
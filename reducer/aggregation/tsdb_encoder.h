@@ -7,6 +7,9 @@
 
 #include "percentile_latencies.h"
 
+#include <reducer/aggregation/cardinality_guard.h>
+#include <reducer/aggregation/rollup.h>
+
 #include <reducer/constants.h>
 #include <reducer/disabled_metrics.h>
 #include <reducer/publisher.h>
@@ -19,6 +22,7 @@
 #include <chrono>
 #include <optional>
 #include <string>
+#include <tuple>
 #include <vector>
 
 namespace reducer::aggregation {
@@ -35,8 +39,9 @@ public:
       bool id_id_enabled,
       bool az_id_enabled,
       bool flow_logs_enabled,
+      CardinalityGuards &cardinality_guards,
       const DisabledMetrics &disabled_metrics,
-      std::optional<int> rollup_count = std::nullopt);
+      std::optional<Rollup> rollup = std::nullopt);
 
   void set_reverse(int reverse) { reverse_ = reverse; }
 
@@ -53,13 +58,17 @@ public:
   DECLARE_OPERATORS(udp_metrics)
   DECLARE_OPERATORS(http_metrics)
   DECLARE_OPERATORS(dns_metrics)
+  DECLARE_OPERATORS(tcp_latency_metrics)
+  DECLARE_OPERATORS(http_latency_metrics)
+  DECLARE_OPERATORS(dns_latency_metrics)
 
 #undef DECLARE_OPERATOR
 #undef DECLARE_OPERATORS
 
   void encode_and_write_p_latencies(const PercentileLatencies &plat);
 
-  // Flush formatter(s) which may have metrics buffered.
+  // Writes the "other" series of the node aggregations, then flushes
+  // formatter(s) which may have metrics buffered.
   void flush();
 
 private:
@@ -75,6 +84,23 @@ private:
   bool az_id_enabled_{false};
   bool flow_logs_enabled_{false};
   int reverse_{0};
+  // Set when writing the metrics of a rollup instead of base timeslots.
+  std::optional<Rollup> rollup_;
+
+  CardinalityGuards &cardinality_guards_;
+
+  // Metrics of the series that cardinality guards folded into the "other"
+  // series of each node aggregation, for each metrics type.
+  template <typename Metrics> using FoldedMetrics = enum_traits<NodeAggregation>::array_map<std::optional<Metrics>>;
+  std::tuple<
+      FoldedMetrics<::ebpf_net::metrics::tcp_metrics>,
+      FoldedMetrics<::ebpf_net::metrics::udp_metrics>,
+      FoldedMetrics<::ebpf_net::metrics::http_metrics>,
+      FoldedMetrics<::ebpf_net::metrics::dns_metrics>,
+      FoldedMetrics<::ebpf_net::metrics::tcp_latency_metrics>,
+      FoldedMetrics<::ebpf_net::metrics::http_latency_metrics>,
+      FoldedMetrics<::ebpf_net::metrics::dns_latency_metrics>>
+      folded_;
 
   const DisabledMetrics &disabled_metrics_;
 
@@ -84,6 +110,24 @@ private:
   // OTLP gRPC formatter
   std::unique_ptr<TsdbFormatter> otlp_grpc_formatter_;
 
+  // Labels the series written by |formatter| with the rollup, if any.
+  void assign_rollup_label(TsdbFormatter &formatter)
+  {
+    if (rollup_) {
+      formatter.assign_label(std::string_view(kRollupDimName), to_string(*rollup_));
+    }
+  }
+
+  // Returns whether the series at |loc| is output on its own in |aggregation|.
+  // Otherwise folds |metrics| into the aggregation's "other" series.
+  template <typename Metrics> bool admit_or_fold(NodeAggregation aggregation, u32 loc, Metrics const &metrics);
+
+  // Writes the "other" series of the node aggregations.
+  void write_folded_metrics();
+  // Writes the "other" series of |folded|, numbering them from |series_num|
+  // to spread them across the metric writers.
+  template <typename Metrics> void write_folded_metrics(FoldedMetrics<Metrics> &folded, size_t &series_num);
+
   // encode_and_write for exporting metrics with Prometheus (scrape) style publisher writers
   template <typename Metrics>
   void
@@ -92,6 +136,7 @@ private:
     prometheus_formatter_->set_aggregation(aggregation);
     prometheus_formatter_->set_labels(labels);
     prometheus_formatter_->assign_label(std::string_view(kProductIdDimName), std::string_view(kProductIdDimValue));
+    assign_rollup_label(*prometheus_formatter_);
     write_metrics(metrics, writer, *prometheus_formatter_, disabled_metrics_);
   }
 
@@ -103,6 +148,7 @@ private:
     otlp_grpc_formatter_->set_aggregation(aggregation);
     otlp_grpc_formatter_->set_labels(labels);
     otlp_grpc_formatter_->assign_label(std::string_view(kProductIdDimName), std::string_view(kProductIdDimValue));
+    assign_rollup_label(*otlp_grpc_formatter_);
     write_metrics(metrics, writer, *otlp_grpc_formatter_, disabled_metrics_);
   }
 
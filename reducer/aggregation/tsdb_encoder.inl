@@ -8,7 +8,7 @@ void TsdbEncoder::operator()(
 void TsdbEncoder::operator()(
     u64 t, ::ebpf_net::aggregation::weak_refs::node_node &span, ::ebpf_net::metrics::METRICS &metrics, u64 interval)
 {
-  if (id_id_enabled_) {
+  if (id_id_enabled_ && admit_or_fold(NodeAggregation::id_id, span.loc(), metrics)) {
     if (!metric_writers_.empty()) {
       auto writer_num = span.loc() % metric_writers_.size();
       auto &metric_writer = metric_writers_[writer_num];
@@ -25,7 +25,7 @@ void TsdbEncoder::operator()(
     }
   }
 
-  if (flow_logs_enabled_ && otlp_metric_writer_) {
+  if (flow_logs_enabled_ && !rollup_ && otlp_metric_writer_) {
     NodeLabels k[2] = {span.node1(), span.node2()};
 
     encode_and_write_otlp_grpc_flow_log({k[reverse_], k[1 - reverse_]}, metrics);
@@ -34,8 +34,9 @@ void TsdbEncoder::operator()(
   // If there was activity in this timeslot, start a new timeslot
   // so there is a zero report at the end.
   // Also this keeps handles for another interval so should reduce
-  // handle churn.
-  if (metrics.active_sockets > 0) {
+  // handle churn. Rollups are fed from the base timeslots, which get the
+  // zero reports.
+  if (!rollup_ && needs_zero_report(metrics)) {
     ::ebpf_net::metrics::METRICS zero_metrics = {};
 
     if (reverse_ == 0)
@@ -48,7 +49,8 @@ void TsdbEncoder::operator()(
 void TsdbEncoder::operator()(
     u64 t, ::ebpf_net::aggregation::weak_refs::az_node &az_node, ::ebpf_net::metrics::METRICS &metrics, u64 interval)
 {
-  if (az_id_enabled_) {
+  if (az_id_enabled_ &&
+      admit_or_fold((reverse_ == 0) ? NodeAggregation::az_id : NodeAggregation::id_az, az_node.loc(), metrics)) {
     if (!metric_writers_.empty()) {
       auto writer_num = az_node.loc() % metric_writers_.size();
       auto &metric_writer = metric_writers_[writer_num];
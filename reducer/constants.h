@@ -28,7 +28,8 @@
   X(LOCALHOST, 6, "")                                                                                                          \
   X(K8S_CONTAINER, 7, "")                                                                                                      \
   X(CONTAINER, 8, "")                                                                                                          \
-  X(NOMAD, 9, "")
+  X(NOMAD, 9, "")                                                                                                              \
+  X(IP_RANGE, 10, "")
 #define ENUM_DEFAULT NONE
 #include <util/enum_operators.inl>
 
@@ -47,10 +48,16 @@ enum class UpdateDirection {
 
 static constexpr char kUnknown[] = "(unknown)";
 
+// Node id of the series that stands for all series beyond a cardinality limit.
+static constexpr char kOtherSeries[] = "(other)";
+
 static constexpr char kCommKubelet[] = "kubelet";
 
 static constexpr u16 kPortDNS = 53;
 
+// Label of the series of metrics rolled up to a coarser resolution, e.g. "5m".
+static constexpr char kRollupDimName[] = "rollup";
+
 static constexpr char kProductIdDimName[] = "sf_product";
 static constexpr char kProductIdDimValue[] = "network-explorer";
 static constexpr char kServiceName[] = "reducer";
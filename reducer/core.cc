@@ -4,6 +4,7 @@
 #include "core.h"
 
 #include <reducer/constants.h>
+#include <reducer/rpc_queue_matrix.h>
 #include <reducer/util/thread_ops.h>
 
 #include <platform/userspace-time.h>
@@ -17,6 +18,13 @@ namespace reducer {
 
 thread_local Core *Core::instance_ = nullptr;
 
+std::chrono::nanoseconds Core::max_input_lateness_{0};
+
+void Core::set_max_input_lateness(std::chrono::nanoseconds max_lateness)
+{
+  max_input_lateness_ = max_lateness;
+}
+
 Core::Core(std::string_view app_name, size_t shard_num, u64 initial_timestamp)
     : app_name_(app_name), shard_num_(shard_num), current_timestamp_(initial_timestamp)
 {
@@ -30,12 +38,16 @@ Core::Core(std::string_view app_name, size_t shard_num, u64 initial_timestamp)
 
   CHECK_UV(uv_timer_init(&loop_, &stats_timer_));
   stats_timer_.data = this;
+
+  // the clock waits in monotonic time, see handle_rpc()
+  virtual_clock_.set_max_lateness(max_input_lateness_.count());
 }
 
 Core::~Core() {}
 
 void Core::set_connection_authenticated()
 {
+  connection_authenticated_ = true;
   for (auto &rpc_client : rpc_clients_) {
     rpc_client.handler->set_connection_authenticated();
   }
@@ -69,6 +81,8 @@ void Core::run()
     LOG::warn("unable to set name for {} core thread {}: {}", app_name_, shard_num_, error);
   });
 
+  on_start();
+
   if (!rpc_clients_.empty()) {
     auto repeat = integer_time<std::chrono::milliseconds>(RPC_HANDLE_TIME);
     CHECK_UV(uv_timer_start(&rpc_timer_, on_rpc_timer, repeat, repeat));
@@ -80,6 +94,9 @@ void Core::run()
   }
 
   uv_run(&loop_, UV_RUN_DEFAULT);
+
+  on_stop();
+
   close_uv_loop_cleanly(&loop_);
 
   done_.Notify();
@@ -163,6 +180,17 @@ bool Core::handle_rpc()
       char *msg_buf{nullptr};
       int msg_len{0};
 
+      if (RpcQueueMatrix::is_resync_marker(rpc_client.queue.peek())) {
+        LOG::info(
+            "{}-{}: client {} ({}) started over", app_name(), shard_num(), rpc_client_index, to_string(rpc_client.client_type));
+        (void)rpc_client.queue.read(msg_buf);
+        resync_rpc_client(rpc_client_index);
+        if (connection_authenticated_) {
+          rpc_client.handler->set_connection_authenticated();
+        }
+        continue;
+      }
+
       // decode the message timestamp
       u64 msg_timestamp;
       if (rpc_client.queue.peek_value(msg_timestamp) < 0) {
@@ -190,6 +218,10 @@ bool Core::handle_rpc()
       }
 
       if (virtual_clock_.is_current(rpc_client_index)) {
+        // messages of a late client are handled in the current timeslot
+        if (virtual_clock_.is_late(rpc_client_index)) {
+          ++rpc_client.late_messages;
+        }
         // update this core's timestamp
         current_timestamp_ = std::max(current_timestamp_, msg_timestamp);
         // read this message
@@ -209,7 +241,7 @@ bool Core::handle_rpc()
     rpc_client.queue.finish_read_batch();
   }
 
-  if (virtual_clock_.advance()) {
+  if (virtual_clock_.advance(monotonic())) {
     on_timeslot_complete();
   }
 
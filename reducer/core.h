@@ -56,6 +56,11 @@ public:
   // Returns the current metrics timestamp, for output to a TSDB.
   std::chrono::nanoseconds metrics_timestamp() const;
 
+  // Sets how long cores wait for lagging RPC clients before completing a
+  // timeslot without them. Zero waits indefinitely.
+  // NOTE: must be called on startup, from main, before any cores are created
+  static void set_max_input_lateness(std::chrono::nanoseconds max_lateness);
+
 protected:
   // Subclasses implement to use concrete render-generated classes.
   //
@@ -77,6 +82,9 @@ protected:
     std::unique_ptr<IRpcHandler> handler;
     // Type of this client.
     ClientType client_type;
+    // Messages handled while this client was late (see VirtualClock), since
+    // last reported.
+    u64 late_messages{0};
 
     RpcClient(ElementQueue queue, std::unique_ptr<IRpcHandler> handler, ClientType client_type);
   };
@@ -94,6 +102,9 @@ private:
   // Assigned in run().
   static thread_local Core *instance_;
 
+  // Lateness bound of the virtual clock of cores, see set_max_input_lateness().
+  static std::chrono::nanoseconds max_input_lateness_;
+
   // This core's application name.
   std::string app_name_;
   // This core's shard number.
@@ -106,6 +117,9 @@ private:
   // Next RPC client to read from.
   size_t next_rpc_client_{0};
 
+  // Whether set_connection_authenticated() was called.
+  bool connection_authenticated_{false};
+
   // Libuv loop object.
   uv_loop_t loop_;
   // Async object used for stopping the loop from another thread.
@@ -134,6 +148,15 @@ private:
   // Called when the current timeslot is complete.
   virtual void on_timeslot_complete();
 
+  // Called when RPC client |client_index| started over, see
+  // RpcQueueMatrix::write_resync_marker. Subclasses drop what the client sent
+  // before, as the client forgot about it.
+  virtual void resync_rpc_client(size_t client_index) {}
+
+  // Called on the core's thread before the execution loop starts and after it stops.
+  virtual void on_start() {}
+  virtual void on_stop() {}
+
   // Subclasses implement to output internal stats to be scraped by a
   // time-series DB.
   // Gets invoked periodically by the internal stats timer.
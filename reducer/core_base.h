@@ -10,6 +10,7 @@
 #include <reducer/publisher.h>
 #include <reducer/rpc_stats.h>
 #include <reducer/util/index_dumper.h>
+#include <reducer/util/index_snapshotter.h>
 
 #include <generated/ebpf_net/matching/auto_handles.h>
 
@@ -64,6 +65,8 @@ protected:
   Index index_;
   // A rate-limited helper to dump the core's index.
   IndexDumper index_dumper_;
+  // Writes and restores binary snapshots of the core's index.
+  IndexSnapshotter index_snapshotter_;
 
   template <typename... Args>
   CoreBase(std::string_view app_name, size_t shard_num, u64 initial_timestamp, Args &&...args)
@@ -83,12 +86,32 @@ protected:
     virtual_clock_.add_inputs(queues.size());
   }
 
+  // Replaces the client's connection, which puts the spans the client
+  // allocated.
+  void resync_rpc_client(size_t client_index) override
+  {
+    auto &rpc_client = rpc_clients_[client_index];
+    auto &receiver_stats = static_cast<RpcHandler &>(*rpc_client.handler).receiver_stats;
+
+    rpc_client.handler.reset();
+    rpc_client.handler =
+        std::make_unique<RpcHandler>(index_, transform_builder_, rpc_client.client_type, client_index, receiver_stats);
+  }
+
   // Writes internal stats common to all core types.
   void write_common_stats(InternalMetricsEncoder &encoder, u64 time_ns);
 
   template <typename CoreStatsHandle> void write_common_stats_to_logging_core(CoreStatsHandle &internal_metrics, u64 time_ns);
 
   void dump_internal_state(std::chrono::milliseconds timestamp);
+
+  // Restores the core's index from the snapshot left by a previous run.
+  // Used by cores whose index survives restarts, from on_start().
+  void restore_index_snapshot();
+
+  // Writes the core's index snapshot and frees spans still held from the restore.
+  // Counterpart of restore_index_snapshot(), from on_stop().
+  void write_index_snapshot();
 };
 
 } // namespace reducer
@@ -59,6 +59,19 @@ void CoreBase<I, P, C, T>::write_common_stats(InternalMetricsEncoder &encoder, u
 
       encoder.write_internal_stats(stats, time_ns);
     });
+
+    if (virtual_clock_.max_lateness() > 0) {
+      RpcLateInputStats stats;
+      stats.labels.module = module;
+      stats.labels.shard = std::to_string(shard);
+      stats.labels.connection = std::to_string(conn);
+      stats.labels.peer = to_string(rpc_clients_[conn].client_type);
+      stats.metrics.late_messages = rpc_clients_[conn].late_messages;
+      stats.metrics.lag = virtual_clock_.lag(conn);
+      encoder.write_internal_stats(stats, time_ns);
+
+      rpc_clients_[conn].late_messages = 0;
+    }
   }
 
   StatusStats stats;
@@ -97,6 +110,20 @@ void CoreBase<I, P, C, T>::write_common_stats_to_logging_core(CoreStatsHandle &i
       internal_metrics.connection_message_error_stats(
           jb_blob(module), shard, conn, jb_blob(msg), jb_blob(error), count, time_ns);
     });
+
+    if (virtual_clock_.max_lateness() > 0) {
+      auto &rpc_client = rpc_clients_[conn];
+      internal_metrics.rpc_late_input_stats(
+          jb_blob(module),
+          shard,
+          conn,
+          jb_blob(to_string(rpc_client.client_type)),
+          rpc_client.late_messages,
+          virtual_clock_.lag(conn),
+          time_ns);
+
+      rpc_client.late_messages = 0;
+    }
   }
 
   std::stringstream ss;
@@ -107,7 +134,20 @@ void CoreBase<I, P, C, T>::write_common_stats_to_logging_core(CoreStatsHandle &i
 template <typename I, typename P, typename C, typename T>
 void CoreBase<I, P, C, T>::dump_internal_state(std::chrono::milliseconds timestamp)
 {
-  index_dumper_.dump(app_name(), shard_num(), index_, std::chrono::duration_cast<std::chrono::seconds>(timestamp));
+  auto const timestamp_s = std::chrono::duration_cast<std::chrono::seconds>(timestamp);
+  index_dumper_.dump(app_name(), shard_num(), index_, timestamp_s);
+  index_snapshotter_.tick(app_name(), shard_num(), index_, timestamp_s);
+}
+
+template <typename I, typename P, typename C, typename T> void CoreBase<I, P, C, T>::restore_index_snapshot()
+{
+  index_snapshotter_.restore(app_name(), shard_num(), index_);
+}
+
+template <typename I, typename P, typename C, typename T> void CoreBase<I, P, C, T>::write_index_snapshot()
+{
+  index_snapshotter_.write(app_name(), shard_num(), index_);
+  index_snapshotter_.release_restored();
 }
 
 } // namespace reducer
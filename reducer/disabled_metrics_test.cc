@@ -263,6 +263,7 @@ TEST(StringToMetricEnumTest, StringToDnsEnum)
   EXPECT_EQ(try_enum_from_string("dns.responses", DnsMetrics::unknown), DnsMetrics::responses);
   EXPECT_EQ(try_enum_from_string("dns.server.duration.average", DnsMetrics::unknown), DnsMetrics::server_duration_average);
   EXPECT_EQ(try_enum_from_string("dns.timeouts", DnsMetrics::unknown), DnsMetrics::timeouts);
+  EXPECT_EQ(try_enum_from_string("dns.client.duration", DnsMetrics::unknown), DnsMetrics::client_duration);
 
   EXPECT_EQ(try_enum_from_string("G4RBAgE!?", DnsMetrics::unknown), DnsMetrics::unknown);
 }
@@ -274,6 +275,7 @@ TEST(StringToMetricEnumTest, StringToHttpEnum)
   EXPECT_EQ(try_enum_from_string("http.client.duration.average", HttpMetrics::unknown), HttpMetrics::client_duration_average);
   EXPECT_EQ(try_enum_from_string("http.server.duration.average", HttpMetrics::unknown), HttpMetrics::server_duration_average);
   EXPECT_EQ(try_enum_from_string("http.status_code", HttpMetrics::unknown), HttpMetrics::status_code);
+  EXPECT_EQ(try_enum_from_string("http.client.duration", HttpMetrics::unknown), HttpMetrics::client_duration);
 
   EXPECT_EQ(try_enum_from_string("G4RBAgE!?", HttpMetrics::unknown), HttpMetrics::unknown);
 }
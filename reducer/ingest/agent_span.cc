@@ -363,12 +363,16 @@ void AgentSpan::map_ip_to_domain(in6_addr const &ip_addr, dns::dns_record const
 
   auto const addr = IPv6Address::from(ip_addr);
 
+  if (!ip_to_domain_) {
+    ip_to_domain_ = std::make_unique<dns_cache_type>();
+  }
+
   /* is the IP already in the LRU? */
-  auto *found = ip_to_domain_.find(addr);
+  auto *found = ip_to_domain_->find(addr);
   if (found != nullptr) {
     /* remove the old entry */
     LOG::trace_in(Component::agent, "reducer::AgentSpan::map_ip_to_domain - removing old entry");
-    ip_to_domain_.remove(addr);
+    ip_to_domain_->remove(addr);
   }
 
   if (rec.len == 0) {
@@ -376,12 +380,12 @@ void AgentSpan::map_ip_to_domain(in6_addr const &ip_addr, dns::dns_record const
   }
 
   /* insert */
-  auto *inserted = ip_to_domain_.insert(addr, rec);
+  auto *inserted = ip_to_domain_->insert(addr, rec);
   if (inserted == nullptr) {
     local_logger().failed_to_insert_dns_record();
   }
 
-  LOG::trace_in(Component::agent, "reducer::AgentSpan::map_ip_to_domain - LRU.size = {}", ip_to_domain_.size());
+  LOG::trace_in(Component::agent, "reducer::AgentSpan::map_ip_to_domain - LRU.size = {}", ip_to_domain_->size());
 }
 
 void AgentSpan::set_config_label_deprecated(
@@ -607,6 +611,13 @@ void AgentSpan::bpf_lost_samples(
   local_logger().agent_lost_events(msg->count, jb_blob(conn->client_hostname()));
 }
 
+void AgentSpan::shed_messages(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__shed_messages *msg)
+{
+  const auto conn = local_connection();
+
+  local_logger().agent_shed_messages(msg->lane, msg->count, jb_blob(conn->client_hostname()));
+}
+
 void AgentSpan::set_pod_new(
     std::string_view uid,
     std::string_view owner_name,
@@ -733,8 +744,12 @@ void AgentSpan::pod_resync(::ebpf_net::ingest::weak_refs::agent span_ref, u64 ti
 
 std::optional<std::string_view> AgentSpan::find_dns_for_ip(const IPv6Address &addr)
 {
+  if (!ip_to_domain_) {
+    return std::nullopt;
+  }
+
   /* is the IP already in the LRU? */
-  auto *found = ip_to_domain_.find(addr);
+  auto *found = ip_to_domain_->find(addr);
   if (found == nullptr) {
     return std::nullopt;
   }
@@ -29,6 +29,7 @@
 
 #include <chrono>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -94,13 +95,15 @@ public:
       ::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__public_to_private_ipv4 *msg);
   void metadata_complete(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__metadata_complete *msg);
   void bpf_lost_samples(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__bpf_lost_samples *msg);
+  void shed_messages(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__shed_messages *msg);
   void heartbeat(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__heartbeat *msg);
   void
   agent_resource_usage(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__agent_resource_usage *msg);
 
-  // Handlers for arriving k8s-collector messages. These will be broadcast to
-  // every agent, and the actual business logic will be performed in the
-  // `pod_*_internal` messages below.
+  // Handlers for k8s-collector messages. They are only received on the
+  // k8s-collector's own span, which keeps a handle on each pod's k8s_pod span
+  // (proxied to matching, where flows look pods up by uid), so pod churn costs
+  // the same however many agents are connected.
   void pod_new_legacy2(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__pod_new_legacy2 *msg);
   void pod_new_legacy(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__pod_new_legacy *msg);
   void pod_new_with_name(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__pod_new_with_name *msg);
@@ -116,14 +119,6 @@ public:
   void pod_delete(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__pod_delete *msg);
   void pod_resync(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__pod_resync *msg);
 
-  // Handlers for k8s-collector messages. These will be invoked via the visitor
-  // pattern on `TcpServer`.
-  void
-  pod_new_internal(std::string_view uid, std::string_view owner_name, std::string_view ns, uint32_t ip, bool is_host_network);
-  void pod_container_internal(uint64_t timestamp_ns, std::string_view uid, std::string_view container_id);
-  void pod_delete_internal(std::string_view uid);
-  void pod_resync_internal(uint64_t resync_count);
-
   void log_message(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__log_message *msg);
   void bpf_log(::ebpf_net::ingest::weak_refs::agent span_ref, u64 timestamp, jsrv_ingest__bpf_log *msg);
 
@@ -228,7 +223,9 @@ private:
   // handle updated in: pod_new(): adds elements pod_delete(): removes elements
   std::unordered_map<u64, ::ebpf_net::ingest::handles::k8s_pod> k8s_pods_;
 
-  dns_cache_type ip_to_domain_;
+  // Allocated on the first DNS response: it's large, and collectors other than
+  // the kernel collector never send any.
+  std::unique_ptr<dns_cache_type> ip_to_domain_;
 
   bool is_socket_steady_state_ = false;
 
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <reducer/constants.h>
+#include <reducer/ingest/flow_string_encoder.h>
 
 #include <jitbuf/jb.h>
 
@@ -44,14 +45,15 @@ public:
       return;
     }
 
-    flow.container_info(
-        (u8)side,
-        jb_blob(container.name()),
-        jb_blob(container.pod_name()),
-        jb_blob(container.role()),
-        jb_blob(container.version()),
-        jb_blob(container.ns()),
-        container.node_type());
+    FlowStringEncoder encode(flow);
+
+    u32 const name = encode(container.name());
+    u32 const pod_name = encode(container.pod_name());
+    u32 const role = encode(container.role());
+    u32 const version = encode(container.version());
+    u32 const ns = encode(container.ns());
+
+    flow.container_info_ids((u8)side, encode.dict(), name, pod_name, role, version, ns, container.node_type());
   }
 
 private:
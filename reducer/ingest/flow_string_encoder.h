@@ -0,0 +1,45 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <reducer/ingest/shared_state.h>
+#include <reducer/string_dictionaries.h>
+
+#include <jitbuf/jb.h>
+
+#include <generated/ebpf_net/ingest/weak_refs.h>
+
+#include <string_view>
+
+namespace reducer::ingest {
+
+// Encodes strings for the *_info_ids messages of a flow, in the dictionary of
+// the queue to the flow's matching shard.
+//
+// Strings the matching shard doesn't know yet are defined to it first, so
+// all strings of a message must be encoded before the message is sent.
+//
+class FlowStringEncoder {
+public:
+  explicit FlowStringEncoder(ebpf_net::ingest::weak_refs::flow flow)
+      : flow_(flow), dictionaries_(local_matching_string_dictionaries()), shard_(flow.shard_id())
+  {}
+
+  u32 operator()(std::string_view value)
+  {
+    return dictionaries_.encode(shard_, value, [&](u16 dict, u32 id) { flow_.define_string(dict, id, jb_blob(value)); });
+  }
+
+  // The dictionary id to send along with the encoded strings.
+  u16 dict() const { return dictionaries_.dict(); }
+
+private:
+  ebpf_net::ingest::weak_refs::flow flow_;
+  StringDictionaryWriters &dictionaries_;
+  u8 shard_;
+};
+
+} // namespace reducer::ingest
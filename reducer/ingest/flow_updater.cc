@@ -4,6 +4,7 @@
 #include "flow_updater.h"
 
 #include <reducer/ingest/component.h>
+#include <reducer/ingest/flow_string_encoder.h>
 #include <reducer/ingest/shared_state.h>
 
 #include <reducer/constants.h>
@@ -24,16 +25,6 @@ namespace reducer::ingest {
 
 namespace {
 
-template <size_t N> jb_blob jb(short_string<N> const &s)
-{
-  return {s.buf, s.len};
-}
-
-jb_blob jb(std::string const &s)
-{
-  return {s.c_str(), (u16)s.length()};
-}
-
 u32 reverse_connector(u32 connector)
 {
   switch (connector) {
@@ -115,6 +106,16 @@ void FlowUpdater::put_handles()
   agent_handle_.put(*local_index());
 }
 
+void FlowUpdater::send_task_info(::ebpf_net::ingest::weak_refs::flow flow, std::string_view comm, std::string_view cgroup_name)
+{
+  FlowStringEncoder encode(flow);
+
+  u32 const comm_id = encode(comm);
+  u32 const cgroup_name_id = encode(cgroup_name);
+
+  flow.task_info_ids((u8)side_, encode.dict(), comm_id, cgroup_name_id);
+}
+
 ::ebpf_net::ingest::weak_refs::flow FlowUpdater::create_flow()
 {
   u128 local_addr_int = local_addr_.as_int();
@@ -201,7 +202,7 @@ void FlowUpdater::put_handles()
     }
 
     // Send task information to flow.
-    flow.task_info((u8)side_, jb_blob(process.comm()), jb_blob(cgroup_name));
+    send_task_info(flow, process.comm(), cgroup_name);
 
     if (!service_name.empty()) {
       // Send service information, if any.
@@ -231,7 +232,15 @@ void FlowUpdater::put_handles()
     auto &agent = agent_ref.impl();
 
     // send agent information to flow
-    flow.agent_info((u8)side_, jb(agent.node_id()), jb(agent.node_az()), jb(agent.cluster()), jb(agent.role()), jb(agent.ns()));
+    FlowStringEncoder encode(flow);
+
+    u32 const id = encode(agent.node_id());
+    u32 const az = encode(agent.node_az());
+    u32 const env = encode(agent.cluster());
+    u32 const role = encode(agent.role());
+    u32 const ns = encode(agent.ns());
+
+    flow.agent_info_ids((u8)side_, encode.dict(), id, az, env, role, ns);
   }
 
   LOG::trace_in(
@@ -306,11 +315,11 @@ void FlowUpdater::put_handles()
   // info message again to ensure the matching core has the correct cgroup ID
   if ((side_ == FlowSide::SIDE_A) && proc1.valid() && proc1.cgroup_override().valid()) {
     auto cgroup = proc1.cgroup_override();
-    flow.task_info((u8)side_, jb(proc1.comm()), jb(cgroup.name()));
+    send_task_info(flow, proc1.comm(), cgroup.name());
   }
   if ((side_ == FlowSide::SIDE_B) && proc2.valid() && proc2.cgroup_override().valid()) {
     auto cgroup = proc2.cgroup_override();
-    flow.task_info((u8)side_, jb(proc2.comm()), jb(cgroup.name()));
+    send_task_info(flow, proc2.comm(), cgroup.name());
   }
 
   auto container1 = flow.container1_override().valid() ? flow.container1_override() : flow.container1();
@@ -16,6 +16,7 @@
 #include <util/ip_address.h>
 
 #include <optional>
+#include <string_view>
 
 namespace reducer::ingest {
 
@@ -115,6 +116,9 @@ private:
 
   // Puts all handles back to index.
   void put_handles();
+
+  // Sends the local side's task information to the flow span.
+  void send_task_info(::ebpf_net::ingest::weak_refs::flow flow, std::string_view comm, std::string_view cgroup_name);
 };
 
 } // namespace reducer::ingest
@@ -58,7 +58,10 @@ void IngestCore::on_stop_async(uv_async_t *handle)
 IngestCore::IngestCore(
     RpcQueueMatrix &ingest_to_logging_queues, RpcQueueMatrix &ingest_to_matching_queues, u32 telemetry_port, bool localhost)
 {
-  auto const ingest_shard_count = ingest_to_matching_queues.num_senders();
+  // when the reducer is scaled out, the queues also have senders for the
+  // ingest shards of other processes
+  auto const ingest_shards = ingest_to_matching_queues.local_senders();
+  auto const ingest_shard_count = ingest_shards.size();
   int res;
 
   res = uv_loop_init(&loop_);
@@ -78,12 +81,11 @@ IngestCore::IngestCore(
 
   std::vector<std::unique_ptr<IngestWorker>> workers;
   workers.reserve(ingest_shard_count);
-  for (uint32_t shard = 0; shard < ingest_shard_count; ++shard) {
+  for (auto const shard : ingest_shards) {
     workers.push_back(std::make_unique<IngestWorker>(ingest_to_logging_queues, ingest_to_matching_queues, shard));
   }
   tcp_server_.reset(new TcpServer(loop_, telemetry_port, localhost, std::move(workers)));
   index_dumper_.resize(ingest_shard_count);
-  TcpServer::singleton()->instance = tcp_server_.get();
 
   /* internal stats */
   /* initialize the internal stats timer */
@@ -119,10 +121,7 @@ IngestCore::IngestCore(
   connection_timeout_handler_->start(MESSAGE_TIMEOUT_CHECK_INTERVAL);
 }
 
-IngestCore::~IngestCore()
-{
-  TcpServer::singleton()->instance = nullptr;
-}
+IngestCore::~IngestCore() {}
 
 void IngestCore::run()
 {
@@ -360,6 +359,10 @@ void IngestCore::on_pulse_timer()
 {
   tcp_server_->visit_indexes(
       [&](const int shard, ::ebpf_net::ingest::Index *const index) { index->send_pulse(); }, false /* block */);
+
+  // when the reducer is scaled out, matching shards of other processes may
+  // have to start over (see RpcBridge)
+  tcp_server_->resync_matching();
 }
 
 void IngestCore::check_connection_timeouts()
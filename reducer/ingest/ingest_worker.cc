@@ -18,6 +18,7 @@
 #include <util/boot_time.h>
 #include <util/error_handling.h>
 #include <util/log.h>
+#include <util/lz4_decompressor.h>
 
 #include <absl/time/time.h>
 
@@ -29,18 +30,30 @@
 namespace reducer::ingest {
 
 IngestWorker::IngestWorker(RpcQueueMatrix &ingest_to_logging_queues, RpcQueueMatrix &ingest_to_matching_queues, u32 shard_num)
-    : ingest_to_logging_stats_(shard_num, "ingest", "logging", ingest_to_logging_queues),
+    : ingest_to_matching_queues_(ingest_to_matching_queues),
+      shard_num_(shard_num),
+      ingest_to_logging_stats_(shard_num, "ingest", "logging", ingest_to_logging_queues),
       ingest_to_matching_stats_(shard_num, "ingest", "matching", ingest_to_matching_queues),
       index_(std::make_unique<ebpf_net::ingest::Index>(
           ingest_to_logging_queues.make_writers<ebpf_net::logging::Writer>(shard_num, monotonic, get_boot_time()),
           ingest_to_matching_queues.make_writers<ebpf_net::matching::Writer>(shard_num, monotonic, get_boot_time()))),
       logger_(index_->logger.alloc()),
       core_stats_(index_->core_stats.alloc()),
-      ingest_core_stats_(index_->ingest_core_stats.alloc())
+      ingest_core_stats_(index_->ingest_core_stats.alloc()),
+      matching_string_dictionaries_(shard_num, ingest_to_matching_queues.num_receivers())
 {}
 
 IngestWorker::~IngestWorker() {}
 
+#if ENABLE_ZSTD
+ZstdDecompressor::Dictionary IngestWorker::zstd_dictionary_;
+
+void IngestWorker::set_zstd_dictionary(ZstdDecompressor::Dictionary dictionary)
+{
+  zstd_dictionary_ = std::move(dictionary);
+}
+#endif
+
 void IngestWorker::register_close_callback(OnCloseCallback on_close_cb)
 {
   on_close_cb_ = std::move(on_close_cb);
@@ -75,12 +88,36 @@ std::shared_ptr<absl::Notification> IngestWorker::visit_rpc_stats(RpcStatsCb cb)
   });
 }
 
+std::shared_ptr<absl::Notification> IngestWorker::resync_matching()
+{
+  return visit_thread([this] {
+    bool resynced = false;
+
+    for (size_t shard = 0; shard < ingest_to_matching_queues_.num_receivers(); ++shard) {
+      if (!ingest_to_matching_queues_.resync_requested(shard_num_, shard)) {
+        continue;
+      }
+
+      LOG::info("ingest-{}: starting over with matching shard {}", shard_num_, shard);
+
+      ingest_to_matching_queues_.write_resync_marker(shard_num_, shard);
+      matching_string_dictionaries_.reset(shard);
+      resynced = true;
+    }
+
+    if (resynced) {
+      close_connections();
+    }
+  });
+}
+
 void IngestWorker::on_thread_start()
 {
   set_local_index(index_.get());
   set_local_logger(&logger_);
   set_local_core_stats_handle(&core_stats_);
   set_local_ingest_core_stats_handle(&ingest_core_stats_);
+  set_local_matching_string_dictionaries(&matching_string_dictionaries_);
 }
 
 void IngestWorker::on_thread_stop()
@@ -89,6 +126,7 @@ void IngestWorker::on_thread_stop()
   set_local_logger(nullptr);
   set_local_core_stats_handle(nullptr);
   set_local_ingest_core_stats_handle(nullptr);
+  set_local_matching_string_dictionaries(nullptr);
   set_local_connection(nullptr);
 }
 
@@ -98,7 +136,7 @@ std::unique_ptr<::channel::Callbacks> IngestWorker::create_callbacks(uv_loop_t &
 }
 
 IngestWorker::Callbacks::Callbacks(IngestWorker *worker, channel::TCPChannel *channel)
-    : worker_(worker), channel_(channel), decompressor_(Worker::kBufferSize)
+    : worker_(worker), channel_(channel)
 {
   assert(local_index() == worker_->index_.get());
 
@@ -109,6 +147,17 @@ IngestWorker::Callbacks::Callbacks(IngestWorker *worker, channel::TCPChannel *ch
 
 IngestWorker::Callbacks::~Callbacks() {}
 
+std::unique_ptr<Decompressor> IngestWorker::Callbacks::make_decompressor(const u8 *data)
+{
+#if ENABLE_ZSTD
+  if (ZstdDecompressor::is_zstd_stream(data)) {
+    return std::make_unique<ZstdDecompressor>(Worker::kBufferSize, zstd_dictionary_);
+  }
+#endif
+
+  return std::make_unique<Lz4Decompressor>(Worker::kBufferSize);
+}
+
 uint32_t IngestWorker::Callbacks::received_data(const u8 *data, int data_len)
 {
   const u8 *begin = data;
@@ -144,16 +193,26 @@ uint32_t IngestWorker::Callbacks::received_data(const u8 *data, int data_len)
   // 1) The first message received (and whether or not compression is being
   //    used is being negotiated).
   // 2) This is a subsequent data message, and it is compressed.
+  if (!decompressor_) {
+#if ENABLE_ZSTD
+    // the codec is told by the magic number the compressed stream starts with
+    if (end - begin < static_cast<ptrdiff_t>(ZstdDecompressor::magic_size)) {
+      return begin - data;
+    }
+#endif
+    decompressor_ = make_decompressor(begin);
+  }
+
   size_t consumed_len = 0;
   do {
-    const size_t res = decompressor_.process(begin, end - begin, &consumed_len);
+    const size_t res = decompressor_->process(begin, end - begin, &consumed_len);
 
     // Check if decompression failed.
     if (res != 0) {
       local_logger().ingest_decompression_error(
           static_cast<u8>(connection_->client_type()),
           jb_blob(connection_->client_hostname()),
-          jb_blob(std::string_view(LZ4F_getErrorName(res))));
+          jb_blob(std::string_view(decompressor_->error_name(res))));
       channel_->close_permanently();
       return 0;
     }
@@ -163,7 +222,7 @@ uint32_t IngestWorker::Callbacks::received_data(const u8 *data, int data_len)
 
     ASSUME(decompressor_active_);
     const std::optional<uint32_t> consumed_uncompressed =
-        received_data_internal(decompressor_.output_buf(), decompressor_.output_buf_size());
+        received_data_internal(decompressor_->output_buf(), decompressor_->output_buf_size());
 
     // An error occurred, close.
     if (!consumed_uncompressed) {
@@ -172,7 +231,7 @@ uint32_t IngestWorker::Callbacks::received_data(const u8 *data, int data_len)
     }
 
     // Remove the handled bytes from decompression buffer.
-    decompressor_.discard(*consumed_uncompressed);
+    decompressor_->discard(*consumed_uncompressed);
     ++count;
 
     // * if we weren't able to decompress any bytes, can exit -- another
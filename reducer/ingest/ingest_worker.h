@@ -5,9 +5,12 @@
 
 #pragma once
 
+#include <config.h>
+
 #include "npm_connection.h"
 
 #include <reducer/rpc_stats.h>
+#include <reducer/string_dictionaries.h>
 #include <reducer/worker.h>
 
 #include <generated/ebpf_net/ingest/index.h>
@@ -17,7 +20,10 @@
 #include <channel/callbacks.h>
 
 #include <util/log.h>
-#include <util/lz4_decompressor.h>
+#include <util/decompressor.h>
+#if ENABLE_ZSTD
+#include <util/zstd_decompressor.h>
+#endif
 
 #include <absl/time/time.h>
 #include <uv.h>
@@ -44,6 +50,12 @@ public:
   IngestWorker(RpcQueueMatrix &ingest_to_logging_queues, RpcQueueMatrix &ingest_to_matching_queues, u32 shard_num);
   ~IngestWorker() override;
 
+#if ENABLE_ZSTD
+  // Sets the dictionary used to decompress zstd streams from collectors.
+  // Must be called before any worker thread starts.
+  static void set_zstd_dictionary(ZstdDecompressor::Dictionary dictionary);
+#endif
+
   // Registers a callback that will be invoked everytime a TCP connection
   // is closed. Overwrites the previous callback if this function has already
   // been called.
@@ -70,9 +82,15 @@ public:
     // the connection to close).
     std::optional<uint32_t> received_data_internal(const u8 *data, int data_len);
 
+    // Creates the decompressor for the codec of the stream starting at
+    // |data|, of at least ZstdDecompressor::magic_size bytes when built with
+    // zstd. Streams are always LZ4 otherwise.
+    static std::unique_ptr<Decompressor> make_decompressor(const u8 *data);
+
     IngestWorker *worker_;
     channel::TCPChannel *channel_;
-    Lz4Decompressor decompressor_;
+    // Created once the compressed stream starts.
+    std::unique_ptr<Decompressor> decompressor_;
 
     std::unique_ptr<NpmConnection> connection_;
 
@@ -100,6 +118,12 @@ public:
   using RpcStatsCb = std::function<void(RpcSenderStats &)>;
   std::shared_ptr<absl::Notification> visit_rpc_stats(RpcStatsCb cb);
 
+  // Starts over with the matching shards that asked for it (see
+  // RpcQueueMatrix::request_resync), in this worker's thread: they forget
+  // this worker's strings and spans, so the worker closes its connections
+  // for the collectors to reconnect and report their state again.
+  std::shared_ptr<absl::Notification> resync_matching();
+
 protected:
   void on_thread_start() override;
   void on_thread_stop() override;
@@ -108,12 +132,19 @@ protected:
 
 private:
   OnCloseCallback on_close_cb_;
+  RpcQueueMatrix &ingest_to_matching_queues_;
+  u32 shard_num_;
   RpcSenderStats ingest_to_logging_stats_;
   RpcSenderStats ingest_to_matching_stats_;
   std::unique_ptr<::ebpf_net::ingest::Index> index_;
   ::ebpf_net::ingest::auto_handles::logger logger_;
   ::ebpf_net::ingest::auto_handles::core_stats core_stats_;
   ::ebpf_net::ingest::auto_handles::ingest_core_stats ingest_core_stats_;
+  StringDictionaryWriters matching_string_dictionaries_;
+
+#if ENABLE_ZSTD
+  static ZstdDecompressor::Dictionary zstd_dictionary_;
+#endif
 
   friend class Callbacks;
 };
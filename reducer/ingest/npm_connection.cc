@@ -6,9 +6,15 @@
 namespace reducer::ingest {
 
 NpmConnection::NpmConnection(::ebpf_net::ingest::Index &index)
-    : transform_builder_(), protocol_(transform_builder_), connection_(protocol_, index), time_tracker_()
+    : protocol_(shared_transform_builder()), connection_(protocol_, index), time_tracker_()
 {}
 
+ebpf_net::ingest::TransformBuilder &NpmConnection::shared_transform_builder()
+{
+  static ebpf_net::ingest::TransformBuilder builder;
+  return builder;
+}
+
 int NpmConnection::handle(const char *msg, uint32_t len)
 {
   auto const handled = protocol_.handle(msg, len);
@@ -38,7 +38,10 @@ public:
   ClientType client_type() const { return client_type_; }
 
 private:
-  ebpf_net::ingest::TransformBuilder transform_builder_;
+  // Identity transforms are immutable once built, so a single builder is
+  // shared by all connections across ingest workers.
+  static ebpf_net::ingest::TransformBuilder &shared_transform_builder();
+
   ebpf_net::ingest::Protocol protocol_;
   ebpf_net::ingest::Connection connection_;
   TimeTracker time_tracker_;
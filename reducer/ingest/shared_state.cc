@@ -19,6 +19,7 @@ struct LocalState {
   ::ebpf_net::ingest::auto_handles::logger *logger = nullptr;
   ::ebpf_net::ingest::auto_handles::core_stats *core_stats = nullptr;
   ::ebpf_net::ingest::auto_handles::ingest_core_stats *ingest_core_stats = nullptr;
+  StringDictionaryWriters *matching_string_dictionaries = nullptr;
 };
 
 GlobalState *global_state()
@@ -70,6 +71,12 @@ NpmConnection *local_connection()
   return *(local_state()->ingest_core_stats);
 }
 
+StringDictionaryWriters &local_matching_string_dictionaries()
+{
+  assert(local_state()->matching_string_dictionaries != nullptr);
+  return *(local_state()->matching_string_dictionaries);
+}
+
 void set_local_index(::ebpf_net::ingest::Index *const index)
 {
   local_state()->index = index;
@@ -95,4 +102,9 @@ void set_local_ingest_core_stats_handle(::ebpf_net::ingest::auto_handles::ingest
   local_state()->ingest_core_stats = ingest_core_stats;
 }
 
+void set_local_matching_string_dictionaries(StringDictionaryWriters *dictionaries)
+{
+  local_state()->matching_string_dictionaries = dictionaries;
+}
+
 } // namespace reducer::ingest
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <reducer/ingest/npm_connection.h>
+#include <reducer/string_dictionaries.h>
 #include <reducer/thread_safe_map.h>
 
 #include <generated/ebpf_net/ingest/index.h>
@@ -32,6 +33,8 @@ NpmConnection *local_connection();
 ::ebpf_net::ingest::weak_refs::logger local_logger();
 ::ebpf_net::ingest::weak_refs::core_stats local_core_stats_handle();
 ::ebpf_net::ingest::weak_refs::ingest_core_stats local_ingest_core_stats_handle();
+// Dictionaries of strings sent to the matching cores, by matching shard.
+StringDictionaryWriters &local_matching_string_dictionaries();
 
 // Setters for the above values.
 void set_local_index(::ebpf_net::ingest::Index *index);
@@ -39,5 +42,6 @@ void set_local_connection(NpmConnection *connection);
 void set_local_logger(::ebpf_net::ingest::auto_handles::logger *logger);
 void set_local_core_stats_handle(::ebpf_net::ingest::auto_handles::core_stats *core_stats);
 void set_local_ingest_core_stats_handle(::ebpf_net::ingest::auto_handles::ingest_core_stats *ingest_core_stats);
+void set_local_matching_string_dictionaries(StringDictionaryWriters *dictionaries);
 
 } // namespace reducer::ingest
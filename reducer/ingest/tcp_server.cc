@@ -110,10 +110,9 @@ void TcpServer::visit_rpc_stats(const RpcStatsCb &cb, const bool block)
       block);
 }
 
-TcpServer::Singleton *TcpServer::singleton()
+void TcpServer::resync_matching()
 {
-  static auto *const value = new Singleton;
-  return value;
+  visit_internal([](const int, IngestWorker *const worker) { return worker->resync_matching(); }, false /* block */);
 }
 
 void TcpServer::on_new_connection()
@@ -63,30 +63,11 @@ public:
   using RpcStatsCb = std::function<void(int, RpcSenderStats &)>;
   void visit_rpc_stats(const RpcStatsCb &cb, bool block);
 
-  std::size_t workers_count() const { return workers_.size(); }
-
-  // Global accessor for the TcpSever. Used by classes who want use the
-  // `visit_*` functions but do not have direct access to a `TcpSever` instance
-  // for whatever reason (e.g. render-instantiated `*Span` classes).
-  // It is the caller's responsibility to make sure that `instance` has already
-  // been set to a valid value before using it.
-  struct Singleton {
-  private:
-    // Classes are given whitelisted access. Global variables are generally an
-    // antipattern, and therefore this list should only be extended if there is
-    // no other reasonable alternative.
-
-    // Classes that set `instance`.
-    friend class IngestCore;
-    friend class TestServer; // Used in agent_span_pod_test.cc
-
-    // Classes that read `instance`.
-    friend class AgentSpan;
-
-    TcpServer *instance = nullptr;
-  };
+  // Has each worker start over with the matching shards that asked for it,
+  // see IngestWorker::resync_matching. Doesn't wait for the workers.
+  void resync_matching();
 
-  static Singleton *singleton();
+  std::size_t workers_count() const { return workers_.size(); }
 
 private:
   // libuv callback invoked when a new conneciton arrives.
@@ -11,6 +11,7 @@
 
 #include <util/log.h>
 
+#include <algorithm>
 #include <cstring>
 
 namespace reducer::ingest {
@@ -123,6 +124,7 @@ void UdpSocketSpan::dns_response_dep_b(
   newmsg.ipv4_addrs = msg->ipv4_addrs;
   newmsg.ipv6_addrs = msg->ipv6_addrs;
   newmsg.latency_ns = msg->latency_ns;
+  newmsg.weight = 1;
 
   // for older agents, just key client_server off of port 53 (like old is_dns_rx)
   newmsg.client_server = (u8)((local_port_ == kPortDNS) ? SC_SERVER : SC_CLIENT);
@@ -161,6 +163,9 @@ void UdpSocketSpan::dns_response(
 
   agent.map_ips_to_domain(ipv4_addrs, num_ipv4_addrs, ipv6_addrs, num_ipv6_addrs, domain_name);
 
+  // collectors that don't sample DNS leave the weight out
+  u32 const weight = std::max(msg->weight, 1u);
+
   // Update DNS stats.
   const enum CLIENT_SERVER_TYPE client_server = (const enum CLIENT_SERVER_TYPE)msg->client_server;
   update_dns_stats(
@@ -169,13 +174,14 @@ void UdpSocketSpan::dns_response(
       client_server,
       ::ebpf_net::metrics::dns_metrics_point{
           .active_sockets = 1,
-          .requests_a = (num_ipv4_addrs > 0),
-          .requests_aaaa = (num_ipv6_addrs > 0),
-          .responses = 1,
+          .requests_a = (num_ipv4_addrs > 0) * weight,
+          .requests_aaaa = (num_ipv6_addrs > 0) * weight,
+          .responses = weight,
           .timeouts = 0,
-          .sum_total_time_ns = (client_server == SC_CLIENT) ? msg->latency_ns : 0, // client latency contributes to total time
-          .sum_processing_time_ns =
-              (client_server == SC_SERVER) ? msg->latency_ns : 0 // server latency contributes to processing time
+          // client latency contributes to total time
+          .sum_total_time_ns = (client_server == SC_CLIENT) ? msg->latency_ns * weight : 0,
+          // server latency contributes to processing time
+          .sum_processing_time_ns = (client_server == SC_SERVER) ? msg->latency_ns * weight : 0
       },
       false);
 }
@@ -202,7 +208,7 @@ void UdpSocketSpan::dns_timeout(
           .requests_a = 0,
           .requests_aaaa = 0,
           .responses = 0,
-          .timeouts = 1,
+          .timeouts = std::max(msg->weight, 1u),
           .sum_total_time_ns = 0,     // timeout duration does not contribute here
           .sum_processing_time_ns = 0 // timeout duration does not contribute here
       },
@@ -203,6 +203,19 @@ struct AggPrometheusBytesStats {
   END_METRICS
 };
 
+struct AggCardinalityStats {
+  BEGIN_LABELS
+  COMMON_LABELS
+  LABEL(aggregation)
+  END_LABELS
+
+  BEGIN_METRICS
+  METRIC(EbpfNetMetricInfo::aggregation_series, series)
+  METRIC(EbpfNetMetricInfo::aggregation_series_folded, folded)
+  METRIC(EbpfNetMetricInfo::aggregation_series_evicted, evicted)
+  END_METRICS
+};
+
 struct CodeTimingStats {
   BEGIN_LABELS
   LABEL(name)
@@ -445,6 +458,19 @@ struct RpcLatencyStats {
   END_METRICS
 };
 
+struct RpcLateInputStats {
+  BEGIN_LABELS
+  COMMON_LABELS
+  LABEL(connection)
+  LABEL(peer)
+  END_LABELS
+
+  BEGIN_METRICS
+  METRIC(EbpfNetMetricInfo::rpc_late_messages, late_messages)
+  METRIC(EbpfNetMetricInfo::rpc_input_lag, lag)
+  END_METRICS
+};
+
 #undef BEGIN_LABELS
 #undef END_LABELS
 #undef LABEL
@@ -0,0 +1,256 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <reducer/ip_enrichment.h>
+
+#include <geoip/geoip.h>
+#include <util/log.h>
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/string_view.h>
+#include <absl/strings/str_split.h>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <fstream>
+#include <system_error>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace reducer {
+
+namespace {
+
+constexpr u8 kV4MappedLen = 96;
+
+struct Cidr {
+  u128 prefix;
+  u8 len;
+};
+
+// Parses `<address>[/<length>]`, IPv4 or IPv6. IPv4 ranges are returned as
+// IPv4-mapped IPv6 ranges.
+std::optional<Cidr> parse_cidr(absl::string_view text)
+{
+  std::vector<absl::string_view> parts = absl::StrSplit(text, '/');
+  if (parts.size() > 2) {
+    return std::nullopt;
+  }
+
+  std::string const address(parts[0]);
+
+  Cidr cidr;
+  u8 max_len;
+  if (auto ipv4 = IPv4Address::parse(address.c_str())) {
+    cidr.prefix = ipv4->to_ipv6().as_int();
+    max_len = 32;
+  } else if (auto ipv6 = IPv6Address::parse(address.c_str())) {
+    cidr.prefix = ipv6->as_int();
+    max_len = 128;
+  } else {
+    return std::nullopt;
+  }
+
+  u32 len = max_len;
+  if (parts.size() == 2 && (!absl::SimpleAtoi(parts[1], &len) || len > max_len)) {
+    return std::nullopt;
+  }
+
+  cidr.len = (max_len == 32) ? kV4MappedLen + len : len;
+  return cidr;
+}
+
+} // namespace
+
+size_t IpEnrichment::memory_usage() const
+{
+  size_t usage = table_.memory_usage() + labels_.capacity() * sizeof(IpLabels);
+  for (auto const &labels : labels_) {
+    usage += labels.role.capacity() + labels.az.capacity() + labels.id.capacity() + labels.autonomous_system.capacity();
+  }
+  return usage;
+}
+
+size_t IpEnrichment::Builder::add_geoip(geoip::database &db)
+{
+  size_t count = 0;
+
+  bool const valid = db.foreach_network([&](in6_addr const &network, unsigned prefix_length, geoip::address_entry &entry) {
+    std::string organization;
+    if (!geoip::well_known_data::try_autonomous_system_organization(organization, entry)) {
+      return;
+    }
+
+    auto [it, inserted] = autonomous_systems_.try_emplace(organization, labels_.size());
+    if (inserted) {
+      labels_.push_back(IpLabels{.autonomous_system = std::move(organization)});
+    }
+
+    ranges_.add_v6(network.s6_addr, prefix_length, it->second);
+    ++count;
+  });
+
+  if (!valid) {
+    throw std::runtime_error("corrupt GeoIP database search tree");
+  }
+
+  return count;
+}
+
+size_t IpEnrichment::Builder::add_ip_labels(std::istream &in)
+{
+  size_t count = 0;
+
+  std::string line;
+  for (size_t line_number = 1; std::getline(in, line); ++line_number) {
+    auto const text = absl::StripAsciiWhitespace(line);
+    if (text.empty() || text.front() == '#') {
+      continue;
+    }
+
+    std::vector<absl::string_view> fields = absl::StrSplit(text, ',');
+    for (auto &field : fields) {
+      field = absl::StripAsciiWhitespace(field);
+    }
+
+    if (fields.size() < 2 || fields.size() > 4 || fields[1].empty()) {
+      throw std::runtime_error(fmt::format("line {}: expected '<cidr>,<role>[,<az>[,<id>]]'", line_number));
+    }
+
+    auto cidr = parse_cidr(fields[0]);
+    if (!cidr) {
+      throw std::runtime_error(fmt::format("line {}: invalid CIDR '{}'", line_number, std::string(fields[0])));
+    }
+
+    IpLabels labels{.role = std::string(fields[1])};
+    if (fields.size() > 2) {
+      labels.az = std::string(fields[2]);
+    }
+    if (fields.size() > 3) {
+      labels.id = std::string(fields[3]);
+    }
+
+    ip_labels_ranges_.push_back(Range{.prefix = cidr->prefix, .len = cidr->len, .labels = u32(labels_.size())});
+    labels_.push_back(std::move(labels));
+    ++count;
+  }
+
+  if (in.bad()) {
+    throw std::runtime_error("failed to read IP labels");
+  }
+
+  return count;
+}
+
+size_t IpEnrichment::Builder::add_ip_labels(std::string const &path)
+{
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error(fmt::format("unable to open '{}'", path));
+  }
+
+  try {
+    return add_ip_labels(in);
+  } catch (std::runtime_error const &e) {
+    throw std::runtime_error(fmt::format("{}: {}", path, e.what()));
+  }
+}
+
+std::shared_ptr<IpEnrichment const> IpEnrichment::Builder::build()
+{
+  for (auto const &range : ip_labels_ranges_) {
+    ranges_.add_v6(range.prefix, range.len, range.labels);
+  }
+  ip_labels_ranges_.clear();
+
+  auto enrichment = std::make_shared<IpEnrichment>();
+  enrichment->table_ = ranges_.build();
+  enrichment->labels_ = labels_;
+  return enrichment;
+}
+
+IpEnrichmentLoader::IpEnrichmentLoader(std::optional<std::string> geoip_path, std::optional<std::string> ip_labels_path)
+    : geoip_path_(std::move(geoip_path)), ip_labels_path_(std::move(ip_labels_path))
+{}
+
+std::optional<IpEnrichmentLoader::FileStamp> IpEnrichmentLoader::stamp(std::optional<std::string> const &path)
+{
+  if (!path) {
+    return std::nullopt;
+  }
+
+  std::error_code ec;
+  FileStamp stamp;
+  stamp.mtime = std::filesystem::last_write_time(*path, ec);
+  if (!ec) {
+    stamp.size = std::filesystem::file_size(*path, ec);
+  }
+  if (ec) {
+    return std::nullopt;
+  }
+
+  return stamp;
+}
+
+bool IpEnrichmentLoader::reload_if_changed()
+{
+  if (!enabled()) {
+    return false;
+  }
+
+  auto geoip_stamp = stamp(geoip_path_);
+  auto ip_labels_stamp = stamp(ip_labels_path_);
+  if (loaded_ && geoip_stamp == geoip_stamp_ && ip_labels_stamp == ip_labels_stamp_) {
+    return false;
+  }
+
+  // Remember what was seen even if loading fails, so a broken file is retried
+  // once it changes again rather than on every call.
+  geoip_stamp_ = geoip_stamp;
+  ip_labels_stamp_ = ip_labels_stamp;
+
+  bool const reloading = loaded_;
+  loaded_ = true;
+
+  IpEnrichment::Builder builder;
+  bool failed = false;
+
+  if (geoip_path_) {
+    try {
+      geoip::database geoip_db(geoip_path_->c_str());
+      auto const count = builder.add_geoip(geoip_db);
+      LOG::info("Loaded {} networks from GeoIP database '{}'.", count, *geoip_path_);
+    } catch (std::exception &exc) {
+      LOG::error("Failed to load GeoIP database from '{}': {}.", *geoip_path_, exc.what());
+      failed = true;
+    }
+  }
+
+  if (ip_labels_path_) {
+    try {
+      auto const count = builder.add_ip_labels(*ip_labels_path_);
+      LOG::info("Loaded {} IP ranges from '{}'.", count, *ip_labels_path_);
+    } catch (std::exception &exc) {
+      LOG::error("Failed to load IP labels: {}.", exc.what());
+      failed = true;
+    }
+  }
+
+  // On startup, go with whatever did load; afterwards, a partial table would
+  // drop labels that are currently in use.
+  if (failed && reloading) {
+    LOG::warn("Keeping the previous IP enrichment table.");
+    return false;
+  }
+
+  auto enrichment = builder.build();
+  LOG::info("IP enrichment table: {} ranges, {} bytes.", enrichment->size(), enrichment->memory_usage());
+
+  std::atomic_store(&current_, std::shared_ptr<IpEnrichment const>(std::move(enrichment)));
+  version_.fetch_add(1, std::memory_order_release);
+  return true;
+}
+
+} // namespace reducer
@@ -0,0 +1,155 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <util/ip_address.h>
+#include <util/ip_prefix_table.h>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <atomic>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace geoip {
+struct database;
+}
+
+namespace reducer {
+
+// Labels of a range of IP addresses.
+struct IpLabels {
+  // Node labels, for ranges from an IP labels file.
+  std::string role;
+  std::string az;
+  std::string id;
+
+  // Organization of the autonomous system the range belongs to, for ranges
+  // from a GeoIP ASN database.
+  std::string autonomous_system;
+};
+
+// Longest-prefix-match table of the labels of IP address ranges.
+//
+// The table is built once, from a GeoIP ASN database and from an IP labels
+// file, and is then shared read-only by all matching cores. The most specific
+// range containing an address wins; ranges from the IP labels file win over
+// GeoIP ranges of the same size.
+//
+// IP labels files have one range per line, as `<cidr>,<role>[,<az>[,<id>]]`,
+// e.g. `10.1.0.0/16,payments-vpc,us-east-1a`. Blank lines and lines starting
+// with `#` are ignored. A bare address is a range of one address.
+//
+class IpEnrichment {
+public:
+  class Builder;
+
+  // Returns the labels of the most specific range containing |addr|, or
+  // nullptr if no range contains it.
+  IpLabels const *lookup(IPv6Address const &addr) const
+  {
+    auto index = table_.lookup_v6(addr.as_int());
+    return index ? &labels_[*index] : nullptr;
+  }
+
+  // Number of ranges in the table.
+  size_t size() const { return table_.v4_prefixes() + table_.v6_prefixes(); }
+
+  // Bytes of memory held by the table and the labels.
+  size_t memory_usage() const;
+
+private:
+  IpPrefixTable table_;
+  std::vector<IpLabels> labels_;
+};
+
+class IpEnrichment::Builder {
+public:
+  // Adds the networks of a GeoIP ASN database that have an autonomous system
+  // organization. Returns the number of networks added.
+  //
+  // Throws std::runtime_error if the database is corrupt.
+  size_t add_geoip(geoip::database &db);
+
+  // Adds the ranges of an IP labels file. Returns the number of ranges added.
+  //
+  // Throws std::runtime_error, naming the offending line, if the file is
+  // malformed.
+  size_t add_ip_labels(std::istream &in);
+
+  // Same as above, reading the file at |path|.
+  size_t add_ip_labels(std::string const &path);
+
+  std::shared_ptr<IpEnrichment const> build();
+
+private:
+  struct Range {
+    u128 prefix;
+    u8 len;
+    u32 labels;
+  };
+
+  IpPrefixTable::Builder ranges_;
+  // IP labels ranges, added to ranges_ last so they win over GeoIP ranges of
+  // the same size.
+  std::vector<Range> ip_labels_ranges_;
+
+  std::vector<IpLabels> labels_;
+  // Index of the labels of each autonomous system organization.
+  absl::flat_hash_map<std::string, u32> autonomous_systems_;
+};
+
+// Builds the IP enrichment table from a GeoIP ASN database and an IP labels
+// file, and rebuilds it when either file changes.
+//
+// Reloading is done by one thread, while matching cores pick up the current
+// table with current(). A reload that fails keeps the previous table.
+//
+class IpEnrichmentLoader {
+public:
+  IpEnrichmentLoader(std::optional<std::string> geoip_path, std::optional<std::string> ip_labels_path);
+
+  // Whether there are any files to load the table from.
+  bool enabled() const { return geoip_path_ || ip_labels_path_; }
+
+  // (Re)builds the table if it was never built or if any of the files changed
+  // since it was last built. Returns whether a new table was built.
+  bool reload_if_changed();
+
+  // Returns the current table, or nullptr if there's none.
+  std::shared_ptr<IpEnrichment const> current() const { return std::atomic_load(&current_); }
+
+  // Incremented each time a new table is built.
+  u64 version() const { return version_.load(std::memory_order_acquire); }
+
+private:
+  // Last modification time and size of a file.
+  struct FileStamp {
+    std::filesystem::file_time_type mtime;
+    std::uintmax_t size = 0;
+
+    bool operator==(FileStamp const &other) const { return mtime == other.mtime && size == other.size; }
+  };
+
+  static std::optional<FileStamp> stamp(std::optional<std::string> const &path);
+
+  std::optional<std::string> const geoip_path_;
+  std::optional<std::string> const ip_labels_path_;
+
+  // Stamps of the files the current table was built from.
+  std::optional<FileStamp> geoip_stamp_;
+  std::optional<FileStamp> ip_labels_stamp_;
+  bool loaded_ = false;
+
+  std::shared_ptr<IpEnrichment const> current_;
+  std::atomic<u64> version_ = 0;
+};
+
+} // namespace reducer
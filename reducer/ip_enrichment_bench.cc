@@ -0,0 +1,276 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+// Lookup benchmark: autonomous system lookups through the shared IpEnrichment
+// table vs. through a per-shard geoip::database, as FlowSpan does them, and
+// whether a per-shard LRU of lookup results in front of the table pays off
+// when remote addresses repeat the way they do in real traffic.
+//
+// Not part of the unit test suite; run manually:
+//   GEOIP_PATH=/usr/share/GeoIP/GeoLite2-ASN.mmdb ip_enrichment_bench [--gtest_filter=...]
+//
+// The GeoIP comparison is skipped if GEOIP_PATH is not set. The number of
+// lookups defaults to 4M and can be overridden with the
+// IP_ENRICHMENT_BENCH_LOOKUPS environment variable.
+
+#include <reducer/ip_enrichment.h>
+
+#include <geoip/geoip.h>
+#include <util/LRU.h>
+
+#include <absl/hash/hash.h>
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace reducer {
+
+namespace {
+
+constexpr size_t default_num_lookups = 4'000'000;
+
+size_t num_lookups()
+{
+  if (char const *env = getenv("IP_ENRICHMENT_BENCH_LOOKUPS")) {
+    return strtoull(env, nullptr, 10);
+  }
+  return default_num_lookups;
+}
+
+// Remote addresses of flows: mostly public IPv4, some IPv6.
+std::vector<IPv6Address> make_addresses(size_t n)
+{
+  std::vector<IPv6Address> addresses;
+  addresses.reserve(n);
+
+  u64 seed = 1;
+  for (size_t i = 0; i < n; ++i) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    if (i % 8) {
+      addresses.push_back(IPv4Address::from(u32(seed >> 32)).to_ipv6());
+    } else {
+      // 2000::/4, global unicast
+      std::array<u16, 8> hextets = {u16(0x2000 | ((seed >> 48) & 0x0fff)), u16(seed >> 32), u16(seed >> 16), 0, 0, 0, 0, 1};
+      addresses.push_back(IPv6Address::from_host_hextets(hextets));
+    }
+  }
+
+  return addresses;
+}
+
+// Lookups into a population of |distinct| addresses, where the k-th most
+// frequent address is picked with probability proportional to 1/k (Zipf).
+std::vector<IPv6Address> make_zipf_lookups(size_t n, size_t distinct)
+{
+  auto const population = make_addresses(distinct);
+
+  std::vector<double> cdf(distinct);
+  double sum = 0;
+  for (size_t k = 0; k < distinct; ++k) {
+    sum += 1.0 / (k + 1);
+    cdf[k] = sum;
+  }
+
+  std::vector<IPv6Address> lookups;
+  lookups.reserve(n);
+
+  u64 seed = 7;
+  for (size_t i = 0; i < n; ++i) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    double const u = double(seed >> 11) / double(1ull << 53) * sum;
+    auto const k = std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+    lookups.push_back(population[std::min(size_t(k), distinct - 1)]);
+  }
+
+  return lookups;
+}
+
+double ns_per_lookup(std::chrono::steady_clock::duration elapsed, size_t n)
+{
+  return std::chrono::duration<double, std::nano>(elapsed).count() / n;
+}
+
+} // namespace
+
+TEST(IpEnrichmentBench, SyntheticIpLabels)
+{
+  // one range per /24 of a 10.0.0.0/12 network, plus some /16s around them
+  std::string file;
+  for (u32 i = 0; i < (1 << 12); ++i) {
+    file += fmt::format("10.{}.{}.0/24,role-{},az-{}\n", i >> 8, i & 0xff, i % 300, i % 6);
+  }
+  for (u32 i = 0; i < 256; ++i) {
+    file += fmt::format("172.{}.0.0/16,net-{}\n", i, i);
+  }
+
+  std::istringstream in(file);
+  IpEnrichment::Builder builder;
+  builder.add_ip_labels(in);
+  auto const enrichment = builder.build();
+
+  size_t const n = num_lookups();
+  auto const addresses = make_addresses(n);
+
+  size_t found = 0;
+  auto const start = std::chrono::steady_clock::now();
+  for (auto const &address : addresses) {
+    found += enrichment->lookup(address) != nullptr;
+  }
+  auto const elapsed = std::chrono::steady_clock::now() - start;
+
+  printf(
+      "%-16s ranges=%zu  memory=%6.1f MB  lookup=%5.1f ns  (%zu found)\n",
+      "IpEnrichment",
+      enrichment->size(),
+      enrichment->memory_usage() / 1e6,
+      ns_per_lookup(elapsed, n),
+      found);
+}
+
+// Checks whether caching lookup results per shard beats looking them up in the
+// shared table every time.
+TEST(IpEnrichmentBench, ZipfReuseWithShardCache)
+{
+  // a table about the size of a GeoLite2 ASN database: ~400k IPv4 ranges
+  // between /16 and /24, and some IPv6 ones
+  IpEnrichment::Builder builder;
+  std::string file;
+  u64 seed = 3;
+  for (u32 i = 0; i < 400'000; ++i) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    u32 const len = 16 + (seed >> 60) % 9;
+    u32 const prefix = u32(seed >> 32) & ~((1u << (32 - len)) - 1);
+    file += fmt::format("{}/{},as-{}\n", IPv4Address::from(htonl(prefix)).str(), len, i % 60'000);
+  }
+  for (u32 i = 0; i < 40'000; ++i) {
+    file += fmt::format("2{:03x}:{:x}::/32,as6-{}\n", i >> 16 & 0xfff, i & 0xffff, i);
+  }
+  std::istringstream in(file);
+  builder.add_ip_labels(in);
+  auto const enrichment = builder.build();
+
+  size_t const n = num_lookups();
+  auto const lookups = make_zipf_lookups(n, 50'000);
+
+  auto const direct_start = std::chrono::steady_clock::now();
+  size_t direct_found = 0;
+  for (auto const &address : lookups) {
+    direct_found += enrichment->lookup(address) != nullptr;
+  }
+  auto const direct_elapsed = std::chrono::steady_clock::now() - direct_start;
+
+  printf(
+      "%-16s memory=%6.1f MB  lookup=%5.1f ns  (%zu found)\n",
+      "IpEnrichment",
+      enrichment->memory_usage() / 1e6,
+      ns_per_lookup(direct_elapsed, n),
+      direct_found);
+
+  auto const cached = [&](auto &cache, char const *name) {
+    size_t hits = 0;
+    size_t found = 0;
+    auto const start = std::chrono::steady_clock::now();
+    for (auto const &address : lookups) {
+      IpLabels const *labels;
+      if (auto entry = cache.find(address)) {
+        labels = *entry;
+        ++hits;
+      } else {
+        labels = enrichment->lookup(address);
+        cache.insert(address, labels);
+      }
+      found += labels != nullptr;
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(direct_found, found);
+    printf(
+        "%-16s hit=%5.1f%%                  lookup=%5.1f ns\n", name, 100.0 * hits / n, ns_per_lookup(elapsed, n));
+  };
+
+  using SmallCache = LRU<IPv6Address, IpLabels const *, 1024, absl::Hash<IPv6Address>>;
+  using LargeCache = LRU<IPv6Address, IpLabels const *, 16384, absl::Hash<IPv6Address>>;
+  auto small_cache = std::make_unique<SmallCache>();
+  auto large_cache = std::make_unique<LargeCache>();
+  cached(*small_cache, "LRU(1024)");
+  cached(*large_cache, "LRU(16384)");
+}
+
+TEST(IpEnrichmentBench, GeoIpAutonomousSystems)
+{
+  char const *path = getenv("GEOIP_PATH");
+  if (!path || !*path) {
+    GTEST_SKIP() << "GEOIP_PATH not set";
+  }
+
+  size_t const n = num_lookups();
+  auto const addresses = make_addresses(n);
+
+  geoip::database db(path);
+
+  struct stat file_stat = {};
+  ASSERT_EQ(0, stat(path, &file_stat));
+
+  auto const build_start = std::chrono::steady_clock::now();
+  IpEnrichment::Builder builder;
+  builder.add_geoip(db);
+  auto const enrichment = builder.build();
+  auto const build_elapsed = std::chrono::steady_clock::now() - build_start;
+
+  // what FlowSpan::get_id_az used to do with each matching shard's database
+  std::vector<std::string> db_results(n);
+  auto const db_start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; ++i) {
+    if (auto entry = db.lookup(reinterpret_cast<in6_addr const *>(&addresses[i]))) {
+      geoip::well_known_data::try_autonomous_system_organization(db_results[i], entry);
+    }
+  }
+  auto const db_elapsed = std::chrono::steady_clock::now() - db_start;
+
+  std::vector<IpLabels const *> table_results(n);
+  auto const table_start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; ++i) {
+    table_results[i] = enrichment->lookup(addresses[i]);
+  }
+  auto const table_elapsed = std::chrono::steady_clock::now() - table_start;
+
+  size_t found = 0;
+  size_t mismatches = 0;
+  for (size_t i = 0; i < n; ++i) {
+    auto const &expected = db_results[i];
+    auto const *labels = table_results[i];
+    found += !expected.empty();
+    mismatches += expected != (labels ? labels->autonomous_system : std::string());
+  }
+  EXPECT_EQ(0u, mismatches);
+
+  printf(
+      "%-16s mapped=%6.1f MB per shard              lookup=%5.1f ns  (%zu found)\n",
+      "geoip::database",
+      file_stat.st_size / 1e6,
+      ns_per_lookup(db_elapsed, n),
+      found);
+  printf(
+      "%-16s memory=%6.1f MB shared  build=%5.0f ms  lookup=%5.1f ns  (%zu ranges)\n",
+      "IpEnrichment",
+      enrichment->memory_usage() / 1e6,
+      std::chrono::duration<double, std::milli>(build_elapsed).count(),
+      ns_per_lookup(table_elapsed, n),
+      enrichment->size());
+}
+
+} // namespace reducer
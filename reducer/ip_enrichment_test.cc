@@ -0,0 +1,130 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ip_enrichment.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace reducer {
+
+namespace {
+
+IPv6Address address(char const *text)
+{
+  if (auto ipv4 = IPv4Address::parse(text)) {
+    return ipv4->to_ipv6();
+  }
+  return IPv6Address::parse(text).value();
+}
+
+void write_file(std::filesystem::path const &path, char const *text)
+{
+  // write then rename, like a deployment replacing the file would
+  auto const temp = path.string() + ".tmp";
+  std::ofstream(temp) << text;
+  std::filesystem::rename(temp, path);
+}
+
+} // namespace
+
+TEST(IpEnrichmentTest, IpLabelsFile)
+{
+  std::istringstream file(R"(
+# cidr,role,az,id
+10.0.0.0/8, corp
+10.1.0.0/16,payments,us-east-1a
+10.1.2.3,payments-db,us-east-1a,db-primary
+
+2001:db8::/32,edge,,pop-1
+)");
+
+  IpEnrichment::Builder builder;
+  EXPECT_EQ(4u, builder.add_ip_labels(file));
+  auto enrichment = builder.build();
+
+  EXPECT_EQ(4u, enrichment->size());
+  EXPECT_EQ(nullptr, enrichment->lookup(address("192.168.1.1")));
+
+  auto labels = enrichment->lookup(address("10.200.0.1"));
+  ASSERT_NE(nullptr, labels);
+  EXPECT_EQ("corp", labels->role);
+  EXPECT_EQ("", labels->az);
+
+  labels = enrichment->lookup(address("10.1.2.4"));
+  ASSERT_NE(nullptr, labels);
+  EXPECT_EQ("payments", labels->role);
+  EXPECT_EQ("us-east-1a", labels->az);
+
+  labels = enrichment->lookup(address("10.1.2.3"));
+  ASSERT_NE(nullptr, labels);
+  EXPECT_EQ("payments-db", labels->role);
+  EXPECT_EQ("db-primary", labels->id);
+
+  labels = enrichment->lookup(address("2001:db8:1::1"));
+  ASSERT_NE(nullptr, labels);
+  EXPECT_EQ("edge", labels->role);
+  EXPECT_EQ("", labels->az);
+  EXPECT_EQ("pop-1", labels->id);
+  EXPECT_EQ("", labels->autonomous_system);
+}
+
+TEST(IpEnrichmentTest, MalformedIpLabelsFile)
+{
+  for (char const *text : {"10.0.0.0/8", "10.0.0.0/33,role", "10.0.0/8,role", "::/129,role", "10.0.0.0/8,,az"}) {
+    std::istringstream file(text);
+    IpEnrichment::Builder builder;
+    EXPECT_THROW(builder.add_ip_labels(file), std::runtime_error) << text;
+  }
+}
+
+TEST(IpEnrichmentTest, LoaderReloadsChangedFile)
+{
+  auto const dir = std::filesystem::temp_directory_path() / ("ip_enrichment_test." + std::to_string(getpid()));
+  std::filesystem::create_directories(dir);
+  auto const path = dir / "ip_labels.csv";
+
+  IpEnrichmentLoader disabled(std::nullopt, std::nullopt);
+  EXPECT_FALSE(disabled.enabled());
+  EXPECT_FALSE(disabled.reload_if_changed());
+  EXPECT_EQ(nullptr, disabled.current());
+
+  write_file(path, "10.0.0.0/8,corp\n");
+  IpEnrichmentLoader loader(std::nullopt, path.string());
+  EXPECT_TRUE(loader.enabled());
+  EXPECT_TRUE(loader.reload_if_changed());
+  EXPECT_EQ(1u, loader.version());
+
+  auto const first = loader.current();
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ("corp", first->lookup(address("10.1.1.1"))->role);
+
+  // unchanged
+  EXPECT_FALSE(loader.reload_if_changed());
+  EXPECT_EQ(first, loader.current());
+
+  write_file(path, "10.0.0.0/8,corp\n10.1.0.0/16,payments\n");
+  EXPECT_TRUE(loader.reload_if_changed());
+  EXPECT_EQ(2u, loader.version());
+
+  auto const second = loader.current();
+  EXPECT_EQ("payments", second->lookup(address("10.1.1.1"))->role);
+  // tables handed out before stay valid
+  EXPECT_EQ("corp", first->lookup(address("10.1.1.1"))->role);
+
+  // a broken file keeps the previous table
+  write_file(path, "10.0.0.0/8,corp\nnot a range\n");
+  EXPECT_FALSE(loader.reload_if_changed());
+  EXPECT_EQ(2u, loader.version());
+  EXPECT_EQ(second, loader.current());
+
+  std::filesystem::remove_all(dir);
+}
+
+} // namespace reducer
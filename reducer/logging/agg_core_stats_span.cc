@@ -103,4 +103,31 @@ void AggCoreStatsSpan::agg_otlp_grpc_stats(
       msg->time_ns);
 }
 
+void AggCoreStatsSpan::agg_cardinality_stats(
+    ::ebpf_net::logging::weak_refs::agg_core_stats span_ref, u64 timestamp, jsrv_logging__agg_cardinality_stats *msg)
+{
+  auto &encoder = local_core<LoggingCore>().encoder_;
+
+  AggCardinalityStats stats;
+  stats.labels.module = msg->module;
+  stats.labels.shard = std::to_string(msg->shard);
+  stats.labels.aggregation = msg->aggregation;
+  stats.metrics.series = msg->series;
+  stats.metrics.folded = msg->folded;
+  stats.metrics.evicted = msg->evicted;
+
+  encoder.write_internal_stats(stats, msg->time_ns);
+
+  LOG::debug_in(
+      reducer::logging::Component::internal_metrics,
+      "AggCoreStatsSpan::agg_cardinality_stats module={} shard={} aggregation={} series={} folded={} evicted={} timestamp={}",
+      msg->module,
+      msg->shard,
+      msg->aggregation,
+      msg->series,
+      msg->folded,
+      msg->evicted,
+      msg->time_ns);
+}
+
 } // namespace reducer::logging
@@ -17,6 +17,8 @@ public:
       ::ebpf_net::logging::weak_refs::agg_core_stats span_ref, u64 timestamp, jsrv_logging__agg_prometheus_bytes_stats *msg);
   void agg_otlp_grpc_stats(
       ::ebpf_net::logging::weak_refs::agg_core_stats span_ref, u64 timestamp, jsrv_logging__agg_otlp_grpc_stats *msg);
+  void agg_cardinality_stats(
+      ::ebpf_net::logging::weak_refs::agg_core_stats span_ref, u64 timestamp, jsrv_logging__agg_cardinality_stats *msg);
 };
 
 }; // namespace reducer::logging
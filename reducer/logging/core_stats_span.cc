@@ -234,4 +234,31 @@ void CoreStatsSpan::code_timing_stats(
       msg->sum_ns,
       msg->time_ns);
 }
+
+void CoreStatsSpan::rpc_late_input_stats(
+    ::ebpf_net::logging::weak_refs::core_stats span_ref, u64 timestamp, jsrv_logging__rpc_late_input_stats *msg)
+{
+  auto &encoder = local_core<LoggingCore>().encoder_;
+
+  RpcLateInputStats stats;
+  stats.labels.module = msg->module;
+  stats.labels.shard = std::to_string(msg->shard);
+  stats.labels.connection = std::to_string(msg->conn);
+  stats.labels.peer = msg->peer;
+  stats.metrics.late_messages = msg->late_messages;
+  stats.metrics.lag = msg->lag;
+
+  encoder.write_internal_stats(stats, msg->time_ns);
+
+  LOG::debug_in(
+      reducer::logging::Component::internal_metrics,
+      "CoreStatsSpan::rpc_late_input_stats module={} shard={} conn={} peer={} late_messages={} lag={} timestamp={}",
+      msg->module,
+      msg->shard,
+      msg->conn,
+      msg->peer,
+      msg->late_messages,
+      msg->lag,
+      msg->time_ns);
+}
 } // namespace reducer::logging
@@ -26,6 +26,8 @@ public:
       ::ebpf_net::logging::weak_refs::core_stats span_ref, u64 timestamp, jsrv_logging__rpc_write_utilization_stats *msg);
   void
   code_timing_stats(::ebpf_net::logging::weak_refs::core_stats span_ref, u64 timestamp, jsrv_logging__code_timing_stats *msg);
+  void rpc_late_input_stats(
+      ::ebpf_net::logging::weak_refs::core_stats span_ref, u64 timestamp, jsrv_logging__rpc_late_input_stats *msg);
 };
 
 }; // namespace reducer::logging
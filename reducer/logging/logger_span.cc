@@ -5,6 +5,7 @@
 #include "connection_metrics.h"
 
 #include <common/client_type.h>
+#include <common/send_lane.h>
 #include <reducer/constants.h>
 
 #include <util/log.h>
@@ -38,6 +39,17 @@ void LoggerSpan::agent_lost_events(
   LOG::warn("({}) lost events ({}) from agent at '{}'", msg->_rpc_id, msg->count, msg->client_hostname);
 }
 
+void LoggerSpan::agent_shed_messages(
+    ::ebpf_net::logging::weak_refs::logger span_ref, u64 timestamp, jsrv_logging__agent_shed_messages *msg)
+{
+  LOG::warn(
+      "({}) agent at '{}' shed {} messages of the {} lane",
+      msg->_rpc_id,
+      msg->client_hostname,
+      msg->count,
+      to_string(static_cast<SendLane>(msg->lane), "unknown"));
+}
+
 void LoggerSpan::pod_not_found(::ebpf_net::logging::weak_refs::logger span_ref, u64 timestamp, jsrv_logging__pod_not_found *msg)
 {
   LOG::error("({}) pod with uid={} not found", msg->_rpc_id, msg->uid);
@@ -23,6 +23,8 @@ public:
   void connection_metrics(std::function<void(std::string_view, ConnectionMetrics const &)> const &f);
 
   void agent_lost_events(::ebpf_net::logging::weak_refs::logger span_ref, u64 timestamp, jsrv_logging__agent_lost_events *msg);
+  void agent_shed_messages(
+      ::ebpf_net::logging::weak_refs::logger span_ref, u64 timestamp, jsrv_logging__agent_shed_messages *msg);
 
   void pod_not_found(::ebpf_net::logging::weak_refs::logger span_ref, u64 timestamp, jsrv_logging__pod_not_found *msg);
 
@@ -32,6 +32,18 @@ int main(int argc, char *argv[])
   args::Flag print_config(*parser, "print_config", "Print configuration values to stdout", {"print-config"});
   args::ValueFlag<u32> telemetry_port(
       *parser, "port", "TCP port to listen on for incoming connections from collectors", {'p', "port"});
+  auto zstd_dictionary_path = parser.add_arg<std::string>(
+      "zstd-dictionary",
+      "Path to the dictionary collectors compress telemetry with, when using zstd compression with a dictionary");
+  args::Flag enable_io_uring(
+      *parser,
+      "enable_io_uring",
+      "Receives telemetry from collectors through io_uring, on kernels that support it",
+      {"enable-io-uring"});
+  auto ingest_admissions_per_second = parser.add_arg<u32>(
+      "ingest-admissions-per-second",
+      "Maximum number of new collector connections each ingest shard starts handling per second, in bursts of up to a"
+      " second's worth; the others wait their turn. Spreads out reconnect storms. A value of 0 means no limit.");
   args::ValueFlag<std::string> metrics_tsdb_format_flag(
       *parser, "prometheus|json", "Format of TSDB data for scraped metrics", {"metrics-tsdb-format"}, "prometheus");
 
@@ -47,11 +59,27 @@ int main(int argc, char *argv[])
   args::Flag enable_id_id(*parser, "enable_id_id", "Enables id-id timeseries generation", {"enable-id-id"});
   args::Flag enable_az_id(*parser, "enable_az_id", "Enables az-id timeseries generation", {"enable-az-id"});
   args::Flag enable_flow_logs(*parser, "enable_flow_logs", "Enables exporting metric flow logs", {"enable-flow-logs"});
+  auto max_id_id_series = parser.add_arg<u32>(
+      "max-id-id-series",
+      "Maximum number of id-id series each aggregation shard writes per timeslot; the rest are added up into an"
+      " \"(other)\" series. A value of 0 means no limit.");
+  auto max_az_id_series = parser.add_arg<u32>(
+      "max-az-id-series",
+      "Maximum number of az-id and id-az series each aggregation shard writes per timeslot; the rest are added up"
+      " into an \"(other)\" series. A value of 0 means no limit.");
   args::Flag enable_autonomous_system_ip(
       *parser,
       "enable_autonomous_system_ip",
       "Enables using IP addresses for autonomous systems",
       {"enable-autonomous-system-ip"});
+  auto ip_labels_path = parser.add_arg<std::string>(
+      "ip-labels-path",
+      "Path to a file of IP address ranges and the node labels to use for them, one '<cidr>,<role>[,<az>[,<id>]]'"
+      " per line. Applies to addresses without an agent, after AWS enrichment.");
+  auto ip_enrichment_reload_interval = parser.add_arg<u64>(
+      "ip-enrichment-reload-interval",
+      "Interval (in seconds) at which the GeoIP database and the IP labels file are checked for changes and reloaded."
+      " A value of 0 disables reloading.");
   args::Flag enable_percentile_latencies(
       *parser,
       "enable_percentile_latencies",
@@ -67,6 +95,15 @@ int main(int argc, char *argv[])
       *parser, "num_aggregation_shards", "How many aggregation shards to run.", {"num-aggregation-shards"});
   args::ValueFlag<u32> partitions_per_shard(
       *parser, "count", "How many partitions per aggregation shard to write metrics into.", {"partitions-per-shard"});
+  auto max_input_lateness = parser.add_arg<u64>(
+      "max-input-lateness",
+      "Time (in seconds) cores wait for lagging inputs before completing a timeslot without them;"
+      " late messages are merged into the current timeslot. A value of 0 waits indefinitely.");
+  auto shard_peers = parser.add_arg<std::string>(
+      "shard-peers",
+      "Comma-separated `host:port` addresses of the reducer processes to distribute matching and aggregation shards"
+      " across, in process order. Empty runs all shards in this process.");
+  auto shard_peer_index = parser.add_arg<u32>("shard-peer-index", "Position of this process in --shard-peers.");
 
   // Prometheus output.
   //
@@ -75,6 +112,8 @@ int main(int argc, char *argv[])
   args::Flag shard_prometheus_metrics(
       *parser, "shard_prometheus_metrics", "Partitions prometheus metrics", {"shard-prometheus-metrics"});
   args::ValueFlag<std::string> prom_bind(*parser, "prometheus_bind", "Bind address for Prometheus", {"prom"});
+  args::ValueFlag<std::string> rollup_prom_bind(
+      *parser, "prometheus_bind", "Bind address for Prometheus scraping of rolled up metrics", {"rollup-prom"});
   args::ValueFlag<u64> scrape_size_limit_bytes(
       *parser, "scrape_size_limit", "Maximum size of a scrape response, in bytes.", {"scrape-size-limit-bytes"});
 
@@ -117,6 +156,12 @@ int main(int argc, char *argv[])
       "This example will enable all http metrics, all dns metrics, and the udp.drops metric.",
       {"enable-metrics"});
 
+  auto metric_rollups = parser.add_arg<std::string>(
+      "metric-rollups",
+      "A comma (,) separated list of coarser resolutions to also output metrics at, out of: 5m,1h.\n"
+      "Rolled up metrics are written once per rollup period, with a 'rollup' label, to the OTLP gRPC output and\n"
+      "to their own Prometheus endpoint (see --rollup-prom).");
+
   // Internal stats.
   //
   args::ValueFlag<std::string> internal_prom_bind(
@@ -133,6 +178,17 @@ int main(int argc, char *argv[])
       "index-dump-interval",
       "Interval (in seconds) to generate a JSON dump of the span indexes for each core."
       " A value of 0 disables index dumping.");
+  args::Flag enable_index_snapshots(
+      *parser,
+      "enable_index_snapshots",
+      "Enables binary snapshots of the matching and aggregation indexes, restored on startup.",
+      {"enable-index-snapshots"});
+  auto index_snapshot_interval = parser.add_arg<u64>(
+      "index-snapshot-interval",
+      "Interval (in seconds) to write index snapshots."
+      " A value of 0 only writes snapshots on shutdown.");
+  auto index_snapshot_grace_period = parser.add_arg<u64>(
+      "index-snapshot-grace-period", "Time (in seconds) restored spans are kept alive for collectors to re-establish them.");
   parser.new_handler<LogWhitelistHandler<ClientType>>("client-type");
   parser.new_handler<LogWhitelistHandler<NodeResolutionType>>("node-resolution-type");
   parser.new_handler<LogWhitelistHandler<channel::Component>>("channel");
@@ -163,15 +219,23 @@ int main(int argc, char *argv[])
   }
 
   SET_CONFIG(config.telemetry_port, telemetry_port);
+  SET_CONFIG(config.zstd_dictionary_path, zstd_dictionary_path);
+  SET_CONFIG(config.enable_io_uring, enable_io_uring);
+  SET_CONFIG(config.ingest_admissions_per_second, ingest_admissions_per_second);
 
   SET_CONFIG(config.num_ingest_shards, num_ingest_shards);
   SET_CONFIG(config.num_matching_shards, num_matching_shards);
   SET_CONFIG(config.num_aggregation_shards, num_aggregation_shards);
   SET_CONFIG(config.partitions_per_shard, partitions_per_shard);
+  SET_CONFIG(config.max_input_lateness, max_input_lateness);
+  SET_CONFIG(config.shard_peers, shard_peers);
+  SET_CONFIG(config.shard_peer_index, shard_peer_index);
 
   SET_CONFIG(config.enable_id_id, enable_id_id);
   SET_CONFIG(config.enable_az_id, enable_az_id);
   SET_CONFIG(config.enable_flow_logs, enable_flow_logs);
+  SET_CONFIG(config.max_id_id_series, max_id_id_series);
+  SET_CONFIG(config.max_az_id_series, max_az_id_series);
 
   SET_CONFIG(config.enable_otlp_grpc_metrics, enable_otlp_grpc_metrics);
   SET_CONFIG(config.otlp_grpc_metrics_address, otlp_grpc_metrics_address);
@@ -182,19 +246,27 @@ int main(int argc, char *argv[])
   SET_CONFIG(config.disable_prometheus_metrics, disable_prometheus_metrics);
   SET_CONFIG(config.shard_prometheus_metrics, shard_prometheus_metrics);
   SET_CONFIG(config.prom_bind, prom_bind);
+  SET_CONFIG(config.rollup_prom_bind, rollup_prom_bind);
   SET_CONFIG(config.internal_prom_bind, internal_prom_bind);
 
   SET_CONFIG(config.disable_node_ip_field, disable_node_ip_field);
   SET_CONFIG(config.enable_autonomous_system_ip, enable_autonomous_system_ip);
+  SET_CONFIG(config.ip_labels_path, ip_labels_path);
+  SET_CONFIG(config.ip_enrichment_reload_interval, ip_enrichment_reload_interval);
 
   SET_CONFIG(config.enable_aws_enrichment, enable_aws_enrichment);
   SET_CONFIG(config.enable_percentile_latencies, enable_percentile_latencies);
 
   SET_CONFIG(config.disable_metrics, disable_metrics);
   SET_CONFIG(config.enable_metrics, enable_metrics);
+  SET_CONFIG(config.metric_rollups, metric_rollups);
 
   SET_CONFIG(config.index_dump_interval, index_dump_interval);
 
+  SET_CONFIG(config.enable_index_snapshots, enable_index_snapshots);
+  SET_CONFIG(config.index_snapshot_interval, index_snapshot_interval);
+  SET_CONFIG(config.index_snapshot_grace_period, index_snapshot_grace_period);
+
   SET_CONFIG(config.scrape_size_limit_bytes, scrape_size_limit_bytes);
 
 #undef SET_CONFIG
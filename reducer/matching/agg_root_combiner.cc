@@ -0,0 +1,184 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <reducer/matching/agg_root_combiner.h>
+
+#include <reducer/copy_metrics.h>
+
+#include <generated/ebpf_net/matching/auto_handles.h>
+#include <generated/ebpf_net/matching/index.h>
+#include <generated/ebpf_net/matching/weak_refs.inl>
+
+#include <cassert>
+
+namespace reducer::matching {
+
+bool AggRootCombiner::latency_sketches_enabled_ = false;
+
+void AggRootCombiner::enable_latency_sketches(bool enabled)
+{
+  latency_sketches_enabled_ = enabled;
+}
+
+AggRootCombiner::~AggRootCombiner()
+{
+  assert(entries_.empty());
+}
+
+template <typename Metrics> Metrics *AggRootCombiner::Directions<Metrics>::get(UpdateDirection dir)
+{
+  switch (dir) {
+  case UpdateDirection::A_TO_B:
+    has_a_to_b = true;
+    return &a_to_b;
+  case UpdateDirection::B_TO_A:
+    has_b_to_a = true;
+    return &b_to_a;
+  default:
+    return nullptr;
+  }
+}
+
+template <typename Metrics> template <typename F> void AggRootCombiner::Directions<Metrics>::foreach(F &&f) const
+{
+  if (has_a_to_b) {
+    f(UpdateDirection::A_TO_B, a_to_b);
+  }
+  if (has_b_to_a) {
+    f(UpdateDirection::B_TO_A, b_to_a);
+  }
+}
+
+AggRootCombiner::Entry &AggRootCombiner::entry(::ebpf_net::matching::weak_refs::agg_root agg_root)
+{
+  auto [it, inserted] = entries_.try_emplace(agg_root.loc());
+  if (inserted) {
+    it->second.handle = agg_root.get().to_handle();
+  }
+
+  return it->second;
+}
+
+void AggRootCombiner::add(
+    ::ebpf_net::matching::weak_refs::agg_root agg_root, UpdateDirection dir, ::ebpf_net::metrics::tcp_metrics const &m)
+{
+  auto &e = entry(agg_root);
+  if (auto *acc = e.tcp.get(dir)) {
+    add_tcp_metrics(*acc, m);
+  }
+
+  if (latency_sketches_enabled_ && (m.active_rtts > 0)) {
+    if (auto *sketch = e.tcp_rtt.get(dir)) {
+      // RTTs are measured in units of 1/8 microseconds
+      sketch->add(double(m.sum_srtt) / 8 / 1'000'000 / m.active_rtts, m.active_rtts);
+    }
+  }
+}
+
+void AggRootCombiner::add(
+    ::ebpf_net::matching::weak_refs::agg_root agg_root, UpdateDirection dir, ::ebpf_net::metrics::udp_metrics const &m)
+{
+  if (auto *acc = entry(agg_root).udp.get(dir)) {
+    add_udp_metrics(*acc, m);
+  }
+}
+
+void AggRootCombiner::add(
+    ::ebpf_net::matching::weak_refs::agg_root agg_root, UpdateDirection dir, ::ebpf_net::metrics::dns_metrics const &m)
+{
+  auto &e = entry(agg_root);
+  if (auto *acc = e.dns.get(dir)) {
+    add_dns_metrics(*acc, m);
+  }
+
+  if (latency_sketches_enabled_ && (m.responses > 0)) {
+    if (auto *sketch = e.dns_duration.get(dir)) {
+      sketch->add(double(m.sum_total_time_ns) / 1'000'000'000 / m.responses, m.responses);
+    }
+  }
+}
+
+void AggRootCombiner::add(
+    ::ebpf_net::matching::weak_refs::agg_root agg_root, UpdateDirection dir, ::ebpf_net::metrics::http_metrics const &m)
+{
+  auto &e = entry(agg_root);
+  if (auto *acc = e.http.get(dir)) {
+    add_http_metrics(*acc, m);
+  }
+
+  if (latency_sketches_enabled_ && (m.active_sockets > 0)) {
+    if (auto *sketch = e.http_duration.get(dir)) {
+      sketch->add(double(m.sum_total_time_ns) / 1'000'000'000 / m.active_sockets, m.active_sockets);
+    }
+  }
+}
+
+void AggRootCombiner::flush(::ebpf_net::matching::Index &index)
+{
+  for (auto &[_, entry] : entries_) {
+    auto agg_root = entry.handle.access(index);
+
+    entry.tcp.foreach([&](UpdateDirection dir, ::ebpf_net::metrics::tcp_metrics const &m) {
+      agg_root.update_tcp_metrics(
+          (u8)dir,
+          m.active_sockets,
+          m.sum_retrans,
+          m.sum_bytes,
+          m.sum_srtt,
+          m.sum_delivered,
+          m.active_rtts,
+          m.syn_timeouts,
+          m.new_sockets,
+          m.tcp_resets);
+    });
+
+    entry.udp.foreach([&](UpdateDirection dir, ::ebpf_net::metrics::udp_metrics const &m) {
+      agg_root.update_udp_metrics((u8)dir, m.active_sockets, m.addr_changes, m.packets, m.bytes, m.drops);
+    });
+
+    entry.dns.foreach([&](UpdateDirection dir, ::ebpf_net::metrics::dns_metrics const &m) {
+      agg_root.update_dns_metrics(
+          (u8)dir,
+          m.active_sockets,
+          m.requests_a,
+          m.requests_aaaa,
+          m.responses,
+          m.timeouts,
+          m.sum_total_time_ns,
+          m.sum_processing_time_ns);
+    });
+
+    entry.http.foreach([&](UpdateDirection dir, ::ebpf_net::metrics::http_metrics const &m) {
+      agg_root.update_http_metrics(
+          (u8)dir,
+          m.active_sockets,
+          m.sum_code_200,
+          m.sum_code_400,
+          m.sum_code_500,
+          m.sum_code_other,
+          m.sum_total_time_ns,
+          m.sum_processing_time_ns);
+    });
+
+    entry.tcp_rtt.foreach([&](UpdateDirection dir, ::util::LatencySketch const &sketch) {
+      sketch.encode(encoded_sketch_);
+      agg_root.update_tcp_latency((u8)dir, jb_blob(encoded_sketch_));
+    });
+
+    entry.http_duration.foreach([&](UpdateDirection dir, ::util::LatencySketch const &sketch) {
+      sketch.encode(encoded_sketch_);
+      agg_root.update_http_latency((u8)dir, jb_blob(encoded_sketch_));
+    });
+
+    entry.dns_duration.foreach([&](UpdateDirection dir, ::util::LatencySketch const &sketch) {
+      sketch.encode(encoded_sketch_);
+      agg_root.update_dns_latency((u8)dir, jb_blob(encoded_sketch_));
+    });
+
+    entry.handle.put(index);
+  }
+
+  entries_.clear();
+}
+
+} // namespace reducer::matching
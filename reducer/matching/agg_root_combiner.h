@@ -0,0 +1,91 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <reducer/constants.h>
+
+#include <generated/ebpf_net/matching/handles.h>
+#include <generated/ebpf_net/matching/weak_refs.h>
+#include <generated/ebpf_net/metrics.h>
+
+#include <util/latency_sketch.h>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <string>
+
+namespace reducer::matching {
+
+// Folds the metrics of all flows sharing an agg_root into one accumulator per
+// agg_root and direction, so that a timeslot sends aggregation one
+// update_*_metrics message per agg_root and direction instead of one per flow.
+//
+// Aggregation sums these metrics anyway, so the result is the same.
+//
+// Latency distributions can't be summed: when enabled, each flow's average
+// RTT or response time is added to a latency sketch of its agg_root and
+// direction, weighted by the flow's number of measurements, and the sketch is
+// sent along with the metrics in an update_*_latency message.
+//
+class AggRootCombiner {
+public:
+  // Enables building latency sketches.
+  static void enable_latency_sketches(bool enabled);
+
+  AggRootCombiner() = default;
+  ~AggRootCombiner();
+
+  AggRootCombiner(AggRootCombiner const &) = delete;
+  AggRootCombiner &operator=(AggRootCombiner const &) = delete;
+
+  void add(::ebpf_net::matching::weak_refs::agg_root agg_root, UpdateDirection dir, ::ebpf_net::metrics::tcp_metrics const &m);
+  void add(::ebpf_net::matching::weak_refs::agg_root agg_root, UpdateDirection dir, ::ebpf_net::metrics::udp_metrics const &m);
+  void add(::ebpf_net::matching::weak_refs::agg_root agg_root, UpdateDirection dir, ::ebpf_net::metrics::dns_metrics const &m);
+  void add(::ebpf_net::matching::weak_refs::agg_root agg_root, UpdateDirection dir, ::ebpf_net::metrics::http_metrics const &m);
+
+  // Sends the accumulated metrics to aggregation and releases the agg_roots.
+  void flush(::ebpf_net::matching::Index &index);
+
+private:
+  template <typename Metrics> struct Directions {
+    Metrics a_to_b{};
+    Metrics b_to_a{};
+    bool has_a_to_b = false;
+    bool has_b_to_a = false;
+
+    // Returns the accumulator for |dir|, marking it as used.
+    Metrics *get(UpdateDirection dir);
+
+    // Calls |f(dir, metrics)| for each used direction.
+    template <typename F> void foreach(F &&f) const;
+  };
+
+  struct Entry {
+    // keeps the agg_root alive, so its location can't be reused by another
+    // agg_root before the flush
+    ::ebpf_net::matching::handles::agg_root handle;
+
+    Directions<::ebpf_net::metrics::tcp_metrics> tcp;
+    Directions<::ebpf_net::metrics::udp_metrics> udp;
+    Directions<::ebpf_net::metrics::dns_metrics> dns;
+    Directions<::ebpf_net::metrics::http_metrics> http;
+
+    Directions<::util::LatencySketch> tcp_rtt;
+    Directions<::util::LatencySketch> http_duration;
+    Directions<::util::LatencySketch> dns_duration;
+  };
+
+  // Returns the entry for |agg_root|, creating it if needed.
+  Entry &entry(::ebpf_net::matching::weak_refs::agg_root agg_root);
+
+  static bool latency_sketches_enabled_;
+
+  absl::flat_hash_map<u32, Entry> entries_;
+  // scratch space for encoding latency sketches
+  std::string encoded_sketch_;
+};
+
+} // namespace reducer::matching
@@ -1,6 +1,7 @@
 // Copyright The OpenTelemetry Authors
 // SPDX-License-Identifier: Apache-2.0
 
+#include <reducer/matching/agg_root_combiner.h>
 #include <reducer/matching/component.h>
 #include <reducer/matching/flow_span.h>
 #include <reducer/matching/matching_core.h>
@@ -43,6 +44,20 @@ template <typename T> const T &get_or_default(const std::optional<T> &value)
   return value.has_value() ? *value : *kDefault;
 }
 
+// Interns a string received in a message, for storage in the span.
+InternedString intern(jb_blob const &blob)
+{
+  return local_core<MatchingCore>().flow_strings.intern(std::string_view(blob.buf, blob.len));
+}
+
+// Returns the dictionary of strings sent by ingest shard |dict|.
+StringDictionaryDecoder &ingest_string_dictionary(u16 dict)
+{
+  auto *dictionary = local_core<MatchingCore>().ingest_string_dictionaries.get(dict);
+  ASSUME(dictionary).else_log("unknown string dictionary {}", dict);
+  return *dictionary;
+}
+
 } // namespace
 
 bool FlowSpan::aws_enrichment_enabled_ = false;
@@ -58,42 +73,45 @@ FlowSpan::~FlowSpan() {}
 
 void FlowSpan::agent_info(::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__agent_info *msg)
 {
-  std::string id{msg->id.buf, msg->id.len};
-  std::string az{msg->az.buf, msg->az.len};
-  std::string env{msg->env.buf, msg->env.len};
-  std::string role{msg->role.buf, msg->role.len};
-  std::string ns{msg->ns.buf, msg->ns.len};
-
-  LOG::trace_in(
-      Component::flow, "matching::FlowSpan::agent_info: side={} id={} az={} env={} ns={}", msg->side, id, az, env, ns);
-
   auto const side = u8_to_side(msg->side);
 
   agent_info_[+side] = {
-      .id = std::move(id),
-      .az = std::move(az),
-      .env = std::move(env),
-      .role = std::move(role),
-      .ns = std::move(ns),
+      .id = intern(msg->id),
+      .az = intern(msg->az),
+      .env = intern(msg->env),
+      .role = intern(msg->role),
+      .ns = intern(msg->ns),
   };
 
+  auto const &info = *agent_info_[+side];
+  LOG::trace_in(
+      Component::flow,
+      "matching::FlowSpan::agent_info: side={} id={} az={} env={} ns={}",
+      msg->side,
+      info.id.str(),
+      info.az.str(),
+      info.env.str(),
+      info.ns.str());
+
   n_received_info_messages_++;
 }
 
 void FlowSpan::task_info(::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__task_info *msg)
 {
-  std::string comm{msg->comm.buf, msg->comm.len};
-  std::string cgroup_name{msg->cgroup_name.buf, msg->cgroup_name.len};
-
-  LOG::trace_in(Component::flow, "matching::FlowSpan::task_info: side={} comm='{}' cgroup='{}'", msg->side, comm, cgroup_name);
-
   auto const side = u8_to_side(msg->side);
 
   task_info_[+side] = {
-      .comm = comm,
-      .cgroup_name = cgroup_name,
+      .comm = intern(msg->comm),
+      .cgroup_name = intern(msg->cgroup_name),
   };
 
+  LOG::trace_in(
+      Component::flow,
+      "matching::FlowSpan::task_info: side={} comm='{}' cgroup='{}'",
+      msg->side,
+      task_info_[+side]->comm.str(),
+      task_info_[+side]->cgroup_name.str());
+
   n_received_info_messages_++;
 }
 
@@ -101,7 +119,6 @@ void FlowSpan::socket_info(::ebpf_net::matching::weak_refs::flow span_ref, u64 t
 {
   auto local_addr = IPv6Address::from(msg->local_addr);
   auto remote_addr = IPv6Address::from(msg->remote_addr);
-  std::string remote_dns_name{msg->remote_dns_name.buf, msg->remote_dns_name.len};
 
   LOG::trace_in(
       Component::flow,
@@ -121,7 +138,7 @@ void FlowSpan::socket_info(::ebpf_net::matching::weak_refs::flow span_ref, u64 t
       .remote_addr = remote_addr,
       .remote_port = msg->remote_port,
       .is_connector = msg->is_connector,
-      .remote_dns_name = std::move(remote_dns_name),
+      .remote_dns_name = intern(msg->remote_dns_name),
   };
 
   n_received_info_messages_++;
@@ -154,19 +171,14 @@ void FlowSpan::container_info(
     ::ebpf_net::matching::weak_refs::flow span_ref, const u64 timestamp, jsrv_matching__container_info *const msg)
 {
   auto const side = u8_to_side(msg->side);
-  std::string name{msg->name.buf, msg->name.len};
-  std::string pod{msg->pod.buf, msg->pod.len};
-  std::string role{msg->role.buf, msg->role.len};
-  std::string version{msg->version.buf, msg->version.len};
-  std::string ns{msg->ns.buf, msg->ns.len};
   auto const type = static_cast<NodeResolutionType>(msg->node_type);
 
   container_info_[+side] = ContainerInfo{
-      .name = std::move(name),
-      .pod = std::move(pod),
-      .role = std::move(role),
-      .version = std::move(version),
-      .ns = std::move(ns),
+      .name = intern(msg->name),
+      .pod = intern(msg->pod),
+      .role = intern(msg->role),
+      .version = intern(msg->version),
+      .ns = intern(msg->ns),
       .type = (sanitize_enum(type) == type ? type : NodeResolutionType::CONTAINER)};
 
   n_received_info_messages_++;
@@ -176,22 +188,74 @@ void FlowSpan::service_info(
     ::ebpf_net::matching::weak_refs::flow span_ref, const u64 timestamp, jsrv_matching__service_info *const msg)
 {
   auto const side = u8_to_side(msg->side);
-  std::string name{msg->name.buf, msg->name.len};
 
   service_info_[+side] = ServiceInfo{
-      .name = std::move(name),
+      .name = intern(msg->name),
   };
 
   n_received_info_messages_++;
 }
 
+void FlowSpan::define_string(
+    ::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__define_string *msg)
+{
+  ASSUME(ingest_string_dictionary(msg->dict).define(msg->id, std::string_view(msg->value.buf, msg->value.len)))
+      .else_log("string id {} out of range in dictionary {}", msg->id, msg->dict);
+}
+
+void FlowSpan::agent_info_ids(
+    ::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__agent_info_ids *msg)
+{
+  auto &strings = ingest_string_dictionary(msg->dict);
+
+  jsrv_matching__agent_info info{};
+  info.side = msg->side;
+  info.id = jb_blob(strings.lookup(msg->id));
+  info.az = jb_blob(strings.lookup(msg->az));
+  info.env = jb_blob(strings.lookup(msg->env));
+  info.role = jb_blob(strings.lookup(msg->role));
+  info.ns = jb_blob(strings.lookup(msg->ns));
+
+  agent_info(span_ref, timestamp, &info);
+}
+
+void FlowSpan::task_info_ids(
+    ::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__task_info_ids *msg)
+{
+  auto &strings = ingest_string_dictionary(msg->dict);
+
+  jsrv_matching__task_info info{};
+  info.side = msg->side;
+  info.comm = jb_blob(strings.lookup(msg->comm));
+  info.cgroup_name = jb_blob(strings.lookup(msg->cgroup_name));
+
+  task_info(span_ref, timestamp, &info);
+}
+
+void FlowSpan::container_info_ids(
+    ::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__container_info_ids *msg)
+{
+  auto &strings = ingest_string_dictionary(msg->dict);
+
+  jsrv_matching__container_info info{};
+  info.side = msg->side;
+  info.name = jb_blob(strings.lookup(msg->name));
+  info.pod = jb_blob(strings.lookup(msg->pod));
+  info.role = jb_blob(strings.lookup(msg->role));
+  info.version = jb_blob(strings.lookup(msg->version));
+  info.ns = jb_blob(strings.lookup(msg->ns));
+  info.node_type = msg->node_type;
+
+  container_info(span_ref, timestamp, &info);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void FlowSpan::update_nodes_if_required(::ebpf_net::matching::weak_refs::flow flow)
 {
   bool got_messages = (n_received_info_messages_ != message_count_on_last_update_);
 
-  bool update_needed = got_messages || should_attempt_k8s_enrichment(flow, FlowSide::SIDE_A) ||
+  bool update_needed = got_messages || agg_root_resynced(flow) || should_attempt_k8s_enrichment(flow, FlowSide::SIDE_A) ||
                        should_attempt_k8s_enrichment(flow, FlowSide::SIDE_B);
 
   if (!update_needed) {
@@ -218,20 +282,42 @@ void FlowSpan::update_nodes(::ebpf_net::matching::weak_refs::flow flow, NodeData
 
 void FlowSpan::update_node(::ebpf_net::matching::weak_refs::agg_root agg_root, FlowSide side, NodeData const &n)
 {
-  agg_root.update_node(
+  auto &dictionaries = local_core<MatchingCore>().aggregation_string_dictionaries;
+  auto const shard = agg_root.shard_id();
+
+  // definitions of strings new to the aggregation shard go out before the
+  // update that uses them
+  auto encode = [&](std::string_view value) {
+    return dictionaries.encode(shard, value, [&](u16 dict, u32 id) { agg_root.define_string(dict, id, jb_blob(value)); });
+  };
+
+  u32 const id = encode(n.id);
+  u32 const az = encode(n.az);
+  u32 const role = encode(n.role);
+  u32 const version = encode(n.version);
+  u32 const env = encode(n.env);
+  u32 const ns = encode(n.ns);
+  u32 const address = encode(n.address);
+  u32 const process = encode(n.comm);
+  u32 const container = encode(n.container_name);
+  u32 const pod_name = encode(n.pod_name);
+  u32 const role_uid = encode(n.role_uid);
+
+  agg_root.update_node_ids(
       static_cast<u8>(side),
-      jb_blob(n.id),
-      jb_blob(n.az),
-      jb_blob(n.role),
-      jb_blob(n.version),
-      jb_blob(n.env),
-      jb_blob(n.ns),
+      dictionaries.dict(),
+      id,
+      az,
+      role,
+      version,
+      env,
+      ns,
       static_cast<u8>(n.node_type),
-      jb_blob(n.address),
-      jb_blob(n.comm),
-      jb_blob(n.container_name),
-      jb_blob(n.pod_name),
-      jb_blob(n.role_uid));
+      address,
+      process,
+      container,
+      pod_name,
+      role_uid);
 }
 
 void FlowSpan::create_agg_root(::ebpf_net::matching::weak_refs::flow flow, NodeData const &node_a, NodeData const &node_b)
@@ -276,11 +362,18 @@ void FlowSpan::create_agg_root(::ebpf_net::matching::weak_refs::flow flow, NodeD
   }
 
   if ((flow.agg_root().valid() == false) || (role1 != flow.agg_root().role1()) || (role2 != flow.agg_root().role2()) ||
-      (az1 != flow.agg_root().az1()) || (az2 != flow.agg_root().az2())) {
+      (az1 != flow.agg_root().az1()) || (az2 != flow.agg_root().az2()) || agg_root_resynced(flow)) {
     flow.modify().agg_root(flow.index().agg_root.alloc(role1, az1, role2, az2));
+    agg_root_resyncs_ = local_core<MatchingCore>().aggregation_resyncs[flow.agg_root().shard_id()];
   }
 }
 
+bool FlowSpan::agg_root_resynced(::ebpf_net::matching::weak_refs::flow flow) const
+{
+  auto agg_root = flow.agg_root();
+  return agg_root.valid() && (agg_root_resyncs_ != local_core<MatchingCore>().aggregation_resyncs[agg_root.shard_id()]);
+}
+
 bool FlowSpan::should_attempt_k8s_enrichment(::ebpf_net::matching::weak_refs::flow flow, FlowSide side) const
 {
   // should we retry to enrich using kubernetes pods?
@@ -325,13 +418,13 @@ FlowSpan::NodeData FlowSpan::resolve_node(::ebpf_net::matching::weak_refs::flow
   auto node_type = NodeResolutionType::NONE;
 
   if (auto &agent_info = agent_info_[+side]; agent_info.has_value()) {
-    env = agent_info->env;
-    ns = agent_info->ns;
+    env = agent_info->env.str();
+    ns = agent_info->ns.str();
   } else {
     env = kNoAgentEnvironmentName;
   }
 
-  const std::string &pod_name = get_or_default(container_info_[+side]).pod;
+  const std::string &pod_name = get_or_default(container_info_[+side]).pod.str();
 
   // sanity checks on messages:
   // we get agent_info_ if and only if task_info and socket info
@@ -371,7 +464,7 @@ FlowSpan::NodeData FlowSpan::resolve_node(::ebpf_net::matching::weak_refs::flow
     ns = pod.ns();
 
     if (auto &task_info = task_info_[+side]; task_info.has_value()) {
-      auto info = CGroupParser{task_info->cgroup_name}.get();
+      auto info = CGroupParser{task_info->cgroup_name.str()}.get();
       auto container_id = info.container_id;
 
       if (!container_id.empty()) {
@@ -390,23 +483,23 @@ FlowSpan::NodeData FlowSpan::resolve_node(::ebpf_net::matching::weak_refs::flow
   } else if (auto const &container = container_info_[+side]; container.has_value()) {
     // if we have container info, use that
     node_type = sanitize_enum(container->type) == container->type ? container->type : NodeResolutionType::CONTAINER;
-    role = container->role;
-    version = container->version;
-    ns = container->ns;
+    role = container->role.str();
+    version = container->version.str();
+    ns = container->ns.str();
   } else if (agent_info_[+side].has_value()) {
     // if we at least have an agent, use that
     node_type = NodeResolutionType::PROCESS;
     if (service_info_[+side].has_value()) {
-      role = service_info_[+side]->name;
+      role = service_info_[+side]->name.str();
     } else if (task_info_[+side].has_value()) {
-      role = task_info_[+side]->comm;
+      role = task_info_[+side]->comm.str();
     } else {
       // Shouldn't happen :( need to fix
-      role = agent_info_[+side]->role;
+      role = agent_info_[+side]->role.str();
     }
-    ns = agent_info_[+side]->ns;
+    ns = agent_info_[+side]->ns.str();
   } else if (auto const &flipside_socket_info = socket_info_[+(~side)]; flipside_socket_info.has_value()) {
-    // no agent: try AWS -> DNS -> IP
+    // no agent: try AWS -> IP labels -> DNS -> IP
     auto const &ipv6 = flipside_socket_info->remote_addr;
 
     AwsEnrichmentInfo const *aws_info = nullptr;
@@ -443,10 +536,29 @@ FlowSpan::NodeData FlowSpan::resolve_node(::ebpf_net::matching::weak_refs::flow
       if (!aws_info->id.empty()) {
         id = aws_info->id + "/" + id;
       }
+    } else if (auto ip_labels = get_ip_labels(ipv6); ip_labels && !ip_labels->role.empty()) {
+      // the address is in a labeled IP range
+      LOG::trace_in(
+          NodeResolutionType::IP_RANGE,
+          "matching::FlowSpan::update_node: found IP labels"
+          " for: ipv6={} role={} az={} id={}",
+          ipv6,
+          ip_labels->role,
+          ip_labels->az,
+          ip_labels->id);
+
+      node_type = NodeResolutionType::IP_RANGE;
+      role = ip_labels->role;
+      if (!ip_labels->az.empty()) {
+        az = ip_labels->az;
+      }
+      if (!ip_labels->id.empty()) {
+        id = ip_labels->id + "/" + id;
+      }
     } else {
       if (!flipside_socket_info->remote_dns_name.empty()) {
         node_type = NodeResolutionType::DNS;
-        role = flipside_socket_info->remote_dns_name;
+        role = flipside_socket_info->remote_dns_name.str();
       } else {
         // no agent and no DNS, fall back on the IP address
         node_type = NodeResolutionType::IP;
@@ -463,8 +575,8 @@ FlowSpan::NodeData FlowSpan::resolve_node(::ebpf_net::matching::weak_refs::flow
     role = "instance metadata";
     node_type = NodeResolutionType::INSTANCE_METADATA;
     if (auto &agent_info = agent_info_[+(~side)]; agent_info.has_value()) {
-      id = agent_info->id;
-      az = agent_info->az;
+      id = agent_info->id.str();
+      az = agent_info->az.str();
     }
   }
 
@@ -473,7 +585,7 @@ FlowSpan::NodeData FlowSpan::resolve_node(::ebpf_net::matching::weak_refs::flow
   }
 
   if (container_name.empty()) {
-    container_name = get_or_default(container_info_[+side]).name;
+    container_name = get_or_default(container_info_[+side]).name.str();
   }
 
   return NodeData{
@@ -494,7 +606,7 @@ FlowSpan::NodeData FlowSpan::resolve_node(::ebpf_net::matching::weak_refs::flow
 
 std::string FlowSpan::get_comm(FlowSide side) const
 {
-  return get_or_default(task_info_[+side]).comm;
+  return get_or_default(task_info_[+side]).comm.str();
 }
 
 std::optional<FlowSpan::AddrPort> FlowSpan::get_addr_port(FlowSide side) const
@@ -515,7 +627,7 @@ std::tuple<std::string, std::string, bool> FlowSpan::get_id_az(FlowSide side) co
 {
   if (auto &agent_info = agent_info_[+side]; agent_info.has_value()) {
     // use ID and AZ obtained from this side's agent info
-    return std::make_tuple(agent_info->id, agent_info->az, false);
+    return std::make_tuple(agent_info->id.str(), agent_info->az.str(), false);
   }
 
   std::string id;
@@ -527,17 +639,23 @@ std::tuple<std::string, std::string, bool> FlowSpan::get_id_az(FlowSide side) co
     // use the remote IP address from other side's socket info for ID
     id = socket_info->remote_addr.tidy_string();
 
-    if (auto &an_db = local_core<MatchingCore>().an_db; an_db) {
-      auto addr = reinterpret_cast<in6_addr const *>(&socket_info->remote_addr);
-      if (auto entry = an_db.lookup(addr)) {
-        is_autonomous_system = geoip::well_known_data::try_autonomous_system_organization(az, entry);
-      }
+    if (auto labels = get_ip_labels(socket_info->remote_addr); labels && !labels->autonomous_system.empty()) {
+      az = labels->autonomous_system;
+      is_autonomous_system = true;
     }
   }
 
   return std::make_tuple(id, az, is_autonomous_system);
 }
 
+IpLabels const *FlowSpan::get_ip_labels(IPv6Address const &addr) const
+{
+  if (auto const &ip_enrichment = local_core<MatchingCore>().ip_enrichment) {
+    return ip_enrichment->lookup(addr);
+  }
+  return nullptr;
+}
+
 ::ebpf_net::matching::auto_handles::k8s_pod FlowSpan::get_k8s_pod(FlowSide side, ::ebpf_net::matching::Index &index)
 {
   if (auto &k8s_info = k8s_info_[+side]; k8s_info.has_value()) {
@@ -558,7 +676,7 @@ std::tuple<std::string, std::string, bool> FlowSpan::get_id_az(FlowSide side) co
   }
 
   if (auto &task_info = task_info_[+side]; task_info.has_value()) {
-    auto info = CGroupParser{task_info->cgroup_name}.get();
+    auto info = CGroupParser{task_info->cgroup_name.str()}.get();
     auto container_id = info.container_id;
 
     if (!container_id.empty()) {
@@ -741,103 +859,46 @@ void FlowSpan::dns_update(::ebpf_net::matching::weak_refs::flow span_ref, u64 ti
 
 namespace {
 
-template <UpdateDirection Dir>
-void send_tcp_metrics(
-    u64 t, ::ebpf_net::matching::weak_refs::flow span_ref, ::ebpf_net::metrics::tcp_metrics const &m, u64 interval)
-{
-  span_ref.impl().update_nodes_if_required(span_ref);
-
-  auto agg_root = span_ref.agg_root();
-  if (!agg_root.valid()) {
-    return;
-  }
-
-  agg_root.update_tcp_metrics(
-      (u8)Dir,
-      m.active_sockets,
-      m.sum_retrans,
-      m.sum_bytes,
-      m.sum_srtt,
-      m.sum_delivered,
-      m.active_rtts,
-      m.syn_timeouts,
-      m.new_sockets,
-      m.tcp_resets);
-}
-
-template <UpdateDirection Dir>
-void send_udp_metrics(
-    u64 t, ::ebpf_net::matching::weak_refs::flow span_ref, ::ebpf_net::metrics::udp_metrics const &m, u64 interval)
+// Returns a functor for a flow metric store's _foreach, that adds each flow's
+// metrics to |combiner| under the flow's agg_root.
+template <UpdateDirection Dir, typename Metrics> auto combine_metrics(AggRootCombiner &combiner)
 {
-  span_ref.impl().update_nodes_if_required(span_ref);
+  return [&combiner](u64 t, ::ebpf_net::matching::weak_refs::flow span_ref, Metrics const &m, u64 interval) {
+    span_ref.impl().update_nodes_if_required(span_ref);
 
-  auto agg_root = span_ref.agg_root();
-  if (!agg_root.valid()) {
-    return;
-  }
+    auto agg_root = span_ref.agg_root();
+    if (!agg_root.valid()) {
+      return;
+    }
 
-  agg_root.update_udp_metrics((u8)Dir, m.active_sockets, m.addr_changes, m.packets, m.bytes, m.drops);
+    combiner.add(agg_root, Dir, m);
+  };
 }
 
-template <UpdateDirection Dir>
-void send_dns_metrics(
-    u64 t, ::ebpf_net::matching::weak_refs::flow span_ref, ::ebpf_net::metrics::dns_metrics const &m, u64 interval)
-{
-  span_ref.impl().update_nodes_if_required(span_ref);
-
-  auto agg_root = span_ref.agg_root();
-  if (!agg_root.valid()) {
-    return;
-  }
-
-  agg_root.update_dns_metrics(
-      (u8)Dir,
-      m.active_sockets,
-      m.requests_a,
-      m.requests_aaaa,
-      m.responses,
-      m.timeouts,
-      m.sum_total_time_ns,
-      m.sum_processing_time_ns);
-}
+} // namespace
 
-template <UpdateDirection Dir>
-void send_http_metrics(
-    u64 t, ::ebpf_net::matching::weak_refs::flow span_ref, ::ebpf_net::metrics::http_metrics const &m, u64 interval)
+void FlowSpan::send_metrics_to_aggregation(::ebpf_net::matching::Index &index, u64 ts)
 {
-  span_ref.impl().update_nodes_if_required(span_ref);
+  using namespace ::ebpf_net::metrics;
 
-  auto agg_root = span_ref.agg_root();
-  if (!agg_root.valid()) {
-    return;
-  }
+  auto &flows = index.flow;
 
-  agg_root.update_http_metrics(
-      (u8)Dir,
-      m.active_sockets,
-      m.sum_code_200,
-      m.sum_code_400,
-      m.sum_code_500,
-      m.sum_code_other,
-      m.sum_total_time_ns,
-      m.sum_processing_time_ns);
-}
+  // flows sharing an agg_root are sent as a single update per direction
+  AggRootCombiner combiner;
 
-} // namespace
+  flows.tcp_a_to_b_foreach(ts, combine_metrics<UpdateDirection::A_TO_B, tcp_metrics>(combiner));
+  flows.tcp_b_to_a_foreach(ts, combine_metrics<UpdateDirection::B_TO_A, tcp_metrics>(combiner));
 
-void FlowSpan::send_metrics_to_aggregation(::ebpf_net::matching::containers::flow &flows, u64 ts)
-{
-  flows.tcp_a_to_b_foreach(ts, send_tcp_metrics<UpdateDirection::A_TO_B>);
-  flows.tcp_b_to_a_foreach(ts, send_tcp_metrics<UpdateDirection::B_TO_A>);
+  flows.udp_a_to_b_foreach(ts, combine_metrics<UpdateDirection::A_TO_B, udp_metrics>(combiner));
+  flows.udp_b_to_a_foreach(ts, combine_metrics<UpdateDirection::B_TO_A, udp_metrics>(combiner));
 
-  flows.udp_a_to_b_foreach(ts, send_udp_metrics<UpdateDirection::A_TO_B>);
-  flows.udp_b_to_a_foreach(ts, send_udp_metrics<UpdateDirection::B_TO_A>);
+  flows.dns_a_to_b_foreach(ts, combine_metrics<UpdateDirection::A_TO_B, dns_metrics>(combiner));
+  flows.dns_b_to_a_foreach(ts, combine_metrics<UpdateDirection::B_TO_A, dns_metrics>(combiner));
 
-  flows.dns_a_to_b_foreach(ts, send_dns_metrics<UpdateDirection::A_TO_B>);
-  flows.dns_b_to_a_foreach(ts, send_dns_metrics<UpdateDirection::B_TO_A>);
+  flows.http_a_to_b_foreach(ts, combine_metrics<UpdateDirection::A_TO_B, http_metrics>(combiner));
+  flows.http_b_to_a_foreach(ts, combine_metrics<UpdateDirection::B_TO_A, http_metrics>(combiner));
 
-  flows.http_a_to_b_foreach(ts, send_http_metrics<UpdateDirection::A_TO_B>);
-  flows.http_b_to_a_foreach(ts, send_http_metrics<UpdateDirection::B_TO_A>);
+  combiner.flush(index);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -858,15 +919,15 @@ void FlowSpan::debug_state(const std::string_view &reason)
       LOG::debug_in(
           NodeResolutionType::NONE,
           "  agent:     id='{}' az='{}' env='{}'",
-          agent_info_[i]->id,
-          agent_info_[i]->az,
-          agent_info_[i]->env);
+          agent_info_[i]->id.str(),
+          agent_info_[i]->az.str(),
+          agent_info_[i]->env.str());
     } else {
       LOG::debug_in(NodeResolutionType::NONE, "  agent:     null");
     }
 
     if (task_info_[i].has_value()) {
-      LOG::debug_in(NodeResolutionType::NONE, "  task:      comm='{}'", task_info_[i]->comm);
+      LOG::debug_in(NodeResolutionType::NONE, "  task:      comm='{}'", task_info_[i]->comm.str());
     } else {
       LOG::debug_in(NodeResolutionType::NONE, "  task:      null");
     }
@@ -886,7 +947,10 @@ void FlowSpan::debug_state(const std::string_view &reason)
 
     if (container_info_[i].has_value()) {
       LOG::debug_in(
-          NodeResolutionType::NONE, "  container: name='{}' pod='{}'", container_info_[i]->name, container_info_[i]->pod);
+          NodeResolutionType::NONE,
+          "  container: name='{}' pod='{}'",
+          container_info_[i]->name.str(),
+          container_info_[i]->pod.str());
     } else {
       LOG::debug_in(NodeResolutionType::NONE, "  container: null");
     }
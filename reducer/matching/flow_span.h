@@ -6,11 +6,13 @@
 #pragma once
 
 #include <reducer/constants.h>
+#include <reducer/ip_enrichment.h>
 
 #include <generated/ebpf_net/matching/modifiers.h>
 #include <generated/ebpf_net/matching/span_base.h>
 
 #include <util/ip_address.h>
+#include <util/string_interner.h>
 
 #include <array>
 #include <functional>
@@ -32,6 +34,13 @@ public:
   void container_info(::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__container_info *msg);
   void service_info(::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__service_info *msg);
 
+  // Dictionary-encoded variants of the above.
+  void define_string(::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__define_string *msg);
+  void agent_info_ids(::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__agent_info_ids *msg);
+  void task_info_ids(::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__task_info_ids *msg);
+  void
+  container_info_ids(::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__container_info_ids *msg);
+
   void tcp_update(::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__tcp_update *msg);
   void udp_update(::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__udp_update *msg);
   void http_update(::ebpf_net::matching::weak_refs::flow span_ref, u64 timestamp, jsrv_matching__http_update *msg);
@@ -40,24 +49,28 @@ public:
   // Updates nodes if new messages have arrived.
   void update_nodes_if_required(::ebpf_net::matching::weak_refs::flow flow);
 
-  static void send_metrics_to_aggregation(::ebpf_net::matching::containers::flow &flows, u64 timestamp);
+  // Sends the metrics of timeslot |timestamp| to aggregation, combined per agg_root.
+  static void send_metrics_to_aggregation(::ebpf_net::matching::Index &index, u64 timestamp);
 
   // NOTE: must be called on startup, from main, before any flow spans are
   // created
   static void enable_aws_enrichment(bool enabled);
 
 private:
+  // Strings received in info messages are mostly drawn from a small
+  // vocabulary, so they are interned in MatchingCore::flow_strings.
+
   struct AgentInfo {
-    std::string id;
-    std::string az;
-    std::string env;
-    std::string role;
-    std::string ns;
+    InternedString id;
+    InternedString az;
+    InternedString env;
+    InternedString role;
+    InternedString ns;
   };
 
   struct TaskInfo {
-    std::string comm;
-    std::string cgroup_name;
+    InternedString comm;
+    InternedString cgroup_name;
   };
 
   struct SocketInfo {
@@ -66,7 +79,7 @@ private:
     IPv6Address remote_addr;
     u16 remote_port = 0;
     u8 is_connector = 0;
-    std::string remote_dns_name;
+    InternedString remote_dns_name;
   };
 
   struct K8sInfo {
@@ -75,16 +88,16 @@ private:
   };
 
   struct ContainerInfo {
-    std::string name;
-    std::string pod;
-    std::string role;
-    std::string version;
-    std::string ns;
+    InternedString name;
+    InternedString pod;
+    InternedString role;
+    InternedString version;
+    InternedString ns;
     NodeResolutionType type = NodeResolutionType::CONTAINER;
   };
 
   struct ServiceInfo {
-    std::string name;
+    InternedString name;
   };
 
   struct AddrPort {
@@ -124,6 +137,10 @@ private:
   // Creates the appropriate agg_root proxy and assignes it to the span.
   void create_agg_root(::ebpf_net::matching::weak_refs::flow flow, NodeData const &node_a, NodeData const &role_b);
 
+  // Returns whether the aggregation shard of the flow's agg_root started over
+  // since it was allocated, so it no longer knows about it.
+  bool agg_root_resynced(::ebpf_net::matching::weak_refs::flow flow) const;
+
   // Returns true if we should try to re-enrich kubernetes information for the
   // side
   bool should_attempt_k8s_enrichment(::ebpf_net::matching::weak_refs::flow flow, FlowSide side) const;
@@ -145,6 +162,9 @@ private:
   // The third tuple element indicates whether this is an autonomous system.
   std::tuple<std::string, std::string, bool> get_id_az(FlowSide side) const;
 
+  // Returns the labels of the IP range containing |addr|, if any.
+  IpLabels const *get_ip_labels(IPv6Address const &addr) const;
+
   // Returns the k8s_pod span of the process for the specified side, if any.
   ::ebpf_net::matching::auto_handles::k8s_pod get_k8s_pod(FlowSide side, ::ebpf_net::matching::Index &index);
 
@@ -160,6 +180,10 @@ private:
   // the value of n_received_info_messages_ when update_node() was last called
   u32 message_count_on_last_update_ = ~0u;
 
+  // MatchingCore::aggregation_resyncs of the agg_root's shard when the
+  // agg_root was allocated
+  u64 agg_root_resyncs_ = 0;
+
   static bool aws_enrichment_enabled_;
 };
 
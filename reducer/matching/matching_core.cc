@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <config.h>
 
+#include <reducer/matching/agg_root_combiner.h>
 #include <reducer/matching/component.h>
 #include <reducer/matching/matching_core.h>
 
@@ -22,24 +23,11 @@
 #include <util/time.h>
 
 #include <functional>
+#include <utility>
 #include <stdexcept>
 
 namespace reducer::matching {
 
-namespace {
-
-geoip::database make_geoip_db(std::optional<std::string> const &path)
-{
-  if (!path) {
-    // Return a no-op database object.
-    return geoip::database(std::nothrow, {});
-  }
-
-  return geoip::database(std::nothrow, path->c_str());
-}
-
-} // namespace
-
 bool MatchingCore::autonomous_system_ip_enabled_ = false;
 
 bool MatchingCore::autonomous_system_ip_enabled()
@@ -57,11 +45,16 @@ void MatchingCore::enable_aws_enrichment(bool enabled)
   FlowSpan::enable_aws_enrichment(enabled);
 }
 
+void MatchingCore::enable_latency_sketches(bool enabled)
+{
+  AggRootCombiner::enable_latency_sketches(enabled);
+}
+
 MatchingCore::MatchingCore(
     RpcQueueMatrix &ingest_to_matching_queues,
     RpcQueueMatrix &matching_to_aggregation_queues,
     RpcQueueMatrix &matching_to_logging_queues,
-    std::optional<std::string> geoip_path,
+    IpEnrichmentLoader const &ip_enrichment_loader,
     size_t shard_num,
     u64 initial_timestamp)
     : CoreBase(
@@ -72,7 +65,13 @@ MatchingCore::MatchingCore(
               shard_num, std::bind(&Core::current_timestamp, this)),
           matching_to_logging_queues.make_writers<ebpf_net::logging::Writer>(
               shard_num, std::bind(&Core::current_timestamp, this))),
-      an_db(make_geoip_db(geoip_path)),
+      ip_enrichment(ip_enrichment_loader.current()),
+      ingest_string_dictionaries(ingest_to_matching_queues.num_senders()),
+      aggregation_string_dictionaries(shard_num, matching_to_aggregation_queues.num_receivers()),
+      aggregation_resyncs(matching_to_aggregation_queues.num_receivers()),
+      matching_to_aggregation_queues_(matching_to_aggregation_queues),
+      ip_enrichment_loader_(ip_enrichment_loader),
+      ip_enrichment_version_(ip_enrichment_loader.version()),
       ingest_to_matching_stats_(shard_num, "ingest", "matching"),
       matching_to_aggregation_stats_(shard_num, "matching", "aggregation", matching_to_aggregation_queues),
       matching_to_logging_stats_(shard_num, "matching", "logging", matching_to_logging_queues),
@@ -87,14 +86,62 @@ ebpf_net::matching::weak_refs::logger MatchingCore::logger()
   return logger_;
 }
 
+void MatchingCore::on_start()
+{
+  restore_index_snapshot();
+}
+
+void MatchingCore::on_stop()
+{
+  write_index_snapshot();
+}
+
 void MatchingCore::on_timeslot_complete()
 {
+  resync_aggregation();
   send_metrics_to_aggregation();
 
   matching_to_aggregation_stats_.check_utilization();
   matching_to_logging_stats_.check_utilization();
 
   index_.send_pulse();
+
+  refresh_ip_enrichment();
+}
+
+void MatchingCore::resync_rpc_client(size_t client_index)
+{
+  CoreBase::resync_rpc_client(client_index);
+
+  // only forwarded queues start over, and with those there's a client for
+  // each ingest shard, in order
+  ingest_string_dictionaries.reset(client_index);
+}
+
+void MatchingCore::resync_aggregation()
+{
+  for (size_t shard = 0; shard < aggregation_resyncs.size(); ++shard) {
+    if (!matching_to_aggregation_queues_.resync_requested(shard_num(), shard)) {
+      continue;
+    }
+
+    LOG::info("matching-{}: starting over with aggregation shard {}", shard_num(), shard);
+
+    matching_to_aggregation_queues_.write_resync_marker(shard_num(), shard);
+    aggregation_string_dictionaries.reset(shard);
+    ++aggregation_resyncs[shard];
+  }
+}
+
+void MatchingCore::refresh_ip_enrichment()
+{
+  auto const version = ip_enrichment_loader_.version();
+  if (version == ip_enrichment_version_) {
+    return;
+  }
+
+  ip_enrichment_version_ = version;
+  ip_enrichment = ip_enrichment_loader_.current();
 }
 
 void MatchingCore::send_metrics_to_aggregation()
@@ -103,7 +150,7 @@ void MatchingCore::send_metrics_to_aggregation()
   u64 slot_timestamp = current_timestamp() - (u64)timeslot_duration();
 
   if (index_.flow.tcp_a_to_b_ready(slot_timestamp)) {
-    FlowSpan::send_metrics_to_aggregation(index_.flow, slot_timestamp);
+    FlowSpan::send_metrics_to_aggregation(index_, slot_timestamp);
   }
 }
 
@@ -7,19 +7,24 @@
 
 #include <reducer/core_base.h>
 
-#include <geoip/geoip.h>
+#include <reducer/ip_enrichment.h>
 #include <reducer/publisher.h>
 #include <reducer/rpc_stats.h>
+#include <reducer/string_dictionaries.h>
 #include <reducer/tsdb_format.h>
 
 #include <generated/ebpf_net/logging/writer.h>
 #include <generated/ebpf_net/matching/connection.h>
 #include <generated/ebpf_net/matching/index.h>
 #include <generated/ebpf_net/matching/protocol.h>
+#include <generated/ebpf_net/matching/snapshot.h>
 #include <generated/ebpf_net/matching/span_base.h>
 #include <generated/ebpf_net/matching/transform_builder.h>
 
+#include <util/string_interner.h>
+
 #include <memory>
+#include <vector>
 
 namespace reducer {
 class RpcQueueMatrix;
@@ -43,18 +48,37 @@ public:
   // created
   static void enable_aws_enrichment(bool enabled);
 
+  // Enables sending aggregation the latency sketches of agg_roots, for when
+  // an aggregation output uses them.
+  // NOTE: must be called on startup, before any matching cores are created
+  static void enable_latency_sketches(bool enabled);
+
   // Enables using IP address for autonomous systems.
   static void set_autonomous_system_ip_enabled(bool enabled);
   // Returns whether using IP addresses for autonomous systems is enabled.
   static bool autonomous_system_ip_enabled();
 
-  geoip::database an_db;
+  // This core's reference to the IP enrichment table shared by all matching
+  // cores, or nullptr if there's none. Switched to the loader's current table
+  // between timeslots, so a reload never changes it in the middle of one.
+  std::shared_ptr<IpEnrichment const> ip_enrichment;
+
+  // Dictionaries of strings sent by the ingest cores, by ingest shard.
+  StringDictionaryReaders ingest_string_dictionaries;
+  // Dictionaries of strings sent to the aggregation cores, by aggregation shard.
+  StringDictionaryWriters aggregation_string_dictionaries;
+  // Number of times each aggregation shard was asked to start over, see
+  // resync_aggregation(). Flows replace agg_roots allocated before.
+  std::vector<u64> aggregation_resyncs;
+
+  // Storage for the node metadata strings held by flow spans.
+  StringInterner flow_strings;
 
   MatchingCore(
       RpcQueueMatrix &ingest_to_matching_queues,
       RpcQueueMatrix &matching_to_aggregation_queues,
       RpcQueueMatrix &matching_to_logging_queues,
-      std::optional<std::string> geoip_path,
+      IpEnrichmentLoader const &ip_enrichment_loader,
       size_t shard_num,
       u64 initial_timestamp);
 
@@ -65,6 +89,12 @@ private:
   // Flag indicating whether IP addresses should be used for autonomous systems.
   static bool autonomous_system_ip_enabled_;
 
+  RpcQueueMatrix &matching_to_aggregation_queues_;
+
+  IpEnrichmentLoader const &ip_enrichment_loader_;
+  // Loader version of ip_enrichment.
+  u64 ip_enrichment_version_;
+
   // Keeper of ingest->this RPC stats.
   RpcReceiverStats ingest_to_matching_stats_;
   // Keeper of this->aggregation RPC stats.
@@ -80,6 +110,21 @@ private:
 
   void on_timeslot_complete() override;
 
+  // Drops the strings and agg_roots of ingest shard |client_index|, which
+  // started over.
+  void resync_rpc_client(size_t client_index) override;
+
+  // Starts over with the aggregation shards that asked for it: they forget
+  // this core's strings and agg_roots, so flows allocate new agg_roots.
+  void resync_aggregation();
+
+  // Picks up the IP enrichment table if the loader built a new one.
+  void refresh_ip_enrichment();
+
+  // Restores the index snapshot when the core starts, and writes it when the core stops.
+  void on_start() override;
+  void on_stop() override;
+
   // Sends metrics from the metrics store to the aggregation core.
   void send_metrics_to_aggregation();
 
@@ -7,6 +7,7 @@ namespace {
 
 static constexpr std::string_view UNIT_BYTES = "By";
 static constexpr std::string_view UNIT_MICROSECONDS = "us";
+static constexpr std::string_view UNIT_SECONDS = "s";
 static constexpr std::string_view UNIT_DIMENSIONLESS = "1";
 
 } // namespace
@@ -71,6 +72,14 @@ TcpMetricInfo TcpMetricInfo::resets{
     UNIT_DIMENSIONLESS,
     MetricTypeSum};
 
+TcpMetricInfo TcpMetricInfo::rtt{
+    TcpMetrics::rtt,
+    "The distribution of round trip times between the source and destination in seconds, for the prior thirty seconds."
+    " Each flow contributes its average RTT over that time, weighted by its number of RTT measurements, so the"
+    " distribution is of per-flow averages rather than of individual measurements.",
+    UNIT_SECONDS,
+    MetricTypeExponentialHistogram};
+
 ////////////////////////////////////////////////////////////////////////////////
 // UDP
 //
@@ -137,6 +146,15 @@ DnsMetricInfo DnsMetricInfo::timeouts{
     UNIT_DIMENSIONLESS,
     MetricTypeSum};
 
+DnsMetricInfo DnsMetricInfo::client_duration{
+    DnsMetrics::client_duration,
+    "The distribution of durations in seconds from when the client sends a DNS request, until the response is received"
+    " back from the server, for the prior thirty seconds. Each flow contributes its average duration over that time,"
+    " weighted by its number of responses, so the distribution is of per-flow averages rather than of individual"
+    " requests.",
+    UNIT_SECONDS,
+    MetricTypeExponentialHistogram};
+
 ////////////////////////////////////////////////////////////////////////////////
 // HTTP
 //
@@ -169,4 +187,13 @@ HttpMetricInfo HttpMetricInfo::status_code{
     " HTTPv1 status code between the source and destination measured for the prior thirty seconds.",
     UNIT_DIMENSIONLESS,
     MetricTypeSum};
+
+HttpMetricInfo HttpMetricInfo::client_duration{
+    HttpMetrics::client_duration,
+    "The distribution of durations in seconds from when the client sends an HTTP request, until the response is received"
+    " back from the server, for the prior thirty seconds. Each flow contributes its average duration over that time,"
+    " weighted by its number of active sockets, so the distribution is of per-flow averages rather than of individual"
+    " requests.",
+    UNIT_SECONDS,
+    MetricTypeExponentialHistogram};
 } // namespace reducer
@@ -16,6 +16,8 @@ enum MetricType {
   MetricTypeSum,
   // OTLP Metric Data Gauge
   MetricTypeGauge,
+  // OTLP Metric Data ExponentialHistogram
+  MetricTypeExponentialHistogram,
 };
 
 // Information associated with a metric.
@@ -62,6 +64,7 @@ struct TcpMetricInfo : public OutboundMetricInfo<TcpMetrics> {
   static TcpMetricInfo syn_timeouts;
   static TcpMetricInfo new_sockets;
   static TcpMetricInfo resets;
+  static TcpMetricInfo rtt;
 };
 
 // Information on UDP outbound metrics.
@@ -85,6 +88,7 @@ struct DnsMetricInfo : public OutboundMetricInfo<DnsMetrics> {
   static DnsMetricInfo active_sockets;
   static DnsMetricInfo responses;
   static DnsMetricInfo timeouts;
+  static DnsMetricInfo client_duration;
 };
 
 // Information on HTTP outbound metrics.
@@ -96,6 +100,7 @@ struct HttpMetricInfo : public OutboundMetricInfo<HttpMetrics> {
   static HttpMetricInfo server_duration_average;
   static HttpMetricInfo active_sockets;
   static HttpMetricInfo status_code;
+  static HttpMetricInfo client_duration;
 };
 
 } // namespace reducer
@@ -26,6 +26,16 @@ int global_otlp_grpc_batch_size = 1000;
 
 namespace reducer {
 
+namespace {
+
+// Duration covered by a data point: a 30-second timeslot, or |rollup| seconds.
+int64_t interval_ns(TsdbFormatter::rollup_t rollup)
+{
+  return int64_t(rollup.value_or(30)) * 1000000000;
+}
+
+} // namespace
+
 bool OtlpGrpcFormatter::metric_description_field_enabled_ = false;
 
 void OtlpGrpcFormatter::set_metric_description_field_enabled(bool enabled)
@@ -140,9 +150,9 @@ void OtlpGrpcFormatter::format(
     }
   }
 
-  if (timestamp_changed) {
-    // set the start time to the timestamp minus 30 seconds.
-    data_point_.set_start_time_unix_nano(integer_time<std::chrono::nanoseconds>(timestamp) - int64_t(30000000000));
+  if (timestamp_changed || rollup_changed) {
+    // set the start time to the timestamp minus 30 seconds, or minus the rollup.
+    data_point_.set_start_time_unix_nano(integer_time<std::chrono::nanoseconds>(timestamp) - interval_ns(rollup));
     data_point_.set_time_unix_nano(integer_time<std::chrono::nanoseconds>(timestamp));
   }
 
@@ -169,6 +179,62 @@ void OtlpGrpcFormatter::format(
   }
 }
 
+void OtlpGrpcFormatter::format_histogram(
+    MetricInfo const &metric_info,
+    ::util::LatencySketch const &sketch,
+    labels_t const &labels,
+    timestamp_t timestamp,
+    Publisher::WriterPtr const &unused_writer)
+{
+  if (sketch.empty()) {
+    return;
+  }
+
+  START_TIMING(OtlpGrpcFormatterFormatHistogram);
+  opentelemetry::proto::metrics::v1::Metric metric;
+
+  metric.set_name(metric_info.name.data(), metric_info.name.size());
+  metric.set_unit(metric_info.unit.data(), metric_info.unit.size());
+  if (metric_description_field_enabled()) {
+    metric.set_description(metric_info.description.data(), metric_info.description.size());
+  }
+
+  auto histogram = metric.mutable_exponential_histogram();
+  histogram->set_aggregation_temporality(
+      opentelemetry::proto::metrics::v1::AggregationTemporality::AGGREGATION_TEMPORALITY_DELTA);
+
+  auto data_point = histogram->add_data_points();
+  for (auto const &[key, value] : labels) {
+    auto attribute = data_point->add_attributes();
+    attribute->set_key(key.data(), key.size());
+    attribute->mutable_value()->set_string_value(value.data(), value.size());
+  }
+
+  // set the start time to the timestamp minus 30 seconds, or minus the rollup, as in format().
+  data_point->set_start_time_unix_nano(integer_time<std::chrono::nanoseconds>(timestamp) - interval_ns(rollup()));
+  data_point->set_time_unix_nano(integer_time<std::chrono::nanoseconds>(timestamp));
+
+  data_point->set_count(sketch.count());
+  data_point->set_sum(sketch.sum());
+  data_point->set_min(sketch.min());
+  data_point->set_max(sketch.max());
+  data_point->set_scale(sketch.scale());
+  data_point->set_zero_count(sketch.zero_count());
+
+  auto positive = data_point->mutable_positive();
+  positive->set_offset(sketch.offset());
+  for (u64 count : sketch.bucket_counts()) {
+    positive->add_bucket_counts(count);
+  }
+
+  *scope_metrics_->add_metrics() = std::move(metric);
+  STOP_TIMING(OtlpGrpcFormatterFormatHistogram);
+
+  if (scope_metrics_->metrics_size() >= global_otlp_grpc_batch_size) {
+    send_metrics_request();
+  }
+}
+
 void OtlpGrpcFormatter::format_flow_log(
     ebpf_net::metrics::tcp_metrics const &tcp_metrics,
     labels_t labels,
@@ -46,6 +46,14 @@ protected:
       bool timestamp_changed,
       Publisher::WriterPtr const &unused_writer) override;
 
+  // Format a latency distribution as an exponential histogram.
+  void format_histogram(
+      MetricInfo const &metric_info,
+      ::util::LatencySketch const &sketch,
+      labels_t const &labels,
+      timestamp_t timestamp,
+      Publisher::WriterPtr const &unused_writer) override;
+
   // Format tcp_metrics as a flow log.
   void format_flow_log(
       ebpf_net::metrics::tcp_metrics const &tcp_metrics,
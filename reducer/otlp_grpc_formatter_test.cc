@@ -1,6 +1,7 @@
 // Copyright The OpenTelemetry Authors
 // SPDX-License-Identifier: Apache-2.0
 
+#include "metric_info.h"
 #include "otlp_grpc_formatter.h"
 #include "publisher.h"
 
@@ -246,4 +247,67 @@ TEST_F(OtlpGrpcFormatterTest, ValidateMetricsRequest)
   }
 }
 
+TEST_F(OtlpGrpcFormatterTest, ValidateHistogramRequest)
+{
+  ::util::LatencySketch sketch;
+  sketch.add(0.0, 2);
+  sketch.add(0.010, 5);
+  sketch.add(0.250, 3);
+
+  TsdbFormatter::labels_t labels{{"az_equal", "false"}, {"daz", "us-east-1"}, {"saz", "us-west-1"}};
+  auto const timestamp = 1652901833555555555ns;
+
+  formatter_->set_aggregation("az_az");
+  formatter_->set_labels(labels);
+  formatter_->set_timestamp(timestamp);
+  formatter_->write_histogram(TcpMetricInfo::rtt, sketch, writer_);
+  formatter_->flush();
+
+  auto const &metrics = metrics_request_to_validate_.resource_metrics(0).scope_metrics(0);
+  ASSERT_EQ(1, metrics.metrics_size());
+
+  auto const &metric = metrics.metrics(0);
+  EXPECT_EQ(TcpMetricInfo::rtt.name, metric.name());
+  EXPECT_EQ(TcpMetricInfo::rtt.unit, metric.unit());
+  ASSERT_TRUE(metric.has_exponential_histogram());
+
+  auto const &histogram = metric.exponential_histogram();
+  EXPECT_EQ(
+      opentelemetry::proto::metrics::v1::AggregationTemporality::AGGREGATION_TEMPORALITY_DELTA,
+      histogram.aggregation_temporality());
+  ASSERT_EQ(1, histogram.data_points_size());
+
+  auto const &data_point = histogram.data_points(0);
+  EXPECT_EQ(integer_time<std::chrono::nanoseconds>(timestamp), data_point.time_unix_nano());
+  EXPECT_EQ(10u, data_point.count());
+  EXPECT_EQ(2u, data_point.zero_count());
+  EXPECT_DOUBLE_EQ(sketch.sum(), data_point.sum());
+  EXPECT_EQ(0.0, data_point.min());
+  EXPECT_EQ(0.250, data_point.max());
+  EXPECT_EQ(sketch.scale(), data_point.scale());
+  EXPECT_EQ(sketch.offset(), data_point.positive().offset());
+
+  u64 bucket_total = 0;
+  for (auto count : data_point.positive().bucket_counts()) {
+    bucket_total += count;
+  }
+  EXPECT_EQ(8u, bucket_total);
+
+  EXPECT_EQ(labels.size(), (size_t)data_point.attributes_size());
+  for (auto const &attribute : data_point.attributes()) {
+    ASSERT_EQ(1u, labels.count(attribute.key()));
+    EXPECT_EQ(labels.at(attribute.key()), attribute.value().string_value());
+  }
+}
+
+TEST_F(OtlpGrpcFormatterTest, EmptyHistogramIsSkipped)
+{
+  formatter_->set_labels({{"az_equal", "true"}});
+  formatter_->set_timestamp(1652901836666666666ns);
+  formatter_->write_histogram(TcpMetricInfo::rtt, ::util::LatencySketch(), writer_);
+  formatter_->flush();
+
+  EXPECT_EQ(0, metrics_request_to_validate_.resource_metrics_size());
+}
+
 } // namespace reducer
@@ -55,6 +55,7 @@
   X(syn_timeouts, 0x040, TCP_PREFIX "syn_timeouts")                                                                            \
   X(new_sockets, 0x080, TCP_PREFIX "new_sockets")                                                                              \
   X(resets, 0x100, TCP_PREFIX "resets")                                                                                        \
+  X(rtt, 0x200, TCP_PREFIX "rtt")                                                                                              \
   X(all, 0xFFFFFFFF, TCP_PREFIX "all")
 #define ENUM_DEFAULT unknown
 #include <util/enum_operators.inl>
@@ -86,6 +87,7 @@
   X(active_sockets, 0x004, DNS_PREFIX "active_sockets")                                                                        \
   X(responses, 0x008, DNS_PREFIX "responses")                                                                                  \
   X(timeouts, 0x010, DNS_PREFIX "timeouts")                                                                                    \
+  X(client_duration, 0x020, DNS_PREFIX "client.duration")                                                                      \
   X(all, 0xFFFFFFFF, DNS_PREFIX "all")
 #define ENUM_DEFAULT unknown
 #include <util/enum_operators.inl>
@@ -101,6 +103,7 @@
   X(server_duration_average, 0x002, HTTP_PREFIX "server.duration.average")                                                     \
   X(active_sockets, 0x004, HTTP_PREFIX "active_sockets")                                                                       \
   X(status_code, 0x008, HTTP_PREFIX "status_code")                                                                             \
+  X(client_duration, 0x010, HTTP_PREFIX "client.duration")                                                                     \
   X(all, 0xFFFFFFFF, HTTP_PREFIX "all")
 #define ENUM_DEFAULT unknown
 #include <util/enum_operators.inl>
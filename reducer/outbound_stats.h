@@ -62,6 +62,11 @@
   X(span_utilization_max,                0x0000'0020'0000'0000, INTERNAL_PREFIX "span_utilization_max") \
   X(time_since_last_message_ns,          0x0000'0040'0000'0000, INTERNAL_PREFIX "time_since_last_message_ns") \
   X(up,                                  0x0000'0080'0000'0000, INTERNAL_PREFIX "up") \
+  X(rpc_late_messages,                   0x0000'0100'0000'0000, INTERNAL_PREFIX "rpc_late_messages") \
+  X(rpc_input_lag,                       0x0000'0200'0000'0000, INTERNAL_PREFIX "rpc_input_lag") \
+  X(aggregation_series,                  0x0000'0400'0000'0000, INTERNAL_PREFIX "aggregation_series") \
+  X(aggregation_series_folded,           0x0000'0800'0000'0000, INTERNAL_PREFIX "aggregation_series_folded") \
+  X(aggregation_series_evicted,          0x0000'1000'0000'0000, INTERNAL_PREFIX "aggregation_series_evicted") \
   X(all,                                 0xFFFF'FFFF'FFFF'FFFF, INTERNAL_PREFIX "all")
 // clang-format on
 #define ENUM_DEFAULT unknown
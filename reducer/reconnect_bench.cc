@@ -0,0 +1,251 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+// Reconnect storm benchmark: how long it takes ingest workers to get back to
+// steady state when every collector reconnects at once, e.g. after a reducer
+// restart, and how much memory the connections take meanwhile.
+//
+// Each collector connects over loopback and sends a handshake, standing for
+// the connection-setup messages (`connect`, `version_info`, `os_info`,
+// `set_node_info`, ...) and the initial state it reports. A collector is in
+// steady state once its handshake has been received. Runs are compared with
+// the agent's DNS cache allocated at connection time, as it used to be, or on
+// demand, and with or without pacing admissions.
+//
+// Not part of the unit test suite; run manually:
+//   reconnect_bench [--gtest_filter=...]
+//
+// RECONNECT_BENCH_COLLECTORS (5000 by default) collectors connect to
+// RECONNECT_BENCH_WORKERS (4 by default) workers, each sending a handshake of
+// RECONNECT_BENCH_HANDSHAKE_SIZE bytes (16384 by default). Paced runs admit
+// RECONNECT_BENCH_ADMISSIONS connections per second per worker (500 by
+// default). The open files limit is raised as needed, if allowed.
+
+#include <reducer/dns_cache.h>
+#include <reducer/ingest/agent_span.h>
+#include <reducer/worker.h>
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace reducer {
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+u64 env_or(char const *name, u64 fallback)
+{
+  if (char const *env = getenv(name)) {
+    return strtoull(env, nullptr, 10);
+  }
+  return fallback;
+}
+
+// Resident and virtual memory of the process, in bytes.
+std::pair<u64, u64> memory_usage()
+{
+  u64 size = 0;
+  u64 resident = 0;
+  std::ifstream("/proc/self/statm") >> size >> resident;
+  u64 const page_size = sysconf(_SC_PAGESIZE);
+  return {resident * page_size, size * page_size};
+}
+
+struct Storm {
+  u64 handshake_size;
+  bool eager_caches;
+  // when each collector got to steady state, by collector index
+  std::vector<clock_type::time_point> steady_at;
+  std::atomic<u64> steady_count{0};
+};
+
+// Receives a collector's handshake, which starts with the collector's index.
+class HandshakeCallbacks : public ::channel::Callbacks {
+public:
+  explicit HandshakeCallbacks(Storm &storm) : storm_(storm)
+  {
+    if (storm_.eager_caches) {
+      dns_cache_ = std::make_unique<ingest::AgentSpan::dns_cache_type>();
+    }
+  }
+
+  u32 received_data(u8 const *data, int length) override
+  {
+    if (received_ < sizeof(index_)) {
+      u32 const needed = std::min<u32>(sizeof(index_) - received_, length);
+      memcpy(reinterpret_cast<u8 *>(&index_) + received_, data, needed);
+    }
+
+    received_ += length;
+    if (received_ == storm_.handshake_size) {
+      storm_.steady_at[index_] = clock_type::now();
+      storm_.steady_count.fetch_add(1, std::memory_order_release);
+    }
+    return length;
+  }
+
+  void on_error(int error) override {}
+
+private:
+  Storm &storm_;
+  std::unique_ptr<ingest::AgentSpan::dns_cache_type> dns_cache_;
+  u64 received_ = 0;
+  u32 index_ = 0;
+};
+
+class BenchWorker : public Worker {
+public:
+  explicit BenchWorker(Storm &storm) : storm_(storm) {}
+
+protected:
+  std::unique_ptr<::channel::Callbacks> create_callbacks(uv_loop_t &loop, ::channel::TCPChannel *tcp_channel) override
+  {
+    return std::make_unique<HandshakeCallbacks>(storm_);
+  }
+
+private:
+  Storm &storm_;
+};
+
+// Reconnects all collectors at once and prints how long they take to get to
+// steady state.
+void measure(char const *name, bool eager_caches, u32 admissions_per_second)
+{
+  u64 const worker_count = env_or("RECONNECT_BENCH_WORKERS", 4);
+  u64 collector_count = env_or("RECONNECT_BENCH_COLLECTORS", 5000);
+
+  // each collector takes a client socket, a server socket, and briefly the
+  // server socket's duplicate
+  struct rlimit limit;
+  ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &limit));
+  limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, std::max<rlim_t>(limit.rlim_cur, collector_count * 2 + 256));
+  setrlimit(RLIMIT_NOFILE, &limit);
+  if (collector_count * 2 + 256 > limit.rlim_cur) {
+    collector_count = (limit.rlim_cur - 256) / 2;
+    printf("open files limit of %llu only allows %llu collectors\n", (unsigned long long)limit.rlim_cur, collector_count);
+  }
+
+  Storm storm{
+      .handshake_size = std::max<u64>(env_or("RECONNECT_BENCH_HANDSHAKE_SIZE", 16384), sizeof(u32)),
+      .eager_caches = eager_caches,
+      .steady_at = std::vector<clock_type::time_point>(collector_count),
+  };
+
+  Worker::set_max_admissions_per_second(admissions_per_second);
+  std::vector<std::unique_ptr<BenchWorker>> workers;
+  for (u64 i = 0; i < worker_count; ++i) {
+    workers.push_back(std::make_unique<BenchWorker>(storm));
+    workers.back()->start(i);
+  }
+  Worker::set_max_admissions_per_second(0);
+
+  int const listener = ::socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_LE(0, listener);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(0, ::bind(listener, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)));
+  ASSERT_EQ(0, ::listen(listener, 128));
+  ASSERT_EQ(0, ::getsockname(listener, reinterpret_cast<struct sockaddr *>(&addr), &len));
+
+  // the loop of the server accepting connections, as in TcpServer
+  uv_loop_t loop;
+  ASSERT_EQ(0, uv_loop_init(&loop));
+
+  std::string handshake(storm.handshake_size, 'x');
+  std::vector<clock_type::time_point> connected_at(collector_count);
+  std::vector<int> clients;
+
+  auto const memory_before = memory_usage();
+  auto const start = clock_type::now();
+
+  for (u32 i = 0; i < collector_count; ++i) {
+    int const client = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_LE(0, client);
+    connected_at[i] = clock_type::now();
+    ASSERT_EQ(0, ::connect(client, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)));
+    clients.push_back(client);
+
+    int const server_fd = ::accept(listener, nullptr, nullptr);
+    ASSERT_LE(0, server_fd);
+    auto *const conn = reinterpret_cast<uv_tcp_t *>(std::malloc(sizeof(uv_tcp_t)));
+    ASSERT_EQ(0, uv_tcp_init(&loop, conn));
+    ASSERT_EQ(0, uv_tcp_open(conn, server_fd));
+    workers[i % worker_count]->assign(*conn);
+    uv_close(reinterpret_cast<uv_handle_t *>(conn), reinterpret_cast<uv_close_cb>(&std::free));
+    uv_run(&loop, UV_RUN_NOWAIT);
+
+    // sent in one go, which loopback socket buffers can take
+    memcpy(handshake.data(), &i, sizeof(i));
+    ASSERT_EQ(ssize_t(handshake.size()), ::write(client, handshake.data(), handshake.size()));
+  }
+  ::close(listener);
+
+  while (storm.steady_count.load(std::memory_order_acquire) < collector_count) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  auto const memory_after = memory_usage();
+  double const elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+
+  std::vector<double> latencies;
+  for (u64 i = 0; i < collector_count; ++i) {
+    latencies.push_back(std::chrono::duration<double, std::milli>(storm.steady_at[i] - connected_at[i]).count());
+  }
+  std::sort(latencies.begin(), latencies.end());
+
+  printf(
+      "%-14s steady after %6.2fs  per collector p50=%7.1fms p99=%7.1fms  memory +%6.1f MB resident +%8.1f MB virtual\n",
+      name,
+      elapsed,
+      latencies[latencies.size() / 2],
+      latencies[latencies.size() * 99 / 100],
+      (double(memory_after.first) - double(memory_before.first)) / 1e6,
+      (double(memory_after.second) - double(memory_before.second)) / 1e6);
+
+  for (int client : clients) {
+    ::close(client);
+  }
+  for (auto &worker : workers) {
+    worker->stop();
+  }
+  uv_run(&loop, UV_RUN_DEFAULT);
+  EXPECT_EQ(0, uv_loop_close(&loop));
+}
+
+} // namespace
+
+TEST(ReconnectBench, EagerCaches)
+{
+  measure("eager caches", true, 0);
+}
+
+TEST(ReconnectBench, LazyCaches)
+{
+  measure("lazy caches", false, 0);
+}
+
+TEST(ReconnectBench, LazyCachesPaced)
+{
+  measure("lazy, paced", false, env_or("RECONNECT_BENCH_ADMISSIONS", 500));
+}
+
+} // namespace reducer
@@ -8,6 +8,7 @@
 #include <reducer/disabled_metrics.h>
 #include <reducer/ingest/agent_span.h>
 #include <reducer/ingest/component.h>
+#include <reducer/ingest/ingest_worker.h>
 #include <reducer/matching/component.h>
 #include <reducer/null_publisher.h>
 #include <reducer/otlp_grpc_formatter.h>
@@ -16,39 +17,86 @@
 #include <reducer/reducer.h>
 #include <reducer/reducer_config.h>
 #include <reducer/util/index_dumper.h>
+#include <reducer/util/index_snapshotter.h>
 
 #include <channel/component.h>
 #include <common/client_type.h>
 
-#include <geoip/geoip.h>
-
 #include <util/boot_time.h>
 #include <util/debug.h>
 #include <util/environment_variables.h>
 #include <util/error_handling.h>
 #include <util/file_ops.h>
 #include <util/log.h>
+#include <util/string_view.h>
 #include <util/uv_helpers.h>
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <ctime>
 #include <filesystem>
 #include <iomanip>
 #include <sstream>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 
 namespace reducer {
 
+namespace {
+
+// Parses the addresses of the reducer processes to distribute shards across.
+std::vector<std::string> parse_shard_peers(ReducerConfig const &config)
+{
+  std::vector<std::string> peers;
+  try {
+    peers = RpcBridge::parse_peers(config.shard_peers);
+  } catch (std::invalid_argument const &e) {
+    LOG::critical("Invalid shard peers: {}", e.what());
+    exit(1);
+  }
+
+  if (!peers.empty() && config.shard_peer_index >= peers.size()) {
+    LOG::critical("Shard peer index {} is out of range for {} shard peers", config.shard_peer_index, peers.size());
+    exit(1);
+  }
+
+  return peers;
+}
+
+} // namespace
+
 Reducer::Reducer(uv_loop_t &loop, ReducerConfig &config)
     : loop_(loop),
       config_(config),
-      ingest_to_matching_queues_(config_.num_ingest_shards, config_.num_matching_shards),
-      ingest_to_logging_queues_(config_.num_ingest_shards, 1),
-      matching_to_logging_queues_(config_.num_matching_shards, 1),
-      matching_to_aggregation_queues_(config_.num_matching_shards, config_.num_aggregation_shards),
-      aggregation_to_logging_queues_(config_.num_aggregation_shards, 1)
+      shard_peers_(parse_shard_peers(config_)),
+      shard_map_(shard_peers_.empty() ? ShardMap() : ShardMap(config_.shard_peer_index, shard_peers_.size())),
+      // each process runs its own ingest shards, while matching and
+      // aggregation shards are distributed across processes
+      ingest_to_matching_queues_(
+          shard_map_.num_processes() * config_.num_ingest_shards,
+          config_.num_matching_shards,
+          {[this](size_t s) { return shard_map_.is_local_ingest(s, config_.num_ingest_shards); },
+           [this](size_t r) { return shard_map_.is_local(r); },
+           /* forwarded */ true}),
+      ingest_to_logging_queues_(
+          shard_map_.num_processes() * config_.num_ingest_shards,
+          1,
+          {[this](size_t s) { return shard_map_.is_local_ingest(s, config_.num_ingest_shards); },
+           [](size_t) { return true; }}),
+      matching_to_logging_queues_(
+          config_.num_matching_shards, 1, {[this](size_t s) { return shard_map_.is_local(s); }, [](size_t) { return true; }}),
+      matching_to_aggregation_queues_(
+          config_.num_matching_shards,
+          config_.num_aggregation_shards,
+          {[this](size_t s) { return shard_map_.is_local(s); },
+           [this](size_t r) { return shard_map_.is_local(r); },
+           /* forwarded */ true}),
+      aggregation_to_logging_queues_(
+          config_.num_aggregation_shards,
+          1,
+          {[this](size_t s) { return shard_map_.is_local(s); }, [](size_t) { return true; }})
 {}
 
 void Reducer::startup()
@@ -74,6 +122,11 @@ void Reducer::shutdown()
   LOG::info("Stopping ingest core threads...");
   ingest_core_->stop_async();
 
+  if (rpc_bridge_) {
+    LOG::info("Stopping RPC bridge thread...");
+    rpc_bridge_->stop_async();
+  }
+
   for (std::size_t i = 0; i < matching_cores_.size(); ++i) {
     LOG::info("Stopping matching core thread {}...", i);
     matching_cores_[i]->stop_async();
@@ -98,6 +151,23 @@ void Reducer::init_config()
   reducer::aggregation::AggCore::set_id_id_enabled(config_.enable_id_id);
   reducer::aggregation::AggCore::set_az_id_enabled(config_.enable_az_id);
   reducer::aggregation::AggCore::set_flow_logs_enabled(config_.enable_flow_logs);
+  reducer::aggregation::AggCore::set_max_id_id_series(config_.max_id_id_series);
+  reducer::aggregation::AggCore::set_max_az_id_series(config_.max_az_id_series);
+
+  for (std::string_view rollups = config_.metric_rollups; !rollups.empty();) {
+    auto const name = views::trim_ws(views::trim_up_to(rollups, ',', views::SeekBehavior::CONSUME));
+    if (name.empty()) {
+      continue;
+    }
+
+    reducer::aggregation::Rollup rollup;
+    if (!enum_from_string(name, rollup)) {
+      LOG::critical("Unknown metric rollup '{}', expected one of: 5m, 1h", name);
+      exit(1);
+    }
+
+    reducer::aggregation::AggCore::set_rollup_enabled(rollup, true);
+  }
 
   reducer::logging::LoggingCore::set_otlp_formatted_internal_metrics_enabled(config_.enable_otlp_grpc_metrics);
   reducer::OtlpGrpcFormatter::set_metric_description_field_enabled(config_.enable_otlp_grpc_metric_descriptions);
@@ -105,18 +175,43 @@ void Reducer::init_config()
   reducer::aggregation::AggCore::set_node_ip_field_disabled(config_.disable_node_ip_field);
   reducer::matching::MatchingCore::set_autonomous_system_ip_enabled(config_.enable_autonomous_system_ip);
 
-  // If the path to a GeoIP database is defined, try loading the database here
-  // and print an error message if it fails.
-  // Unfortunately, the database structure is not thread safe and is not
-  // cloneable, so each matching shard will have to load it again for itself.
-  //
-  if (config_.geoip_path) {
+  reducer::Core::set_max_input_lateness(std::chrono::seconds(config_.max_input_lateness));
+
+  reducer::Worker::set_io_uring_enabled(config_.enable_io_uring);
+  reducer::Worker::set_max_admissions_per_second(config_.ingest_admissions_per_second);
+
+  if (config_.zstd_dictionary_path) {
+#if ENABLE_ZSTD
+    auto const dictionary = read_file_as_string(config_.zstd_dictionary_path->c_str());
+    if (!dictionary) {
+      LOG::critical("Could not read zstd dictionary {}: {}", *config_.zstd_dictionary_path, dictionary.error());
+      exit(1);
+    }
+
     try {
-      geoip::database geoip_db(config_.geoip_path->c_str());
-      LOG::info("Loaded GeoIP database from '{}'.", *config_.geoip_path);
-    } catch (std::exception &exc) {
-      LOG::error("Failed to load GeoIP database from '{}': {}.", *config_.geoip_path, exc.what());
-      config_.geoip_path.reset(); // so matching shards don't try loading it for naught
+      reducer::ingest::IngestWorker::set_zstd_dictionary(ZstdDecompressor::load_dictionary(*dictionary));
+    } catch (std::exception const &e) {
+      LOG::critical("Could not load zstd dictionary {}: {}", *config_.zstd_dictionary_path, e.what());
+      exit(1);
+    }
+#else
+    LOG::warn("Ignoring zstd dictionary {}: zstd is not supported by this build", *config_.zstd_dictionary_path);
+#endif
+  }
+
+  // Build the IP enrichment table from the GeoIP database and the IP labels
+  // file, printing an error message for either that fails to load.
+  // The table is immutable, so all matching shards share one; a new one is
+  // built when the files change.
+  //
+  ip_enrichment_loader_ = std::make_unique<IpEnrichmentLoader>(config_.geoip_path, config_.ip_labels_path);
+  ip_enrichment_loader_->reload_if_changed();
+
+  if (ip_enrichment_loader_->enabled() && config_.ip_enrichment_reload_interval) {
+    auto const reload_interval = std::chrono::seconds{config_.ip_enrichment_reload_interval};
+    ip_enrichment_reload_timer_ = std::make_unique<scheduling::Timer>(loop_, [this] { reload_ip_enrichment(); });
+    if (auto started = ip_enrichment_reload_timer_->start(reload_interval, reload_interval); !started) {
+      LOG::error("Failed to start IP enrichment reload timer: {}.", started.error());
     }
   }
 
@@ -150,12 +245,51 @@ void Reducer::init_config()
     IndexDumper::set_dump_dir("");
     IndexDumper::set_cooldown(0s);
   }
+
+  if (config_.enable_index_snapshots) {
+    std::filesystem::path snapshot_dir;
+    if (auto data_dir = try_get_env_var(DATA_DIR_VAR); !data_dir.empty()) {
+      snapshot_dir = std::filesystem::path(data_dir) / "snapshot";
+    } else {
+      snapshot_dir = std::filesystem::current_path() / "snapshot";
+    }
+
+    LOG::info("Writing index snapshots to {}", snapshot_dir);
+
+    if (!std::filesystem::exists(snapshot_dir)) {
+      std::error_code ec;
+      if (!std::filesystem::create_directories(snapshot_dir, ec)) {
+        LOG::critical("Could not create directory {}: {}", snapshot_dir, ec);
+        exit(1);
+      }
+    } else if (!std::filesystem::is_directory(snapshot_dir)) {
+      LOG::critical("{} exists but is not a directory!", snapshot_dir);
+      exit(1);
+    }
+
+    IndexSnapshotter::set_snapshot_dir(snapshot_dir.native());
+    IndexSnapshotter::set_interval(std::chrono::seconds{config_.index_snapshot_interval});
+    IndexSnapshotter::set_grace_period(std::chrono::seconds{config_.index_snapshot_grace_period});
+  } else {
+    IndexSnapshotter::set_snapshot_dir("");
+  }
 }
 
 void Reducer::init_cores()
 {
   const size_t num_stat_writers = 1; // one for the logging core
-  const size_t num_prom_metric_writers = config_.num_aggregation_shards * config_.partitions_per_shard;
+  auto const agg_shards = shard_map_.local_shards(config_.num_aggregation_shards);
+  auto const matching_shards = shard_map_.local_shards(config_.num_matching_shards);
+  const size_t num_prom_metric_writers = agg_shards.size() * config_.partitions_per_shard;
+
+  if (shard_map_.scaled_out()) {
+    LOG::info(
+        "Running process {} of {}: {} matching shard(s), {} aggregation shard(s)",
+        shard_map_.process(),
+        shard_map_.num_processes(),
+        matching_shards.size(),
+        agg_shards.size());
+  }
 
   if (config_.enable_otlp_grpc_metrics) {
     stats_publisher_ = std::make_unique<reducer::OtlpGrpcPublisher>(
@@ -179,9 +313,23 @@ void Reducer::init_cores()
         config_.scrape_size_limit_bytes);
   }
 
+  bool const rollups_enabled = std::any_of(
+      enum_traits<reducer::aggregation::Rollup>::values.begin(),
+      enum_traits<reducer::aggregation::Rollup>::values.end(),
+      reducer::aggregation::AggCore::rollup_enabled);
+
+  if (rollups_enabled && !config_.disable_prometheus_metrics) {
+    rollup_prom_metrics_publisher_ = std::make_unique<reducer::PrometheusPublisher>(
+        reducer::PrometheusPublisher::SINGLE_PORT,
+        agg_shards.size(),
+        config_.rollup_prom_bind,
+        1,
+        config_.scrape_size_limit_bytes);
+  }
+
   if (config_.enable_otlp_grpc_metrics) {
     otlp_metrics_publisher_ = std::make_unique<reducer::OtlpGrpcPublisher>(
-        config_.num_aggregation_shards,
+        agg_shards.size(),
         std::string(config_.otlp_grpc_metrics_address + ":" + std::to_string(config_.otlp_grpc_metrics_port)));
   }
 
@@ -191,6 +339,8 @@ void Reducer::init_cores()
   size_t prom_metric_writer_num = 0;
   // index of the next otlp metrics writer
   size_t otlp_metric_writer_num = 0;
+  // index of the next rollup prom metrics writer
+  size_t rollup_prom_metric_writer_num = 0;
 
   auto initial_timestamp = monotonic() + get_boot_time();
 
@@ -208,8 +358,8 @@ void Reducer::init_cores()
   // other in-process core(s), so authentication is not needed
   logging_core_->set_connection_authenticated();
 
-  agg_cores_.reserve(config_.num_aggregation_shards);
-  for (size_t shard = 0; shard < config_.num_aggregation_shards; ++shard) {
+  agg_cores_.reserve(agg_shards.size());
+  for (size_t const shard : agg_shards) {
     std::vector<reducer::Publisher::WriterPtr> prom_metric_writers;
     if (prom_metrics_publisher_) {
       prom_metric_writers.reserve(config_.partitions_per_shard);
@@ -223,6 +373,11 @@ void Reducer::init_cores()
       otlp_metric_writer = otlp_metrics_publisher_->make_writer(otlp_metric_writer_num++);
     }
 
+    std::vector<reducer::Publisher::WriterPtr> rollup_prom_metric_writers;
+    if (rollup_prom_metrics_publisher_) {
+      rollup_prom_metric_writers.emplace_back(rollup_prom_metrics_publisher_->make_writer(rollup_prom_metric_writer_num++));
+    }
+
     auto agg_core = std::make_unique<reducer::aggregation::AggCore>(
         matching_to_aggregation_queues_,
         aggregation_to_logging_queues_,
@@ -230,6 +385,7 @@ void Reducer::init_cores()
         std::move(prom_metric_writers),
         otlp_metrics_publisher_,
         std::move(otlp_metric_writer),
+        std::move(rollup_prom_metric_writers),
         config_.enable_percentile_latencies,
         config_.scrape_metrics_tsdb_format,
         disabled_metrics,
@@ -241,14 +397,17 @@ void Reducer::init_cores()
   }
 
   reducer::matching::MatchingCore::enable_aws_enrichment(config_.enable_aws_enrichment);
+  // matching feeds the sketches that aggregation cores aggregate, see AggCore
+  reducer::matching::MatchingCore::enable_latency_sketches(
+      reducer::aggregation::AggCore::latency_histograms_enabled(otlp_metrics_publisher_ != nullptr, disabled_metrics));
 
-  matching_cores_.reserve(config_.num_matching_shards);
-  for (size_t shard = 0; shard < config_.num_matching_shards; ++shard) {
+  matching_cores_.reserve(matching_shards.size());
+  for (size_t const shard : matching_shards) {
     auto matching_core = std::make_unique<reducer::matching::MatchingCore>(
         ingest_to_matching_queues_,
         matching_to_aggregation_queues_,
         matching_to_logging_queues_,
-        config_.geoip_path,
+        *ip_enrichment_loader_,
         shard,
         initial_timestamp);
     matching_core->set_connection_authenticated();
@@ -258,14 +417,26 @@ void Reducer::init_cores()
   ingest_core_ = std::make_unique<reducer::ingest::IngestCore>(
       ingest_to_logging_queues_, ingest_to_matching_queues_, config_.telemetry_port);
 
+  if (shard_map_.scaled_out()) {
+    rpc_bridge_ = std::make_unique<reducer::RpcBridge>(
+        shard_map_, shard_peers_, ingest_to_matching_queues_, matching_to_aggregation_queues_);
+  }
+
   // all writers created
   ASSUME(stat_writer_num == num_stat_writers);
   ASSUME(!prom_metrics_publisher_ || prom_metric_writer_num == num_prom_metric_writers);
 }
 
+void Reducer::reload_ip_enrichment()
+{
+  // Runs on the main loop, off the matching cores' threads; they pick the new
+  // table up at their next timeslot.
+  ip_enrichment_loader_->reload_if_changed();
+}
+
 void Reducer::start_threads()
 {
-  threads_.reserve(config_.num_matching_shards + config_.num_aggregation_shards + 3);
+  threads_.reserve(matching_cores_.size() + agg_cores_.size() + 3);
 
   // start all threads
   threads_.emplace_back(&reducer::logging::LoggingCore::run, logging_core_.get());
@@ -276,6 +447,9 @@ void Reducer::start_threads()
     threads_.emplace_back(&reducer::matching::MatchingCore::run, matching_core.get());
   }
   threads_.emplace_back(&reducer::ingest::IngestCore::run, ingest_core_.get());
+  if (rpc_bridge_) {
+    threads_.emplace_back(&reducer::RpcBridge::run, rpc_bridge_.get());
+  }
 }
 
 } // namespace reducer
@@ -7,13 +7,21 @@
 
 #include <reducer/aggregation/agg_core.h>
 #include <reducer/ingest/ingest_core.h>
+#include <reducer/ip_enrichment.h>
 #include <reducer/logging/logging_core.h>
 #include <reducer/matching/matching_core.h>
 #include <reducer/publisher.h>
 #include <reducer/reducer_config.h>
+#include <reducer/rpc_bridge.h>
 #include <reducer/rpc_queue_matrix.h>
+#include <reducer/shard_map.h>
 
+#include <scheduling/timer.h>
+
+#include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace reducer {
 
@@ -29,13 +37,25 @@ private:
   void init_cores();
   void start_threads();
 
+  void reload_ip_enrichment();
+
   uv_loop_t &loop_;
   ReducerConfig &config_;
 
   std::unique_ptr<reducer::Publisher> stats_publisher_;
   std::unique_ptr<reducer::Publisher> prom_metrics_publisher_;
+  std::unique_ptr<reducer::Publisher> rollup_prom_metrics_publisher_;
   std::unique_ptr<reducer::Publisher> otlp_metrics_publisher_;
 
+  // Loads the IP enrichment table shared by the matching cores.
+  std::unique_ptr<reducer::IpEnrichmentLoader> ip_enrichment_loader_;
+  // Periodically checks whether the IP enrichment files changed.
+  std::unique_ptr<scheduling::Timer> ip_enrichment_reload_timer_;
+
+  // Reducer processes the shards are distributed across, see ShardMap.
+  std::vector<std::string> shard_peers_;
+  reducer::ShardMap shard_map_;
+
   reducer::RpcQueueMatrix ingest_to_matching_queues_;
   reducer::RpcQueueMatrix ingest_to_logging_queues_;
   reducer::RpcQueueMatrix matching_to_logging_queues_;
@@ -46,6 +66,8 @@ private:
   std::vector<std::unique_ptr<reducer::aggregation::AggCore>> agg_cores_;
   std::vector<std::unique_ptr<reducer::matching::MatchingCore>> matching_cores_;
   std::unique_ptr<reducer::ingest::IngestCore> ingest_core_;
+  // Forwards messages to and from the other processes, when scaled out.
+  std::unique_ptr<reducer::RpcBridge> rpc_bridge_;
 
   std::vector<std::thread> threads_;
 };
@@ -13,15 +13,23 @@ namespace reducer {
 
 const ReducerConfig DEFAULT_REDUCER_CONFIG = {
     .telemetry_port = 8000,
+    .zstd_dictionary_path = std::nullopt,
+    .enable_io_uring = false,
+    .ingest_admissions_per_second = 0,
 
     .num_ingest_shards = 1,
     .num_matching_shards = 1,
     .num_aggregation_shards = 1,
     .partitions_per_shard = 1,
+    .max_input_lateness = 0,
+    .shard_peers = "",
+    .shard_peer_index = 0,
 
     .enable_id_id = false,
     .enable_az_id = false,
     .enable_flow_logs = false,
+    .max_id_id_series = 0,
+    .max_az_id_series = 0,
 
     .enable_otlp_grpc_metrics = false,
     .otlp_grpc_metrics_address = "localhost",
@@ -32,6 +40,7 @@ const ReducerConfig DEFAULT_REDUCER_CONFIG = {
     .disable_prometheus_metrics = false,
     .shard_prometheus_metrics = false,
     .prom_bind = "127.0.0.1:7010",
+    .rollup_prom_bind = "127.0.0.1:7011",
     .scrape_size_limit_bytes = std::nullopt,
     .internal_prom_bind = "0.0.0.0:7001",
     .stats_scrape_size_limit_bytes = std::nullopt,
@@ -41,14 +50,21 @@ const ReducerConfig DEFAULT_REDUCER_CONFIG = {
     .enable_autonomous_system_ip = false,
 
     .geoip_path = std::nullopt,
+    .ip_labels_path = std::nullopt,
+    .ip_enrichment_reload_interval = 60,
 
     .enable_aws_enrichment = false,
     .enable_percentile_latencies = false,
 
     .disable_metrics = "",
     .enable_metrics = "",
+    .metric_rollups = "",
 
     .index_dump_interval = 0,
+
+    .enable_index_snapshots = false,
+    .index_snapshot_interval = 0,
+    .index_snapshot_grace_period = 60,
 };
 
 namespace {
@@ -76,15 +92,23 @@ void read_config_from_yaml(ReducerConfig &config, std::string const &path)
   }
 
   LOAD_FIELD(telemetry_port);
+  LOAD_FIELD(zstd_dictionary_path);
+  LOAD_FIELD(enable_io_uring);
+  LOAD_FIELD(ingest_admissions_per_second);
 
   LOAD_FIELD(num_ingest_shards);
   LOAD_FIELD(num_matching_shards);
   LOAD_FIELD(num_aggregation_shards);
   LOAD_FIELD(partitions_per_shard);
+  LOAD_FIELD(max_input_lateness);
+  LOAD_FIELD(shard_peers);
+  LOAD_FIELD(shard_peer_index);
 
   LOAD_FIELD(enable_id_id);
   LOAD_FIELD(enable_az_id);
   LOAD_FIELD(enable_flow_logs);
+  LOAD_FIELD(max_id_id_series);
+  LOAD_FIELD(max_az_id_series);
 
   LOAD_FIELD(enable_otlp_grpc_metrics);
   LOAD_FIELD(otlp_grpc_metrics_address);
@@ -95,6 +119,7 @@ void read_config_from_yaml(ReducerConfig &config, std::string const &path)
   LOAD_FIELD(disable_prometheus_metrics);
   LOAD_FIELD(shard_prometheus_metrics);
   LOAD_FIELD(prom_bind);
+  LOAD_FIELD(rollup_prom_bind);
   LOAD_FIELD(scrape_size_limit_bytes);
   LOAD_FIELD(internal_prom_bind);
   LOAD_FIELD(stats_scrape_size_limit_bytes);
@@ -110,15 +135,22 @@ void read_config_from_yaml(ReducerConfig &config, std::string const &path)
   LOAD_FIELD(enable_autonomous_system_ip);
 
   LOAD_FIELD(geoip_path);
+  LOAD_FIELD(ip_labels_path);
+  LOAD_FIELD(ip_enrichment_reload_interval);
 
   LOAD_FIELD(enable_aws_enrichment);
   LOAD_FIELD(enable_percentile_latencies);
 
   LOAD_FIELD(disable_metrics);
   LOAD_FIELD(enable_metrics);
+  LOAD_FIELD(metric_rollups);
 
   LOAD_FIELD(index_dump_interval);
 
+  LOAD_FIELD(enable_index_snapshots);
+  LOAD_FIELD(index_snapshot_interval);
+  LOAD_FIELD(index_snapshot_grace_period);
+
 #undef LOAD_FIELD
 }
 
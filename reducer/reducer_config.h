@@ -20,15 +20,23 @@ namespace reducer {
 //
 struct ReducerConfig {
   u32 telemetry_port = 0;
+  std::optional<std::string> zstd_dictionary_path;
+  bool enable_io_uring = false;
+  u32 ingest_admissions_per_second = 0;
 
   u32 num_ingest_shards = 0;
   u32 num_matching_shards = 0;
   u32 num_aggregation_shards = 0;
   u32 partitions_per_shard = 0;
+  u64 max_input_lateness = 0;
+  std::string shard_peers;
+  u32 shard_peer_index = 0;
 
   bool enable_id_id = false;
   bool enable_az_id = false;
   bool enable_flow_logs = false;
+  u32 max_id_id_series = 0;
+  u32 max_az_id_series = 0;
 
   bool enable_otlp_grpc_metrics = false;
   std::string otlp_grpc_metrics_address;
@@ -39,6 +47,7 @@ struct ReducerConfig {
   bool disable_prometheus_metrics = false;
   bool shard_prometheus_metrics = false;
   std::string prom_bind;
+  std::string rollup_prom_bind;
   std::optional<u64> scrape_size_limit_bytes;
   std::string internal_prom_bind;
   std::optional<u64> stats_scrape_size_limit_bytes;
@@ -48,14 +57,21 @@ struct ReducerConfig {
   bool enable_autonomous_system_ip = false;
 
   std::optional<std::string> geoip_path;
+  std::optional<std::string> ip_labels_path;
+  u64 ip_enrichment_reload_interval = 60;
 
   bool enable_aws_enrichment = false;
   bool enable_percentile_latencies = false;
 
   std::string disable_metrics;
   std::string enable_metrics;
+  std::string metric_rollups;
 
   u64 index_dump_interval = 0;
+
+  bool enable_index_snapshots = false;
+  u64 index_snapshot_interval = 0;
+  u64 index_snapshot_grace_period = 0;
 };
 
 // Default configuration values.
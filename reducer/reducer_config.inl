@@ -12,13 +12,21 @@ namespace reducer {
 template <typename Out> Out &&operator<<(Out &&out, ReducerConfig const &config)
 {
   out << "telemetry_port: " << config.telemetry_port << "\n"
+      << "zstd_dictionary_path: " << (config.zstd_dictionary_path ? *config.zstd_dictionary_path : "none") << "\n"
+      << "enable_io_uring: " << config.enable_io_uring << "\n"
+      << "ingest_admissions_per_second: " << config.ingest_admissions_per_second << "\n"
       << "num_ingest_shards: " << config.num_ingest_shards << "\n"
       << "num_matching_shards: " << config.num_matching_shards << "\n"
       << "num_aggregation_shards: " << config.num_aggregation_shards << "\n"
       << "partitions_per_shard: " << config.partitions_per_shard << "\n"
+      << "max_input_lateness: " << config.max_input_lateness << "\n"
+      << "shard_peers: " << config.shard_peers << "\n"
+      << "shard_peer_index: " << config.shard_peer_index << "\n"
       << "enable_id_id: " << config.enable_id_id << "\n"
       << "enable_az_id: " << config.enable_az_id << "\n"
       << "enable_flow_logs: " << config.enable_flow_logs << "\n"
+      << "max_id_id_series: " << config.max_id_id_series << "\n"
+      << "max_az_id_series: " << config.max_az_id_series << "\n"
       << "enable_otlp_grpc_metrics: " << config.enable_otlp_grpc_metrics << "\n"
       << "otlp_grpc_metrics_address: " << config.otlp_grpc_metrics_address << "\n"
       << "otlp_grpc_metrics_port: " << config.otlp_grpc_metrics_port << "\n"
@@ -27,6 +35,7 @@ template <typename Out> Out &&operator<<(Out &&out, ReducerConfig const &config)
       << "disable_prometheus_metrics: " << config.disable_prometheus_metrics << "\n"
       << "shard_prometheus_metrics: " << config.shard_prometheus_metrics << "\n"
       << "prom_bind: " << config.prom_bind << "\n"
+      << "rollup_prom_bind: " << config.rollup_prom_bind << "\n"
       << "internal_prom_bind: " << config.internal_prom_bind << "\n";
 
   if (config.scrape_size_limit_bytes) {
@@ -45,11 +54,17 @@ template <typename Out> Out &&operator<<(Out &&out, ReducerConfig const &config)
       << "disable_node_ip_field: " << config.disable_node_ip_field << "\n"
       << "enable_autonomous_system_ip: " << config.enable_autonomous_system_ip << "\n"
       << "geoip_path: " << (config.geoip_path ? *config.geoip_path : "none") << "\n"
+      << "ip_labels_path: " << (config.ip_labels_path ? *config.ip_labels_path : "none") << "\n"
+      << "ip_enrichment_reload_interval: " << config.ip_enrichment_reload_interval << "\n"
       << "enable_aws_enrichment: " << config.enable_aws_enrichment << "\n"
       << "enable_percentile_latencies: " << config.enable_percentile_latencies << "\n"
       << "disable_metrics: " << config.disable_metrics << "\n"
       << "enable_metrics: " << config.enable_metrics << "\n"
-      << "index_dump_interval: " << config.index_dump_interval << "\n";
+      << "metric_rollups: " << config.metric_rollups << "\n"
+      << "index_dump_interval: " << config.index_dump_interval << "\n"
+      << "enable_index_snapshots: " << config.enable_index_snapshots << "\n"
+      << "index_snapshot_interval: " << config.index_snapshot_interval << "\n"
+      << "index_snapshot_grace_period: " << config.index_snapshot_grace_period << "\n";
 
   return std::forward<Out>(out);
 }
@@ -0,0 +1,689 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include "rpc_bridge.h"
+
+#include <reducer/constants.h>
+#include <reducer/rpc_queue_matrix.h>
+#include <reducer/util/thread_ops.h>
+
+#include <util/log.h>
+#include <util/log_formatters.h>
+#include <util/time.h>
+#include <util/uv_helpers.h>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+namespace reducer {
+
+namespace {
+
+constexpr int kListenBacklog = 128;
+constexpr auto kReconnectInterval = std::chrono::seconds(1);
+
+// Splits `host:port` at the last colon.
+std::pair<std::string, std::string> split_host_port(std::string const &peer)
+{
+  auto const colon = peer.rfind(':');
+  return {peer.substr(0, colon), peer.substr(colon + 1)};
+}
+
+// First thing sent on a connection, telling the receiving process what the
+// connection carries and how the sending process is set up.
+struct Hello {
+  static constexpr u64 kMagic = 0x31726272'66706265; // "ebpfrbr1"
+
+  u64 magic;
+  u32 num_senders;
+  u32 num_receivers;
+  u16 process;
+  u16 num_processes;
+  u8 edge;
+  u8 reserved[3];
+};
+static_assert(sizeof(Hello) == 24);
+
+// Precedes each forwarded message.
+struct FrameHeader {
+  u32 length;
+  u16 sender;
+  u16 receiver;
+};
+static_assert(sizeof(FrameHeader) == 8);
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Connection to another process, over which the messages of one edge of the
+// pipeline are sent to that process' receivers.
+//
+class RpcBridge::Outbound : public channel::Callbacks {
+public:
+  Outbound(RpcBridge &bridge, RpcBridgeEdge edge, size_t process)
+      : bridge_(bridge), edge_(edge), process_(process), peer_(bridge.peers_[process])
+  {
+    CHECK_UV(uv_timer_init(&bridge_.loop_, &reconnect_timer_));
+    reconnect_timer_.data = this;
+
+    auto &queues = bridge_.queues(edge_);
+    for (size_t sender : queues.local_senders()) {
+      for (size_t receiver = 0; receiver < queues.num_receivers(); ++receiver) {
+        if (bridge_.shard_map_.owner(receiver) == process_) {
+          queues_.push_back({u16(sender), u16(receiver), queues.make_reader(sender, receiver)});
+        }
+      }
+    }
+  }
+
+  void connect()
+  {
+    LOG::info("rpc bridge: connecting to process {} at {} for {}", process_, peer_, to_string(edge_));
+
+    // channels are closed permanently, so none is reinitialized while the
+    // loop shuts down; each attempt gets a new one
+    auto [host, port] = split_host_port(peer_);
+    // batches are pooled; kMaxWriteQueueSize bounds what waits to be sent
+    channel_ = std::make_unique<channel::TCPChannel>(
+        bridge_.loop_, host, port, channel::TCPSendLimits{.pooled_buffer_size = kSendBatchSize});
+    channel_->connect(*this);
+  }
+
+  void on_connect() override
+  {
+    LOG::info("rpc bridge: connected to process {} at {} for {}", process_, peer_, to_string(edge_));
+
+    auto &queues = bridge_.queues(edge_);
+
+    Hello hello = {};
+    hello.magic = Hello::kMagic;
+    hello.num_senders = queues.num_senders();
+    hello.num_receivers = queues.num_receivers();
+    hello.process = bridge_.shard_map_.process();
+    hello.num_processes = bridge_.shard_map_.num_processes();
+    hello.edge = static_cast<u8>(edge_);
+
+    if (channel_->send(reinterpret_cast<u8 const *>(&hello), sizeof(hello))) {
+      return;
+    }
+    connected_ = true;
+
+    for (auto &queue : queues_) {
+      if (had_connection_) {
+        // messages were lost with the previous connection, or the peer
+        // restarted and lost all it got: the senders start over, and what
+        // they queued before is dropped
+        queues.request_resync(queue.sender, queue.receiver);
+        queue.resyncing = true;
+        queue.send_marker = false;
+      } else {
+        // the queues hold all the senders sent, but the receivers may still
+        // have what an earlier run of this process sent them
+        queue.send_marker = true;
+      }
+    }
+    had_connection_ = true;
+  }
+
+  void on_error(int error) override
+  {
+    LOG::warn(
+        "rpc bridge: connection to process {} at {} for {} failed: {}", process_, peer_, to_string(edge_), uv_error_t{error});
+    connected_ = false;
+    channel_->close_permanently();
+  }
+
+  void on_closed() override
+  {
+    connected_ = false;
+    if (!bridge_.stopping_) {
+      CHECK_UV(uv_timer_start(
+          &reconnect_timer_, on_reconnect_timer, integer_time<std::chrono::milliseconds>(kReconnectInterval), 0));
+    }
+  }
+
+  // Sends what the outbound queues hold, unless there's too much waiting to
+  // be sent already. Returns whether anything was sent.
+  bool forward()
+  {
+    if (!connected_ || channel_->write_queue_size() >= kMaxWriteQueueSize) {
+      return false;
+    }
+
+    bool any_sent = false;
+
+    channel::TCPChannel::send_buffer_t *batch = nullptr;
+    u32 batch_capacity = 0;
+
+    auto const send_batch = [&] {
+      if (batch) {
+        channel_->send(batch);
+        batch = nullptr;
+      }
+    };
+
+    // Returns where to write a frame of |frame_len| bytes to, or nullptr if
+    // the connection failed.
+    auto const append_frame = [&](u32 frame_len) -> u8 * {
+      if (batch && (batch->len + frame_len > batch_capacity)) {
+        send_batch();
+      }
+      if (!connected_) {
+        // sending failed, the connection is closing
+        return nullptr;
+      }
+      if (!batch) {
+        batch_capacity = std::max(kSendBatchSize, frame_len);
+        batch = channel_->allocate_send_buffer(batch_capacity);
+        if (!batch) {
+          // the message stays queued, for after reconnecting
+          on_error(UV_ENOMEM);
+          return nullptr;
+        }
+        batch->len = 0;
+      }
+
+      auto *out = reinterpret_cast<u8 *>(batch->data) + batch->len;
+      batch->len += frame_len;
+      return out;
+    };
+
+    for (auto &queue : queues_) {
+      if (queue.send_marker) {
+        u8 *out = append_frame(sizeof(FrameHeader) + RpcQueueMatrix::kResyncMarkerSize);
+        if (!out) {
+          return any_sent;
+        }
+        FrameHeader const header = {
+            .length = RpcQueueMatrix::kResyncMarkerSize, .sender = queue.sender, .receiver = queue.receiver};
+        memcpy(out, &header, sizeof(header));
+        memset(out + sizeof(header), 0, RpcQueueMatrix::kResyncMarkerSize);
+        queue.send_marker = false;
+        any_sent = true;
+      }
+
+      queue.queue.start_read_batch();
+
+      for (size_t i = 0; (i < kMaxRpcBatchPerQueue) && (queue.queue.peek() > 0); ++i) {
+        int const msg_len = queue.queue.peek();
+        char *msg_buf = nullptr;
+
+        if (queue.resyncing && !RpcQueueMatrix::is_resync_marker(msg_len)) {
+          // sent before the sender started over
+          (void)queue.queue.read(msg_buf);
+          continue;
+        }
+        queue.resyncing = false;
+
+        if (u32(msg_len) > kMaxMessageSize) {
+          LOG::error("rpc bridge: dropping {} message of {} bytes, larger than {}", to_string(edge_), msg_len, kMaxMessageSize);
+          (void)queue.queue.read(msg_buf);
+          continue;
+        }
+
+        // the message is only read once there's room for it
+        u8 *out = append_frame(sizeof(FrameHeader) + msg_len);
+        if (!out) {
+          break;
+        }
+        (void)queue.queue.read(msg_buf);
+
+        FrameHeader const header = {.length = u32(msg_len), .sender = queue.sender, .receiver = queue.receiver};
+        memcpy(out, &header, sizeof(header));
+        memcpy(out + sizeof(header), msg_buf, msg_len);
+
+        any_sent = true;
+      }
+
+      queue.queue.finish_read_batch();
+
+      if (!connected_) {
+        // sending failed, the connection is closing
+        return any_sent;
+      }
+    }
+
+    send_batch();
+
+    return any_sent;
+  }
+
+  void close()
+  {
+    uv_timer_stop(&reconnect_timer_);
+    if (channel_) {
+      channel_->close_permanently();
+    }
+  }
+
+private:
+  struct Queue {
+    u16 sender;
+    u16 receiver;
+    ElementQueue queue;
+    // Whether to send a resync marker before what is queued.
+    bool send_marker = false;
+    // Whether the sender was asked to start over, and what it queued before
+    // its resync marker is dropped.
+    bool resyncing = false;
+  };
+
+  static void on_reconnect_timer(uv_timer_t *timer)
+  {
+    auto outbound = reinterpret_cast<Outbound *>(timer->data);
+    outbound->connect();
+  }
+
+  RpcBridge &bridge_;
+  RpcBridgeEdge const edge_;
+  size_t const process_;
+  std::string const peer_;
+
+  std::unique_ptr<channel::TCPChannel> channel_;
+  uv_timer_t reconnect_timer_;
+  bool connected_ = false;
+  // Whether a connection was established before.
+  bool had_connection_ = false;
+
+  // Queues from the senders of this process to the receivers of the peer.
+  std::vector<Queue> queues_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Connection from another process, whose messages are written to the queues
+// of this process' receivers.
+//
+class RpcBridge::Inbound : public channel::Callbacks {
+public:
+  explicit Inbound(RpcBridge &bridge) : bridge_(bridge), channel_(bridge.loop_) {}
+
+  void accept(uv_tcp_t *listener) { channel_.accept(*this, listener); }
+
+  u32 received_data(u8 const *data, int length) override
+  {
+    if (closed_) {
+      return length;
+    }
+
+    size_t consumed = 0;
+
+    if (!queues_) {
+      if (size_t(length) < sizeof(Hello)) {
+        return 0;
+      }
+      handle_hello(data);
+      consumed = sizeof(Hello);
+    }
+
+    if (!pending_.empty()) {
+      pending_.append(reinterpret_cast<char const *>(data) + consumed, length - consumed);
+      handle_pending();
+      return length;
+    }
+
+    bool blocked = false;
+    consumed += handle_frames(data + consumed, length - consumed, blocked);
+
+    if (blocked) {
+      // keep the rest until the queue has room again
+      pending_.assign(reinterpret_cast<char const *>(data) + consumed, length - consumed);
+      pause();
+      return length;
+    }
+
+    return consumed;
+  }
+
+  void on_error(int error) override
+  {
+    if (error != UV_EOF) {
+      LOG::warn("rpc bridge: connection from process {} failed: {}", process_, uv_error_t{error});
+    }
+    close();
+  }
+
+  void on_closed() override
+  {
+    // destroys this object
+    bridge_.remove_inbound(this);
+  }
+
+  // Retries writing the data kept while the queues were full.
+  void retry()
+  {
+    if (!paused_ || closed_) {
+      return;
+    }
+
+    try {
+      handle_pending();
+    } catch (std::exception const &e) {
+      LOG::error("rpc bridge: error handling data from process {}: {}", process_, e.what());
+      close();
+    }
+  }
+
+  // Closes the connection. What wasn't written to the queues yet is dropped:
+  // the next connection from the peer starts over (see Outbound::on_connect).
+  void close()
+  {
+    if (!closed_) {
+      closed_ = true;
+      channel_.close_permanently();
+    }
+  }
+
+  // Process and edge this connection carries, once known.
+  std::optional<size_t> process() const { return queues_ ? std::make_optional(process_) : std::nullopt; }
+  RpcBridgeEdge edge() const { return edge_; }
+
+private:
+  void handle_hello(u8 const *data)
+  {
+    Hello hello;
+    memcpy(&hello, data, sizeof(hello));
+
+    auto const edge = static_cast<RpcBridgeEdge>(hello.edge);
+    if (hello.magic != Hello::kMagic || !enum_traits<RpcBridgeEdge>::is_valid(edge)) {
+      throw std::runtime_error("not a reducer rpc bridge connection");
+    }
+
+    auto &shard_map = bridge_.shard_map_;
+    if (hello.num_processes != shard_map.num_processes() || hello.process >= shard_map.num_processes() ||
+        hello.process == shard_map.process()) {
+      throw std::runtime_error(fmt::format(
+          "process {} of {} connected to process {} of {}",
+          hello.process,
+          hello.num_processes,
+          shard_map.process(),
+          shard_map.num_processes()));
+    }
+
+    auto &queues = bridge_.queues(edge);
+    if (hello.num_senders != queues.num_senders() || hello.num_receivers != queues.num_receivers()) {
+      throw std::runtime_error(fmt::format(
+          "process {} has {}x{} {} queues, this process has {}x{}",
+          hello.process,
+          hello.num_senders,
+          hello.num_receivers,
+          to_string(edge),
+          queues.num_senders(),
+          queues.num_receivers()));
+    }
+
+    process_ = hello.process;
+    edge_ = edge;
+    queues_ = &queues;
+
+    LOG::info("rpc bridge: accepted connection from process {} for {}", process_, to_string(edge_));
+
+    // a reconnecting peer replaces its previous connection
+    bridge_.close_inbound(process_, edge_, this);
+  }
+
+  // Writes the complete frames in |data| to the queues. Stops early, setting
+  // |blocked|, if the queue of a message is full. Returns the number of bytes
+  // handled.
+  size_t handle_frames(u8 const *data, size_t length, bool &blocked)
+  {
+    size_t offset = 0;
+
+    while (length - offset >= sizeof(FrameHeader)) {
+      FrameHeader header;
+      memcpy(&header, data + offset, sizeof(header));
+
+      if (header.length > kMaxMessageSize || header.sender >= queues_->num_senders() ||
+          header.receiver >= queues_->num_receivers() || queues_->is_local_sender(header.sender) ||
+          !queues_->is_local_receiver(header.receiver)) {
+        throw std::runtime_error(fmt::format(
+            "invalid {} message of {} bytes from {} to {}", to_string(edge_), header.length, header.sender, header.receiver));
+      }
+
+      if (length - offset < sizeof(header) + header.length) {
+        break;
+      }
+
+      ElementQueue &queue = queues_->writer_queue(header.sender, header.receiver);
+      queue.start_write_batch();
+      int const pos = eq_write(&queue, header.length);
+      if (pos == -ENOSPC) {
+        queue.finish_write_batch();
+        blocked = true;
+        break;
+      }
+      if (pos < 0) {
+        queue.finish_write_batch();
+        throw std::runtime_error(
+            fmt::format("failed to write {} message of {} bytes: {}", to_string(edge_), header.length, pos));
+      }
+      memcpy(queue.data + pos, data + offset + sizeof(header), header.length);
+      queue.finish_write_batch();
+
+      offset += sizeof(header) + header.length;
+    }
+
+    return offset;
+  }
+
+  void handle_pending()
+  {
+    bool blocked = false;
+    auto const handled = handle_frames(reinterpret_cast<u8 const *>(pending_.data()), pending_.size(), blocked);
+    pending_.erase(0, handled);
+
+    if (blocked) {
+      pause();
+    } else if (paused_) {
+      // only an incomplete frame, if anything, is left
+      paused_ = false;
+      channel_.resume_reading();
+    }
+  }
+
+  void pause()
+  {
+    if (!paused_) {
+      paused_ = true;
+      channel_.pause_reading();
+    }
+  }
+
+  RpcBridge &bridge_;
+  channel::TCPChannel channel_;
+
+  // Set once the peer said hello.
+  RpcQueueMatrix *queues_ = nullptr;
+  size_t process_ = 0;
+  RpcBridgeEdge edge_ = RpcBridgeEdge::ingest_to_matching;
+
+  // Received data not yet written to the queues.
+  std::string pending_;
+  // Whether reading is paused until pending_ is written.
+  bool paused_ = false;
+  // Set once close() is called.
+  bool closed_ = false;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+RpcBridge::RpcBridge(
+    ShardMap const &shard_map,
+    std::vector<std::string> peers,
+    RpcQueueMatrix &ingest_to_matching_queues,
+    RpcQueueMatrix &matching_to_aggregation_queues)
+    : shard_map_(shard_map),
+      peers_(std::move(peers)),
+      ingest_to_matching_queues_(ingest_to_matching_queues),
+      matching_to_aggregation_queues_(matching_to_aggregation_queues)
+{
+  if (peers_.size() != shard_map_.num_processes()) {
+    throw std::invalid_argument(
+        fmt::format("{} peers listed for {} reducer processes", peers_.size(), shard_map_.num_processes()));
+  }
+
+  CHECK_UV(uv_loop_init(&loop_));
+
+  CHECK_UV(uv_async_init(&loop_, &stop_async_, &on_stop_async));
+  stop_async_.data = this;
+
+  CHECK_UV(uv_timer_init(&loop_, &forward_timer_));
+  forward_timer_.data = this;
+
+  // listen on our own port, on all interfaces
+  auto const port = split_host_port(peers_[shard_map_.process()]).second;
+  struct sockaddr_in addr;
+  CHECK_UV(uv_ip4_addr("0.0.0.0", std::stoi(port), &addr));
+  CHECK_UV(uv_tcp_init(&loop_, &listener_));
+  listener_.data = this;
+  CHECK_UV(uv_tcp_bind(&listener_, reinterpret_cast<struct sockaddr const *>(&addr), 0));
+  CHECK_UV(uv_listen(reinterpret_cast<uv_stream_t *>(&listener_), kListenBacklog, &on_new_connection));
+
+  for (auto edge : enum_traits<RpcBridgeEdge>::values) {
+    for (size_t process = 0; process < shard_map_.num_processes(); ++process) {
+      if (process != shard_map_.process()) {
+        outbound_.push_back(std::make_unique<Outbound>(*this, edge, process));
+      }
+    }
+  }
+}
+
+RpcBridge::~RpcBridge() {}
+
+std::vector<std::string> RpcBridge::parse_peers(std::string_view peers)
+{
+  std::vector<std::string> result;
+
+  while (!peers.empty()) {
+    auto const comma = peers.find(',');
+    auto const peer = peers.substr(0, comma);
+    peers.remove_prefix(comma == std::string_view::npos ? peers.size() : comma + 1);
+
+    auto const colon = peer.rfind(':');
+    if (colon == std::string_view::npos || colon == 0 || colon + 1 == peer.size() ||
+        peer.find_first_not_of("0123456789", colon + 1) != std::string_view::npos) {
+      throw std::invalid_argument(fmt::format("invalid peer '{}', expected <host>:<port>", peer));
+    }
+
+    result.emplace_back(peer);
+  }
+
+  return result;
+}
+
+RpcQueueMatrix &RpcBridge::queues(RpcBridgeEdge edge)
+{
+  switch (edge) {
+  case RpcBridgeEdge::matching_to_aggregation:
+    return matching_to_aggregation_queues_;
+  case RpcBridgeEdge::ingest_to_matching:
+  default:
+    return ingest_to_matching_queues_;
+  }
+}
+
+void RpcBridge::run()
+{
+  set_self_thread_name("rpc_bridge").on_error([](auto const &error) {
+    LOG::warn("unable to set name for rpc bridge thread: {}", error);
+  });
+
+  for (auto &outbound : outbound_) {
+    outbound->connect();
+  }
+
+  auto repeat = integer_time<std::chrono::milliseconds>(RPC_HANDLE_TIME);
+  CHECK_UV(uv_timer_start(&forward_timer_, on_forward_timer, repeat, repeat));
+
+  uv_run(&loop_, UV_RUN_DEFAULT);
+
+  stopping_ = true;
+  for (auto &outbound : outbound_) {
+    outbound->close();
+  }
+  for (auto &inbound : inbound_) {
+    inbound->close();
+  }
+
+  close_uv_loop_cleanly(&loop_);
+
+  done_.Notify();
+}
+
+void RpcBridge::stop_async()
+{
+  uv_async_send(&stop_async_);
+}
+
+void RpcBridge::wait_for_shutdown()
+{
+  done_.WaitForNotification();
+}
+
+void RpcBridge::on_stop_async(uv_async_t *handle)
+{
+  auto bridge = reinterpret_cast<RpcBridge *>(handle->data);
+  uv_stop(&bridge->loop_);
+}
+
+void RpcBridge::on_forward_timer(uv_timer_t *timer)
+{
+  auto bridge = reinterpret_cast<RpcBridge *>(timer->data);
+
+  if (bridge->forward()) {
+    // more may be waiting, come back right away
+    uv_timer_start(timer, timer->timer_cb, 0, timer->repeat);
+  }
+}
+
+bool RpcBridge::forward()
+{
+  for (auto &inbound : inbound_) {
+    inbound->retry();
+  }
+
+  bool any_sent = false;
+  for (auto &outbound : outbound_) {
+    any_sent |= outbound->forward();
+  }
+
+  return any_sent;
+}
+
+void RpcBridge::on_new_connection(uv_stream_t *stream, int status)
+{
+  auto bridge = reinterpret_cast<RpcBridge *>(stream->data);
+
+  if (status != 0) {
+    LOG::error("rpc bridge: error accepting connection: {}", uv_error_t{status});
+    return;
+  }
+
+  auto &inbound = bridge->inbound_.emplace_back(std::make_unique<Inbound>(*bridge));
+  inbound->accept(&bridge->listener_);
+}
+
+void RpcBridge::close_inbound(size_t process, RpcBridgeEdge edge, Inbound const *except)
+{
+  for (auto &inbound : inbound_) {
+    if (inbound.get() != except && inbound->process() == process && inbound->edge() == edge) {
+      LOG::info("rpc bridge: closing previous connection from process {} for {}", process, to_string(edge));
+      inbound->close();
+    }
+  }
+}
+
+void RpcBridge::remove_inbound(Inbound const *inbound)
+{
+  auto it = std::find_if(inbound_.begin(), inbound_.end(), [inbound](auto const &p) { return p.get() == inbound; });
+  if (it != inbound_.end()) {
+    inbound_.erase(it);
+  }
+}
+
+} // namespace reducer
@@ -0,0 +1,133 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <reducer/shard_map.h>
+
+#include <channel/callbacks.h>
+#include <channel/tcp_channel.h>
+
+#include <platform/types.h>
+#include <util/element_queue_cpp.h>
+#include <util/enum.h>
+
+#include <absl/synchronization/notification.h>
+#include <uv.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Edges of the reducer's pipeline that can cross processes.
+#define ENUM_NAMESPACE reducer
+#define ENUM_NAME RpcBridgeEdge
+#define ENUM_TYPE u8
+#define ENUM_ELEMENTS(X)                                                                                                       \
+  X(ingest_to_matching, 0, "")                                                                                                 \
+  X(matching_to_aggregation, 1, "")
+#define ENUM_DEFAULT ingest_to_matching
+#include <util/enum_operators.inl>
+
+namespace reducer {
+
+class RpcQueueMatrix;
+
+// Forwards RPC messages between the cores of this reducer process and the
+// cores of the other processes, when the reducer is scaled out (see ShardMap).
+//
+// For each edge and each other process, the bridge keeps a TCP connection to
+// that process, over which it sends what the senders of this process write to
+// the queues of that process' receivers. Messages are sent as they are in the
+// queues, timestamp included, so the receiving cores' virtual clocks see the
+// same timestamps they would if the senders were in-process. On the other
+// end, the bridge writes them to the queues from those senders.
+//
+// Backpressure works as with in-process queues: outbound queues aren't read
+// while their connection is down or has kMaxWriteQueueSize bytes waiting to be
+// sent, so senders stall once the queues fill up; an inbound connection stops
+// being read while the queue of the next message is full.
+//
+// Each connection starts with a resync marker per queue (see
+// RpcQueueMatrix::write_resync_marker), at which receivers drop the spans and
+// strings they got from the sender before. Messages in flight when a
+// connection breaks are lost, and a peer that restarts loses all it got, so
+// when reconnecting the senders are asked to start over, and what they queued
+// until they write the marker is dropped. Matching cores then replace their
+// agg_roots, and ingest workers close their connections for collectors to
+// report their state again.
+//
+class RpcBridge {
+public:
+  // Maximum number of bytes waiting to be sent on a connection before its
+  // queues are no longer read.
+  static constexpr size_t kMaxWriteQueueSize = 16 * 1024 * 1024;
+  // Size of the buffers messages are batched in for sending.
+  static constexpr u32 kSendBatchSize = 64 * 1024;
+  // Largest message that can be forwarded.
+  static constexpr u32 kMaxMessageSize = channel::TCPChannel::rx_buffer_size / 2;
+
+  // Arguments:
+  //   - shard_map - Which shards run in which process.
+  //   - peers - Address (`host:port`) the bridge of each process listens on,
+  //       by process number; this process listens on the port of its own.
+  //   - ingest_to_matching_queues, matching_to_aggregation_queues - Queues of
+  //       the edges to forward, placed according to |shard_map|.
+  RpcBridge(
+      ShardMap const &shard_map,
+      std::vector<std::string> peers,
+      RpcQueueMatrix &ingest_to_matching_queues,
+      RpcQueueMatrix &matching_to_aggregation_queues);
+
+  ~RpcBridge();
+
+  // Runs the bridge's loop.
+  void run();
+
+  // Stops the loop. Can be run from any thread.
+  void stop_async();
+  void wait_for_shutdown();
+
+  // Parses a comma-separated list of `host:port` addresses.
+  // Throws std::invalid_argument if any of them is malformed.
+  static std::vector<std::string> parse_peers(std::string_view peers);
+
+private:
+  class Outbound;
+  class Inbound;
+
+  // Returns the queues of |edge|.
+  RpcQueueMatrix &queues(RpcBridgeEdge edge);
+
+  static void on_stop_async(uv_async_t *handle);
+  static void on_forward_timer(uv_timer_t *timer);
+  static void on_new_connection(uv_stream_t *stream, int status);
+
+  // Sends what is in the outbound queues. Returns whether anything was sent.
+  bool forward();
+
+  // Closes the connections from |process| for |edge|, other than |except|.
+  void close_inbound(size_t process, RpcBridgeEdge edge, Inbound const *except);
+  // Destroys a closed inbound connection.
+  void remove_inbound(Inbound const *inbound);
+
+  ShardMap const shard_map_;
+  std::vector<std::string> const peers_;
+  RpcQueueMatrix &ingest_to_matching_queues_;
+  RpcQueueMatrix &matching_to_aggregation_queues_;
+
+  uv_loop_t loop_;
+  uv_async_t stop_async_;
+  uv_timer_t forward_timer_;
+  uv_tcp_t listener_;
+  absl::Notification done_;
+  // Set once the loop stopped, so closed connections aren't reconnected.
+  bool stopping_ = false;
+
+  std::vector<std::unique_ptr<Outbound>> outbound_;
+  std::vector<std::unique_ptr<Inbound>> inbound_;
+};
+
+} // namespace reducer
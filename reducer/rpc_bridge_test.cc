@@ -0,0 +1,284 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <reducer/rpc_bridge.h>
+#include <reducer/rpc_queue_matrix.h>
+#include <reducer/string_dictionaries.h>
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace reducer {
+namespace {
+
+// small queues, so that forwarding many messages exercises backpressure
+constexpr u32 queue_n_elems = 1 << 6;
+constexpr u32 queue_buf_len = 1 << 12;
+
+constexpr size_t num_processes = 2;
+constexpr size_t num_ingest_shards = 1;
+constexpr size_t num_matching_shards = 2;
+constexpr size_t num_aggregation_shards = 2;
+
+// Returns a port nothing listens on at the moment.
+u16 free_port()
+{
+  int const fd = socket(AF_INET, SOCK_STREAM, 0);
+  EXPECT_GE(fd, 0);
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  EXPECT_EQ(0, bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)));
+
+  socklen_t len = sizeof(addr);
+  EXPECT_EQ(0, getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &len));
+  close(fd);
+
+  return ntohs(addr.sin_port);
+}
+
+// The queues and bridge of one reducer process, placed the way Reducer does.
+struct Process {
+  Process(size_t process, std::vector<std::string> const &peers)
+      : shard_map(process, num_processes),
+        ingest_to_matching(
+            num_processes * num_ingest_shards,
+            num_matching_shards,
+            {[this](size_t s) { return shard_map.is_local_ingest(s, num_ingest_shards); },
+             [this](size_t r) { return shard_map.is_local(r); },
+             /* forwarded */ true},
+            queue_n_elems,
+            queue_buf_len),
+        matching_to_aggregation(
+            num_matching_shards,
+            num_aggregation_shards,
+            {[this](size_t s) { return shard_map.is_local(s); },
+             [this](size_t r) { return shard_map.is_local(r); },
+             /* forwarded */ true},
+            queue_n_elems,
+            queue_buf_len),
+        bridge(shard_map, peers, ingest_to_matching, matching_to_aggregation),
+        thread(&RpcBridge::run, &bridge)
+  {}
+
+  ~Process()
+  {
+    bridge.stop_async();
+    thread.join();
+  }
+
+  ShardMap shard_map;
+  RpcQueueMatrix ingest_to_matching;
+  RpcQueueMatrix matching_to_aggregation;
+  RpcBridge bridge;
+  std::thread thread;
+};
+
+// Writes |count| numbered messages to |queue|, waiting while it is full.
+void write_messages(ElementQueue &queue, size_t count)
+{
+  for (size_t i = 0; i < count; ++i) {
+    std::string const msg = std::to_string(i);
+    for (;;) {
+      queue.start_write_batch();
+      int const res = queue.write(msg);
+      queue.finish_write_batch();
+      if (res != -ENOSPC) {
+        ASSERT_EQ(0, res);
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
+
+// Reads |count| messages from |queue|, expecting them numbered in order.
+void read_messages(ElementQueue &queue, size_t count)
+{
+  auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+
+  size_t received = 0;
+  while (received < count) {
+    ASSERT_LT(std::chrono::steady_clock::now(), deadline) << "received " << received << " of " << count;
+
+    queue.start_read_batch();
+    while (queue.peek() > 0) {
+      char *buf = nullptr;
+      int const len = queue.read(buf);
+      ASSERT_GT(len, 0);
+      if (RpcQueueMatrix::is_resync_marker(len)) {
+        continue;
+      }
+      EXPECT_EQ(std::to_string(received), std::string(buf, len));
+      ++received;
+    }
+    queue.finish_read_batch();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+// Writes |msg| to |queue|, waiting while it is full, unless |stop| is set.
+void write_message(ElementQueue &queue, std::string const &msg, std::atomic<bool> const &stop)
+{
+  while (!stop) {
+    queue.start_write_batch();
+    int const res = queue.write(msg);
+    queue.finish_write_batch();
+    if (res != -ENOSPC) {
+      ASSERT_EQ(0, res);
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+// Stands in for a sender core: sends "use <id> <label>" messages, with the
+// labels encoded through a string dictionary, until stopped. Starts over
+// when asked to, like the cores do.
+void send_labels(RpcQueueMatrix &queues, size_t sender, size_t receiver, std::atomic<bool> const &stop)
+{
+  StringDictionaryWriters dictionaries(sender, queues.num_receivers());
+  auto &queue = queues.writer_queue(sender, receiver);
+
+  for (size_t i = 0; !stop; ++i) {
+    if (queues.resync_requested(sender, receiver)) {
+      queues.write_resync_marker(sender, receiver);
+      dictionaries.reset(receiver);
+    }
+
+    std::string const label = "label-" + std::to_string(i % 10);
+    u32 const id = dictionaries.encode(receiver, label, [&](u16 dict, u32 id) {
+      write_message(queue, "define " + std::to_string(id) + " " + label, stop);
+    });
+    write_message(queue, "use " + std::to_string(id) + " " + label, stop);
+  }
+}
+
+// Stands in for a receiver core: reads |count| uses of labels from |queue|,
+// expecting each to decode to the label it names.
+void receive_labels(ElementQueue &queue, size_t count)
+{
+  auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+
+  StringDictionaryDecoder dictionary(kStringDictionaryCapacity);
+
+  size_t received = 0;
+  while (received < count) {
+    ASSERT_LT(std::chrono::steady_clock::now(), deadline) << "received " << received << " of " << count;
+
+    queue.start_read_batch();
+    while ((queue.peek() > 0) && (received < count)) {
+      char *buf = nullptr;
+      int const len = queue.read(buf);
+      ASSERT_GT(len, 0);
+      if (RpcQueueMatrix::is_resync_marker(len)) {
+        dictionary.clear();
+        continue;
+      }
+
+      std::string_view msg(buf, len);
+      auto const space = msg.find(' ', msg.find(' ') + 1);
+      auto const kind = msg.substr(0, msg.find(' '));
+      u32 const id = std::stoul(std::string(msg.substr(kind.size() + 1, space - kind.size() - 1)));
+      auto const label = msg.substr(space + 1);
+
+      if (kind == "define") {
+        ASSERT_TRUE(dictionary.define(id, label));
+      } else {
+        ASSERT_EQ(label, dictionary.lookup(id)) << "use of id " << id;
+        ++received;
+      }
+    }
+    queue.finish_read_batch();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+} // namespace
+
+TEST(RpcBridgeTest, ParsePeers)
+{
+  EXPECT_TRUE(RpcBridge::parse_peers("").empty());
+  EXPECT_EQ(
+      RpcBridge::parse_peers("reducer-0:7000,10.0.0.2:7000,[::1]:7001"),
+      (std::vector<std::string>{"reducer-0:7000", "10.0.0.2:7000", "[::1]:7001"}));
+
+  for (char const *peers : {"reducer-0", "reducer-0:", ":7000", "reducer-0:70a0"}) {
+    EXPECT_THROW(RpcBridge::parse_peers(peers), std::invalid_argument) << peers;
+  }
+}
+
+TEST(RpcBridgeTest, ForwardsBetweenProcesses)
+{
+  std::vector<std::string> const peers = {
+      "127.0.0.1:" + std::to_string(free_port()), "127.0.0.1:" + std::to_string(free_port())};
+
+  Process process0(0, peers);
+  Process process1(1, peers);
+
+  // many times what the queues hold, so both ends fill up along the way
+  size_t const count = 20 * queue_n_elems;
+
+  // ingest shard 0 of process 0 to matching shard 1, in process 1
+  std::thread ingest_writer(write_messages, std::ref(process0.ingest_to_matching.writer_queue(0, 1)), count);
+  // matching shard 1 of process 1 to aggregation shard 0, in process 0
+  std::thread matching_writer(write_messages, std::ref(process1.matching_to_aggregation.writer_queue(1, 0)), count);
+
+  auto matching_readers = process1.ingest_to_matching.make_readers(1);
+  ASSERT_EQ(num_processes * num_ingest_shards, matching_readers.size());
+  read_messages(matching_readers[0], count);
+
+  auto aggregation_readers = process0.matching_to_aggregation.make_readers(0);
+  ASSERT_EQ(num_matching_shards, aggregation_readers.size());
+  read_messages(aggregation_readers[1], count);
+
+  ingest_writer.join();
+  matching_writer.join();
+}
+
+TEST(RpcBridgeTest, RestartedReceiverGetsLabels)
+{
+  std::vector<std::string> const peers = {
+      "127.0.0.1:" + std::to_string(free_port()), "127.0.0.1:" + std::to_string(free_port())};
+
+  Process process0(0, peers);
+  auto process1 = std::make_unique<Process>(1, peers);
+
+  // ingest shard 0 of process 0 to matching shard 1, in process 1
+  std::atomic<bool> stop = false;
+  std::thread sender(send_labels, std::ref(process0.ingest_to_matching), 0, 1, std::cref(stop));
+
+  {
+    auto readers = process1->ingest_to_matching.make_readers(1);
+    receive_labels(readers[0], 10 * queue_n_elems);
+  }
+
+  // the restarted receiver knows none of the labels, the sender has to
+  // define them again
+  process1.reset();
+  process1 = std::make_unique<Process>(1, peers);
+
+  {
+    auto readers = process1->ingest_to_matching.make_readers(1);
+    receive_labels(readers[0], 10 * queue_n_elems);
+  }
+
+  stop = true;
+  sender.join();
+}
+
+} // namespace reducer
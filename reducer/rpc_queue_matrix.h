@@ -8,7 +8,10 @@
 #include <util/element_queue_cpp.h>
 #include <util/element_queue_writer.h>
 
+#include <atomic>
 #include <cassert>
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -24,6 +27,30 @@ public:
   // Default number of bytes in a queue shared buffer.
   static constexpr u32 default_queue_buf_len = (1 << 23);
 
+  // Size of the element marking, in the queue from a sender to a receiver,
+  // where the sender started over (see write_resync_marker). Messages are
+  // always larger, having a timestamp and an RPC id.
+  static constexpr int kResyncMarkerSize = sizeof(u64);
+
+  // Where the senders and receivers run, when the reducer is scaled out to
+  // several processes (see ShardMap).
+  struct Placement {
+    // Whether a sender runs in this process.
+    std::function<bool(size_t)> is_local_sender;
+    // Whether a receiver runs in this process.
+    std::function<bool(size_t)> is_local_receiver;
+    // Whether messages between senders and receivers of different processes
+    // are forwarded (see RpcBridge). If not, receivers only read from the
+    // senders of their own process.
+    bool forwarded = false;
+
+    // Everything runs in this process.
+    static Placement local()
+    {
+      return {[](size_t) { return true; }, [](size_t) { return true; }};
+    }
+  };
+
   // Constructs the object for |num_senders| senders and |num_receivers|
   // receivers.
   RpcQueueMatrix(
@@ -31,14 +58,34 @@ public:
       size_t num_receivers,
       u32 queue_n_elems = default_queue_n_elems,
       u32 queue_buf_len = default_queue_buf_len)
-      : num_senders_(num_senders), num_receivers_(num_receivers)
-  {
-    size_t const num_entries = num_receivers * num_senders;
+      : RpcQueueMatrix(num_senders, num_receivers, Placement::local(), queue_n_elems, queue_buf_len)
+  {}
 
-    entries_.reserve(num_entries);
+  // Constructs the object for |num_senders| senders and |num_receivers|
+  // receivers, placed as specified.
+  //
+  // Queues are only allocated between a sender and a receiver of which at
+  // least one runs in this process.
+  //
+  RpcQueueMatrix(
+      size_t num_senders,
+      size_t num_receivers,
+      Placement placement,
+      u32 queue_n_elems = default_queue_n_elems,
+      u32 queue_buf_len = default_queue_buf_len)
+      : num_senders_(num_senders), num_receivers_(num_receivers), placement_(std::move(placement))
+  {
+    entries_.reserve(num_receivers * num_senders);
 
-    for (size_t i = 0; i < num_entries; ++i) {
-      entries_.emplace_back(make_storage(queue_n_elems, queue_buf_len));
+    // receiver-major ordering
+    for (size_t r = 0; r < num_receivers; ++r) {
+      for (size_t s = 0; s < num_senders; ++s) {
+        if (placement_.is_local_sender(s) || placement_.is_local_receiver(r)) {
+          entries_.emplace_back(std::make_unique<Entry>(make_storage(queue_n_elems, queue_buf_len)));
+        } else {
+          entries_.emplace_back(nullptr);
+        }
+      }
     }
   }
 
@@ -59,8 +106,14 @@ public:
     readers.reserve(length);
 
     for (size_t i = 0; i < length; ++i) {
+      if (!placement_.forwarded && !placement_.is_local_sender(i)) {
+        // nothing to read, and nothing to wait for
+        continue;
+      }
+
       size_t const pos = offset + (i * stride);
-      readers.emplace_back(entries_[pos].storage, std::forward<Args>(args)...);
+      assert(entries_[pos]);
+      readers.emplace_back(entries_[pos]->storage, std::forward<Args>(args)...);
     }
 
     return readers;
@@ -85,12 +138,86 @@ public:
 
     for (size_t i = 0; i < length; ++i) {
       size_t const pos = offset + (i * stride);
-      writers.emplace_back(entries_[pos].queue_writer, std::forward<Args>(args)...);
+      assert(entries_[pos]);
+      writers.emplace_back(entries_[pos]->queue_writer, std::forward<Args>(args)...);
     }
 
     return writers;
   }
 
+  // Creates a reader of the queue from |sender| to |receiver|.
+  //
+  // Used to forward messages to a receiver running in another process.
+  //
+  ElementQueue make_reader(size_t sender, size_t receiver)
+  {
+    return ElementQueue(entry(sender, receiver).storage);
+  }
+
+  // Returns the queue from |sender| to |receiver|, for writing.
+  //
+  // Used to pass on messages forwarded from a sender running in another
+  // process.
+  //
+  ElementQueue &writer_queue(size_t sender, size_t receiver) { return entry(sender, receiver).writer_queue; }
+
+  // Asks |sender| to start over with |receiver|, whose state may no longer
+  // match the sender's, e.g. when the connection to the receiver's process
+  // broke (see RpcBridge).
+  //
+  // Can be called from any thread.
+  //
+  void request_resync(size_t sender, size_t receiver)
+  {
+    entry(sender, receiver).resync_requested.store(true, std::memory_order_release);
+  }
+
+  // Returns whether a resync of |sender| with |receiver| is pending.
+  bool resync_requested(size_t sender, size_t receiver)
+  {
+    return entry(sender, receiver).resync_requested.load(std::memory_order_acquire);
+  }
+
+  // Writes the resync marker to the queue from |sender| to |receiver|, and
+  // clears the pending request.
+  //
+  // Called from the sender's thread, which must then forget what it told the
+  // receiver before, like the strings in its dictionary, as the receiver
+  // forgets the sender's spans and strings when reading the marker.
+  //
+  void write_resync_marker(size_t sender, size_t receiver)
+  {
+    auto &entry = this->entry(sender, receiver);
+
+    // cleared first, so that a request made meanwhile gets another marker
+    entry.resync_requested.store(false, std::memory_order_release);
+
+    if (auto buf = entry.queue_writer.start_write(kResyncMarkerSize)) {
+      memset(*buf, 0, kResyncMarkerSize);
+    }
+    entry.queue_writer.finish_write();
+  }
+
+  // Returns whether an element of |length| bytes is a resync marker.
+  static bool is_resync_marker(int length) { return length == kResyncMarkerSize; }
+
+  // Returns the senders that run in this process.
+  std::vector<size_t> local_senders() const
+  {
+    std::vector<size_t> senders;
+    for (size_t s = 0; s < num_senders_; ++s) {
+      if (placement_.is_local_sender(s)) {
+        senders.push_back(s);
+      }
+    }
+    return senders;
+  }
+
+  // Returns whether |sender| runs in this process.
+  bool is_local_sender(size_t sender) const { return placement_.is_local_sender(sender); }
+  // Returns whether |receiver| runs in this process.
+  bool is_local_receiver(size_t receiver) const { return placement_.is_local_receiver(receiver); }
+
   // Returns the number of senders this matrix is constructed for.
   size_t num_senders() const { return num_senders_; }
   // Returns the number of receivers this matrix is constructed for.
@@ -102,14 +229,27 @@ private:
     ElementQueueStoragePtr storage;
     ElementQueue writer_queue;
     ElementQueueWriter queue_writer;
+    std::atomic<bool> resync_requested{false};
 
     Entry(ElementQueueStoragePtr s) : storage(s), writer_queue(storage), queue_writer(writer_queue) {}
   };
 
   size_t num_senders_;
   size_t num_receivers_;
+  Placement placement_;
 
-  std::vector<Entry> entries_;
+  // Null for pairs of which neither runs in this process.
+  std::vector<std::unique_ptr<Entry>> entries_;
+
+  Entry &entry(size_t sender, size_t receiver)
+  {
+    assert(sender < num_senders_);
+    assert(receiver < num_receivers_);
+
+    auto &entry = entries_[(receiver * num_senders_) + sender];
+    assert(entry);
+    return *entry;
+  }
 
   static ElementQueueStoragePtr make_storage(u32 num_elems, u32 buf_len)
   {
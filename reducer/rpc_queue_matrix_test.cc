@@ -106,5 +106,49 @@ TEST(RpcQueueMatrixTest, TestMessaging)
   }
 }
 
+TEST(RpcQueueMatrixTest, TestPlacement)
+{
+  size_t const num_senders = 4;
+  size_t const num_receivers = 4;
+
+  // process 0 of 2, senders and receivers split round-robin
+  auto const is_local = [](size_t shard) { return shard % 2 == 0; };
+
+  RpcQueueMatrix local_only(num_senders, num_receivers, {is_local, is_local, /* forwarded */ false}, 1 << 4, 1 << 10);
+  RpcQueueMatrix forwarded(num_senders, num_receivers, {is_local, is_local, /* forwarded */ true}, 1 << 4, 1 << 10);
+
+  EXPECT_EQ(local_only.local_senders(), (std::vector<size_t>{0, 2}));
+
+  // receivers only wait for senders whose messages can reach them
+  EXPECT_EQ(local_only.make_readers(0).size(), 2u);
+  EXPECT_EQ(forwarded.make_readers(0).size(), num_senders);
+
+  // a local sender writes to a remote receiver, whose messages are read here
+  // to be forwarded
+  std::vector<Writer> writers = forwarded.make_writers<Writer>(2);
+  std::string const sent = make_msg(2, 1);
+  writers[1].write(sent.c_str(), sent.size());
+
+  ElementQueue reader = forwarded.make_reader(2, 1);
+  reader.start_read_batch();
+  char *buf = nullptr;
+  int len = reader.read(buf);
+  EXPECT_EQ(std::string(buf, len), sent);
+  reader.finish_read_batch();
+
+  // and a message forwarded from a remote sender is read by a local receiver
+  std::string const received = make_msg(3, 0);
+  ElementQueue &queue = forwarded.writer_queue(3, 0);
+  queue.start_write_batch();
+  EXPECT_EQ(queue.write(received), 0);
+  queue.finish_write_batch();
+
+  std::vector<ElementQueue> readers = forwarded.make_readers(0);
+  readers[3].start_read_batch();
+  len = readers[3].read(buf);
+  EXPECT_EQ(std::string(buf, len), received);
+  readers[3].finish_read_batch();
+}
+
 } // namespace
 } // namespace reducer
@@ -0,0 +1,75 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace reducer {
+
+// Assignment of the shards of the matching and aggregation apps to reducer
+// processes, when the reducer is scaled out to several processes.
+//
+// Shard `n` runs in process `n % num_processes`. The generated writers pick a
+// shard by the `shard_by` keys of each message, the same way whether or not
+// the shard runs in the sending process; messages for shards of other
+// processes are forwarded by RpcBridge.
+//
+// Ingest shards are not distributed: each process runs its own, as collectors
+// connect to any one process. They are numbered
+// `process * num_ingest_shards + i` on the queues, so the receivers can tell
+// the ingest shards of all processes apart.
+//
+class ShardMap {
+public:
+  // A map for process number |process| of |num_processes|.
+  ShardMap(size_t process = 0, size_t num_processes = 1) : process_(process), num_processes_(num_processes)
+  {
+    assert(num_processes > 0);
+  }
+
+  // This process' number.
+  size_t process() const { return process_; }
+  // Number of reducer processes.
+  size_t num_processes() const { return num_processes_; }
+
+  // Whether the reducer runs in more than one process.
+  bool scaled_out() const { return num_processes_ > 1; }
+
+  // Process that runs |shard|.
+  size_t owner(size_t shard) const { return shard % num_processes_; }
+
+  // Whether |shard| runs in this process.
+  bool is_local(size_t shard) const { return owner(shard) == process_; }
+
+  // Shards, out of |num_shards|, that run in this process.
+  std::vector<size_t> local_shards(size_t num_shards) const
+  {
+    std::vector<size_t> shards;
+    for (size_t shard = process_; shard < num_shards; shard += num_processes_) {
+      shards.push_back(shard);
+    }
+    return shards;
+  }
+
+  // Process that runs ingest shard |shard|, out of |num_ingest_shards| per
+  // process.
+  size_t ingest_owner(size_t shard, size_t num_ingest_shards) const { return shard / num_ingest_shards; }
+
+  // Whether ingest shard |shard|, out of |num_ingest_shards| per process, runs
+  // in this process.
+  bool is_local_ingest(size_t shard, size_t num_ingest_shards) const
+  {
+    return ingest_owner(shard, num_ingest_shards) == process_;
+  }
+
+private:
+  size_t process_;
+  size_t num_processes_;
+};
+
+} // namespace reducer
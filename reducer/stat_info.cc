@@ -256,4 +256,32 @@ EbpfNetMetricInfo EbpfNetMetricInfo::rpc_write_stalls{
     " some definitions"
     " some description.",
     UNIT_DIMENSIONLESS};
+
+EbpfNetMetricInfo EbpfNetMetricInfo::rpc_late_messages{
+    EbpfNetMetrics::rpc_late_messages,
+    "Number of messages from an RPC client handled after the core stopped waiting for it,"
+    " as part of a later timeslot.",
+    UNIT_DIMENSIONLESS};
+
+EbpfNetMetricInfo EbpfNetMetricInfo::rpc_input_lag{
+    EbpfNetMetrics::rpc_input_lag,
+    "Number of timeslots an RPC client is behind the core's clock.",
+    UNIT_DIMENSIONLESS};
+
+EbpfNetMetricInfo EbpfNetMetricInfo::aggregation_series{
+    EbpfNetMetrics::aggregation_series,
+    "Number of series of a node aggregation written on their own in the last timeslot,"
+    " when the aggregation's number of series is limited.",
+    UNIT_DIMENSIONLESS};
+
+EbpfNetMetricInfo EbpfNetMetricInfo::aggregation_series_folded{
+    EbpfNetMetrics::aggregation_series_folded,
+    "Number of metric entries of a node aggregation folded into its \"(other)\" series"
+    " because they were beyond the aggregation's series limit.",
+    UNIT_DIMENSIONLESS};
+
+EbpfNetMetricInfo EbpfNetMetricInfo::aggregation_series_evicted{
+    EbpfNetMetrics::aggregation_series_evicted,
+    "Number of series of a node aggregation no longer tracked by its heavy-hitter summary.",
+    UNIT_DIMENSIONLESS};
 } // namespace reducer
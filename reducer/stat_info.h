@@ -56,6 +56,11 @@ struct EbpfNetMetricInfo : public OutboundMetricInfo<EbpfNetMetrics> {
   static EbpfNetMetricInfo span_utilization_max;
   static EbpfNetMetricInfo time_since_last_message_ns;
   static EbpfNetMetricInfo up;
+  static EbpfNetMetricInfo rpc_late_messages;
+  static EbpfNetMetricInfo rpc_input_lag;
+  static EbpfNetMetricInfo aggregation_series;
+  static EbpfNetMetricInfo aggregation_series_folded;
+  static EbpfNetMetricInfo aggregation_series_evicted;
 };
 
 } // namespace reducer
@@ -0,0 +1,102 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <util/string_dictionary.h>
+
+#include <cassert>
+#include <deque>
+#include <string_view>
+
+namespace reducer {
+
+// Default number of strings in each queue's dictionary.
+//
+// Must be at least the number of dictionary-encoded strings in any one
+// message, so a message's strings don't evict each other.
+//
+static constexpr u32 kStringDictionaryCapacity = 1 << 14;
+
+// Sender side of the string dictionaries of a core's RPC queues to the
+// shards of another app, one dictionary per queue.
+//
+// Messages carry the sender's shard number as dictionary id (`dict`), so the
+// receiver can tell which of its senders' dictionaries an id refers to.
+//
+class StringDictionaryWriters {
+public:
+  StringDictionaryWriters(size_t sender, size_t num_receivers, u32 capacity = kStringDictionaryCapacity) : dict_(sender)
+  {
+    for (size_t i = 0; i < num_receivers; ++i) {
+      dictionaries_.emplace_back(capacity);
+    }
+  }
+
+  // The id of this sender's dictionaries, to be sent along with encoded
+  // strings.
+  u16 dict() const { return dict_; }
+
+  // Encodes |value| for the queue to |receiver|.
+  //
+  // If the receiver doesn't know the string yet, first calls
+  // `define(dict, id)`, which must send the definition of |value|.
+  //
+  template <typename Define> u32 encode(size_t receiver, std::string_view value, Define &&define)
+  {
+    assert(receiver < dictionaries_.size());
+
+    auto const code = dictionaries_[receiver].encode(value);
+    if (code.is_new) {
+      define(dict_, code.id);
+    }
+
+    return code.id;
+  }
+
+  // Starts the dictionary of the queue to |receiver| over, when the receiver
+  // starts over with an empty one (see RpcQueueMatrix::write_resync_marker).
+  void reset(size_t receiver)
+  {
+    assert(receiver < dictionaries_.size());
+    dictionaries_[receiver].clear();
+  }
+
+private:
+  u16 dict_;
+  std::deque<StringDictionaryEncoder> dictionaries_;
+};
+
+// Receiver side of the string dictionaries of a core's RPC queues from the
+// shards of another app.
+//
+// @see StringDictionaryWriters
+//
+class StringDictionaryReaders {
+public:
+  StringDictionaryReaders(size_t num_senders, u32 capacity = kStringDictionaryCapacity)
+  {
+    for (size_t i = 0; i < num_senders; ++i) {
+      dictionaries_.emplace_back(capacity);
+    }
+  }
+
+  // Returns the dictionary of sender |dict|, or nullptr if there is no such
+  // sender.
+  StringDictionaryDecoder *get(u16 dict) { return (dict < dictionaries_.size()) ? &dictionaries_[dict] : nullptr; }
+
+  // Starts the dictionary of sender |dict| over, as the sender did.
+  void reset(u16 dict)
+  {
+    if (auto *dictionary = get(dict)) {
+      dictionary->clear();
+    }
+  }
+
+private:
+  std::deque<StringDictionaryDecoder> dictionaries_;
+};
+
+} // namespace reducer
@@ -118,4 +118,12 @@ void TsdbFormatter::write(MetricInfo const &metric, value_t value, Publisher::Wr
   timestamp_changed_ = false;
 }
 
+void TsdbFormatter::write_histogram(
+    MetricInfo const &metric, ::util::LatencySketch const &sketch, Publisher::WriterPtr const &writer)
+{
+  // the changed flags are left as they are: histograms are formatted as a
+  // whole, while format() may still rely on them for entries it caches
+  format_histogram(metric, sketch, labels_, timestamp_, writer);
+}
+
 } // namespace reducer
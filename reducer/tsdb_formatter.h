@@ -11,6 +11,8 @@
 
 #include <platform/types.h>
 
+#include <util/latency_sketch.h>
+
 #include <chrono>
 #include <functional>
 #include <map>
@@ -96,6 +98,10 @@ public:
   // Writes the formatted entry using the provided publisher writer object.
   void write(MetricInfo const &metric, value_t value, Publisher::WriterPtr const &writer);
 
+  // Writes a latency distribution as a histogram. Formats that don't support
+  // histograms skip it.
+  void write_histogram(MetricInfo const &metric, ::util::LatencySketch const &sketch, Publisher::WriterPtr const &writer);
+
   // Writes the formatted entry as a flow log.
   template <typename TMetrics> void write_flow_log(TMetrics const &metrics)
   {
@@ -108,6 +114,9 @@ public:
   };
 
 protected:
+  // Rollup count of the time-series being formatted, see set_rollup().
+  rollup_t rollup() const { return rollup_; }
+
   // Subclasses implement this function to do the actual formatting.
   virtual void format(
       MetricInfo const &metric,
@@ -122,6 +131,14 @@ protected:
       bool timestamp_changed,
       Publisher::WriterPtr const &writer) = 0;
 
+  // Subclasses that support histograms implement this function to do the actual formatting.
+  virtual void format_histogram(
+      MetricInfo const &metric,
+      ::util::LatencySketch const &sketch,
+      labels_t const &labels,
+      timestamp_t timestamp,
+      Publisher::WriterPtr const &writer){};
+
   // Subclasses that support formatting metrics as flow logs implement this function to do the actual formatting.
   virtual void format_flow_log(
       ebpf_net::metrics::tcp_metrics const &tcp_metrics,
@@ -0,0 +1,112 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <reducer/util/index_snapshotter.h>
+
+#include <platform/types.h>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+std::string IndexSnapshotter::snapshot_dir_{};
+
+void IndexSnapshotter::set_snapshot_dir(std::string_view dir)
+{
+  snapshot_dir_ = dir;
+}
+
+std::chrono::seconds IndexSnapshotter::interval_{0};
+
+void IndexSnapshotter::set_interval(std::chrono::seconds interval)
+{
+  interval_ = interval;
+}
+
+std::chrono::seconds IndexSnapshotter::grace_period_{0};
+
+void IndexSnapshotter::set_grace_period(std::chrono::seconds grace_period)
+{
+  grace_period_ = grace_period;
+}
+
+void IndexSnapshotter::release_restored()
+{
+  if (release_) {
+    release_();
+    release_ = nullptr;
+  }
+  release_at_.reset();
+}
+
+std::string IndexSnapshotter::file_path(std::string_view app, int shard)
+{
+  return fmt::format("{}/{}_{}.snapshot", snapshot_dir_, app, shard);
+}
+
+bool IndexSnapshotter::read_file(std::string const &path, std::function<void(std::string_view)> const &f)
+{
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      return false;
+    }
+    throw std::runtime_error(fmt::format("open failed: {}", std::strerror(errno)));
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) < 0) {
+    auto const err = errno;
+    ::close(fd);
+    throw std::runtime_error(fmt::format("fstat failed: {}", std::strerror(err)));
+  }
+
+  if (st.st_size == 0) {
+    ::close(fd);
+    f({});
+    return true;
+  }
+
+  void *data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error(fmt::format("mmap failed: {}", std::strerror(errno)));
+  }
+
+  try {
+    f({static_cast<char const *>(data), static_cast<std::size_t>(st.st_size)});
+  } catch (...) {
+    ::munmap(data, st.st_size);
+    throw;
+  }
+
+  ::munmap(data, st.st_size);
+  return true;
+}
+
+void IndexSnapshotter::write_file(std::string const &path, std::string_view data)
+{
+  auto const tmp_path = path + ".tmp";
+
+  {
+    std::ofstream out{tmp_path, std::ios::binary | std::ios::trunc};
+    out.write(data.data(), data.size());
+    out.flush();
+    if (!out) {
+      throw std::runtime_error("write failed");
+    }
+  }
+
+  if (std::rename(tmp_path.c_str(), path.c_str()) < 0) {
+    throw std::runtime_error(fmt::format("rename failed: {}", std::strerror(errno)));
+  }
+}
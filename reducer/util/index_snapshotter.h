@@ -0,0 +1,70 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Writes binary snapshots of a core's index, and restores them when the core
+// starts, so a reducer restart doesn't lose the spans and pending metrics.
+//
+// Restored spans are held for a grace period, during which clients are
+// expected to re-acquire the spans they still use. Spans nobody re-acquired
+// are freed when the grace period ends.
+//
+class IndexSnapshotter {
+public:
+  // Restores the index from the snapshot left by a previous run, if any.
+  template <typename Index> void restore(std::string_view app, int shard, Index &index);
+
+  // Writes the snapshot if the snapshot interval has elapsed, and frees
+  // restored spans once the grace period is over.
+  template <typename Index> void tick(std::string_view app, int shard, Index &index, std::chrono::seconds timestamp);
+
+  // Unconditionally writes the snapshot, e.g. when the core shuts down.
+  template <typename Index> void write(std::string_view app, int shard, Index &index);
+
+  // Frees restored spans that are still held.
+  // Must be called before the index is destroyed.
+  void release_restored();
+
+  // Sets the snapshot directory. An empty directory (default) disables snapshots.
+  // This function is not thread-safe and should be called by `main` before any threads are created.
+  static void set_snapshot_dir(std::string_view dir);
+
+  // This function is not thread-safe and should be called by `main` before any threads are created.
+  // A value of 0 (default) only writes snapshots on shutdown.
+  static void set_interval(std::chrono::seconds interval);
+
+  // This function is not thread-safe and should be called by `main` before any threads are created.
+  static void set_grace_period(std::chrono::seconds grace_period);
+
+  static bool enabled() { return !snapshot_dir_.empty(); }
+
+private:
+  static std::string file_path(std::string_view app, int shard);
+
+  // Memory-maps the file at `path` and passes its contents to `f`.
+  // Returns false if the file doesn't exist.
+  static bool read_file(std::string const &path, std::function<void(std::string_view)> const &f);
+
+  // Atomically replaces the file at `path` with `data`.
+  static void write_file(std::string const &path, std::string_view data);
+
+  std::chrono::seconds last_snapshot_ = {};
+  // Frees the restored spans, if any are held.
+  std::function<void()> release_;
+  std::optional<std::chrono::seconds> release_at_;
+
+  static std::string snapshot_dir_;
+  static std::chrono::seconds interval_;
+  static std::chrono::seconds grace_period_;
+};
+
+#include <reducer/util/index_snapshotter.inl>
@@ -0,0 +1,74 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <util/log.h>
+#include <util/snapshot.h>
+
+#include <memory>
+
+template <typename Index> void IndexSnapshotter::restore(std::string_view app, int shard, Index &index)
+{
+  if (!enabled()) {
+    return;
+  }
+
+  auto const path = file_path(app, shard);
+
+  try {
+    bool const found = read_file(path, [&](std::string_view data) {
+      SnapshotReader in(data);
+      auto restored = std::make_shared<decltype(restore_snapshot(index, in))>(restore_snapshot(index, in));
+
+      LOG::info("{}-{}: restored {} spans from index snapshot {}", app, shard, restored->size(), path);
+
+      release_ = [restored, &index]() { restored->release(index); };
+      release_at_.reset();
+    });
+
+    if (!found) {
+      LOG::info("{}-{}: no index snapshot found at {}", app, shard, path);
+    }
+  } catch (std::exception const &e) {
+    LOG::error("{}-{}: failed to restore index snapshot {}: {}", app, shard, path, e.what());
+  }
+}
+
+template <typename Index>
+void IndexSnapshotter::tick(std::string_view app, int shard, Index &index, std::chrono::seconds timestamp)
+{
+  if (release_) {
+    // the grace period starts with the first timeslot after the restore
+    if (!release_at_) {
+      release_at_ = timestamp + grace_period_;
+    } else if (timestamp >= *release_at_) {
+      release_restored();
+    }
+  }
+
+  if (!enabled() || !interval_.count()) {
+    return;
+  }
+  if (timestamp <= last_snapshot_ + interval_) {
+    return;
+  }
+  last_snapshot_ = timestamp;
+
+  write(app, shard, index);
+}
+
+template <typename Index> void IndexSnapshotter::write(std::string_view app, int shard, Index &index)
+{
+  if (!enabled()) {
+    return;
+  }
+
+  auto const path = file_path(app, shard);
+
+  try {
+    SnapshotWriter out;
+    write_snapshot(index, out);
+    write_file(path, out.data());
+  } catch (std::exception const &e) {
+    LOG::error("{}-{}: failed to write index snapshot {}: {}", app, shard, path, e.what());
+  }
+}
@@ -17,21 +17,52 @@ size_t VirtualClock::n_inputs() const
   return inputs_.size();
 }
 
+void VirtualClock::set_max_lateness(u64 max_lateness)
+{
+  max_lateness_ = max_lateness;
+  waiting_since_.reset();
+}
+
 bool VirtualClock::is_current(size_t input_index)
 {
-  return current_timeslot_.has_value() && (inputs_.at(input_index).timeslot == current_timeslot_);
+  auto const &input = inputs_.at(input_index);
+
+  return current_timeslot_.has_value() && input.timeslot.has_value() && (diff(*input.timeslot, *current_timeslot_) <= 0);
+}
+
+u16 VirtualClock::lag(size_t input_index) const
+{
+  auto const &input = inputs_.at(input_index);
+
+  if (!current_timeslot_) {
+    return 0;
+  }
+
+  if (!input.timeslot) {
+    return 1;
+  }
+
+  return (u16)std::max(0, -diff(*input.timeslot, *current_timeslot_));
 }
 
 bool VirtualClock::can_update(size_t input_index)
 {
-  return (inputs_.at(input_index).timeslot == current_timeslot_);
+  auto const &input = inputs_.at(input_index);
+
+  if (!current_timeslot_ || !input.timeslot) {
+    // before initialization each input can be updated once; after that, only
+    // inputs left behind in watermark mode have no timeslot
+    return !input.timeslot;
+  }
+
+  return diff(*input.timeslot, *current_timeslot_) <= 0;
 }
 
 int VirtualClock::update(size_t input_index, u64 timestamp)
 {
   auto &input = inputs_.at(input_index);
 
-  if (input.timeslot != current_timeslot_) {
+  if (!can_update(input_index)) {
     return -EPERM;
   }
 
@@ -51,37 +82,120 @@ int VirtualClock::update(size_t input_index, u64 timestamp)
   return 0;
 }
 
-bool VirtualClock::advance()
+bool VirtualClock::advance(u64 now)
 {
   if (current_timeslot_) {
-    if (auto advance_slots = min_input_advance().value_or(0); advance_slots > 0) {
-      // All inputs have moved into newer timeslots.
+    auto advance_slots = min_input_advance().value_or(0);
+
+    if ((advance_slots <= 0) && (max_lateness_ > 0)) {
+      advance_slots = watermark_advance(now);
+    }
+
+    if (advance_slots > 0) {
+      // All inputs (in watermark mode, all inputs that aren't late) have moved
+      // into newer timeslots.
+      drop_stalled_inputs(advance_slots);
       *current_timeslot_ += advance_slots;
+      waiting_since_.reset();
       return true;
     }
   } else {
     // Initializing the current timeslot to the earliest input timeslot.
     current_timeslot_ = earliest_input_timeslot();
+
+    if (!current_timeslot_ && (max_lateness_ > 0) && earliest_input_timeslot(true) && waited_too_long(now)) {
+      // Don't wait any longer for inputs that haven't shown up yet.
+      current_timeslot_ = earliest_input_timeslot(true);
+    }
+
+    if (current_timeslot_) {
+      waiting_since_.reset();
+    }
   }
 
   return false;
 }
 
-std::optional<VirtualClock::timeslot_t> VirtualClock::earliest_input_timeslot()
+void VirtualClock::drop_stalled_inputs(timeslot_diff_t advance_slots)
+{
+  for (auto &input : inputs_) {
+    if (input.timeslot && (advance_slots - diff(*input.timeslot, *current_timeslot_) > max_lag)) {
+      // the input will be late once it's updated again, as if it never sent
+      // anything so far
+      input.timeslot.reset();
+    }
+  }
+}
+
+bool VirtualClock::waited_too_long(u64 now)
+{
+  if (!waiting_since_) {
+    waiting_since_ = now;
+  }
+
+  return (now - *waiting_since_) >= max_lateness_;
+}
+
+VirtualClock::timeslot_diff_t VirtualClock::watermark_advance(u64 now)
+{
+  std::optional<timeslot_diff_t> min_advance;
+  bool lagging = false;
+
+  for (auto &input : inputs_) {
+    if (!input.timeslot) {
+      // late, since the clock didn't wait for it to initialize
+      continue;
+    }
+
+    timeslot_diff_t advance = diff(*input.timeslot, *current_timeslot_);
+
+    if (advance > 0) {
+      min_advance = min_advance ? std::min(*min_advance, advance) : advance;
+    } else if (advance == 0) {
+      lagging = true;
+    }
+    // inputs behind the clock are already late, the clock doesn't wait for them
+  }
+
+  if (!min_advance) {
+    // no input is ahead, nobody is waiting on the clock
+    waiting_since_.reset();
+    return 0;
+  }
+
+  if (lagging && !waited_too_long(now)) {
+    return 0;
+  }
+
+  return *min_advance;
+}
+
+std::optional<VirtualClock::timeslot_t> VirtualClock::earliest_input_timeslot(bool skip_missing)
 {
   std::optional<timeslot_t> min_timeslot;
 
   for (auto &input : inputs_) {
     if (!input.timeslot) {
+      if (skip_missing) {
+        continue;
+      }
       return std::nullopt;
     }
 
     min_timeslot = min_timeslot ? std::min(*min_timeslot, *input.timeslot) : *input.timeslot;
   }
 
+  if (!min_timeslot) {
+    return std::nullopt;
+  }
+
   std::optional<timeslot_diff_t> min_diff;
 
   for (auto &input : inputs_) {
+    if (!input.timeslot) {
+      continue;
+    }
+
     timeslot_diff_t diff = (timeslot_diff_t)(*input.timeslot) - *min_timeslot;
     min_diff = min_diff ? std::min(*min_diff, diff) : diff;
   }
@@ -19,10 +19,24 @@
 //
 // Inputs are first added using the `add_inputs()` method.
 //
+// By default the clock waits for every input, so a single stalled input holds
+// the clock back indefinitely. In watermark mode (see `set_max_lateness()`)
+// the clock waits for lagging inputs only up to a lateness bound, then
+// advances without them. Those inputs are then late: they can still be
+// updated, and their messages are meant to be handled as part of the clock's
+// current timeslot, until they catch up. An input that falls more than
+// `max_lag` timeslots behind is treated as one that never sent anything, until
+// it is updated again, so that its timeslot can't wrap around and appear to be
+// ahead of the clock.
+//
 class VirtualClock {
 public:
   typedef u16 timeslot_t;
 
+  // How many timeslots a late input can fall behind before the clock stops
+  // tracking its timeslot, well within the range of timeslot differences.
+  static constexpr u16 max_lag = 0x4000;
+
   // Constructs the object by using the specified timestamp divider.
   explicit VirtualClock(fast_div const &divider = {1e9, 16});
 
@@ -32,12 +46,35 @@ public:
   // Returns the current number of inputs this clock has.
   size_t n_inputs() const;
 
+  // Enables watermark mode: once some input has moved past the current
+  // timeslot, the clock waits at most `max_lateness` for the others before
+  // advancing, as measured by the `now` argument of `advance()`.
+  // Zero disables watermark mode.
+  void set_max_lateness(u64 max_lateness);
+
+  // Watermark mode lateness bound, or 0 if watermark mode is disabled.
+  u64 max_lateness() const { return max_lateness_; }
+
   // Returns whether the specified input is current with this clock.
-  // Current means that the input timeslot is aligned with the clock's timeslot.
+  // Current means that the input timeslot is not ahead of the clock's
+  // timeslot: either aligned with it, or late.
   // Assumes `input_index` < `n_inputs()`.
   bool is_current(size_t input_index);
 
+  // Returns whether the clock has advanced without the specified input, which
+  // can only happen in watermark mode.
+  // Assumes `input_index` < `n_inputs()`.
+  bool is_late(size_t input_index) const { return lag(input_index) > 0; }
+
+  // Returns the number of timeslots the specified input is behind the clock,
+  // or 0 if it isn't late. An input that was never updated, or that fell more
+  // than `max_lag` timeslots behind, counts as one timeslot behind once the
+  // clock is initialized.
+  // Assumes `input_index` < `n_inputs()`.
+  u16 lag(size_t input_index) const;
+
   // Returns whether the specified input can be updated.
+  // Inputs ahead of the clock can't be updated until the clock catches up.
   // Assumes `input_index` < `n_inputs()`.
   bool can_update(size_t input_index);
 
@@ -56,12 +93,16 @@ public:
   std::optional<timeslot_t> current_timeslot() const { return current_timeslot_; }
 
   // Advances this clock's timeslot, if possible.
+  // `now` is the current time, only used in watermark mode.
   // Returns `true` if advanced, `false` otherwise.
-  bool advance();
+  bool advance(u64 now = 0);
 
 private:
   typedef s16 timeslot_diff_t;
 
+  // Returns `a - b` in timeslots, accounting for wrap-around.
+  static timeslot_diff_t diff(timeslot_t a, timeslot_t b) { return (timeslot_diff_t)(timeslot_t)(a - b); }
+
   struct Input {
     std::optional<timeslot_t> timeslot;
   };
@@ -76,12 +117,33 @@ private:
   // This clock's current timeslot.
   std::optional<timeslot_t> current_timeslot_;
 
+  // Watermark mode lateness bound; 0 if disabled.
+  u64 max_lateness_{0};
+  // Time since which the clock has been waiting for lagging inputs.
+  std::optional<u64> waiting_since_;
+
+  // Forgets the timeslot of late inputs that would fall more than `max_lag`
+  // timeslots behind if the clock advanced by `advance_slots`.
+  // Assumes `current_timeslot_` is initialized.
+  void drop_stalled_inputs(timeslot_diff_t advance_slots);
+
+  // Returns whether the clock has waited for lagging inputs for longer than
+  // the lateness bound, starting the wait if not yet started.
+  bool waited_too_long(u64 now);
+
   // Returns the earliest timeslot value of all inputs, or nullopt if
   // not all inputs have been updated.
-  std::optional<timeslot_t> earliest_input_timeslot();
+  // If `skip_missing` is set, inputs that haven't been updated are ignored,
+  // and nullopt is only returned if no input has been updated.
+  std::optional<timeslot_t> earliest_input_timeslot(bool skip_missing = false);
 
   // Returns the smallest advance in timeslots of all inputs, or nullopt
   // if not all inputs have been updated.
   // Assumes `current_timeslot_` is initialized.
   std::optional<timeslot_diff_t> min_input_advance();
+
+  // Returns the smallest advance in timeslots of the inputs ahead of the
+  // clock, if the clock doesn't have to wait any longer for the others, or 0.
+  // Assumes `current_timeslot_` is initialized and watermark mode is enabled.
+  timeslot_diff_t watermark_advance(u64 now);
 };
@@ -261,3 +261,164 @@ TEST(virtual_clock, advance_wraparound)
   ASSERT_TRUE(clock.is_current(0));
   ASSERT_TRUE(clock.is_current(1));
 }
+
+TEST(virtual_clock, watermark_disabled_waits)
+{
+  VirtualClock clock = DEFAULT_CLOCK;
+  clock.add_inputs(2);
+
+  u64 timestamp = TIMESTAMP_STEP * 42;
+
+  clock.update(0, timestamp);
+  clock.update(1, timestamp);
+  clock.advance();
+
+  // input 1 is stuck, input 0 moves on
+  clock.update(0, timestamp + TIMESTAMP_STEP);
+  ASSERT_EQ(clock.advance(0), false);
+  ASSERT_EQ(clock.advance(1'000'000'000'000), false);
+  ASSERT_EQ(clock.current_timeslot().value(), 42);
+  ASSERT_FALSE(clock.is_late(1));
+}
+
+TEST(virtual_clock, watermark_advances_past_stragglers)
+{
+  constexpr u64 max_lateness = 1000;
+
+  VirtualClock clock = DEFAULT_CLOCK;
+  clock.set_max_lateness(max_lateness);
+  clock.add_inputs(3);
+
+  u64 timestamp = TIMESTAMP_STEP * 42;
+  u64 now = 5000;
+
+  clock.update(0, timestamp);
+  clock.update(1, timestamp);
+  clock.update(2, timestamp);
+  clock.advance(now);
+  ASSERT_EQ(clock.current_timeslot().value(), 42);
+
+  // inputs 0 and 1 move on, input 2 is stuck: wait for it up to the bound
+  clock.update(0, timestamp + 2 * TIMESTAMP_STEP);
+  clock.update(1, timestamp + TIMESTAMP_STEP);
+  ASSERT_EQ(clock.advance(now), false);
+  ASSERT_EQ(clock.advance(now + max_lateness - 1), false);
+
+  ASSERT_EQ(clock.advance(now + max_lateness), true);
+  ASSERT_EQ(clock.current_timeslot().value(), 43);
+
+  ASSERT_TRUE(clock.is_late(2));
+  ASSERT_EQ(clock.lag(2), 1);
+  ASSERT_FALSE(clock.is_late(0));
+  ASSERT_FALSE(clock.is_late(1));
+
+  // a late input doesn't hold the clock back any further
+  now += 2 * max_lateness;
+  clock.update(1, timestamp + 2 * TIMESTAMP_STEP);
+  ASSERT_EQ(clock.advance(now), true);
+  ASSERT_EQ(clock.current_timeslot().value(), 44);
+  ASSERT_EQ(clock.lag(2), 2);
+
+  // late inputs can still be updated, and their messages are handled right away
+  ASSERT_TRUE(clock.can_update(2));
+  ASSERT_TRUE(clock.is_current(2));
+  ASSERT_EQ(clock.update(2, timestamp + TIMESTAMP_STEP), 0);
+  ASSERT_TRUE(clock.is_current(2));
+  ASSERT_EQ(clock.lag(2), 1);
+
+  // but not with out-of-order timestamps
+  ASSERT_EQ(clock.update(2, timestamp), -EINVAL);
+
+  // once the late input catches up, it is current again
+  ASSERT_EQ(clock.update(2, timestamp + 2 * TIMESTAMP_STEP), 0);
+  ASSERT_FALSE(clock.is_late(2));
+  ASSERT_TRUE(clock.is_current(2));
+
+  // and the clock waits for it again
+  clock.update(0, timestamp + 3 * TIMESTAMP_STEP);
+  clock.update(1, timestamp + 3 * TIMESTAMP_STEP);
+  ASSERT_EQ(clock.advance(now), false);
+  ASSERT_EQ(clock.update(2, timestamp + 3 * TIMESTAMP_STEP), 0);
+  ASSERT_EQ(clock.advance(now), true);
+  ASSERT_EQ(clock.current_timeslot().value(), 45);
+}
+
+TEST(virtual_clock, watermark_initializes_without_all_inputs)
+{
+  constexpr u64 max_lateness = 1000;
+
+  VirtualClock clock = DEFAULT_CLOCK;
+  clock.set_max_lateness(max_lateness);
+  clock.add_inputs(2);
+
+  u64 timestamp = TIMESTAMP_STEP * 42;
+  u64 now = 5000;
+
+  clock.update(0, timestamp);
+  clock.advance(now);
+  ASSERT_FALSE(clock.current_timeslot().has_value());
+
+  clock.advance(now + max_lateness);
+  ASSERT_TRUE(clock.current_timeslot().has_value());
+  ASSERT_EQ(clock.current_timeslot().value(), 42);
+
+  // the input that never sent anything doesn't hold the clock back
+  ASSERT_TRUE(clock.is_late(1));
+  clock.update(0, timestamp + TIMESTAMP_STEP);
+  ASSERT_EQ(clock.advance(now + max_lateness), true);
+  ASSERT_EQ(clock.current_timeslot().value(), 43);
+
+  // and joins whenever it shows up
+  ASSERT_TRUE(clock.can_update(1));
+  ASSERT_EQ(clock.update(1, timestamp + TIMESTAMP_STEP), 0);
+  ASSERT_FALSE(clock.is_late(1));
+  ASSERT_TRUE(clock.is_current(1));
+}
+
+TEST(virtual_clock, watermark_drops_stalled_inputs)
+{
+  constexpr u64 max_lateness = 1000;
+  constexpr u64 step_slots = 1000;
+
+  VirtualClock clock = DEFAULT_CLOCK;
+  clock.set_max_lateness(max_lateness);
+  clock.add_inputs(2);
+
+  u64 timestamp = TIMESTAMP_STEP * 42;
+  u64 now = 5000;
+
+  clock.update(0, timestamp);
+  clock.update(1, timestamp);
+  clock.advance(now);
+  ASSERT_EQ(clock.current_timeslot().value(), 42);
+
+  // input 1 stalls for longer than timeslot differences can represent: the
+  // clock keeps following input 0, without jumping when input 1 would wrap
+  u64 slot = 42;
+  for (u64 i = 0; i < 40; ++i) {
+    timestamp += step_slots * TIMESTAMP_STEP;
+    slot += step_slots;
+    ASSERT_EQ(clock.update(0, timestamp), 0);
+    if (i == 0) {
+      // only waits for input 1 until it is late
+      ASSERT_EQ(clock.advance(now), false);
+      now += max_lateness;
+    }
+    ASSERT_EQ(clock.advance(now), true);
+    ASSERT_EQ(clock.current_timeslot().value(), (VirtualClock::timeslot_t)slot);
+    ASSERT_TRUE(clock.is_late(1));
+    ASSERT_LE(clock.lag(1), VirtualClock::max_lag);
+    ASSERT_TRUE(clock.can_update(1));
+  }
+
+  // once it shows up again, it rejoins the clock
+  ASSERT_EQ(clock.update(1, timestamp), 0);
+  ASSERT_FALSE(clock.is_late(1));
+  ASSERT_TRUE(clock.is_current(1));
+
+  clock.update(0, timestamp + TIMESTAMP_STEP);
+  ASSERT_EQ(clock.advance(now), false);
+  clock.update(1, timestamp + TIMESTAMP_STEP);
+  ASSERT_EQ(clock.advance(now), true);
+  ASSERT_EQ(clock.current_timeslot().value(), (VirtualClock::timeslot_t)(slot + 1));
+}
@@ -7,6 +7,7 @@
 #include <channel/tcp_channel.h>
 #include <reducer/ingest/component.h>
 #include <reducer/util/thread_ops.h>
+#include <platform/userspace-time.h>
 #include <util/defer.h>
 #include <util/log.h>
 #include <util/log_formatters.h>
@@ -17,6 +18,8 @@
 #include <absl/synchronization/notification.h>
 #include <uv.h>
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <thread>
@@ -73,15 +76,41 @@ private:
 
 } // namespace
 
-Worker::Worker()
+bool Worker::io_uring_enabled_ = false;
+u32 Worker::max_admissions_per_second_ = 0;
+
+void Worker::set_io_uring_enabled(bool enabled)
+{
+  io_uring_enabled_ = enabled;
+}
+
+void Worker::set_max_admissions_per_second(u32 per_second)
+{
+  max_admissions_per_second_ = per_second;
+}
+
+Worker::Worker() : admission_(max_admissions_per_second_)
 {
   // Initialize the uv loop.
   CHECK_UV(uv_loop_init(&loop_));
 
+  if (io_uring_enabled_) {
+    auto receiver = ::channel::IoUringReceiver::create(loop_);
+    if (receiver) {
+      io_uring_receiver_ = std::move(*receiver);
+    } else {
+      LOG::warn("io_uring not available, receiving through libuv: {}", receiver.error());
+    }
+  }
+
   // Initialize the async for opening tcp sockets.
   CHECK_UV(uv_async_init(&loop_, &open_tcp_socks_async_, &Worker::open_tcp_socks_async_cb));
   open_tcp_socks_async_.data = this;
 
+  // Initialize the timer for connections waiting to be admitted.
+  CHECK_UV(uv_timer_init(&loop_, &admission_timer_));
+  admission_timer_.data = this;
+
   // Initialize the stopping async.
   CHECK_UV(uv_async_init(&loop_, &stop_async_, &Worker::stop_async_cb));
   stop_async_.data = this;
@@ -108,6 +137,13 @@ void Worker::start(std::size_t thread_num)
     uv_run(&loop_, UV_RUN_DEFAULT);
     close_uv_loop_cleanly(&loop_);
     on_thread_stop();
+
+    // Close the connections that were never admitted.
+    absl::MutexLock l(&mu_);
+    for (const uv_os_sock_t fd : tcp_sock_fds_) {
+      close(fd);
+    }
+    tcp_sock_fds_.clear();
   });
   thread_started_.WaitForNotification();
   started_ = true;
@@ -190,6 +226,13 @@ std::shared_ptr<absl::Notification> Worker::visit_callbacks(CallbacksCb cb)
   });
 }
 
+void Worker::close_connections()
+{
+  for (auto &kv : tcp_channel_to_payload_) {
+    kv.first->close_permanently();
+  }
+}
+
 std::unique_ptr<channel::Callbacks> Worker::create_callbacks(uv_loop_t &loop, ::channel::TCPChannel * /* unused */)
 {
   return std::make_unique<channel::Callbacks>();
@@ -198,12 +241,29 @@ std::unique_ptr<channel::Callbacks> Worker::create_callbacks(uv_loop_t &loop, ::
 void Worker::open_tcp_socks_async_cb(uv_async_t *const handle)
 {
   auto *const worker = reinterpret_cast<Worker *>(handle->data);
+  worker->open_admitted_tcp_socks();
+}
+
+void Worker::admission_timer_cb(uv_timer_t *const handle)
+{
+  auto *const worker = reinterpret_cast<Worker *>(handle->data);
+  worker->open_admitted_tcp_socks();
+}
+
+void Worker::open_admitted_tcp_socks()
+{
+  const std::chrono::nanoseconds now(monotonic());
 
-  // Get the pending list of tcp sockets file descriptors.
+  // Get the admitted part of the pending list of tcp sockets file descriptors,
+  // oldest first.
   std::vector<uv_os_sock_t> tcp_sock_fds;
+  std::size_t still_pending;
   {
-    absl::MutexLock l(&worker->mu_);
-    std::swap(worker->tcp_sock_fds_, tcp_sock_fds);
+    absl::MutexLock l(&mu_);
+    const auto admitted = tcp_sock_fds_.begin() + admission_.admit(tcp_sock_fds_.size(), now);
+    tcp_sock_fds.assign(tcp_sock_fds_.begin(), admitted);
+    tcp_sock_fds_.erase(tcp_sock_fds_.begin(), admitted);
+    still_pending = tcp_sock_fds_.size();
   }
 
   // Create a new tcp connection for each socket fd.
@@ -211,22 +271,35 @@ void Worker::open_tcp_socks_async_cb(uv_async_t *const handle)
     TcpPayload payload;
 
     // Instantiate the TCP channel.
-    payload.tcp_channel = std::make_unique<::channel::TCPChannel>(worker->loop_);
+    payload.tcp_channel = std::make_unique<::channel::TCPChannel>(loop_);
     auto *const tcp_channel_ptr = payload.tcp_channel.get();
 
     // Create the callbacks.
     payload.callbacks = std::make_unique<WorkerCallbacksDecorator>(
-        worker->create_callbacks(worker->loop_, tcp_channel_ptr),
-        [worker, tcp_channel_ptr] { worker->tcp_channel_to_payload_.erase(tcp_channel_ptr); },
+        create_callbacks(loop_, tcp_channel_ptr),
+        [this, tcp_channel_ptr] { tcp_channel_to_payload_.erase(tcp_channel_ptr); },
         tcp_channel_ptr);
 
     // Store the payload.
-    TcpPayload *const payload_ptr = &worker->tcp_channel_to_payload_.emplace(tcp_channel_ptr, std::move(payload)).first->second;
+    TcpPayload *const payload_ptr = &tcp_channel_to_payload_.emplace(tcp_channel_ptr, std::move(payload)).first->second;
 
     payload_ptr->callbacks->on_connect();
 
     // Start accepting messages.
-    tcp_channel_ptr->open_fd(*payload_ptr->callbacks, fd);
+    tcp_channel_ptr->open_fd(*payload_ptr->callbacks, fd, io_uring_receiver_.get());
+  }
+
+  // Come back for the others once the next one can be admitted.
+  if (still_pending && !uv_is_active(reinterpret_cast<uv_handle_t *>(&admission_timer_))) {
+    const auto delay = std::chrono::ceil<std::chrono::milliseconds>(admission_.next_admission_delay(now));
+    CHECK_UV(uv_timer_start(&admission_timer_, &Worker::admission_timer_cb, std::max<u64>(delay.count(), 1), 0));
+
+    LOG::trace_in(
+        ingest::Component::worker,
+        "Worker {:p}: {} connections waiting to be admitted, next in {}ms",
+        (void *)this,
+        still_pending,
+        delay.count());
   }
 }
 
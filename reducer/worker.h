@@ -6,7 +6,9 @@
 #pragma once
 
 #include "channel/callbacks.h"
+#include "channel/io_uring_receiver.h"
 #include "channel/tcp_channel.h"
+#include "reducer/admission_controller.h"
 
 #include <absl/container/node_hash_map.h>
 #include <absl/synchronization/mutex.h>
@@ -31,6 +33,15 @@ public:
   Worker();
   virtual ~Worker();
 
+  // Makes workers created from now on receive through io_uring, on kernels
+  // that support it, rather than libuv.
+  static void set_io_uring_enabled(bool enabled);
+
+  // Makes workers created from now on start handling at most `per_second`
+  // new connections per second, the others waiting their turn. 0 for no
+  // limit.
+  static void set_max_admissions_per_second(u32 per_second);
+
   // Starts the event-processing thread for this worker
   void start(std::size_t thread_num);
 
@@ -42,6 +53,7 @@ public:
   // duplicates the connections file descriptor, and it is the responsibility of
   // the caller to close the original connection. `uv_accept` must already have
   // been called on `tcp_conn` before passing it here.
+  // The connection is handled once admitted, see `set_max_admissions_per_second`.
   // Requires that `start()` was already called.
   void assign(const uv_tcp_t &tcp_conn);
 
@@ -78,9 +90,18 @@ protected:
   // function.
   virtual std::unique_ptr<channel::Callbacks> create_callbacks(uv_loop_t &loop, ::channel::TCPChannel *tcp_channel);
 
+  // Closes all of this worker's connections. Must be called from within the
+  // worker's thread.
+  void close_connections();
+
 private:
+  // Starts handling the assigned connections that can be admitted, and
+  // schedules admitting the others.
+  void open_admitted_tcp_socks();
+
   // Callbacks used by libuv.
   static void open_tcp_socks_async_cb(uv_async_t *handle);
+  static void admission_timer_cb(uv_timer_t *handle);
   static void stop_async_cb(uv_async_t *handle);
   static void visit_async_cb(uv_async_t *handle);
 
@@ -99,6 +120,9 @@ private:
   // The loop that accepts messages on behalf of this worker.
   uv_loop_t loop_;
 
+  // Receives from the connections, if io_uring is enabled and supported.
+  std::unique_ptr<::channel::IoUringReceiver> io_uring_receiver_;
+
   // The thread that runs `loop_`.
   std::thread thread_;
 
@@ -111,6 +135,10 @@ private:
   std::vector<uv_os_sock_t> tcp_sock_fds_ ABSL_GUARDED_BY(mu_);
   mutable absl::Mutex mu_;
 
+  // Paces opening the assigned sockets, retrying on a timer while some wait.
+  AdmissionController admission_;
+  uv_timer_t admission_timer_;
+
   // The queue of visitors.
   uv_async_t visit_async_;
   std::vector<Visitor> visitors_ ABSL_GUARDED_BY(mu_);
@@ -121,6 +149,9 @@ private:
   // Notification to determine when the worker thread has begun.
   bool started_ = false;
   absl::Notification thread_started_;
+
+  static bool io_uring_enabled_;
+  static u32 max_admissions_per_second_;
 };
 
 } // namespace reducer
@@ -115,6 +115,39 @@ inline void write_metrics(
   formatter.remove_label(status_code_label);
 }
 
+#define WRITE_HISTOGRAM(metric_info, sketch)                                                                                   \
+  if (!disabled_metrics.is_metric_disabled(metric_info.metric)) {                                                              \
+    formatter.write_histogram(metric_info, sketch, writer);                                                                    \
+  }
+
+inline void write_metrics(
+    ebpf_net::metrics::tcp_latency_metrics const &m,
+    Publisher::WriterPtr const &writer,
+    TsdbFormatter &formatter,
+    const DisabledMetrics &disabled_metrics)
+{
+  WRITE_HISTOGRAM(TcpMetricInfo::rtt, m.rtt);
+}
+
+inline void write_metrics(
+    ebpf_net::metrics::dns_latency_metrics const &m,
+    Publisher::WriterPtr const &writer,
+    TsdbFormatter &formatter,
+    const DisabledMetrics &disabled_metrics)
+{
+  WRITE_HISTOGRAM(DnsMetricInfo::client_duration, m.client_duration);
+}
+
+inline void write_metrics(
+    ebpf_net::metrics::http_latency_metrics const &m,
+    Publisher::WriterPtr const &writer,
+    TsdbFormatter &formatter,
+    const DisabledMetrics &disabled_metrics)
+{
+  WRITE_HISTOGRAM(HttpMetricInfo::client_duration, m.client_duration);
+}
+
+#undef WRITE_HISTOGRAM
 #undef WRITE
 
 // The following functions are used to write metrics as flow logs.
@@ -139,4 +172,16 @@ inline void write_flow_log(
     ebpf_net::metrics::http_metrics const &metrics, TsdbFormatter &formatter, const DisabledMetrics &disabled_metrics)
 {}
 
+inline void write_flow_log(
+    ebpf_net::metrics::tcp_latency_metrics const &metrics, TsdbFormatter &formatter, const DisabledMetrics &disabled_metrics)
+{}
+
+inline void write_flow_log(
+    ebpf_net::metrics::dns_latency_metrics const &metrics, TsdbFormatter &formatter, const DisabledMetrics &disabled_metrics)
+{}
+
+inline void write_flow_log(
+    ebpf_net::metrics::http_latency_metrics const &metrics, TsdbFormatter &formatter, const DisabledMetrics &disabled_metrics)
+{}
+
 } // namespace reducer
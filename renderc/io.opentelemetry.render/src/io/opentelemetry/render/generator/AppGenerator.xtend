@@ -18,6 +18,7 @@ class AppGenerator {
   ProtocolGenerator protocolGenerator = new ProtocolGenerator()
   ConnectionGenerator connectionGenerator = new ConnectionGenerator()
   TransformBuilderGenerator transformBuilderGenerator = new TransformBuilderGenerator()
+  SnapshotGenerator snapshotGenerator = new SnapshotGenerator()
 
   def void doGenerate(App app, IFileSystemAccess2 fsa) {
     bpfGenerator.doGenerate(app, fsa)
@@ -28,6 +29,7 @@ class AppGenerator {
     protocolGenerator.doGenerate(app, fsa)
     connectionGenerator.doGenerate(app, fsa)
     transformBuilderGenerator.doGenerate(app, fsa)
+    snapshotGenerator.doGenerate(app, fsa)
   }
 
   static def outputPath(App app, String fileName) {
@@ -23,6 +23,8 @@ class MetricsGenerator {
   private def generateMetricPointField(MetricField field) {
     if (field.method == AggregationMethod.TDIGEST) {
       '''double «field.name»;'''
+    } else if (field.method == AggregationMethod.SKETCH) {
+      '''::util::LatencySketch «field.name»;'''
     } else {
       '''«field.cType» «field.name»;'''
     }
@@ -31,6 +33,8 @@ class MetricsGenerator {
   private def generateField(MetricField field) {
     if (field.method == AggregationMethod.TDIGEST) {
       '''::util::TDigest «field.name»;'''
+    } else if (field.method == AggregationMethod.SKETCH) {
+      '''::util::LatencySketch «field.name»;'''
     } else if (field.method == AggregationMethod.GAUGE) {
       '''::data::Gauge<«field.cType»> «field.name»;'''
     } else if (field.method == AggregationMethod.COUNTER) {
@@ -51,6 +55,7 @@ class MetricsGenerator {
     #include <platform/types.h>
     #include <util/counter.h>
     #include <util/gauge.h>
+    #include <util/latency_sketch.h>
     #include <util/tdigest.h>
 
     namespace «pkg_name» {
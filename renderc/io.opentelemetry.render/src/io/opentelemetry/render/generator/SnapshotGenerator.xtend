@@ -0,0 +1,319 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+package io.opentelemetry.render.generator
+
+import java.util.ArrayList
+import java.util.List
+
+import org.eclipse.xtext.generator.IFileSystemAccess2
+
+import io.opentelemetry.render.render.App
+import io.opentelemetry.render.render.Field
+import io.opentelemetry.render.render.Reference
+import io.opentelemetry.render.render.Span
+import static io.opentelemetry.render.generator.AppGenerator.outputPath
+import static io.opentelemetry.render.generator.RenderGenerator.generatedCodeWarning
+import static extension io.opentelemetry.render.extensions.AppExtensions.*
+import static extension io.opentelemetry.render.extensions.FieldExtensions.*
+import static extension io.opentelemetry.render.extensions.MetricFieldExtensions.cType
+
+/**
+ * Generates binary snapshot/restore routines for an app's Index.
+ *
+ * Only indexed spans are covered, since they can be re-created through
+ * by_key(). A span is covered if all spans it references in its key are
+ * covered, and spans are restored in that dependency order.
+ */
+class SnapshotGenerator {
+
+  def void doGenerate(App app, IFileSystemAccess2 fsa) {
+    fsa.generateFile(outputPath(app, "snapshot.h"), generateSnapshotH(app))
+    fsa.generateFile(outputPath(app, "snapshot.cc"), generateSnapshotCc(app))
+  }
+
+  /**
+   * Indexed spans whose key references are all snapshotted, ordered such
+   * that each span comes after the targets of its key references.
+   */
+  static def List<Span> snapshotSpans(App app) {
+    val result = new ArrayList<Span>
+    var changed = true
+    while (changed) {
+      changed = false
+      for (span : app.spans) {
+        if (span.index !== null && !result.contains(span) &&
+            span.index.keys.filter(Reference).forall[result.contains(target)]) {
+          result.add(span)
+          changed = true
+        }
+      }
+    }
+    return result
+  }
+
+  /**
+   * Manual non-key references that can be restored, i.e. whose target is
+   * restored before the span.
+   */
+  private static def restorableReferences(Span span, List<Span> spans) {
+    span.definitions.filter(Reference).filter[
+      !isAuto && !isCached && !span.index.keys.contains(it) &&
+      spans.indexOf(target) >= 0 && spans.indexOf(target) < spans.indexOf(span)
+    ]
+  }
+
+  /**
+   * Metric stores to snapshot. Spans with an impl object are left out: the
+   * impl isn't snapshotted, so their metrics would go out without what it
+   * holds (e.g. node labels) until collectors resend it.
+   */
+  private static def metricStores(Span span) {
+    val stores = new ArrayList<String>
+    if (span.impl !== null) {
+      return stores
+    }
+    for (agg : span.aggs) {
+      stores.add(agg.name)
+      for (rollup : agg.rollups) {
+        stores.add(agg.name + "_" + rollup.rollup_count)
+      }
+    }
+    return stores
+  }
+
+  /**
+   * Description of everything that determines the snapshot layout, written in
+   * full so snapshots from incompatible render definitions are rejected.
+   */
+  private static def schemaString(App app) {
+    val spans = snapshotSpans(app)
+    val schema = new StringBuilder
+    for (span : spans) {
+      schema.append(span.name).append('{')
+      for (field : span.definitions.filter(Field)) {
+        schema.append(field.name).append(':').append(field.cType).append(';')
+      }
+      for (ref : span.index.keys.filter(Reference)) {
+        schema.append(ref.name).append("->").append(ref.target.name).append(';')
+      }
+      for (ref : restorableReferences(span, spans)) {
+        schema.append(ref.name).append("=>").append(ref.target.name).append(';')
+      }
+      for (agg : span.aggs.filter[span.impl === null]) {
+        schema.append(agg.name).append('[').append(agg.slots).append(']').append(agg.isRoot).append('<')
+        for (field : agg.type.fields) {
+          schema.append(field.name).append(':').append(field.cType).append(':').append(field.method).append(';')
+        }
+        schema.append('>').append(agg.rollups.map[rollup_count].join(","))
+      }
+      schema.append('}')
+    }
+    return schema.toString
+  }
+
+  private static def generateSnapshotH(App app) {
+    '''
+    «generatedCodeWarning()»
+    #pragma once
+
+    #include "handles.h"
+
+    #include <util/snapshot.h>
+
+    #include <cstddef>
+    #include <vector>
+
+    namespace «app.pkg.name»::«app.name» {
+
+    class Index;
+
+    /**
+     * Handles held on spans restored from a snapshot.
+     *
+     * Restored spans are kept alive until release() is called, giving
+     * clients time to re-acquire them. Spans nobody re-acquired are freed.
+     */
+    struct RestoredSpans {
+      «FOR span : snapshotSpans(app)»
+        std::vector<::«app.pkg.name»::«app.name»::handles::«span.name»> «span.name»;
+      «ENDFOR»
+
+      /**
+       * @returns the number of spans held
+       */
+      std::size_t size() const;
+
+      void release(Index &index);
+    };
+
+    /**
+     * Writes the indexed spans to |out|, with the queued metrics of spans
+     * that have no impl object.
+     */
+    void write_snapshot(Index &index, SnapshotWriter &out);
+
+    /**
+     * Re-creates the spans in |in| in |index|.
+     *
+     * @throws std::runtime_error if the snapshot is truncated or was created
+     *   from different render definitions.
+     */
+    RestoredSpans restore_snapshot(Index &index, SnapshotReader &in);
+
+    } // namespace «app.pkg.name»::«app.name»
+    '''
+  }
+
+  private static def generateSnapshotCc(App app) {
+    val spans = snapshotSpans(app)
+    '''
+    «generatedCodeWarning()»
+    #include "snapshot.h"
+    #include "index.h"
+    #include "weak_refs.inl"
+    #include "containers.inl"
+
+    #include <stdexcept>
+    #include <string_view>
+
+    namespace «app.pkg.name»::«app.name» {
+
+    namespace {
+
+    constexpr u64 magic = 0x32504e5352444e52ull; // "RNDRSNP2"
+    constexpr std::string_view schema = R"schema(«schemaString(app)»)schema";
+
+    } // namespace
+
+    std::size_t RestoredSpans::size() const
+    {
+      return 0«FOR span : spans» + «span.name».size()«ENDFOR»;
+    }
+
+    void RestoredSpans::release(Index &index)
+    {
+      «FOR span : spans.reverseView»
+        for (auto &handle : «span.name») {
+          handle.put(index);
+        }
+        «span.name».clear();
+      «ENDFOR»
+    }
+
+    void write_snapshot(Index &index, SnapshotWriter &out)
+    {
+      out.write(magic);
+      out.write_string(schema);
+
+      «FOR span : spans»
+        /* span «span.name» */
+        {
+          auto &container = index.«span.name»;
+          out.write(static_cast<u32>(container.size()));
+          for (auto const loc : container.map.allocated()) {
+            auto span_ref = container.at(loc);
+            out.write(static_cast<u32>(loc));
+            «FOR field : span.definitions.filter(Field)»
+              out.write(span_ref.«field.name»());
+            «ENDFOR»
+            «FOR ref : span.index.keys.filter(Reference)»
+              out.write(static_cast<u32>(span_ref.«ref.name»().loc()));
+            «ENDFOR»
+            «FOR ref : restorableReferences(span, spans)»
+              {
+                auto target = span_ref.«ref.name»();
+                out.write(target.valid() ? static_cast<u32>(target.loc()) : u32(-1));
+              }
+            «ENDFOR»
+          }
+          «FOR store : metricStores(span)»
+            snapshot_metric_store(container.«store», out);
+          «ENDFOR»
+        }
+
+      «ENDFOR»
+    }
+
+    RestoredSpans restore_snapshot(Index &index, SnapshotReader &in)
+    {
+      if (in.read<u64>() != magic) {
+        throw std::runtime_error("not an index snapshot");
+      }
+      if (in.read_string() != schema) {
+        throw std::runtime_error("index snapshot was created from different render definitions");
+      }
+
+      RestoredSpans restored;
+
+      // on a truncated snapshot, free whatever was restored so far
+      try {
+        «FOR span : spans»
+          /* span «span.name» */
+          SnapshotLocationMap «span.name»_locations;
+          {
+            auto &container = index.«span.name»;
+            auto const count = in.read<u32>();
+            for (u32 i = 0; i < count; ++i) {
+              auto const old_loc = in.read<u32>();
+              «FOR field : span.definitions.filter(Field)»
+                auto const f_«field.name» = in.read<«field.cType»>();
+              «ENDFOR»
+              «FOR ref : span.index.keys.filter(Reference)»
+                auto const r_«ref.name» = in.read<u32>();
+              «ENDFOR»
+              «FOR ref : restorableReferences(span, spans)»
+                auto const r_«ref.name» = in.read<u32>();
+              «ENDFOR»
+
+              ::«app.pkg.name»::«app.name»::keys::«span.name» key;
+              «FOR field : span.index.keys.filter(Field)»
+                key.«field.name» = f_«field.name»;
+              «ENDFOR»
+              «FOR ref : span.index.keys.filter(Reference)»
+                if (auto found = «ref.target.name»_locations.find(r_«ref.name»); found != «ref.target.name»_locations.end()) {
+                  key.«ref.name» = found->second;
+                } else {
+                  continue;
+                }
+              «ENDFOR»
+
+              auto handle = container.by_key(key);
+              if (!handle.valid()) {
+                continue;
+              }
+
+              {
+                auto modifier = handle.modify();
+                «FOR field : span.definitions.filter(Field).filter[!span.index.keys.contains(it)]»
+                  modifier.«field.name»(f_«field.name»);
+                «ENDFOR»
+                «FOR ref : restorableReferences(span, spans)»
+                  if (auto found = «ref.target.name»_locations.find(r_«ref.name»); found != «ref.target.name»_locations.end()) {
+                    modifier.«ref.name»(index.«ref.target.name».get(found->second));
+                  }
+                «ENDFOR»
+              }
+
+              «span.name»_locations.emplace(old_loc, handle.loc());
+              restored.«span.name».push_back(handle.to_handle());
+            }
+            «FOR store : metricStores(span)»
+              restore_metric_store(container.«store», in, «span.name»_locations);
+            «ENDFOR»
+          }
+
+        «ENDFOR»
+      } catch (...) {
+        restored.release(index);
+        throw;
+      }
+
+      return restored;
+    }
+
+    } // namespace «app.pkg.name»::«app.name»
+    '''
+  }
+
+}
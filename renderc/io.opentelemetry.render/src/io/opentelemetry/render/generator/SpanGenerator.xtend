@@ -96,13 +96,15 @@ class SpanGenerator {
         «FOR field : agg.type.fields»
           «IF field.method == AggregationMethod::TDIGEST»
             it.second.«field.name».add(«metric».«field.name»);
+          «ELSEIF field.method == AggregationMethod::SKETCH»
+            it.second.m.«field.name».merge(«metric».«field.name»);
           «ELSE»
             it.second.m.«field.name» += «metric».«field.name»;
           «ENDIF»
         «ENDFOR»
       «ELSE»
         «FOR field : agg.type.fields»
-          «IF field.method == AggregationMethod::TDIGEST»
+          «IF field.method == AggregationMethod::TDIGEST || field.method == AggregationMethod::SKETCH»
             it.second.«field.name».merge(«metric».«field.name»);
           «ELSE»
             it.second.«field.name» += «metric».«field.name»;
@@ -178,14 +180,20 @@ class SpanGenerator {
         «ENDFOR»
 
         «FOR rollup : agg.rollups»
-          {
-            /* time-based rollup to «rollup.rollup_count» times of interval */
+          if (rollup_«rollup.rollup_count»_enabled) {
+            /* time-based rollup to «rollup.rollup_count» times of interval,
+             * into the rollup slot containing this timeslot */
             auto loc = span.loc();
-            «generateMetricUpdate(agg, agg.name + "_" + rollup.rollup_count, "loc", "t", "metrics", false)»
+            «generateMetricUpdate(agg, agg.name + "_" + rollup.rollup_count, "loc", "metric_timestamp", "metrics", false)»
           }
         «ENDFOR»
         «ENDIF»
 
+        «FOR field : agg.type.fields.filter[method == AggregationMethod::SKETCH]»
+          /* release the sketch's memory, the entry is reassigned when next enqueued */
+          metrics.«field.name».clear();
+        «ENDFOR»
+
         /* return the reference count for the metric */
         put(loc);
 
@@ -463,6 +471,7 @@ class SpanGenerator {
     #include <util/fixed_hash.h>
     #include <util/metric_store.h>
 
+    #include <functional>
     #include <ostream>
 
     namespace «app.pkg.name»::«app.name» {
@@ -646,6 +655,24 @@ class SpanGenerator {
         «ENDFOR»
         «ENDFOR»
 
+        «FOR rollup_count : span.aggs.flatMap[rollups].map[rollup_count].toSet»
+          /**
+           * Whether the «rollup_count»-interval rollup stores are updated as
+           * timeslots of the base stores are output. Off by default: rollups
+           * nobody outputs would only hold on to memory and span references.
+           */
+          bool rollup_«rollup_count»_enabled = false;
+        «ENDFOR»
+
+        «IF !span.aggs.empty»
+          /**
+           * If set, called with the location of a span as it is freed, before
+           * the location can be reused, so that state kept by location (e.g.
+           * about the span's metrics) isn't inherited by the next span.
+           */
+          std::function<void(«locationTypeForHandle(span)»)> on_free;
+        «ENDIF»
+
         void dump_json(std::ostream &out) const;
 
         friend std::ostream &operator <<(std::ostream &out, «span.name» const &what) {
@@ -970,6 +997,11 @@ class SpanGenerator {
           «IF span.sharding !== null»
             auto shard_id = val.shard_id_;
           «ENDIF»
+          «IF !span.aggs.empty»
+            if (on_free) {
+              on_free(loc);
+            }
+          «ENDIF»
           «IF span.index !== null»
             map.erase(_key);
           «ELSE»
@@ -1733,6 +1765,11 @@ class SpanGenerator {
           «FOR msg : span.proxyLogMessages»
             «proxyMethodDeclaration(msg)»
           «ENDFOR»
+          «IF span.sharding !== null»
+
+            /* Shard of the remote app that proxy messages are sent to */
+            u8 shard_id() const;
+          «ENDIF»
         «ENDIF»
 
         «IF span.impl !== null»
@@ -1881,6 +1918,13 @@ class SpanGenerator {
         «FOR msg : span.proxyLogMessages»
           «proxyMethodDefinition(span, msg)»
         «ENDFOR»
+        «IF span.sharding !== null»
+
+          u8 «span.name»::shard_id() const
+          {
+            return span_ptr_->shard_id_;
+          }
+        «ENDIF»
       «ENDIF»
 
       «IF span.impl !== null»
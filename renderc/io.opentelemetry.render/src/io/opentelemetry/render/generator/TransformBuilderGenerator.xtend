@@ -51,6 +51,10 @@ class TransformBuilderGenerator {
       // Returns the size of the identity wire message for the given RPC ID.
       u32 get_identity_size(u16 rpc_id);
 
+      // Returns the alignment the wire message for the given RPC ID needs to be handled in place,
+      // without applying the identity transform, or 0 if it always needs the transform.
+      u32 get_identity_zero_copy_alignment(u16 rpc_id);
+
       // Returns identity transform function for the given RPC ID.
       transform_t get_identity(u16 rpc_id);
 
@@ -58,6 +62,7 @@ class TransformBuilderGenerator {
       struct TransformInfo {
         transform_t func;
         u16 size;
+        u32 zero_copy_alignment;
       };
 
       PerfectHash<TransformInfo, «app.hashSize», «app.hashFunctor»> identity_transforms_;
@@ -107,7 +112,7 @@ class TransformBuilderGenerator {
 
       // Add identity transforms.
       «FOR msg : messages»
-        identity_transforms_.insert(«msg.parsed_msg.rpc_id», TransformInfo{.func = «msg.identityTransformName», .size = «msg.wire_msg.size»});
+        identity_transforms_.insert(«msg.parsed_msg.rpc_id», TransformInfo{.func = «msg.identityTransformName», .size = «msg.wire_msg.size», .zero_copy_alignment = «msg.zeroCopyAlignment»});
       «ENDFOR»
     }
 
@@ -120,6 +125,15 @@ class TransformBuilderGenerator {
       return tranform_info->size;
     }
 
+    u32 TransformBuilder::get_identity_zero_copy_alignment(u16 rpc_id)
+    {
+      auto tranform_info = identity_transforms_.find(rpc_id);
+      if (tranform_info == nullptr) {
+        throw std::runtime_error("identity_zero_copy_alignment: rpc_id not found");
+      }
+      return tranform_info->zero_copy_alignment;
+    }
+
     TransformBuilder::transform_t TransformBuilder::get_identity(u16 rpc_id)
     {
       auto tranform_info = identity_transforms_.find(rpc_id);
@@ -138,6 +152,15 @@ class TransformBuilderGenerator {
     '''«app.c_name»_«msg.name»_identity_handler'''
   }
 
+  // Fixed-size messages have the same wire and parsed layouts, so their identity transform is a
+  // plain copy that can be skipped when the wire message is suitably aligned.
+  private static def zeroCopyAlignment(Message msg) {
+    if (msg.wire_msg.dynamic_size)
+      '''0'''
+    else
+      '''alignof(struct «msg.parsed_msg.struct_name»)'''
+  }
+
   private static def identityTransform(Message msg) {
     '''
     uint16_t «identityTransformName(msg)»(const char *src, char *dst)
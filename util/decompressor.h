@@ -0,0 +1,63 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <platform/platform.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+// Decompresses a stream into an output buffer, from which the user consumes
+// the decompressed data.
+class Decompressor {
+public:
+  explicit Decompressor(size_t buf_capacity) : output_buf_capacity_(buf_capacity), tail_loc_(0)
+  {
+    output_buf_ = (u8 *)malloc(buf_capacity * sizeof(u8));
+    if (output_buf_ == NULL) {
+      throw std::runtime_error("Decompressor: failed to allocate memory.");
+    }
+  }
+
+  virtual ~Decompressor() { free(output_buf_); }
+
+  Decompressor(Decompressor const &) = delete;
+  Decompressor &operator=(Decompressor const &) = delete;
+
+  const u8 *output_buf() const { return output_buf_; }
+  size_t output_buf_size() const { return tail_loc_; }
+
+  // Decompresses |data| of size |data_len|.
+  // The # of bytes that have been decompressed is stored in |consumed_len|.
+  //
+  // Returns an error code, if an error happened, 0 otherwise.
+  virtual size_t process(const u8 *data, size_t data_len, size_t *consumed_len) = 0;
+
+  // Returns the name of an error code returned by process().
+  virtual const char *error_name(size_t error) const = 0;
+
+  // Discards |len| bytes of data in output_buf.
+  void discard(size_t len)
+  {
+    assert(tail_loc_ >= len);
+
+    if (tail_loc_ == len) {
+      tail_loc_ = 0;
+      return;
+    }
+
+    memmove((void *)output_buf_, (const void *)(output_buf_ + len), tail_loc_ - len);
+    tail_loc_ -= len;
+  }
+
+protected:
+  const size_t output_buf_capacity_;
+  size_t tail_loc_;
+
+  u8 *output_buf_;
+};
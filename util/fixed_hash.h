@@ -108,10 +108,10 @@ public:
 
     u32 index = it->second;
 
+    /* remove from hash first: |key| may live in the pooled value */
+    map_.erase(it);
     /* remove from pool */
     pool_.remove(index);
-    /* remove from hash */
-    map_.erase(key);
 
     return true;
   }
@@ -6,6 +6,7 @@
 #include <gtest/gtest.h>
 
 #include <set>
+#include <string>
 
 template <typename Hash, typename... Values> void test_values_iteration(Values... values)
 {
@@ -42,3 +43,32 @@ TEST(fixed_hash, values)
 
   test_values_iteration<FixedHash<int, int, 100, std::hash<int>>>(0, 10, 20, 30, 40, 50, 60, 70);
 }
+
+TEST(fixed_hash, erase_key_stored_in_value)
+{
+  // LRU erases evicted entries by the key stored in their value
+  struct entry {
+    std::string key;
+    int value;
+  };
+  FixedHash<std::string, entry, 4, std::hash<std::string>> hash;
+
+  for (int i = 0; i < 100; ++i) {
+    auto const key = std::to_string(i);
+    ASSERT_NE(hash.invalid, hash.insert(key, entry{key, i}).index);
+
+    if (hash.full()) {
+      auto oldest = hash.find(std::to_string(i - 3));
+      ASSERT_NE(nullptr, oldest.entry);
+      EXPECT_TRUE(hash.erase(oldest.entry->key));
+      EXPECT_FALSE(hash.contains(std::to_string(i - 3)));
+    }
+  }
+
+  EXPECT_EQ(3u, hash.size());
+  for (int i = 97; i < 100; ++i) {
+    auto pos = hash.find(std::to_string(i));
+    ASSERT_NE(nullptr, pos.entry);
+    EXPECT_EQ(i, pos.entry->value);
+  }
+}
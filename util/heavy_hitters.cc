@@ -0,0 +1,158 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <util/heavy_hitters.h>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+HeavyHitters::HeavyHitters(u32 capacity) : capacity_(capacity)
+{
+  assert(capacity > 0);
+  entries_.reserve(capacity);
+  positions_.reserve(capacity);
+}
+
+void HeavyHitters::add(u64 key, double weight)
+{
+  if (auto it = positions_.find(key); it != positions_.end()) {
+    entries_[it->second].weight += weight;
+    sift_down(it->second);
+    return;
+  }
+
+  if (entries_.size() < capacity_) {
+    u32 const pos = entries_.size();
+    entries_.push_back(Entry{.key = key, .weight = weight, .error = 0});
+    positions_.emplace(key, pos);
+    sift_up(pos);
+    return;
+  }
+
+  /* replace the lightest key, which the newcomer may have been all along */
+  auto &min = entries_[0];
+  positions_.erase(min.key);
+  ++evictions_;
+
+  min.key = key;
+  min.error = min.weight;
+  min.weight += weight;
+  positions_.emplace(key, 0);
+  sift_down(0);
+}
+
+void HeavyHitters::remove(u64 key)
+{
+  auto it = positions_.find(key);
+  if (it == positions_.end()) {
+    return;
+  }
+
+  u32 const pos = it->second;
+  u32 const last = entries_.size() - 1;
+  if (pos != last) {
+    swap_entries(pos, last);
+  }
+
+  positions_.erase(key);
+  entries_.pop_back();
+
+  /* the entry moved into |pos| may be lighter or heavier than its new
+   * neighbors */
+  if (pos < entries_.size()) {
+    sift_up(pos);
+    sift_down(positions_[entries_[pos].key]);
+  }
+}
+
+double HeavyHitters::estimate(u64 key) const
+{
+  auto it = positions_.find(key);
+  return (it == positions_.end()) ? 0 : entries_[it->second].weight;
+}
+
+double HeavyHitters::error(u64 key) const
+{
+  auto it = positions_.find(key);
+  return (it == positions_.end()) ? 0 : entries_[it->second].error;
+}
+
+void HeavyHitters::decay(double factor)
+{
+  assert(factor >= 0 && factor <= 1);
+
+  /* scaling all weights keeps the heap ordered */
+  for (auto &entry : entries_) {
+    entry.weight *= factor;
+    entry.error *= factor;
+  }
+}
+
+std::vector<u64> HeavyHitters::top(u32 k, double min_weight) const
+{
+  std::vector<Entry const *> sorted;
+  sorted.reserve(entries_.size());
+  for (auto const &entry : entries_) {
+    if (entry.weight >= min_weight) {
+      sorted.push_back(&entry);
+    }
+  }
+
+  k = std::min<u32>(k, sorted.size());
+  std::partial_sort(sorted.begin(), sorted.begin() + k, sorted.end(), [](Entry const *a, Entry const *b) {
+    return (a->weight != b->weight) ? (a->weight > b->weight) : (a->key < b->key);
+  });
+
+  std::vector<u64> keys;
+  keys.reserve(k);
+  for (u32 i = 0; i < k; ++i) {
+    keys.push_back(sorted[i]->key);
+  }
+
+  return keys;
+}
+
+void HeavyHitters::sift_down(u32 pos)
+{
+  u32 const size = entries_.size();
+
+  for (;;) {
+    u32 lightest = pos;
+    u32 const left = 2 * pos + 1;
+    u32 const right = left + 1;
+
+    if (left < size && entries_[left].weight < entries_[lightest].weight) {
+      lightest = left;
+    }
+    if (right < size && entries_[right].weight < entries_[lightest].weight) {
+      lightest = right;
+    }
+    if (lightest == pos) {
+      return;
+    }
+
+    swap_entries(pos, lightest);
+    pos = lightest;
+  }
+}
+
+void HeavyHitters::sift_up(u32 pos)
+{
+  while (pos > 0) {
+    u32 const parent = (pos - 1) / 2;
+    if (entries_[parent].weight <= entries_[pos].weight) {
+      return;
+    }
+
+    swap_entries(pos, parent);
+    pos = parent;
+  }
+}
+
+void HeavyHitters::swap_entries(u32 a, u32 b)
+{
+  std::swap(entries_[a], entries_[b]);
+  positions_[entries_[a].key] = a;
+  positions_[entries_[b].key] = b;
+}
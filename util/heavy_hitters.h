@@ -0,0 +1,80 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <platform/types.h>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <vector>
+
+/**
+ * Finds the heaviest keys in a stream of weighted keys, in bounded memory,
+ * using the Space-Saving algorithm.
+ *
+ * At most |capacity| keys are tracked. When a key that is not tracked
+ * arrives while full, it replaces the lightest tracked key and inherits its
+ * weight, which becomes the new key's maximum overestimation (its error).
+ * Any key whose true weight exceeds total_weight / capacity is guaranteed to
+ * be tracked.
+ *
+ * decay() scales all weights down, so older activity counts for less and
+ * the tracked keys follow the recent heavy hitters.
+ */
+class HeavyHitters {
+public:
+  explicit HeavyHitters(u32 capacity);
+
+  HeavyHitters(HeavyHitters const &) = delete;
+  HeavyHitters &operator=(HeavyHitters const &) = delete;
+
+  /* adds |weight| to the weight of |key| */
+  void add(u64 key, double weight);
+
+  /* stops tracking |key|, if tracked, dropping its weight */
+  void remove(u64 key);
+
+  /* estimated weight of |key|, an upper bound of its true weight; 0 if the
+   * key is not tracked */
+  double estimate(u64 key) const;
+
+  /* maximum overestimation of estimate(key) */
+  double error(u64 key) const;
+
+  /* multiplies all weights by |factor|, in [0, 1] */
+  void decay(double factor);
+
+  /* the (at most) |k| heaviest tracked keys with an estimated weight of at
+   * least |min_weight|, heaviest first */
+  std::vector<u64> top(u32 k, double min_weight = 0) const;
+
+  u32 size() const { return entries_.size(); }
+  u32 capacity() const { return capacity_; }
+
+  /* number of tracked keys that were replaced by newcomers */
+  u64 evictions() const { return evictions_; }
+
+private:
+  struct Entry {
+    u64 key;
+    double weight;
+    double error;
+  };
+
+  /* restores the heap property for the entry at |pos| after its weight
+   * grew */
+  void sift_down(u32 pos);
+  /* restores the heap property for the entry at |pos| after it was added */
+  void sift_up(u32 pos);
+  void swap_entries(u32 a, u32 b);
+
+  u32 capacity_;
+  /* min-heap on weight: entries_[0] is the lightest tracked key */
+  std::vector<Entry> entries_;
+  /* position of each tracked key in entries_ */
+  absl::flat_hash_map<u64, u32> positions_;
+  u64 evictions_ = 0;
+};
@@ -0,0 +1,119 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <util/heavy_hitters.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+TEST(HeavyHittersTest, TracksExactWeightsBelowCapacity)
+{
+  HeavyHitters hh(4);
+
+  hh.add(1, 10);
+  hh.add(2, 5);
+  hh.add(1, 2);
+  hh.add(3, 1);
+
+  EXPECT_EQ(3u, hh.size());
+  EXPECT_EQ(12, hh.estimate(1));
+  EXPECT_EQ(5, hh.estimate(2));
+  EXPECT_EQ(0, hh.error(1));
+  EXPECT_EQ(0, hh.estimate(42));
+  EXPECT_EQ(0u, hh.evictions());
+
+  EXPECT_EQ((std::vector<u64>{1, 2, 3}), hh.top(10));
+  EXPECT_EQ((std::vector<u64>{1, 2}), hh.top(2));
+  EXPECT_EQ((std::vector<u64>{1, 2}), hh.top(10, 5));
+}
+
+TEST(HeavyHittersTest, NewcomerReplacesLightestKey)
+{
+  HeavyHitters hh(2);
+
+  hh.add(1, 10);
+  hh.add(2, 3);
+  hh.add(3, 1);
+
+  EXPECT_EQ(2u, hh.size());
+  EXPECT_EQ(1u, hh.evictions());
+  EXPECT_EQ(0, hh.estimate(2));
+
+  // the newcomer inherits the evicted weight as its error
+  EXPECT_EQ(4, hh.estimate(3));
+  EXPECT_EQ(3, hh.error(3));
+  EXPECT_EQ((std::vector<u64>{1, 3}), hh.top(2));
+}
+
+TEST(HeavyHittersTest, FindsHeavyKeysInLongTail)
+{
+  constexpr u32 capacity = 16;
+  HeavyHitters hh(capacity);
+
+  // 4 heavy keys among a long tail of light ones, interleaved
+  for (u64 i = 0; i < 10000; ++i) {
+    hh.add(1000 + i, 1);
+    if (i % 10 == 0) {
+      hh.add((i / 10) % 4, 25);
+    }
+  }
+
+  auto top = hh.top(4);
+  std::sort(top.begin(), top.end());
+  EXPECT_EQ((std::vector<u64>{0, 1, 2, 3}), top);
+
+  for (u64 key = 0; key < 4; ++key) {
+    // true weight is 250 * 25, overestimated by at most the error
+    EXPECT_GE(hh.estimate(key), 250 * 25);
+    EXPECT_LE(hh.estimate(key) - hh.error(key), 250 * 25);
+  }
+}
+
+TEST(HeavyHittersTest, DecayFollowsRecentActivity)
+{
+  HeavyHitters hh(2);
+
+  hh.add(1, 100);
+  hh.add(2, 60);
+
+  for (int slot = 0; slot < 4; ++slot) {
+    hh.decay(0.5);
+    hh.add(2, 20);
+  }
+
+  EXPECT_EQ(6.25, hh.estimate(1));
+  EXPECT_EQ((std::vector<u64>{2, 1}), hh.top(2));
+}
+
+TEST(HeavyHittersTest, RemoveForgetsKey)
+{
+  HeavyHitters hh(4);
+
+  for (u64 key = 1; key <= 4; ++key) {
+    hh.add(key, key * 10);
+  }
+
+  hh.remove(3);
+  hh.remove(42);
+  EXPECT_EQ(3u, hh.size());
+  EXPECT_EQ(0, hh.estimate(3));
+  EXPECT_EQ((std::vector<u64>{4, 2, 1}), hh.top(10));
+
+  // a removed key starts over, and its slot goes to a newcomer without an eviction
+  hh.add(3, 15);
+  EXPECT_EQ(15, hh.estimate(3));
+  EXPECT_EQ(0, hh.error(3));
+  EXPECT_EQ(0u, hh.evictions());
+
+  // the heap still finds the lightest key
+  hh.add(5, 2);
+  EXPECT_EQ(1u, hh.evictions());
+  EXPECT_EQ(0, hh.estimate(1));
+  EXPECT_EQ((std::vector<u64>{4, 2, 3, 5}), hh.top(10));
+
+  for (u64 key : {4, 2, 3, 5}) {
+    hh.remove(key);
+  }
+  EXPECT_EQ(0u, hh.size());
+}
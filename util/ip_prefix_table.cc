@@ -0,0 +1,300 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <util/ip_prefix_table.h>
+
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+
+namespace {
+
+/* prefix of IPv4-mapped IPv6 addresses, ::ffff:0:0/96 */
+constexpr u128 kV4MappedPrefix = u128(0xffff) << 32;
+constexpr u8 kV4MappedLen = 96;
+
+u128 from_bytes(u8 const bytes[16])
+{
+  u128 value = 0;
+  for (int i = 0; i < 16; ++i) {
+    value = (value << 8) | bytes[i];
+  }
+  return value;
+}
+
+u128 prefix_mask(u8 len)
+{
+  return (len == 0) ? 0 : (~u128(0) << (128 - len));
+}
+
+unsigned bit_at(u128 value, u8 index)
+{
+  return (value >> (127 - index)) & 1;
+}
+
+/* length of the common prefix of |a| and |b|, at most |max| */
+u8 common_prefix_len(u128 a, u128 b, u8 max)
+{
+  u128 const diff = a ^ b;
+  if (diff == 0) {
+    return max;
+  }
+
+  u64 const high = diff >> 64;
+  unsigned const len = high ? __builtin_clzll(high) : 64 + __builtin_clzll(u64(diff));
+  return std::min<unsigned>(len, max);
+}
+
+bool is_v4_mapped(u128 addr)
+{
+  return (addr >> 32) == (kV4MappedPrefix >> 32);
+}
+
+} // namespace
+
+///////////////////
+// IpPrefixTable //
+///////////////////
+
+IpPrefixTable::IpPrefixTable() : level16_(1 << 16, 0), nodes_(1, Node{.prefix = 0, .value = 0, .child = {0, 0}, .len = 0}) {}
+
+std::optional<u32> IpPrefixTable::entry_value(u32 entry)
+{
+  if (entry == 0) {
+    return std::nullopt;
+  }
+  return entry - 1;
+}
+
+std::optional<u32> IpPrefixTable::lookup_v4(u32 addr) const
+{
+  u32 entry = level16_[addr >> 16];
+
+  if (entry & kChunkBit) {
+    entry = chunks_[(entry & ~kChunkBit) * kChunkSize + ((addr >> 8) & 0xff)];
+
+    if (entry & kChunkBit) {
+      entry = chunks_[(entry & ~kChunkBit) * kChunkSize + (addr & 0xff)];
+    }
+  }
+
+  return entry_value(entry);
+}
+
+std::optional<u32> IpPrefixTable::lookup_v6(u8 const addr[16]) const
+{
+  return lookup_v6(from_bytes(addr));
+}
+
+std::optional<u32> IpPrefixTable::lookup_v6(u128 addr) const
+{
+  if (is_v4_mapped(addr)) {
+    if (auto value = lookup_v4(u32(addr))) {
+      return value;
+    }
+    /* IPv6 prefixes shorter than /96 may still cover the address */
+  }
+
+  std::optional<u32> best;
+
+  for (u32 index = 0;;) {
+    Node const &node = nodes_[index];
+    if ((addr ^ node.prefix) & prefix_mask(node.len)) {
+      break;
+    }
+
+    if (node.value) {
+      best = node.value - 1;
+    }
+
+    if (node.len == 128) {
+      break;
+    }
+
+    index = node.child[bit_at(addr, node.len)];
+    if (index == 0) {
+      break;
+    }
+  }
+
+  return best;
+}
+
+size_t IpPrefixTable::memory_usage() const
+{
+  return sizeof(*this) + level16_.capacity() * sizeof(level16_[0]) + chunks_.capacity() * sizeof(chunks_[0]) +
+         nodes_.capacity() * sizeof(nodes_[0]);
+}
+
+////////////////////////////
+// IpPrefixTable::Builder //
+////////////////////////////
+
+void IpPrefixTable::Builder::add_v4(u32 prefix, u8 len, u32 value)
+{
+  assert(len <= 32);
+  assert(value < kChunkBit - 1);
+
+  u32 const mask = (len == 0) ? 0 : (~u32(0) << (32 - len));
+  v4_.push_back(Prefix{.prefix = prefix & mask, .len = len, .value = value});
+}
+
+void IpPrefixTable::Builder::add_v6(u8 const prefix[16], u8 len, u32 value)
+{
+  add_v6(from_bytes(prefix), len, value);
+}
+
+void IpPrefixTable::Builder::add_v6(u128 prefix, u8 len, u32 value)
+{
+  assert(len <= 128);
+  assert(value < kChunkBit - 1);
+
+  if (len >= kV4MappedLen && is_v4_mapped(prefix)) {
+    add_v4(u32(prefix), len - kV4MappedLen, value);
+    return;
+  }
+
+  v6_.push_back(Prefix{.prefix = prefix & prefix_mask(len), .len = len, .value = value});
+}
+
+IpPrefixTable IpPrefixTable::Builder::build() const
+{
+  IpPrefixTable table;
+  build_v4(table);
+  build_v6(table);
+  return table;
+}
+
+void IpPrefixTable::Builder::build_v4(IpPrefixTable &table) const
+{
+  /* painting shorter prefixes first lets longer ones overwrite them, and
+   * guarantees that no chunk exists yet where a prefix is painted */
+  std::vector<Prefix> sorted = v4_;
+  std::stable_sort(sorted.begin(), sorted.end(), [](Prefix const &a, Prefix const &b) { return a.len < b.len; });
+
+  auto &chunks = table.chunks_;
+
+  /* returns the chunk that entry points to, creating one that inherits the
+   * entry's value if there's none */
+  auto chunk_of = [&chunks](u32 &entry) -> u32 {
+    if (entry & kChunkBit) {
+      return entry & ~kChunkBit;
+    }
+    u32 const chunk = chunks.size() / kChunkSize;
+    u32 const inherited = entry;
+    entry = kChunkBit | chunk;
+    chunks.resize(chunks.size() + kChunkSize, inherited);
+    return chunk;
+  };
+
+  for (auto const &prefix : sorted) {
+    u32 const addr = prefix.prefix;
+    u32 const entry = prefix.value + 1;
+
+    if (prefix.len <= 16) {
+      auto first = table.level16_.begin() + (addr >> 16);
+      std::fill(first, first + (1u << (16 - prefix.len)), entry);
+      continue;
+    }
+
+    u32 const chunk2 = chunk_of(table.level16_[addr >> 16]);
+    u32 const index2 = chunk2 * kChunkSize + ((addr >> 8) & 0xff);
+
+    if (prefix.len <= 24) {
+      auto first = chunks.begin() + index2;
+      std::fill(first, first + (1u << (24 - prefix.len)), entry);
+      continue;
+    }
+
+    /* copy the entry out: creating the chunk may reallocate chunks */
+    u32 entry2 = chunks[index2];
+    u32 const chunk3 = chunk_of(entry2);
+    chunks[index2] = entry2;
+
+    auto first = chunks.begin() + chunk3 * kChunkSize + (addr & 0xff);
+    std::fill(first, first + (1u << (32 - prefix.len)), entry);
+  }
+
+  chunks.shrink_to_fit();
+  table.v4_prefixes_ = sorted.size();
+}
+
+void IpPrefixTable::Builder::build_v6(IpPrefixTable &table) const
+{
+  std::vector<Node> nodes = std::move(table.nodes_);
+
+  auto new_node = [&nodes](u128 prefix, u8 len, u32 value) -> u32 {
+    nodes.push_back(Node{.prefix = prefix, .value = value, .child = {0, 0}, .len = len});
+    return nodes.size() - 1;
+  };
+
+  for (auto const &prefix : v6_) {
+    u32 const value = prefix.value + 1;
+
+    /* invariant: the prefix of nodes[index] is a prefix of this one */
+    for (u32 index = 0;;) {
+      if (nodes[index].len == prefix.len) {
+        nodes[index].value = value;
+        break;
+      }
+
+      unsigned const bit = bit_at(prefix.prefix, nodes[index].len);
+      u32 const child = nodes[index].child[bit];
+
+      if (child == 0) {
+        u32 const leaf = new_node(prefix.prefix, prefix.len, value);
+        nodes[index].child[bit] = leaf;
+        break;
+      }
+
+      u8 const common =
+          common_prefix_len(prefix.prefix, nodes[child].prefix, std::min(prefix.len, nodes[child].len));
+
+      if (common == nodes[child].len) {
+        index = child;
+        continue;
+      }
+
+      /* the child diverges from this prefix: put a node at their common
+       * prefix between them */
+      u32 split;
+      if (common == prefix.len) {
+        split = new_node(prefix.prefix, prefix.len, value);
+      } else {
+        split = new_node(prefix.prefix & prefix_mask(common), common, 0);
+        u32 const leaf = new_node(prefix.prefix, prefix.len, value);
+        nodes[split].child[bit_at(prefix.prefix, common)] = leaf;
+      }
+      nodes[split].child[bit_at(nodes[child].prefix, common)] = child;
+      nodes[index].child[bit] = split;
+      break;
+    }
+  }
+
+  /* lay the nodes out in depth-first order, so the first steps of most
+   * lookups share cache lines */
+  auto &laid_out = table.nodes_;
+  laid_out.clear();
+  laid_out.reserve(nodes.size());
+
+  /* (node in |nodes|, its parent in |laid_out|, the parent's child slot) */
+  std::vector<std::tuple<u32, u32, unsigned>> work{{0, 0, 0}};
+  while (!work.empty()) {
+    auto [index, parent, slot] = work.back();
+    work.pop_back();
+
+    u32 const position = laid_out.size();
+    laid_out.push_back(nodes[index]);
+    if (index != 0) {
+      laid_out[parent].child[slot] = position;
+    }
+
+    for (unsigned bit : {1u, 0u}) {
+      if (u32 child = nodes[index].child[bit]) {
+        work.emplace_back(child, position, bit);
+      }
+    }
+  }
+
+  table.v6_prefixes_ = v6_.size();
+}
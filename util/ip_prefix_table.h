@@ -0,0 +1,113 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <platform/types.h>
+
+#include <optional>
+#include <vector>
+
+/**
+ * Immutable longest-prefix-match table mapping IP prefixes to u32 values.
+ *
+ * IPv4 prefixes are held in a DIR-16-8-8 multibit table: a directly indexed
+ * first level of 2^16 entries, and 256-entry chunks for the next two octets,
+ * allocated only under /16s that hold longer prefixes. A lookup is at most
+ * three dependent loads.
+ *
+ * IPv6 prefixes are held in a path-compressed binary trie, whose nodes are
+ * stored contiguously in depth-first order.
+ *
+ * IPv4-mapped IPv6 prefixes and addresses (::ffff:0:0/96) are handled by the
+ * IPv4 table.
+ *
+ * Tables are built once with a Builder and are safe to share between threads.
+ */
+class IpPrefixTable {
+public:
+  class Builder;
+
+  /* an empty table */
+  IpPrefixTable();
+
+  /* value of the longest prefix containing |addr|, in host byte order */
+  std::optional<u32> lookup_v4(u32 addr) const;
+
+  /* value of the longest prefix containing |addr|, 16 bytes in network byte
+   * order */
+  std::optional<u32> lookup_v6(u8 const addr[16]) const;
+
+  /* value of the longest prefix containing |addr| */
+  std::optional<u32> lookup_v6(u128 addr) const;
+
+  /* number of prefixes added to the table */
+  size_t v4_prefixes() const { return v4_prefixes_; }
+  size_t v6_prefixes() const { return v6_prefixes_; }
+
+  /* bytes of memory held by the table */
+  size_t memory_usage() const;
+
+private:
+  /* an entry points to a chunk if kChunkBit is set, otherwise it holds value
+   * + 1, or 0 if no prefix covers it */
+  static constexpr u32 kChunkBit = 1u << 31;
+  static constexpr u32 kChunkSize = 256;
+
+  struct Node {
+    /* the first |len| bits of the node's prefix, the rest being 0 */
+    u128 prefix;
+    /* value + 1, or 0 if the node only exists to branch */
+    u32 value;
+    /* child node indices, 0 for none (the root is never a child) */
+    u32 child[2];
+    u8 len;
+  };
+
+  static std::optional<u32> entry_value(u32 entry);
+
+  size_t v4_prefixes_ = 0;
+  size_t v6_prefixes_ = 0;
+
+  std::vector<u32> level16_;
+  /* 256-entry chunks of the second and third levels, back to back */
+  std::vector<u32> chunks_;
+
+  /* nodes_[0] is the root, ::/0 */
+  std::vector<Node> nodes_;
+};
+
+/**
+ * Collects the prefixes of an IpPrefixTable.
+ *
+ * When the same prefix is added more than once, the last value added wins.
+ */
+class IpPrefixTable::Builder {
+public:
+  /* adds the prefix |prefix|/|len|, in host byte order; bits past |len| are
+   * ignored */
+  void add_v4(u32 prefix, u8 len, u32 value);
+
+  /* adds the prefix |prefix|/|len|, 16 bytes in network byte order; bits past
+   * |len| are ignored */
+  void add_v6(u8 const prefix[16], u8 len, u32 value);
+
+  void add_v6(u128 prefix, u8 len, u32 value);
+
+  IpPrefixTable build() const;
+
+private:
+  struct Prefix {
+    u128 prefix;
+    u8 len;
+    u32 value;
+  };
+
+  void build_v4(IpPrefixTable &table) const;
+  void build_v6(IpPrefixTable &table) const;
+
+  std::vector<Prefix> v4_;
+  std::vector<Prefix> v6_;
+};
@@ -0,0 +1,193 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <util/ip_prefix_table.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace {
+
+constexpr u32 v4(u8 a, u8 b, u8 c, u8 d)
+{
+  return (u32(a) << 24) | (u32(b) << 16) | (u32(c) << 8) | d;
+}
+
+constexpr u128 v6(u64 high, u64 low)
+{
+  return (u128(high) << 64) | low;
+}
+
+constexpr u128 v4_mapped(u32 addr)
+{
+  return (u128(0xffff) << 32) | addr;
+}
+
+} // namespace
+
+TEST(IpPrefixTableTest, EmptyTable)
+{
+  IpPrefixTable table;
+
+  EXPECT_EQ(std::nullopt, table.lookup_v4(v4(10, 0, 0, 1)));
+  EXPECT_EQ(std::nullopt, table.lookup_v6(v6(0x2001'0db8'0000'0000, 1)));
+  EXPECT_EQ(std::nullopt, table.lookup_v6(v4_mapped(v4(10, 0, 0, 1))));
+}
+
+TEST(IpPrefixTableTest, LongestIpv4PrefixWins)
+{
+  IpPrefixTable::Builder builder;
+  builder.add_v4(v4(10, 0, 0, 0), 8, 1);
+  builder.add_v4(v4(10, 1, 0, 0), 16, 2);
+  builder.add_v4(v4(10, 1, 2, 0), 24, 3);
+  builder.add_v4(v4(10, 1, 2, 128), 25, 4);
+  builder.add_v4(v4(10, 1, 2, 200), 32, 5);
+  builder.add_v4(v4(10, 2, 0, 0), 20, 6);
+  // added out of order, and with bits set past the prefix length
+  builder.add_v4(v4(10, 1, 2, 3), 30, 7);
+  auto table = builder.build();
+
+  EXPECT_EQ(7u, table.v4_prefixes());
+
+  EXPECT_EQ(std::nullopt, table.lookup_v4(v4(11, 0, 0, 0)));
+  EXPECT_EQ(1u, table.lookup_v4(v4(10, 0, 0, 0)));
+  EXPECT_EQ(1u, table.lookup_v4(v4(10, 255, 255, 255)));
+  EXPECT_EQ(2u, table.lookup_v4(v4(10, 1, 0, 1)));
+  EXPECT_EQ(2u, table.lookup_v4(v4(10, 1, 3, 0)));
+  EXPECT_EQ(3u, table.lookup_v4(v4(10, 1, 2, 127)));
+  EXPECT_EQ(4u, table.lookup_v4(v4(10, 1, 2, 128)));
+  EXPECT_EQ(4u, table.lookup_v4(v4(10, 1, 2, 199)));
+  EXPECT_EQ(5u, table.lookup_v4(v4(10, 1, 2, 200)));
+  EXPECT_EQ(4u, table.lookup_v4(v4(10, 1, 2, 201)));
+  EXPECT_EQ(7u, table.lookup_v4(v4(10, 1, 2, 0)));
+  EXPECT_EQ(7u, table.lookup_v4(v4(10, 1, 2, 3)));
+  EXPECT_EQ(3u, table.lookup_v4(v4(10, 1, 2, 4)));
+  EXPECT_EQ(6u, table.lookup_v4(v4(10, 2, 15, 255)));
+  EXPECT_EQ(1u, table.lookup_v4(v4(10, 2, 16, 0)));
+}
+
+TEST(IpPrefixTableTest, DefaultRouteAndOverrides)
+{
+  IpPrefixTable::Builder builder;
+  builder.add_v4(0, 0, 1);
+  builder.add_v4(v4(192, 168, 0, 0), 16, 2);
+  builder.add_v4(v4(192, 168, 0, 0), 16, 3);
+  auto table = builder.build();
+
+  EXPECT_EQ(1u, table.lookup_v4(v4(8, 8, 8, 8)));
+  // the last value added for a prefix wins
+  EXPECT_EQ(3u, table.lookup_v4(v4(192, 168, 1, 1)));
+}
+
+TEST(IpPrefixTableTest, LongestIpv6PrefixWins)
+{
+  IpPrefixTable::Builder builder;
+  builder.add_v6(v6(0x2001'0db8'0000'0000, 0), 32, 1);
+  builder.add_v6(v6(0x2001'0db8'0001'0000, 0), 48, 2);
+  builder.add_v6(v6(0x2001'0db8'0001'0002, 0), 64, 3);
+  builder.add_v6(v6(0x2001'0db8'0001'0002, 5), 128, 4);
+  // siblings that split existing nodes
+  builder.add_v6(v6(0x2001'0db8'8000'0000, 0), 33, 5);
+  builder.add_v6(v6(0x2001'0db8'0001'0003, 0), 64, 6);
+  // a prefix inserted above existing ones
+  builder.add_v6(v6(0x2001'0000'0000'0000, 0), 16, 7);
+  auto table = builder.build();
+
+  EXPECT_EQ(7u, table.v6_prefixes());
+
+  EXPECT_EQ(std::nullopt, table.lookup_v6(v6(0x2002'0000'0000'0000, 0)));
+  EXPECT_EQ(7u, table.lookup_v6(v6(0x2001'0db9'0000'0000, 0)));
+  EXPECT_EQ(1u, table.lookup_v6(v6(0x2001'0db8'0000'0000, 1)));
+  EXPECT_EQ(2u, table.lookup_v6(v6(0x2001'0db8'0001'0001, 0)));
+  EXPECT_EQ(3u, table.lookup_v6(v6(0x2001'0db8'0001'0002, 4)));
+  EXPECT_EQ(4u, table.lookup_v6(v6(0x2001'0db8'0001'0002, 5)));
+  EXPECT_EQ(5u, table.lookup_v6(v6(0x2001'0db8'ffff'0000, 0)));
+  EXPECT_EQ(6u, table.lookup_v6(v6(0x2001'0db8'0001'0003, 9)));
+}
+
+TEST(IpPrefixTableTest, Ipv4MappedAddresses)
+{
+  IpPrefixTable::Builder builder;
+  builder.add_v6(v6(0, 0), 0, 1);
+  builder.add_v4(v4(10, 0, 0, 0), 8, 2);
+  builder.add_v6(v4_mapped(v4(172, 16, 0, 0)), 96 + 12, 3);
+  auto table = builder.build();
+
+  EXPECT_EQ(2u, table.v4_prefixes());
+  EXPECT_EQ(1u, table.v6_prefixes());
+
+  EXPECT_EQ(2u, table.lookup_v6(v4_mapped(v4(10, 1, 2, 3))));
+  EXPECT_EQ(3u, table.lookup_v4(v4(172, 31, 0, 1)));
+  EXPECT_EQ(3u, table.lookup_v6(v4_mapped(v4(172, 31, 0, 1))));
+  // IPv6 prefixes covering all of IPv4 still apply
+  EXPECT_EQ(1u, table.lookup_v6(v4_mapped(v4(8, 8, 8, 8))));
+  EXPECT_EQ(std::nullopt, table.lookup_v4(v4(8, 8, 8, 8)));
+
+  u8 const bytes[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 10, 0, 0, 1};
+  EXPECT_EQ(2u, table.lookup_v6(bytes));
+}
+
+TEST(IpPrefixTableTest, MatchesLinearScan)
+{
+  struct Prefix {
+    u128 prefix;
+    u8 len;
+    u32 value;
+  };
+
+  std::mt19937_64 rng(42);
+  auto random_v6 = [&rng] {
+    // keep addresses in a small part of the space so that prefixes overlap
+    return v6(0x2001'0db8'0000'0000 | (rng() & 0xffff'ffff), rng());
+  };
+
+  std::vector<Prefix> v4_prefixes;
+  std::vector<Prefix> v6_prefixes;
+  IpPrefixTable::Builder builder;
+
+  for (u32 value = 0; value < 2000; ++value) {
+    u8 const len = 8 + rng() % 25;
+    u32 const mask = ~u32(0) << (32 - len);
+    u32 const prefix = (u32(rng()) | 0x0a00'0000) & 0x0aff'ffff & mask;
+    v4_prefixes.push_back({prefix, len, value});
+    builder.add_v4(prefix, len, value);
+  }
+
+  for (u32 value = 0; value < 2000; ++value) {
+    u8 const len = 32 + rng() % 97;
+    u128 const mask = ~u128(0) << (128 - len);
+    u128 const prefix = random_v6() & mask;
+    v6_prefixes.push_back({prefix, len, value});
+    builder.add_v6(prefix, len, value);
+  }
+
+  auto const table = builder.build();
+
+  auto expected = [](std::vector<Prefix> const &prefixes, u128 addr, unsigned width) {
+    std::optional<u32> best;
+    int best_len = -1;
+    for (auto const &prefix : prefixes) {
+      u128 const mask = (prefix.len == 0) ? 0 : (~u128(0) << (width - prefix.len));
+      u128 const width_mask = (width == 128) ? ~u128(0) : ((u128(1) << width) - 1);
+      if (((addr ^ prefix.prefix) & mask & width_mask) == 0 && prefix.len >= best_len) {
+        best = prefix.value;
+        best_len = prefix.len;
+      }
+    }
+    return best;
+  };
+
+  for (int i = 0; i < 5000; ++i) {
+    // half of the probes come from prefixes, so that most hit one
+    u32 addr4 = (u32(rng()) | 0x0a00'0000) & 0x0aff'ffff;
+    u128 addr6 = random_v6();
+    if (i % 2) {
+      addr4 = u32(v4_prefixes[rng() % v4_prefixes.size()].prefix) | (u32(rng()) & 0xff);
+      addr6 = v6_prefixes[rng() % v6_prefixes.size()].prefix | (rng() & 0xffff);
+    }
+
+    ASSERT_EQ(expected(v4_prefixes, addr4, 32), table.lookup_v4(addr4)) << i;
+    ASSERT_EQ(expected(v6_prefixes, addr6, 128), table.lookup_v6(addr6)) << i;
+  }
+}
@@ -0,0 +1,366 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <util/latency_sketch.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <ostream>
+
+namespace util {
+
+namespace {
+
+// Floor of |index| / 2^|by|, also for negative indices.
+s32 shift_index(s32 index, int by)
+{
+  return (index >= 0) ? (index >> by) : -((-index - 1) >> by) - 1;
+}
+
+// Lowest scale a decoded sketch may have; adding or merging never takes a
+// sketch below this, since kMaxBuckets buckets at scale -10 span any double.
+constexpr int kMinScale = -10;
+
+template <typename T> void append(std::string &out, T const &value)
+{
+  out.append(reinterpret_cast<char const *>(&value), sizeof(value));
+}
+
+template <typename T> bool consume(std::string_view &in, T &value)
+{
+  if (in.size() < sizeof(value)) {
+    return false;
+  }
+  memcpy(&value, in.data(), sizeof(value));
+  in.remove_prefix(sizeof(value));
+  return true;
+}
+
+} // namespace
+
+LatencySketch::LatencySketch(LatencySketch const &other)
+    : data_(other.data_ ? std::make_unique<Data>(*other.data_) : nullptr)
+{}
+
+LatencySketch &LatencySketch::operator=(LatencySketch const &other)
+{
+  if (this == &other) {
+    return *this;
+  }
+
+  if (!other.data_) {
+    data_.reset();
+  } else if (data_) {
+    // reuses the bucket vector's memory
+    *data_ = *other.data_;
+  } else {
+    data_ = std::make_unique<Data>(*other.data_);
+  }
+
+  return *this;
+}
+
+LatencySketch::~LatencySketch() {}
+
+s32 LatencySketch::bucket_index(double value, int scale)
+{
+  assert(value > 0);
+
+  // upper boundaries are inclusive, so exact powers of the base belong to
+  // the bucket below them
+  return (s32)std::ceil(std::ldexp(std::log2(value), scale)) - 1;
+}
+
+double LatencySketch::bucket_lower_bound(s32 index, int scale)
+{
+  return std::exp2(std::ldexp((double)index, -scale));
+}
+
+void LatencySketch::add(double value, u64 count)
+{
+  if (count == 0 || !std::isfinite(value)) {
+    return;
+  }
+
+  if (!data_) {
+    data_ = std::make_unique<Data>();
+    data_->min = value;
+    data_->max = value;
+  }
+
+  data_->count += count;
+  data_->sum += value * count;
+  data_->min = std::min(data_->min, value);
+  data_->max = std::max(data_->max, value);
+
+  if (value <= 0) {
+    data_->zero_count += count;
+    return;
+  }
+
+  add_to_bucket(bucket_index(value, data_->scale), data_->scale, count);
+}
+
+void LatencySketch::merge(LatencySketch const &other)
+{
+  if (!other.data_) {
+    return;
+  }
+
+  if (!data_) {
+    *this = other;
+    return;
+  }
+
+  auto const &src = *other.data_;
+
+  data_->count += src.count;
+  data_->zero_count += src.zero_count;
+  data_->sum += src.sum;
+  data_->min = std::min(data_->min, src.min);
+  data_->max = std::max(data_->max, src.max);
+
+  if (src.buckets.empty()) {
+    return;
+  }
+
+  // bring this sketch to a scale that fits both ranges up front, so the
+  // buckets are only downscaled once
+  int scale = std::min(data_->scale, src.scale);
+  if (!data_->buckets.empty()) {
+    s32 const src_lo = src.offset;
+    s32 const src_hi = src.offset + (s32)src.buckets.size() - 1;
+    s32 const dst_lo = data_->offset;
+    s32 const dst_hi = data_->offset + (s32)data_->buckets.size() - 1;
+
+    while (scale > 0) {
+      s32 const lo = std::min(shift_index(src_lo, src.scale - scale), shift_index(dst_lo, data_->scale - scale));
+      s32 const hi = std::max(shift_index(src_hi, src.scale - scale), shift_index(dst_hi, data_->scale - scale));
+      if ((u32)(hi - lo + 1) <= kMaxBuckets) {
+        break;
+      }
+      --scale;
+    }
+  }
+
+  if (scale < data_->scale) {
+    downscale(data_->scale - scale);
+  }
+
+  for (size_t i = 0; i < src.buckets.size(); ++i) {
+    if (src.buckets[i] > 0) {
+      add_to_bucket(src.offset + (s32)i, src.scale, src.buckets[i]);
+    }
+  }
+}
+
+void LatencySketch::add_to_bucket(s32 index, int scale, u64 count)
+{
+  auto &data = *data_;
+
+  if (scale > data.scale) {
+    index = shift_index(index, scale - data.scale);
+  } else {
+    assert(scale == data.scale);
+  }
+
+  if (data.buckets.empty()) {
+    data.offset = index;
+    data.buckets.push_back(count);
+    return;
+  }
+
+  // widen the bucket range to include |index|, lowering the scale as long as
+  // that would exceed kMaxBuckets
+  for (;;) {
+    s32 const lo = std::min(data.offset, index);
+    s32 const hi = std::max(data.offset + (s32)data.buckets.size() - 1, index);
+
+    if ((u32)(hi - lo + 1) <= kMaxBuckets) {
+      if (lo < data.offset) {
+        data.buckets.insert(data.buckets.begin(), data.offset - lo, 0);
+        data.offset = lo;
+      }
+      if (hi >= data.offset + (s32)data.buckets.size()) {
+        data.buckets.resize(hi - data.offset + 1, 0);
+      }
+      break;
+    }
+
+    downscale(1);
+    index = shift_index(index, 1);
+  }
+
+  data.buckets[index - data.offset] += count;
+}
+
+void LatencySketch::downscale(int by)
+{
+  auto &data = *data_;
+
+  assert(by > 0);
+  data.scale -= by;
+
+  if (data.buckets.empty()) {
+    return;
+  }
+
+  s32 const offset = shift_index(data.offset, by);
+  s32 const last = shift_index(data.offset + (s32)data.buckets.size() - 1, by);
+
+  std::vector<u64> buckets(last - offset + 1, 0);
+  for (size_t i = 0; i < data.buckets.size(); ++i) {
+    buckets[shift_index(data.offset + (s32)i, by) - offset] += data.buckets[i];
+  }
+
+  data.offset = offset;
+  data.buckets = std::move(buckets);
+}
+
+u64 LatencySketch::count() const
+{
+  return data_ ? data_->count : 0;
+}
+
+double LatencySketch::sum() const
+{
+  return data_ ? data_->sum : 0.0;
+}
+
+double LatencySketch::min() const
+{
+  return data_ ? data_->min : 0.0;
+}
+
+double LatencySketch::max() const
+{
+  return data_ ? data_->max : 0.0;
+}
+
+int LatencySketch::scale() const
+{
+  return data_ ? data_->scale : kMaxScale;
+}
+
+u64 LatencySketch::zero_count() const
+{
+  return data_ ? data_->zero_count : 0;
+}
+
+s32 LatencySketch::offset() const
+{
+  return data_ ? data_->offset : 0;
+}
+
+std::vector<u64> const &LatencySketch::bucket_counts() const
+{
+  static std::vector<u64> const no_buckets;
+  return data_ ? data_->buckets : no_buckets;
+}
+
+double LatencySketch::quantile(double q) const
+{
+  if (!data_ || data_->count == 0) {
+    return 0.0;
+  }
+
+  auto const &data = *data_;
+
+  if (q <= 0) {
+    return data.min;
+  }
+  if (q >= 1) {
+    return data.max;
+  }
+
+  // rank of the value at |q|, 1-based
+  u64 const rank = std::max<u64>(1, (u64)std::ceil(q * data.count));
+
+  u64 seen = data.zero_count;
+  if (seen >= rank) {
+    return std::clamp(0.0, data.min, data.max);
+  }
+
+  for (size_t i = 0; i < data.buckets.size(); ++i) {
+    seen += data.buckets[i];
+    if (seen >= rank) {
+      // geometric middle of the bucket, which has the lowest relative error
+      s32 const index = data.offset + (s32)i;
+      double const lower = bucket_lower_bound(index, data.scale);
+      double const upper = bucket_lower_bound(index + 1, data.scale);
+      return std::clamp(std::sqrt(lower * upper), data.min, data.max);
+    }
+  }
+
+  return data.max;
+}
+
+void LatencySketch::encode(std::string &out) const
+{
+  out.clear();
+  if (!data_) {
+    return;
+  }
+
+  auto const &data = *data_;
+  out.reserve(sizeof(s8) + 3 * sizeof(u64) + 3 * sizeof(double) + sizeof(s32) + data.buckets.size() * sizeof(u64));
+
+  append(out, (s8)data.scale);
+  append(out, data.count);
+  append(out, data.zero_count);
+  append(out, data.sum);
+  append(out, data.min);
+  append(out, data.max);
+  append(out, data.offset);
+  append(out, (u16)data.buckets.size());
+  for (u64 const count : data.buckets) {
+    append(out, count);
+  }
+}
+
+bool LatencySketch::decode(std::string_view in)
+{
+  data_.reset();
+  if (in.empty()) {
+    return true;
+  }
+
+  auto data = std::make_unique<Data>();
+  s8 scale = 0;
+  u16 bucket_count = 0;
+
+  if (!consume(in, scale) || !consume(in, data->count) || !consume(in, data->zero_count) || !consume(in, data->sum) ||
+      !consume(in, data->min) || !consume(in, data->max) || !consume(in, data->offset) || !consume(in, bucket_count)) {
+    return false;
+  }
+
+  if (scale < kMinScale || scale > kMaxScale || bucket_count > kMaxBuckets || in.size() != bucket_count * sizeof(u64)) {
+    return false;
+  }
+
+  data->scale = scale;
+  data->buckets.resize(bucket_count);
+  for (u64 &count : data->buckets) {
+    consume(in, count);
+  }
+
+  data_ = std::move(data);
+  return true;
+}
+
+std::ostream &operator<<(std::ostream &out, LatencySketch const &sketch)
+{
+  out << "count=" << sketch.count() << " sum=" << sketch.sum() << " scale=" << sketch.scale()
+      << " buckets=" << sketch.bucket_counts().size();
+  return out;
+}
+
+std::ostream &operator<<(std::ostream &out, LatencySketch::Sample const &sample)
+{
+  out << sample.value << 'x' << sample.count;
+  return out;
+}
+
+} // namespace util
@@ -0,0 +1,117 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <platform/types.h>
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+// LatencySketch is a compact, mergeable distribution of latency values, with
+// the bucket layout of an OTLP exponential histogram.
+//
+// Positive values fall into buckets with exponentially growing boundaries:
+// bucket |i| holds values in (base^i, base^(i + 1)], with base =
+// 2^(2^-scale). Non-positive values are counted separately, as zeros.
+//
+// Sketches start at kMaxScale (a relative error of about 4%). When the
+// values span more than kMaxBuckets buckets, the scale is lowered, merging
+// pairs of adjacent buckets, so memory stays bounded. Merging sketches brings
+// both to the lower of their scales, so merging is exact: merging two
+// sketches gives the same result as adding all their values to one.
+//
+// An empty sketch holds no memory besides a null pointer, so it can be
+// embedded in large metric stores that only occasionally carry values.
+//
+class LatencySketch {
+public:
+  static constexpr int kMaxScale = 3;
+  static constexpr u32 kMaxBuckets = 160;
+
+  // A value with a weight, to be added to a sketch.
+  struct Sample {
+    double value = 0.0;
+    u64 count = 0;
+  };
+
+  LatencySketch() = default;
+  LatencySketch(LatencySketch const &other);
+  LatencySketch(LatencySketch &&other) noexcept = default;
+  LatencySketch &operator=(LatencySketch const &other);
+  LatencySketch &operator=(LatencySketch &&other) noexcept = default;
+  ~LatencySketch();
+
+  // Adds |count| occurrences of |value|. No-op if |count| is zero or |value|
+  // is not finite.
+  void add(double value, u64 count = 1);
+  void add(Sample const &sample) { add(sample.value, sample.count); }
+
+  // Merges |other| in place.
+  void merge(LatencySketch const &other);
+
+  // Removes all values, releasing the sketch's memory.
+  void clear() { data_.reset(); }
+
+  bool empty() const { return !data_; }
+
+  // Number, sum, min and max of all values added.
+  u64 count() const;
+  double sum() const;
+  double min() const;
+  double max() const;
+
+  // Bucket layout, see OTLP's ExponentialHistogramDataPoint.
+  int scale() const;
+  u64 zero_count() const;
+  s32 offset() const;
+  std::vector<u64> const &bucket_counts() const;
+
+  // Estimates the value at quantile |q|, in [0, 1].
+  // Returns 0 if the sketch is empty.
+  double quantile(double q) const;
+
+  // Replaces |out| with the sketch's serialized form, so it can be carried in
+  // a message. An empty sketch encodes as an empty string.
+  void encode(std::string &out) const;
+
+  // Replaces the sketch's contents with the sketch serialized in |in|.
+  // Returns false, leaving the sketch empty, if |in| is malformed.
+  bool decode(std::string_view in);
+
+  // Returns the index of the bucket holding positive |value| at |scale|.
+  static s32 bucket_index(double value, int scale);
+  // Returns the (exclusive) lower boundary of bucket |index| at |scale|.
+  static double bucket_lower_bound(s32 index, int scale);
+
+private:
+  struct Data {
+    int scale = kMaxScale;
+    u64 count = 0;
+    u64 zero_count = 0;
+    double sum = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    s32 offset = 0;
+    std::vector<u64> buckets;
+  };
+
+  // Adds |count| to the bucket |index| at |scale|, downscaling as needed.
+  void add_to_bucket(s32 index, int scale, u64 count);
+  // Lowers the scale of the sketch by |by|.
+  void downscale(int by);
+
+  std::unique_ptr<Data> data_;
+};
+
+std::ostream &operator<<(std::ostream &out, LatencySketch const &sketch);
+std::ostream &operator<<(std::ostream &out, LatencySketch::Sample const &sample);
+
+} // namespace util
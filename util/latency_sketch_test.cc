@@ -0,0 +1,174 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <util/latency_sketch.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace util {
+namespace {
+
+// relative error bound at LatencySketch::kMaxScale
+constexpr double kRelativeError = 0.05;
+
+TEST(LatencySketchTest, Empty)
+{
+  LatencySketch sketch;
+
+  EXPECT_TRUE(sketch.empty());
+  EXPECT_EQ(0u, sketch.count());
+  EXPECT_EQ(0.0, sketch.quantile(0.5));
+  EXPECT_TRUE(sketch.bucket_counts().empty());
+
+  // zero-weight samples don't allocate
+  sketch.add(LatencySketch::Sample{});
+  EXPECT_TRUE(sketch.empty());
+}
+
+TEST(LatencySketchTest, BucketBoundaries)
+{
+  int const scale = LatencySketch::kMaxScale;
+
+  // upper boundaries are inclusive
+  EXPECT_EQ(-1, LatencySketch::bucket_index(1.0, scale));
+  EXPECT_EQ(7, LatencySketch::bucket_index(2.0, scale));
+  EXPECT_EQ(0, LatencySketch::bucket_index(1.01, scale));
+
+  for (double value : {0.001, 0.37, 1.5, 42.0, 1e6}) {
+    auto const index = LatencySketch::bucket_index(value, scale);
+    EXPECT_LT(LatencySketch::bucket_lower_bound(index, scale), value);
+    EXPECT_GE(LatencySketch::bucket_lower_bound(index + 1, scale) * (1 + 1e-12), value);
+  }
+}
+
+TEST(LatencySketchTest, Quantiles)
+{
+  LatencySketch sketch;
+
+  for (int i = 1; i <= 1000; ++i) {
+    sketch.add(i / 1000.0);
+  }
+
+  EXPECT_EQ(1000u, sketch.count());
+  EXPECT_NEAR(500.5, sketch.sum(), 1e-9);
+  EXPECT_EQ(0.001, sketch.min());
+  EXPECT_EQ(1.0, sketch.max());
+  EXPECT_EQ(LatencySketch::kMaxScale, sketch.scale());
+
+  for (double q : {0.5, 0.9, 0.95, 0.99}) {
+    EXPECT_NEAR(q, sketch.quantile(q), q * kRelativeError) << "q=" << q;
+  }
+  EXPECT_EQ(1.0, sketch.quantile(1.0));
+}
+
+TEST(LatencySketchTest, WeightedSamplesAndZeros)
+{
+  LatencySketch sketch;
+
+  sketch.add(0.0, 10);
+  sketch.add(LatencySketch::Sample{.value = 2.0, .count = 90});
+
+  EXPECT_EQ(100u, sketch.count());
+  EXPECT_EQ(10u, sketch.zero_count());
+  EXPECT_EQ(180.0, sketch.sum());
+  EXPECT_EQ(0.0, sketch.quantile(0.05));
+  EXPECT_NEAR(2.0, sketch.quantile(0.5), 2.0 * kRelativeError);
+}
+
+TEST(LatencySketchTest, DownscalesWideRanges)
+{
+  LatencySketch sketch;
+
+  sketch.add(1e-6);
+  sketch.add(1e6);
+
+  EXPECT_LT(sketch.scale(), LatencySketch::kMaxScale);
+  EXPECT_LE(sketch.bucket_counts().size(), LatencySketch::kMaxBuckets);
+  EXPECT_EQ(2u, sketch.count());
+  EXPECT_EQ(1e-6, sketch.quantile(0.0));
+  EXPECT_EQ(1e6, sketch.quantile(1.0));
+}
+
+TEST(LatencySketchTest, MergeMatchesAddingAllValues)
+{
+  LatencySketch all;
+  LatencySketch parts[3];
+
+  for (int i = 0; i < 3000; ++i) {
+    // parts cover different ranges, so merging has to downscale
+    double value = std::pow(10.0, (i % 3) * 3 - 3) * (1 + (i % 97));
+    all.add(value);
+    parts[i % 3].add(value);
+  }
+
+  LatencySketch merged;
+  for (auto const &part : parts) {
+    merged.merge(part);
+  }
+
+  EXPECT_EQ(all.count(), merged.count());
+  EXPECT_EQ(all.min(), merged.min());
+  EXPECT_EQ(all.max(), merged.max());
+  EXPECT_EQ(all.scale(), merged.scale());
+  EXPECT_EQ(all.offset(), merged.offset());
+  EXPECT_EQ(all.bucket_counts(), merged.bucket_counts());
+  EXPECT_NEAR(all.sum(), merged.sum(), all.sum() * 1e-12);
+}
+
+TEST(LatencySketchTest, CopyAndClear)
+{
+  LatencySketch sketch;
+  sketch.add(0.5, 3);
+
+  LatencySketch copy = sketch;
+  copy.add(0.25);
+  EXPECT_EQ(3u, sketch.count());
+  EXPECT_EQ(4u, copy.count());
+
+  copy = LatencySketch();
+  EXPECT_TRUE(copy.empty());
+
+  sketch.clear();
+  EXPECT_TRUE(sketch.empty());
+  EXPECT_EQ(0u, sketch.count());
+}
+
+TEST(LatencySketchTest, EncodeDecode)
+{
+  LatencySketch sketch;
+  std::string encoded;
+
+  sketch.encode(encoded);
+  EXPECT_TRUE(encoded.empty());
+
+  sketch.add(0.0, 2);
+  sketch.add(1e-3, 5);
+  sketch.add(30.0);
+
+  sketch.encode(encoded);
+  LatencySketch decoded;
+  ASSERT_TRUE(decoded.decode(encoded));
+  EXPECT_EQ(sketch.count(), decoded.count());
+  EXPECT_EQ(sketch.zero_count(), decoded.zero_count());
+  EXPECT_EQ(sketch.sum(), decoded.sum());
+  EXPECT_EQ(sketch.min(), decoded.min());
+  EXPECT_EQ(sketch.max(), decoded.max());
+  EXPECT_EQ(sketch.scale(), decoded.scale());
+  EXPECT_EQ(sketch.offset(), decoded.offset());
+  EXPECT_EQ(sketch.bucket_counts(), decoded.bucket_counts());
+
+  // merging decoded sketches is as exact as merging the originals
+  decoded.merge(sketch);
+  EXPECT_EQ(2 * sketch.count(), decoded.count());
+
+  EXPECT_TRUE(decoded.decode(""));
+  EXPECT_TRUE(decoded.empty());
+
+  EXPECT_FALSE(decoded.decode(std::string_view(encoded).substr(0, encoded.size() - 1)));
+  EXPECT_TRUE(decoded.empty());
+}
+
+} // namespace
+} // namespace util
@@ -107,6 +107,20 @@ public:
    */
   queue_type &current_queue() { return queue_[current_queue_]; }
 
+  /**
+   * Calls f(index, bin, metric) for every queued entry without dequeuing it.
+   *   |bin| is relative to the current queue, as in lookup_relative().
+   */
+  template <typename F> void foreach_queued(F &&f)
+  {
+    for (epoch_type bin = 0; bin < n_epochs; bin++) {
+      epoch_type epoch = (bin + current_queue_) & (n_epochs - 1);
+      for (index_type i = queue_[epoch].head_; i != list_end; i = arr_[i].next[epoch]) {
+        f(i, bin, arr_[i].m[epoch]);
+      }
+    }
+  }
+
   /**
    * Advances the window of stat collection by one timeslot
    */
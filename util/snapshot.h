@@ -0,0 +1,150 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <platform/types.h>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Binary encoding used by render-generated index snapshots.
+//
+// Values are written in host byte order and layout, so a snapshot can only be
+// restored by a binary built from the same render definitions on the same
+// architecture. Generated code guards against the former by writing its schema
+// and comparing it in full on restore.
+//
+class SnapshotWriter {
+public:
+  template <typename T> void write(T const &value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "snapshot values must be trivially copyable");
+    buffer_.append(reinterpret_cast<char const *>(&value), sizeof(T));
+  }
+
+  // Reserves space for a value to be written later with `patch`, returning its offset.
+  template <typename T> std::size_t reserve()
+  {
+    auto const offset = buffer_.size();
+    buffer_.append(sizeof(T), '\0');
+    return offset;
+  }
+
+  template <typename T> void patch(std::size_t offset, T const &value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "snapshot values must be trivially copyable");
+    std::memcpy(buffer_.data() + offset, &value, sizeof(T));
+  }
+
+  // Writes a length-prefixed string.
+  void write_string(std::string_view value)
+  {
+    write(static_cast<u32>(value.size()));
+    buffer_.append(value);
+  }
+
+  std::string const &data() const { return buffer_; }
+
+private:
+  std::string buffer_;
+};
+
+// Reads values written by SnapshotWriter.
+// Throws std::runtime_error if the input is truncated.
+//
+class SnapshotReader {
+public:
+  explicit SnapshotReader(std::string_view data) : data_(data) {}
+
+  template <typename T> T read()
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "snapshot values must be trivially copyable");
+    if (data_.size() < sizeof(T)) {
+      throw std::runtime_error("truncated snapshot");
+    }
+    T value;
+    std::memcpy(&value, data_.data(), sizeof(T));
+    data_.remove_prefix(sizeof(T));
+    return value;
+  }
+
+  // Reads a string written by SnapshotWriter::write_string. The result points into the input.
+  std::string_view read_string()
+  {
+    auto const size = read<u32>();
+    if (data_.size() < size) {
+      throw std::runtime_error("truncated snapshot");
+    }
+    auto const value = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return value;
+  }
+
+  bool empty() const { return data_.empty(); }
+
+private:
+  std::string_view data_;
+};
+
+// Maps span locations recorded in a snapshot to locations in the restored index.
+using SnapshotLocationMap = absl::flat_hash_map<u32, u32>;
+
+// Writes the queued (not yet output) entries of a metric store.
+// Stores of non-trivially-copyable metrics (e.g. t-digests) are written as empty.
+//
+template <typename Store> void snapshot_metric_store(Store &store, SnapshotWriter &out)
+{
+  using metric_type = typename Store::metric_type;
+
+  auto const count_offset = out.reserve<u32>();
+  u32 count = 0;
+
+  if constexpr (std::is_trivially_copyable_v<metric_type>) {
+    store.foreach_queued([&](u32 index, u32 bin, metric_type const &metric) {
+      out.write(index);
+      out.write(bin);
+      out.write(metric);
+      ++count;
+    });
+  }
+
+  out.patch(count_offset, count);
+}
+
+// Restores metric store entries written by snapshot_metric_store.
+// Entries of spans that were not restored are dropped.
+//
+template <typename Store> void restore_metric_store(Store &store, SnapshotReader &in, SnapshotLocationMap const &locations)
+{
+  using metric_type = typename Store::metric_type;
+
+  auto const count = in.read<u32>();
+  if (count == 0) {
+    return;
+  }
+
+  if constexpr (std::is_trivially_copyable_v<metric_type>) {
+    for (u32 i = 0; i < count; ++i) {
+      auto const index = in.read<u32>();
+      auto const bin = in.read<u32>();
+      auto const metric = in.read<metric_type>();
+
+      auto const found = locations.find(index);
+      if ((found == locations.end()) || (bin >= Store::n_epochs)) {
+        continue;
+      }
+
+      store.lookup_relative(found->second, bin, true).second = metric;
+    }
+  } else {
+    throw std::runtime_error("unexpected entries for non-serializable metric store");
+  }
+}
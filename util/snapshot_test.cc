@@ -0,0 +1,87 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <util/metric_store.h>
+#include <util/snapshot.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <utility>
+
+TEST(snapshot, round_trip_values)
+{
+  SnapshotWriter out;
+  out.write(u8{1});
+  auto const offset = out.reserve<u32>();
+  out.write(u64{0x0123456789abcdef});
+  out.patch(offset, u32{42});
+
+  SnapshotReader in(out.data());
+  EXPECT_EQ(1u, in.read<u8>());
+  EXPECT_EQ(42u, in.read<u32>());
+  EXPECT_EQ(0x0123456789abcdefu, in.read<u64>());
+  EXPECT_TRUE(in.empty());
+}
+
+TEST(snapshot, round_trip_strings)
+{
+  SnapshotWriter out;
+  out.write_string("flow{addr1:u64;}");
+  out.write_string("");
+  out.write(u8{3});
+
+  SnapshotReader in(out.data());
+  EXPECT_EQ("flow{addr1:u64;}", in.read_string());
+  EXPECT_EQ("", in.read_string());
+  EXPECT_EQ(3u, in.read<u8>());
+  EXPECT_TRUE(in.empty());
+}
+
+TEST(snapshot, truncated_string_throws)
+{
+  SnapshotWriter out;
+  out.write_string("schema");
+  auto data = out.data();
+  data.pop_back();
+
+  SnapshotReader in(data);
+  EXPECT_THROW(in.read_string(), std::runtime_error);
+}
+
+TEST(snapshot, truncated_input_throws)
+{
+  SnapshotWriter out;
+  out.write(u16{7});
+
+  SnapshotReader in(out.data());
+  EXPECT_THROW(in.read<u32>(), std::runtime_error);
+}
+
+TEST(snapshot, metric_store_round_trip)
+{
+  using Store = MetricStore<u64, 16, 4>;
+  fast_div t_to_timeslot(1.0, 16);
+
+  Store src(t_to_timeslot);
+  src.lookup_relative(3, 0, true).second = 30;
+  src.lookup_relative(5, 2, true).second = 52;
+  src.lookup_relative(7, 1, true).second = 71;
+
+  SnapshotWriter out;
+  snapshot_metric_store(src, out);
+
+  // span 7 was not restored, spans 3 and 5 moved
+  SnapshotLocationMap locations{{3, 10}, {5, 11}};
+
+  Store dst(t_to_timeslot);
+  SnapshotReader in(out.data());
+  restore_metric_store(dst, in, locations);
+  EXPECT_TRUE(in.empty());
+
+  std::map<std::pair<u32, u32>, u64> restored;
+  dst.foreach_queued([&](u32 index, u32 bin, u64 metric) { restored[{index, bin}] = metric; });
+
+  std::map<std::pair<u32, u32>, u64> expected{{{10, 0}, 30}, {{11, 2}, 52}};
+  EXPECT_EQ(expected, restored);
+}
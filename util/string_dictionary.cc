@@ -0,0 +1,93 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <util/string_dictionary.h>
+
+#include <stdexcept>
+
+StringDictionaryEncoder::StringDictionaryEncoder(u32 capacity) : slots_(capacity + 1)
+{
+  if (capacity == 0) {
+    throw std::invalid_argument("StringDictionaryEncoder: capacity must be positive");
+  }
+
+  ids_.reserve(capacity);
+  clear();
+}
+
+void StringDictionaryEncoder::clear()
+{
+  ids_.clear();
+
+  // all ids start on the list, unused ones first in line for assignment
+  u32 const sentinel = capacity();
+  for (u32 id = 0; id <= sentinel; ++id) {
+    slots_[id].value.clear();
+    slots_[id].prev = (id == 0) ? sentinel : id - 1;
+    slots_[id].next = (id == sentinel) ? 0 : id + 1;
+  }
+}
+
+StringDictionaryEncoder::Code StringDictionaryEncoder::encode(std::string_view value)
+{
+  if (auto found = ids_.find(value); found != ids_.end()) {
+    touch(found->second);
+    return {.id = found->second, .is_new = false};
+  }
+
+  u32 const sentinel = capacity();
+  u32 const id = slots_[sentinel].next;
+  auto &slot = slots_[id];
+
+  if (ids_.size() == capacity()) {
+    ids_.erase(slot.value);
+    ++evictions_;
+  }
+
+  slot.value.assign(value);
+  ids_.emplace(slot.value, id);
+  touch(id);
+
+  return {.id = id, .is_new = true};
+}
+
+void StringDictionaryEncoder::touch(u32 id)
+{
+  unlink(id);
+  link_back(id);
+}
+
+void StringDictionaryEncoder::unlink(u32 id)
+{
+  auto &slot = slots_[id];
+  slots_[slot.prev].next = slot.next;
+  slots_[slot.next].prev = slot.prev;
+}
+
+void StringDictionaryEncoder::link_back(u32 id)
+{
+  u32 const sentinel = capacity();
+  u32 const last = slots_[sentinel].prev;
+
+  slots_[id].prev = last;
+  slots_[id].next = sentinel;
+  slots_[last].next = id;
+  slots_[sentinel].prev = id;
+}
+
+bool StringDictionaryDecoder::define(u32 id, std::string_view value)
+{
+  if (id >= values_.size()) {
+    return false;
+  }
+
+  values_[id].assign(value);
+  return true;
+}
+
+void StringDictionaryDecoder::clear()
+{
+  for (auto &value : values_) {
+    value.clear();
+  }
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <platform/types.h>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Writer side of a string dictionary shared by the two ends of an ordered
+ * channel, used to send repetitive strings as small ids.
+ *
+ * encode() maps a string to one of |capacity| ids. When it returns a new
+ * code, the writer must send the (id, string) definition before any message
+ * using the id; the reader applies it with StringDictionaryDecoder::define().
+ *
+ * When full, the least recently encoded string is evicted and its id
+ * reused. Since the reused id travels with the new definition, the reader's
+ * dictionary mirrors the writer's without running any eviction of its own.
+ *
+ * The strings of a single message are never evicted by each other as long
+ * as the message has at most |capacity| strings.
+ */
+class StringDictionaryEncoder {
+public:
+  struct Code {
+    u32 id;
+    /* whether the id was (re)assigned, and must be defined to the reader */
+    bool is_new;
+  };
+
+  explicit StringDictionaryEncoder(u32 capacity);
+
+  StringDictionaryEncoder(StringDictionaryEncoder const &) = delete;
+  StringDictionaryEncoder &operator=(StringDictionaryEncoder const &) = delete;
+
+  Code encode(std::string_view value);
+
+  /* forgets all strings, as after construction, for when the reader starts
+   * over with an empty dictionary */
+  void clear();
+
+  u32 size() const { return ids_.size(); }
+  u32 capacity() const { return slots_.size() - 1; }
+
+  /* number of strings evicted to make room for new ones */
+  u64 evictions() const { return evictions_; }
+
+private:
+  struct Slot {
+    std::string value;
+    u32 prev;
+    u32 next;
+  };
+
+  /* moves |id| to the most recently used end of the list */
+  void touch(u32 id);
+  void unlink(u32 id);
+  void link_back(u32 id);
+
+  /* slots_[capacity] is the list's sentinel: its next is the least recently
+   * used id, its prev the most recently used one */
+  std::vector<Slot> slots_;
+  /* views point into slots_' strings */
+  absl::flat_hash_map<std::string_view, u32> ids_;
+  u64 evictions_ = 0;
+};
+
+/**
+ * Reader side of a string dictionary.
+ *
+ * @see StringDictionaryEncoder
+ */
+class StringDictionaryDecoder {
+public:
+  explicit StringDictionaryDecoder(u32 capacity) : values_(capacity) {}
+
+  /**
+   * Sets the string for |id|, replacing any previous one.
+   *
+   * @returns false if |id| is out of range
+   */
+  bool define(u32 id, std::string_view value);
+
+  /**
+   * @returns the string for |id|, or an empty string if |id| is undefined or
+   *   out of range
+   */
+  std::string_view lookup(u32 id) const { return (id < values_.size()) ? std::string_view(values_[id]) : std::string_view(); }
+
+  /**
+   * Undefines all ids, mirroring StringDictionaryEncoder::clear().
+   */
+  void clear();
+
+  u32 capacity() const { return values_.size(); }
+
+private:
+  std::vector<std::string> values_;
+};
@@ -0,0 +1,100 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <util/string_dictionary.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+TEST(StringDictionaryTest, RepeatedStringsReuseIds)
+{
+  StringDictionaryEncoder encoder(4);
+
+  auto a = encoder.encode("alpha");
+  EXPECT_TRUE(a.is_new);
+
+  auto b = encoder.encode("beta");
+  EXPECT_TRUE(b.is_new);
+  EXPECT_NE(a.id, b.id);
+
+  auto a2 = encoder.encode("alpha");
+  EXPECT_FALSE(a2.is_new);
+  EXPECT_EQ(a.id, a2.id);
+
+  EXPECT_EQ(2u, encoder.size());
+  EXPECT_EQ(0u, encoder.evictions());
+}
+
+TEST(StringDictionaryTest, EvictsLeastRecentlyUsed)
+{
+  StringDictionaryEncoder encoder(3);
+
+  auto a = encoder.encode("a");
+  auto b = encoder.encode("b");
+  encoder.encode("c");
+
+  // "a" becomes the most recently used, leaving "b" to be evicted
+  encoder.encode("a");
+
+  auto d = encoder.encode("d");
+  EXPECT_TRUE(d.is_new);
+  EXPECT_EQ(b.id, d.id);
+  EXPECT_EQ(1u, encoder.evictions());
+
+  EXPECT_FALSE(encoder.encode("a").is_new);
+  EXPECT_EQ(a.id, encoder.encode("a").id);
+  EXPECT_TRUE(encoder.encode("b").is_new);
+}
+
+TEST(StringDictionaryTest, DecoderMirrorsEncoder)
+{
+  constexpr u32 capacity = 8;
+  StringDictionaryEncoder encoder(capacity);
+  StringDictionaryDecoder decoder(capacity);
+
+  // send more distinct strings than fit, with repetitions
+  for (int i = 0; i < 1000; ++i) {
+    std::string value = "string-" + std::to_string((i * 7) % 23);
+
+    auto code = encoder.encode(value);
+    if (code.is_new) {
+      ASSERT_TRUE(decoder.define(code.id, value));
+    }
+    ASSERT_EQ(value, decoder.lookup(code.id));
+  }
+
+  EXPECT_EQ(capacity, encoder.size());
+  EXPECT_GT(encoder.evictions(), 0u);
+}
+
+TEST(StringDictionaryTest, DecoderOutOfRange)
+{
+  StringDictionaryDecoder decoder(2);
+
+  EXPECT_FALSE(decoder.define(2, "x"));
+  EXPECT_EQ("", decoder.lookup(2));
+  EXPECT_EQ("", decoder.lookup(1));
+}
+
+TEST(StringDictionaryTest, ClearStartsOver)
+{
+  constexpr u32 capacity = 4;
+  StringDictionaryEncoder encoder(capacity);
+  StringDictionaryDecoder decoder(capacity);
+
+  for (auto value : {"a", "b", "c"}) {
+    ASSERT_TRUE(decoder.define(encoder.encode(value).id, value));
+  }
+
+  encoder.clear();
+  decoder.clear();
+  EXPECT_EQ(0u, encoder.size());
+
+  // strings known before are defined again, from the first id on
+  auto b = encoder.encode("b");
+  EXPECT_TRUE(b.is_new);
+  EXPECT_EQ(0u, b.id);
+  EXPECT_EQ("", decoder.lookup(b.id));
+  EXPECT_EQ(1u, encoder.size());
+}
@@ -0,0 +1,74 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <util/string_interner.h>
+
+#include <cassert>
+#include <utility>
+
+InternedString::InternedString(InternedString const &other) : entry_(other.entry_)
+{
+  if (entry_) {
+    ++entry_->refs;
+  }
+}
+
+InternedString &InternedString::operator=(InternedString other) noexcept
+{
+  std::swap(entry_, other.entry_);
+  return *this;
+}
+
+InternedString::~InternedString()
+{
+  if (!entry_ || --entry_->refs > 0) {
+    return;
+  }
+
+  if (entry_->owner) {
+    entry_->owner->release(entry_);
+  } else {
+    delete entry_;
+  }
+}
+
+std::string const &InternedString::str() const
+{
+  static std::string const empty;
+  return entry_ ? entry_->value : empty;
+}
+
+StringInterner::~StringInterner()
+{
+  // handles may outlive the interner (e.g. when held by state destroyed after
+  // it): entries still in use are left to be deleted by their last handle
+  for (auto &[_, entry] : entries_) {
+    entry->owner = nullptr;
+  }
+}
+
+InternedString StringInterner::intern(std::string_view value)
+{
+  if (value.empty()) {
+    return InternedString();
+  }
+
+  if (auto found = entries_.find(value); found != entries_.end()) {
+    ++found->second->refs;
+    return InternedString(found->second);
+  }
+
+  auto *entry = new InternedString::Entry{.value = std::string(value), .refs = 1, .owner = this};
+  entries_.emplace(entry->value, entry);
+
+  return InternedString(entry);
+}
+
+void StringInterner::release(InternedString::Entry *entry)
+{
+  assert(entry->owner == this);
+  assert(entry->refs == 0);
+
+  entries_.erase(std::string_view(entry->value));
+  delete entry;
+}
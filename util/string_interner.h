@@ -0,0 +1,82 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class StringInterner;
+
+/**
+ * Reference-counted handle to a string stored once in a StringInterner.
+ *
+ * A handle is the size of a pointer. Two handles from the same interner are
+ * equal iff their strings are equal, so comparing them is a pointer compare.
+ *
+ * The empty string is represented by a default-constructed handle and takes
+ * no storage in the interner.
+ */
+class InternedString {
+public:
+  InternedString() = default;
+  InternedString(InternedString const &other);
+  InternedString(InternedString &&other) noexcept : entry_(other.entry_) { other.entry_ = nullptr; }
+  InternedString &operator=(InternedString other) noexcept;
+  ~InternedString();
+
+  std::string const &str() const;
+  bool empty() const { return entry_ == nullptr; }
+
+  bool operator==(InternedString const &other) const { return entry_ == other.entry_; }
+  bool operator!=(InternedString const &other) const { return entry_ != other.entry_; }
+
+private:
+  friend class StringInterner;
+
+  struct Entry {
+    std::string value;
+    size_t refs;
+    /* nullptr once the interner is destroyed, see ~StringInterner() */
+    StringInterner *owner;
+  };
+
+  explicit InternedString(Entry *entry) : entry_(entry) {}
+
+  Entry *entry_ = nullptr;
+};
+
+/**
+ * Stores a single copy of each distinct string in use, for memory-heavy
+ * state that holds strings drawn from a small vocabulary.
+ *
+ * A string is released as soon as its last InternedString is destroyed.
+ * Not thread-safe: an interner and all of its handles must be used from a
+ * single thread.
+ */
+class StringInterner {
+public:
+  StringInterner() = default;
+  ~StringInterner();
+
+  StringInterner(StringInterner const &) = delete;
+  StringInterner &operator=(StringInterner const &) = delete;
+
+  InternedString intern(std::string_view value);
+
+  /* number of distinct strings currently in use */
+  size_t size() const { return entries_.size(); }
+
+private:
+  friend class InternedString;
+
+  void release(InternedString::Entry *entry);
+
+  /* keys point into the entries' strings */
+  absl::flat_hash_map<std::string_view, InternedString::Entry *> entries_;
+};
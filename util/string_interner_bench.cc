@@ -0,0 +1,199 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+// Memory benchmark: node metadata of matching flow spans held as one
+// std::string per field vs. as InternedString handles into a StringInterner.
+//
+// Not part of the unit test suite; run manually:
+//   string_interner_bench [--gtest_filter=...]
+//
+// The number of flows defaults to the size of a matching shard's flow pool
+// and can be overridden with the STRING_INTERNER_BENCH_FLOWS environment
+// variable.
+
+#include <platform/types.h>
+#include <util/string_interner.h>
+
+#include <gtest/gtest.h>
+
+#include <malloc.h>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+// heap bytes currently allocated through operator new
+size_t heap_in_use = 0;
+
+} // namespace
+
+void *operator new(size_t size)
+{
+  void *p = malloc(size);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  heap_in_use += malloc_usable_size(p);
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  if (p) {
+    heap_in_use -= malloc_usable_size(p);
+    free(p);
+  }
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  operator delete(p);
+}
+
+namespace {
+
+constexpr size_t default_num_flows = 4'200'000;
+
+size_t num_flows()
+{
+  if (char const *env = getenv("STRING_INTERNER_BENCH_FLOWS")) {
+    return strtoull(env, nullptr, 10);
+  }
+  return default_num_flows;
+}
+
+// Vocabulary of one metadata field: a small set of values, some longer than
+// std::string's small-string buffer.
+class Vocabulary {
+public:
+  Vocabulary(char const *prefix, size_t size)
+  {
+    for (size_t i = 0; i < size; ++i) {
+      values_.push_back(std::string(prefix) + std::to_string(i));
+    }
+  }
+
+  std::string const &pick(u64 &seed) const
+  {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    return values_[(seed >> 33) % values_.size()];
+  }
+
+private:
+  std::vector<std::string> values_;
+};
+
+struct Vocabularies {
+  Vocabulary id{"ip-10-0-", 2000};
+  Vocabulary az{"us-west-2", 6};
+  Vocabulary env{"production-cluster-", 3};
+  Vocabulary role{"checkout-service-", 300};
+  Vocabulary ns{"team-namespace-", 40};
+  Vocabulary comm{"worker-", 100};
+  Vocabulary cgroup{"/kubepods/burstable/pod8a1f3e2c-5b7d-4c9e-a6f0-/cri-containerd-3f4e5d6c7b8a9", 20000};
+  Vocabulary container{"checkout-container-", 400};
+  Vocabulary pod{"checkout-service-7c9d8f6b5-x2k", 20000};
+  Vocabulary version{"registry.example.com/checkout:v1.", 60};
+  Vocabulary service{"checkout.service-", 200};
+  Vocabulary dns{"checkout.payments.svc.cluster.local-", 1000};
+};
+
+// Per-side node metadata, in the layout of FlowSpan's info structs.
+template <typename String> struct SideInfo {
+  struct {
+    String id, az, env, role, ns;
+  } agent;
+  struct {
+    String comm, cgroup_name;
+  } task;
+  struct {
+    String name, pod, role, version, ns;
+  } container;
+  String service;
+  String remote_dns_name;
+};
+
+template <typename String> using FlowInfo = std::array<std::optional<SideInfo<String>>, 2>;
+
+template <typename String, typename Make> void fill(SideInfo<String> &side, Vocabularies const &v, u64 &seed, Make &&make)
+{
+  side.agent.id = make(v.id.pick(seed));
+  side.agent.az = make(v.az.pick(seed));
+  side.agent.env = make(v.env.pick(seed));
+  side.agent.role = make(v.role.pick(seed));
+  side.agent.ns = make(v.ns.pick(seed));
+  side.task.comm = make(v.comm.pick(seed));
+  side.task.cgroup_name = make(v.cgroup.pick(seed));
+  side.container.name = make(v.container.pick(seed));
+  side.container.pod = make(v.pod.pick(seed));
+  side.container.role = make(v.role.pick(seed));
+  side.container.version = make(v.version.pick(seed));
+  side.container.ns = make(v.ns.pick(seed));
+  side.service = make(v.service.pick(seed));
+  side.remote_dns_name = make(v.dns.pick(seed));
+}
+
+template <typename String, typename Make, typename Equal> void bench(char const *name, Make &&make, Equal &&equal)
+{
+  Vocabularies const vocabularies;
+  size_t const n = num_flows();
+  u64 seed = 1;
+
+  size_t const heap_before = heap_in_use;
+  auto const start = std::chrono::steady_clock::now();
+
+  std::vector<FlowInfo<String>> flows(n);
+  for (auto &flow : flows) {
+    for (auto &side : flow) {
+      fill(side.emplace(), vocabularies, seed, make);
+    }
+  }
+
+  auto const filled = std::chrono::steady_clock::now();
+  size_t const heap_after = heap_in_use;
+
+  // the kind of comparison node resolution does between the two sides
+  size_t matches = 0;
+  for (auto const &flow : flows) {
+    matches += equal(flow[0]->agent.az, flow[1]->agent.az) && equal(flow[0]->agent.role, flow[1]->container.role);
+  }
+
+  auto const compared = std::chrono::steady_clock::now();
+
+  printf(
+      "%-16s flows=%zu  heap=%8.1f MB (%6.1f B/flow)  fill=%6.0f ms  compare=%5.1f ms  (%zu matches)\n",
+      name,
+      n,
+      (heap_after - heap_before) / 1e6,
+      double(heap_after - heap_before) / n,
+      std::chrono::duration<double, std::milli>(filled - start).count(),
+      std::chrono::duration<double, std::milli>(compared - filled).count(),
+      matches);
+}
+
+} // namespace
+
+TEST(StringInternerBench, StdString)
+{
+  bench<std::string>(
+      "std::string",
+      [](std::string const &value) { return value; },
+      [](std::string const &a, std::string const &b) { return a == b; });
+}
+
+TEST(StringInternerBench, InternedString)
+{
+  StringInterner interner;
+
+  bench<InternedString>(
+      "InternedString",
+      [&interner](std::string const &value) { return interner.intern(value); },
+      [](InternedString const &a, InternedString const &b) { return a == b; });
+}
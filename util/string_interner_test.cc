@@ -0,0 +1,72 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include <util/string_interner.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+TEST(StringInternerTest, EqualStringsShareStorage)
+{
+  StringInterner interner;
+
+  auto a = interner.intern("us-west-2a");
+  auto b = interner.intern(std::string("us-west-") + "2a");
+  auto c = interner.intern("us-west-2b");
+
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  EXPECT_EQ(&a.str(), &b.str());
+  EXPECT_EQ("us-west-2a", a.str());
+  EXPECT_EQ(2u, interner.size());
+}
+
+TEST(StringInternerTest, EmptyString)
+{
+  StringInterner interner;
+
+  auto empty = interner.intern("");
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ("", empty.str());
+  EXPECT_EQ(InternedString(), empty);
+  EXPECT_EQ(0u, interner.size());
+}
+
+TEST(StringInternerTest, ReleasedWithLastReference)
+{
+  StringInterner interner;
+
+  {
+    auto a = interner.intern("frontend");
+    std::vector<InternedString> copies(10, a);
+    auto moved = std::move(copies.back());
+    copies.pop_back();
+    EXPECT_EQ(1u, interner.size());
+
+    copies.clear();
+    EXPECT_EQ(1u, interner.size());
+    EXPECT_EQ("frontend", moved.str());
+  }
+
+  EXPECT_EQ(0u, interner.size());
+
+  // assignment releases the previous string
+  auto s = interner.intern("x");
+  s = interner.intern("y");
+  EXPECT_EQ(1u, interner.size());
+  EXPECT_EQ("y", s.str());
+}
+
+TEST(StringInternerTest, HandlesMayOutliveInterner)
+{
+  InternedString survivor;
+
+  {
+    auto interner = std::make_unique<StringInterner>();
+    survivor = interner->intern("long-lived value, not subject to SSO");
+  }
+
+  EXPECT_EQ("long-lived value, not subject to SSO", survivor.str());
+}
@@ -0,0 +1,61 @@
+// Copyright The OpenTelemetry Authors
+// SPDX-License-Identifier: Apache-2.0
+
+#include "zstd_decompressor.h"
+
+#include <stdexcept>
+
+ZstdDecompressor::ZstdDecompressor(size_t capacity, Dictionary dictionary)
+    : Decompressor(capacity), ctx_(ZSTD_createDCtx()), dictionary_(std::move(dictionary))
+{
+  if (!ctx_) {
+    throw std::runtime_error("ZstdDecompressor: failed to create a CTX object.");
+  }
+
+  if (dictionary_) {
+    if (ZSTD_isError(ZSTD_DCtx_refDDict(ctx_.get(), dictionary_.get()))) {
+      throw std::runtime_error("ZstdDecompressor: failed to reference the dictionary.");
+    }
+  }
+}
+
+size_t ZstdDecompressor::process(const u8 *data, size_t data_len, size_t *consumed_len)
+{
+  ZSTD_inBuffer input = {.src = data, .size = data_len, .pos = 0};
+  size_t res = 0;
+  bool progress = false;
+
+  do {
+    ZSTD_outBuffer output = {.dst = output_buf_ + tail_loc_, .size = output_buf_capacity_ - tail_loc_, .pos = 0};
+    size_t const input_pos = input.pos;
+
+    res = ZSTD_decompressStream(ctx_.get(), &output, &input);
+
+    tail_loc_ += output.pos;
+
+    // output may still be pending in the context after all input is
+    // consumed, so keep going while zstd is making progress and there's room
+    progress = (output.pos > 0) || (input.pos > input_pos);
+  } while ((!ZSTD_isError(res)) && progress && (tail_loc_ < output_buf_capacity_));
+
+  *consumed_len = input.pos;
+
+  return ZSTD_isError(res) ? res : 0;
+}
+
+bool ZstdDecompressor::is_zstd_stream(const u8 *data)
+{
+  // the magic number is stored little-endian
+  u32 const magic = u32(data[0]) | (u32(data[1]) << 8) | (u32(data[2]) << 16) | (u32(data[3]) << 24);
+  return magic == ZSTD_MAGICNUMBER;
+}
+
+ZstdDecompressor::Dictionary ZstdDecompressor::load_dictionary(std::string_view contents)
+{
+  ZSTD_DDict *dictionary = ZSTD_createDDict(contents.data(), contents.size());
+  if (!dictionary) {
+    throw std::runtime_error("ZstdDecompressor: failed to load the dictionary.");
+  }
+
+  return Dictionary(dictionary, [](ZSTD_DDict const *dictionary) { ZSTD_freeDDict(const_cast<ZSTD_DDict *>(dictionary)); });
+}
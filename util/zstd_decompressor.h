@@ -0,0 +1,46 @@
+/*
+ * Copyright The OpenTelemetry Authors
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <util/decompressor.h>
+#include <util/raii.h>
+
+#include <zstd.h>
+
+#include <memory>
+#include <string_view>
+
+class ZstdDecompressor : public Decompressor {
+public:
+  // A digested dictionary, which decompressors can share across threads.
+  using Dictionary = std::shared_ptr<ZSTD_DDict const>;
+
+  // Number of bytes needed to tell whether a stream is compressed with zstd.
+  static constexpr size_t magic_size = 4;
+
+  // |dictionary| is the dictionary the stream was compressed with, if any.
+  ZstdDecompressor(size_t buf_capacity, Dictionary dictionary = nullptr);
+
+  // Decompresses |data| of size |data_len|.
+  // The # of bytes that have been decompressed is stored in |consumed_len|.
+  //
+  // Returns zstd error, if an error happened, 0 otherwise.
+  size_t process(const u8 *data, size_t data_len, size_t *consumed_len) override;
+
+  const char *error_name(size_t error) const override { return ZSTD_getErrorName(error); }
+
+  // Whether the stream starting with |data|, of at least magic_size bytes, is
+  // compressed with zstd.
+  static bool is_zstd_stream(const u8 *data);
+
+  // Digests the contents of a dictionary made with `zstd --train`.
+  // Throws std::runtime_error if it isn't a valid dictionary.
+  static Dictionary load_dictionary(std::string_view contents);
+
+private:
+  pod_unique_ptr<ZSTD_DCtx, size_t, ZSTD_freeDCtx> ctx_;
+  Dictionary dictionary_;
+};